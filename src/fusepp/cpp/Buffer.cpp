@@ -9,6 +9,9 @@
 #include "fusepp/common.hpp"
 
 #include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
 
 namespace fusepp {
 
@@ -31,7 +34,7 @@ inline void setToFD(::fuse_buf& buf, int fd, off_t offset, size_t length) {
 	buf.fd = fd;
 	buf.size = length;
 	buf.pos = offset;
-	buf.flags = FUSE_BUF_IS_FD | FUSE_BUF_FD_SEEK;
+	buf.flags = static_cast<fuse_buf_flags>(FUSE_BUF_IS_FD | FUSE_BUF_FD_SEEK);
 }
 
 inline void initBufvec(::fuse_bufvec& bufvec, size_t count) {
@@ -40,10 +43,23 @@ inline void initBufvec(::fuse_bufvec& bufvec, size_t count) {
 	bufvec.count = count;
 }
 
+/**
+ * Allocates a bufvec with `malloc`, as fuse frees those it is given.
+ */
+inline ::fuse_bufvec * allocateBufvec(size_t capacity, size_t count) {
+	::fuse_bufvec * buf = static_cast<::fuse_bufvec*>(malloc(bufvec_size(capacity)));
+	if(!buf) {
+		throw std::bad_alloc();
+	}
+	initBufvec(*buf, count);
+	return buf;
+}
+
 namespace internal {
 
 inline AbstractBuffer& internals(Buffer& buf) {
-	return static_cast<AbstractBuffer&>(buf);
+	// Buffer is a virtual base, so cannot be cast down statically
+	return dynamic_cast<AbstractBuffer&>(buf);
 }
 
 /*
@@ -53,6 +69,11 @@ inline AbstractBuffer& internals(Buffer& buf) {
  */
 
 size_t AbstractBuffer::copyDataFrom(Buffer &other, int flags) {
+	if(dynamic_cast<PipeBuffer *>(&other) && !(flags & FUSE_BUF_NO_SPLICE)) {
+		// The pipe has no further use for its pages, so they may be moved
+		// into the destination rather than copied
+		flags |= FUSE_BUF_SPLICE_MOVE;
+	}
 	ssize_t rc = ::fuse_buf_copy(&getBufvec(), &internals(other).getBufvec(),
 			static_cast<::fuse_buf_copy_flags>(flags));
 	if(rc<0) {
@@ -78,10 +99,10 @@ size_t AbstractBuffer::remaining() const {
 	return size - bufvec.off;
 }
 
-void setPos(fuse_bufvec& bufvec, size_t index, off_t offset) {
+static void setPos(fuse_bufvec& bufvec, size_t index, off_t offset) {
 	for(;;) {
-		size_t bufsize = bufvec.buf[bufvec.idx].size;
-		if(offset>=bufsize) {
+		size_t bufsize = bufvec.buf[index].size;
+		if(static_cast<size_t>(offset)>=bufsize) {
 			++index;
 			if(index==bufvec.count) {
 				offset = 0;
@@ -118,24 +139,25 @@ void AbstractBuffer::seek(off_t offset) {
  */
 
 DynamicBuffer::DynamicBuffer(std::function<void (::fuse_buf&)>&& bufSetup)
-		: bufvec(make_unique<::fuse_bufvec>()) {
-	initBufvec(*bufvec, 1);
+		: bufvec(allocateBufvec(1, 1)) {
 	bufSetup(bufvec->buf[0]);
 }
 
-DynamicBuffer::DynamicBuffer(unique_ptr<::fuse_bufvec>&& bufvec)
-		: bufvec(forward<unique_ptr<::fuse_bufvec>>(bufvec)) {}
+DynamicBuffer::DynamicBuffer(BufvecPtr&& bufvec)
+		: bufvec(forward<BufvecPtr>(bufvec)) {}
+
+DynamicBuffer::DynamicBuffer(BufvecPtr&& bufvec, std::vector<shared_ptr<void>>&& owners)
+		: bufvec(forward<BufvecPtr>(bufvec)),
+		  owners(forward<std::vector<shared_ptr<void>>>(owners)) {}
 
 ::fuse_bufvec const & DynamicBuffer::getBufvec() const {
 	return *bufvec;
 }
 
 ::fuse_bufvec * DynamicBuffer::extractBufvec() const {
-	::fuse_bufvec& bufvec = getBufvec();
-	size_t size = bufvec_size(bufvec.count);
-
-	::fuse_bufvec * rc = malloc(size);
-	memcpy(rc, &bufvec, size);
+	::fuse_bufvec const & bufvec = getBufvec();
+	::fuse_bufvec * rc = allocateBufvec(bufvec.count, bufvec.count);
+	std::memcpy(rc, &bufvec, bufvec_size(bufvec.count));
 	return rc;
 }
 
@@ -143,6 +165,29 @@ DynamicBuffer::DynamicBuffer(unique_ptr<::fuse_bufvec>&& bufvec)
 	return bufvec.release();
 }
 
+::fuse_bufvec* DynamicBuffer::copyBufvec() const {
+	::fuse_bufvec * rc = extractBufvec();
+	for(size_t i = 0; i < rc->count; ++i) {
+		::fuse_buf& buf = rc->buf[i];
+		if(!(buf.flags & FUSE_BUF_IS_FD)) {
+			void * mem = malloc(buf.size);
+			if(!mem && buf.size) {
+				// Free the copies made so far, which fuse will now never see
+				for(size_t j = 0; j < i; ++j) {
+					if(!(rc->buf[j].flags & FUSE_BUF_IS_FD)) {
+						free(rc->buf[j].mem);
+					}
+				}
+				free(rc);
+				throw std::bad_alloc();
+			}
+			std::memcpy(mem, buf.mem, buf.size);
+			buf.mem = mem;
+		}
+	}
+	return rc;
+}
+
 /*
  * ===============================================
  * END DynamicBuffer
@@ -155,13 +200,13 @@ DynamicBuffer::DynamicBuffer(unique_ptr<::fuse_bufvec>&& bufvec)
  * ======================================================
  */
 
-inline void const * AbstractDataBuffer::data() const {
+void const * AbstractDataBuffer::data() const {
 	return getBufvec().buf[0].mem;
 }
 
-inline void const * AbstractDataBuffer::tail() const {
+void const * AbstractDataBuffer::tail() const {
 	::fuse_bufvec const & bufvec = getBufvec();
-	return bufvec.buf[0].mem + bufvec.off;
+	return static_cast<char const *>(bufvec.buf[0].mem) + bufvec.off;
 }
 
 off_t AbstractDataBuffer::position() const {
@@ -206,6 +251,11 @@ struct DynamicDataBuffer : DynamicBuffer, virtual AbstractDataBuffer {
 	DynamicDataBuffer(void* mem, size_t size)
 			: DynamicBuffer([=](::fuse_buf& buf) {setToMem(buf, mem, size);}) {}
 
+	DynamicDataBuffer(shared_ptr<void>&& owner, void* mem, size_t size)
+			: DynamicDataBuffer(mem, size) {
+		owners.push_back(forward<shared_ptr<void>>(owner));
+	}
+
 };
 
 /*
@@ -245,12 +295,6 @@ struct DynamicFileBuffer : DynamicBuffer, FileBuffer {
  * ======================================================
  */
 
-inline ::fuse_bufvec * allocateBufvec(size_t capacity, size_t count) {
-	::fuse_bufvec * buf = static_cast<::fuse_bufvec*>(malloc(bufvec_size(capacity)));
-	initBufvec(*buf, count);
-	return buf;
-}
-
 inline ::fuse_bufvec * allocateBufvec(size_t capacity) {
 	return allocateBufvec(capacity, capacity);
 }
@@ -258,6 +302,7 @@ inline ::fuse_bufvec * allocateBufvec(size_t capacity) {
 struct CompoundBufferBuilder::Data {
 	size_t capacity;
 	::fuse_bufvec* bufvec;
+	std::vector<shared_ptr<void>> owners;
 
 	Data() : capacity(2), bufvec(allocateBufvec(capacity, 0)) {}
 
@@ -284,6 +329,11 @@ struct CompoundBufferBuilder::Data {
 CompoundBufferBuilder::CompoundBufferBuilder()
 		: data(make_unique<CompoundBufferBuilder::Data>()) {}
 
+CompoundBufferBuilder::~CompoundBufferBuilder() {
+	// Only set if nothing was built
+	free(data->bufvec);
+}
+
 CompoundBufferBuilder& CompoundBufferBuilder::add(void* mem, size_t length) {
 	setToMem(*data->add(1), mem, length);
 	return *this;
@@ -295,13 +345,20 @@ CompoundBufferBuilder& CompoundBufferBuilder::add(int fd, off_t offset, size_t l
 }
 
 CompoundBufferBuilder& CompoundBufferBuilder::add(Buffer const & buf) {
-	::fuse_bufvec const & src = static_cast<internal::AbstractBuffer const &>(buf).getBufvec();
+	::fuse_bufvec const & src = internal::bufvec(buf);
 	std::memcpy(data->add(src.count), src.buf, src.count * sizeof(::fuse_buf));
 	return *this;
 }
 
+CompoundBufferBuilder& CompoundBufferBuilder::add(std::shared_ptr<Buffer> buf) {
+	add(*buf);
+	data->owners.push_back(move(buf));
+	return *this;
+}
+
 std::shared_ptr<Buffer> CompoundBufferBuilder::build() {
-	return make_shared<internal::DynamicBuffer>(unique_ptr<::fuse_bufvec>(data->release()));
+	return make_shared<internal::DynamicBuffer>(internal::BufvecPtr(data->release()),
+			move(data->owners));
 }
 
 /*
@@ -310,11 +367,15 @@ std::shared_ptr<Buffer> CompoundBufferBuilder::build() {
  * ======================================================
  */
 
-static std::shared_ptr<DataBuffer> DataBuffer::create(void* mem, size_t length) {
+std::shared_ptr<DataBuffer> DataBuffer::create(void* mem, size_t length) {
 	return make_shared<internal::DynamicDataBuffer>(mem, length);
 }
 
-static std::shared_ptr<Buffer> FileBuffer::create(int fd, off_t offset = 0, size_t length ) {
+std::shared_ptr<DataBuffer> DataBuffer::create(std::shared_ptr<void> owner, void* mem, size_t length) {
+	return make_shared<internal::DynamicDataBuffer>(move(owner), mem, length);
+}
+
+std::shared_ptr<Buffer> FileBuffer::create(int fd, off_t offset, size_t length) {
 	return make_shared<internal::DynamicFileBuffer>(fd, offset, length);
 }
 
@@ -7,9 +7,18 @@
 
 #include "fuse.hpp"
 #include "fusepp/internal/impl.hpp"
+#include "fusepp/internal/Buffer.h"
+#include "fusepp/util.hpp"
 
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+
+#include <string>
 #include <tuple>
 #include <type_traits>
+#include <vector>
 
 namespace fusepp {
 
@@ -54,9 +63,15 @@ NI(2, FileHandle1::read)
 NI(2, FileHandle1::write)
 NI(0, FileHandle1::flush)
 NI(2, FileHandle1::lock)
+NI(3, FileHandle1::fallocate)
+NI(5, FileHandle1::copyFileRange)
 
 NI(0, DirHandle1::readdir)
+NI(1, DirHandle1::seekdir)
+NI(0, DirHandle1::telldir)
 
+NI(1, Node1::lookup)
+NI(0, Node1::ino)
 NI(1, Node1::getattr)
 NI(1, Node1::readlink)
 NI(1, Node1::mkfifo)
@@ -94,10 +109,203 @@ static Mount1* get_mount_real() {
 	return (Mount1 *) fuse_get_context()->private_data;
 }
 
+/**
+ * The flag libfuse has for each of the features in @ref Connection::Capabilities
+ * it knows of.
+ */
+static struct {
+	unsigned flag;
+	bool Connection::Capabilities::* capability;
+} const capability_flags[] = {
+	{ FUSE_CAP_ASYNC_READ, &Connection::Capabilities::asyncRead },
+	{ FUSE_CAP_POSIX_LOCKS, &Connection::Capabilities::posixLocks },
+	{ FUSE_CAP_FLOCK_LOCKS, &Connection::Capabilities::flockLocks },
+	{ FUSE_CAP_ATOMIC_O_TRUNC, &Connection::Capabilities::atomicOTrunc },
+	{ FUSE_CAP_EXPORT_SUPPORT, &Connection::Capabilities::exportSupport },
+	{ FUSE_CAP_DONT_MASK, &Connection::Capabilities::dontMask },
+	{ FUSE_CAP_IOCTL_DIR, &Connection::Capabilities::ioctlDir },
+#ifdef FUSE_CAP_BIG_WRITES
+	{ FUSE_CAP_BIG_WRITES, &Connection::Capabilities::bigWrites },
+#endif
+	{ FUSE_CAP_SPLICE_WRITE, &Connection::Capabilities::spliceWrite },
+	{ FUSE_CAP_SPLICE_MOVE, &Connection::Capabilities::spliceMove },
+	{ FUSE_CAP_SPLICE_READ, &Connection::Capabilities::spliceRead },
+};
+
+namespace internal {
+
+Connection read_connection(::fuse_conn_info const & conn) {
+	Connection connection;
+	connection.protocolMajor = conn.proto_major;
+	connection.protocolMinor = conn.proto_minor;
+	for(auto const & c : capability_flags) {
+		connection.capable.*c.capability = conn.capable & c.flag;
+		connection.wanted.*c.capability = conn.want & c.flag;
+	}
+#if FUSE_VERSION < FUSE_MAKE_VERSION(3, 0)
+	// Asked for by default through its own field rather than the flag
+	connection.wanted.asyncRead = connection.wanted.asyncRead || conn.async_read;
+#endif
+	connection.maxWrite = conn.max_write;
+	connection.maxReadahead = conn.max_readahead;
+	connection.maxBackground = conn.max_background;
+	connection.congestionThreshold = conn.congestion_threshold;
+	return connection;
+}
+
+void apply_connection(Connection const & connection, ::fuse_conn_info & conn) {
+	for(auto const & c : capability_flags) {
+		if(connection.wanted.*c.capability && (conn.capable & c.flag)) {
+			conn.want |= c.flag;
+		} else {
+			conn.want &= ~c.flag;
+		}
+	}
+#if FUSE_VERSION < FUSE_MAKE_VERSION(3, 0)
+	// libfuse asks for asynchronous reads if either this or the flag is set
+	conn.async_read = connection.wanted.asyncRead && (conn.capable & FUSE_CAP_ASYNC_READ);
+#endif
+	// libfuse has already clamped these to its buffer, and does not again
+	conn.max_write = std::min(connection.maxWrite, conn.max_write);
+	conn.max_readahead = std::min(connection.maxReadahead, conn.max_readahead);
+	conn.max_background = connection.maxBackground;
+	conn.congestion_threshold = connection.congestionThreshold;
+}
+
+}
+
+/**
+ * Lets a mount choose the parameters of its connection, then tells it that
+ * the kernel has connected.
+ * @return Whether the mount did both, rather than throwing.
+ */
+bool negotiate(Mount1 & mount, ::fuse_conn_info & conn) {
+	try {
+		Connection connection = internal::read_connection(conn);
+		mount.init(connection);
+		internal::apply_connection(connection, conn);
+		mount.mounted();
+		return true;
+	} catch(std::exception const & e) {
+		fprintf(stderr, "fusepp: failed to mount: %s\n", e.what());
+		mount.failed = true;
+		return false;
+	}
+}
+
+/**
+ * Lets the current fuse context's @ref mount choose the parameters of the
+ * connection, then tells it that the kernel has connected. If it fails to
+ * do either, the filesystem is unmounted.
+ * @return The mount, which fuse keeps as the context's private data.
+ */
+#if FUSE_VERSION >= FUSE_MAKE_VERSION(3, 0)
+static void * init_real(::fuse_conn_info * conn, ::fuse_config *) {
+#else
+static void * init_real(::fuse_conn_info * conn) {
+#endif
+	Mount1 * mount = get_mount_real();
+	if(!negotiate(*mount, *conn)) {
+		// The loop then ends once this request is answered
+		::fuse_exit(fuse_get_context()->fuse);
+	}
+	return mount;
+}
+
+/**
+ * @return The channel notifications about a filesystem are sent down.
+ */
+static ::fuse_chan * channel(::fuse * fuse) {
+	if(!fuse) {
+		throw fuse_error(ENOTCONN);
+	}
+	return ::fuse_session_next_chan(::fuse_get_session(fuse), nullptr);
+}
+
+/**
+ * Throws the error a notification failed with, if it did.
+ */
+static void check_notify(int rc) {
+	if(rc < 0) {
+		throw fuse_error(-rc);
+	}
+}
+
+namespace internal {
+
+std::uint64_t nodeid(std::string const & mountpoint, path_t const & path) {
+	struct stat statbuf;
+	std::string full = path == "/" ? mountpoint : mountpoint + path;
+	check_ret(::lstat(full.c_str(), &statbuf));
+	return statbuf.st_ino;
+}
+
+}
+
+std::uint64_t Mount1::nodeid(path_t const & path) const {
+	if(!connection) {
+		throw fuse_error(ENOTCONN);
+	}
+	if(ownInodes) {
+		// st_ino is then the filesystem's own, which the kernel knows nothing of
+		throw fuse_error(EOPNOTSUPP);
+	}
+	return internal::nodeid(mountPoint, path);
+}
+
+void Mount1::notifyStore(path_t const & path, off_t offset, Buffer & data) {
+	::fuse_ino_t ino = nodeid(path);
+	check_notify(::fuse_lowlevel_notify_store(channel(connection), ino, offset,
+			&internal::bufvec(data), static_cast<::fuse_buf_copy_flags>(0)));
+}
+
+void Mount1::invalidateData(path_t const & path, off_t offset, off_t length) {
+	::fuse_ino_t ino = nodeid(path);
+	check_notify(::fuse_lowlevel_notify_inval_inode(channel(connection), ino, offset, length));
+}
+
+void Mount1::invalidateEntry(path_t const & path) {
+	std::string::size_type slash = path.rfind('/');
+	if(slash == std::string::npos || slash + 1 == path.size()) {
+		// The root has no entry
+		throw fuse_error(EINVAL);
+	}
+	std::string name = path.substr(slash + 1);
+	::fuse_ino_t parent = nodeid(slash ? path.substr(0, slash) : "/");
+	check_notify(::fuse_lowlevel_notify_inval_entry(channel(connection), parent, name.c_str(), name.size()));
+}
+
 int main(int argc, char *argv[], Mount1 *mount) {
-	struct fuse_operations operations;
+	struct fuse_operations operations = {};
 	internal::with_mount1<&fusepp::get_mount_real>::bind(&operations);
-	return fuse_main(argc, argv, &operations, mount);
+	operations.init = &init_real;
+
+	// The filesystem's own options go after the command line's
+	std::vector<char *> args(argv, argv + argc);
+	std::string options = mount->options();
+	char dashO[] = "-o";
+	if(!options.empty()) {
+		args.push_back(dashO);
+		args.push_back(&options[0]);
+	}
+	args.push_back(nullptr);
+
+	// As fuse_main, but keeping hold of the session for notifications
+	char * mountpoint;
+	int multithreaded;
+	::fuse * fuse = ::fuse_setup(args.size() - 1, args.data(), &operations, sizeof(operations),
+			&mountpoint, &multithreaded, mount);
+	if(!fuse) {
+		return 1;
+	}
+	mount->connection = fuse;
+	mount->mountPoint = mountpoint;
+	mount->ownInodes = std::any_of(args.begin(), args.end() - 1,
+			[](char const * arg) { return std::strstr(arg, "use_ino"); });
+	int rc = multithreaded ? ::fuse_loop_mt(fuse) : ::fuse_loop(fuse);
+	mount->connection = nullptr;
+	::fuse_teardown(fuse, mountpoint);
+	return rc == -1 || mount->failed ? 1 : 0;
 }
 
 } // namespace fuse
@@ -9,12 +9,16 @@
 #define FUSE_HPP_
 
 // Std includes
+#include <atomic>
 #include <string>
 #include <cstddef> // for size_t
 #include <memory>
 #include <optional>
 
 extern "C" {
+	struct fuse;
+	struct fuse_conn_info;
+
 	// POSIX includes
 	#include <sys/types.h> // for off_t
 	#include <sys/stat.h>
@@ -25,6 +29,7 @@ extern "C" {
 
 #include "fusepp/common.hpp"
 #include "fusepp/Buffer.h"
+#include "fusepp/Connection.h"
 #include "fusepp/DirEntry.h"
 #include "fusepp/Timestamp.h"
 
@@ -154,16 +159,78 @@ struct FileHandle1 : NodeHandle1 {
 
 	virtual void truncate(off_t newLength) = 0;
 
+	/**
+	 * @brief Allocates or deallocates space within this file, as `fallocate`.
+	 *
+	 * @param mode The fallocate mode flags (e.g. FALLOC_FL_PUNCH_HOLE).
+	 * @param offset The offset at which the affected range begins.
+	 * @param length The number of bytes in the affected range.
+	 * @throws fuse_error if an error occurs.
+	 */
+	virtual void fallocate(int mode, off_t offset, off_t length);
+
+	/**
+	 * @brief Copies a range of data from this file into another, as
+	 * `copy_file_range`.
+	 *
+	 * Implementations that cannot copy into the given destination more
+	 * efficiently than by reading and writing the data should throw a
+	 * fuse_error with `EXDEV`, so that the caller falls back to doing so.
+	 *
+	 * libfuse only passes `copy_file_range` on from version 3.4. Built
+	 * against an older libfuse, this is never called by fusepp, and the
+	 * kernel copies by reading and writing instead.
+	 *
+	 * @param offsetIn The offset within this file to copy from.
+	 * @param out The handle of the file to copy to, which may be this handle.
+	 * @param offsetOut The offset within the destination file to copy to.
+	 * @param nbytes The number of bytes to copy.
+	 * @param flags Flags given to `copy_file_range`.
+	 * @return The number of bytes actually copied.
+	 * @throws fuse_error if an error occurs.
+	 */
+	virtual size_t copyFileRange(off_t offsetIn, FileHandle1& out, off_t offsetOut, size_t nbytes, int flags);
+
+	/**
+	 * @brief Whether the kernel may keep the data it has cached for this
+	 * file when this handle is opened, rather than dropping it.
+	 *
+	 * This is only safe if the kernel is told of every change made to the
+	 * file other than through the kernel (see @ref Mount1::invalidateData).
+	 *
+	 * @return false, unless overridden.
+	 */
+	virtual bool keepCache() const {
+		return false;
+	}
+
 };
 
 struct DirHandle1 : NodeHandle1 {
 
 	virtual ~DirHandle1() {}
 
-	virtual AnyDirEntry readdir();
+	/**
+	 * @brief Reads the entry at the current position in this directory, and
+	 * advances past it.
+	 *
+	 * @return The entry, or an empty optional at the end of the directory.
+	 * @throws fuse_error if an error occurs.
+	 */
+	virtual std::optional<AnyDirEntry> readdir();
 
+	/**
+	 * @brief Moves to the given position in this directory.
+	 *
+	 * @param offset A position previously given by @ref telldir or
+	 *               @ref DirEntry::getNextOffset, or zero for the start of
+	 *               the directory.
+	 */
 	virtual void seekdir(std::size_t offset);
 
+	/**
+	 * @return The current position in this directory.
+	 */
 	virtual std::size_t telldir();
 };
 
@@ -211,7 +278,7 @@ public:
 	 *         considered stale.
 	 * @throws fuse_error if an error occurs.
 	 */
-	virtual double getattr(stat& statbuf);
+	virtual double getattr(struct stat& statbuf);
 
 	/**
 	 * @brief Determines the target of a symbolic link at this node.
@@ -404,15 +471,126 @@ public:
 
 };
 
+struct Mount1;
+
+int main(int argc, char *argv[], Mount1 *mount);
+
 struct Mount1 {
 
 	virtual ~Mount1() {}
 
 	virtual std::shared_ptr<Node1> get_node(path_t rel_path) = 0;
 
-};
+	/**
+	 * Called as the kernel connects to the filesystem, before @ref mounted,
+	 * to choose the parameters of the connection. Changes to the connection
+	 * are applied once this returns.
+	 * @param connection What the kernel and libfuse support, with what
+	 *                   libfuse uses by default wanted.
+	 * @throws std::exception to fail the mount, which @ref main then returns
+	 *                        1 for.
+	 */
+	virtual void init(Connection &) {}
 
-int main(int argc, char *argv[], Mount1 *mount);
+	/**
+	 * Called once the kernel has connected to the filesystem, before any
+	 * other operation is handled. Operations are handled only once this
+	 * returns, so anything here that goes through the mount point must be
+	 * left to another thread.
+	 * @throws std::exception to fail the mount, as for @ref init.
+	 */
+	virtual void mounted() {}
+
+	/**
+	 * @return The absolute path the filesystem is mounted on, or the empty
+	 *         string if it has not been mounted.
+	 */
+	std::string const & mountpoint() const {
+		return mountPoint;
+	}
+
+	/**
+	 * @return Whether the kernel is connected to the filesystem, and so may
+	 *         be sent notifications.
+	 */
+	bool connected() const {
+		return connection != nullptr;
+	}
+
+	/**
+	 * @return Options to mount the filesystem with, as given to `-o`, added to
+	 *         those given on the command line, or the empty string for none.
+	 */
+	virtual std::string options() const {
+		return std::string();
+	}
+
+	/**
+	 * @brief Pushes data into the kernel's page cache for a file.
+	 *
+	 * Later reads of the range are then served from memory without reaching
+	 * the filesystem. The kernel only keeps a cache for files it has looked
+	 * up, and drops it when the file is next opened unless the filesystem is
+	 * mounted with `-o kernel_cache` or the handle opened keeps the cache
+	 * (see @ref FileHandle1::keepCache).
+	 *
+	 * Like the other notifications, this finds the node id the kernel knows
+	 * the file by from its inode number through the mount point, which
+	 * libfuse numbers by node id unless mounted with `-o use_ino`. The path
+	 * may be looked up in doing so, which waits on the filesystem, so this
+	 * must not be called while handling an operation.
+	 *
+	 * @param path The path of the file.
+	 * @param offset The offset in the file the data starts at.
+	 * @param data The data, which is consumed.
+	 * @throws fuse_error ENOTCONN if the filesystem is not mounted, EOPNOTSUPP
+	 *                    if it is mounted with `-o use_ino`, as the file
+	 *                    fails to be looked up, or as the kernel rejects the
+	 *                    data.
+	 */
+	void notifyStore(path_t const & path, off_t offset, Buffer & data);
+
+	/**
+	 * @brief Drops a range of a file's data, and its attributes, from the
+	 * kernel's caches.
+	 *
+	 * @param path The path of the file.
+	 * @param offset The offset of the range to drop.
+	 * @param length The length of the range, or zero to drop everything from
+	 *               the offset on. A negative length drops only the attributes.
+	 * @throws fuse_error ENOTCONN if the filesystem is not mounted, EOPNOTSUPP
+	 *                    if it is mounted with `-o use_ino`, or as the file
+	 *                    fails to be looked up.
+	 */
+	void invalidateData(path_t const & path, off_t offset = 0, off_t length = 0);
+
+	/**
+	 * @brief Drops a directory entry from the kernel's caches, so that the
+	 * kernel looks it up afresh.
+	 *
+	 * @param path The path of the entry.
+	 * @throws fuse_error EINVAL for the root, which has no entry, ENOTCONN if
+	 *                    the filesystem is not mounted, EOPNOTSUPP if it is
+	 *                    mounted with `-o use_ino`, or as the entry's
+	 *                    directory fails to be looked up.
+	 */
+	void invalidateEntry(path_t const & path);
+
+private:
+	friend int main(int argc, char *argv[], Mount1 *mount);
+	friend bool negotiate(Mount1 & mount, ::fuse_conn_info & conn);
+
+	std::atomic<::fuse *> connection{nullptr};
+	std::string mountPoint;
+	bool ownInodes = false;
+	bool failed = false;
+
+	/**
+	 * @return The node id the kernel knows a path by.
+	 * @throws fuse_error as for @ref notifyStore.
+	 */
+	std::uint64_t nodeid(path_t const & path) const;
+};
 
 
 using Mount = Mount1;
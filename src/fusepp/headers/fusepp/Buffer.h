@@ -8,12 +8,18 @@
 #ifndef FUSEPP_BUFFER_H_
 #define FUSEPP_BUFFER_H_
 
+#include <cstdint>
 #include <memory>
 
+extern "C" {
+#include <sys/types.h>
+}
+
 namespace fusepp {
 
 class DataBuffer;
 class FileBuffer;
+class PipeBuffer;
 
 /**
  * Represents a container of binary data.
@@ -25,11 +31,8 @@ class FileBuffer;
  *     This is mutable for non-const instances.
  */
 class Buffer {
-	friend class DataBuffer;
-	friend class FileBuffer;
-	friend class AbstractBuffer;
-
-	Buffer();
+protected:
+	Buffer() {}
 
 public:
 	static const int defaultCopyFlags;
@@ -55,8 +58,10 @@ public:
  * A \ref Buffer whose container is a single contiguous region of binary data in memory.
  */
 class DataBuffer : public virtual Buffer {
+protected:
+	DataBuffer() {}
+
 public:
-	DataBuffer();
 
 	/**
 	 * Obtains a pointer to the beginning of buffer's memory region.
@@ -92,13 +97,25 @@ public:
 	 * @return A shared pointer to the newly-created DataBuffer.
 	 */
 	static std::shared_ptr<DataBuffer> create(void* mem, size_t length);
+
+	/**
+	 * Creates a new DataBuffer that wraps a region of memory belonging to a
+	 * shared object. No data is copied; the owner is kept alive for as long
+	 * as the buffer (or any compound buffer it is added to) exists.
+	 * @param owner The object owning the memory region.
+	 * @param mem A pointer to the beginning of the memory region.
+	 * @param length The number of bytes in the memory region.
+	 * @return A shared pointer to the newly-created DataBuffer.
+	 */
+	static std::shared_ptr<DataBuffer> create(std::shared_ptr<void> owner, void* mem, size_t length);
 };
 
 /**
  * A \ref Buffer whose container is a file or portion of a file on disk.
  */
 class FileBuffer : public virtual Buffer {
-	FileBuffer();
+protected:
+	FileBuffer() {}
 
 public:
 
@@ -107,6 +124,28 @@ public:
 	static std::shared_ptr<Buffer> create(int fd, off_t offset = 0, size_t length = SIZE_MAX);
 };
 
+/**
+ * A \ref Buffer whose container is a pipe, as when fuse hands on the data of
+ * a write in the pipe it spliced the data from the kernel into.
+ *
+ * The data in a pipe can only be consumed once, in order. Copying it into a
+ * \ref FileBuffer splices it from the pipe into the file, moving the pipe's
+ * pages rather than copying them where the kernel can (`SPLICE_F_MOVE`), so
+ * the data never passes through userspace memory. Copying it anywhere else
+ * reads it from the pipe.
+ */
+class PipeBuffer : public virtual Buffer {
+protected:
+	PipeBuffer() {}
+
+public:
+
+	/**
+	 * @return The descriptor of the read end of the pipe.
+	 */
+	virtual int getFD() const = 0;
+};
+
 /**
  * A \ref Buffer whose container is made up of a series of sub-containers.
  * Each sub-container can be a region of memory or a file or portion of a file.
@@ -127,6 +166,13 @@ public:
 	CompoundBufferBuilder& add(int fd, off_t offset = 0, size_t length = SIZE_MAX);
 	CompoundBufferBuilder& add(Buffer const & buf);
 
+	/**
+	 * Adds the sub-containers of the given buffer, keeping the buffer (and
+	 * hence any memory it holds a share of) alive until the built buffer is
+	 * destroyed.
+	 */
+	CompoundBufferBuilder& add(std::shared_ptr<Buffer> buf);
+
 	std::shared_ptr<Buffer> build();
 };
 
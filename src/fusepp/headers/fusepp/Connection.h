@@ -0,0 +1,103 @@
+/*
+ * Connection.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef FUSEPP_CONNECTION_H_
+#define FUSEPP_CONNECTION_H_
+
+namespace fusepp {
+
+/**
+ * The parameters of the connection between the kernel and a filesystem,
+ * negotiated as the filesystem is mounted (see @ref Mount1::init).
+ *
+ * Each optional feature is flagged in @ref capable if both the kernel and
+ * libfuse support it, and in @ref wanted if the filesystem is to use it.
+ * Wanting a feature that is not capable has no effect. Only the features of
+ * libfuse 2.9, which fusepp is built against, are described; later ones,
+ * such as the kernel's write-back cache, cannot be asked for.
+ */
+struct Connection {
+
+	/**
+	 * Optional features of the connection.
+	 */
+	struct Capabilities {
+		/**
+		 * Reads may be sent to the filesystem concurrently, and out of order.
+		 */
+		bool asyncRead = false;
+
+		bool posixLocks = false;
+		bool flockLocks = false;
+		bool atomicOTrunc = false;
+		bool exportSupport = false;
+		bool dontMask = false;
+		bool ioctlDir = false;
+
+		/**
+		 * Writes larger than a page may be sent at once.
+		 */
+		bool bigWrites = false;
+
+		/**
+		 * Read replies may be spliced into the kernel from descriptors.
+		 */
+		bool spliceWrite = false;
+
+		/**
+		 * Pages spliced into or out of the kernel may be moved, rather than
+		 * copied.
+		 */
+		bool spliceMove = false;
+
+		/**
+		 * The data of writes may be spliced out of the kernel into a pipe.
+		 */
+		bool spliceRead = false;
+	};
+
+	unsigned protocolMajor = 0;
+	unsigned protocolMinor = 0;
+
+	/**
+	 * The features both the kernel and libfuse support.
+	 */
+	Capabilities capable;
+
+	/**
+	 * The features to use, initially those libfuse uses by default.
+	 */
+	Capabilities wanted;
+
+	/**
+	 * The largest number of bytes written in one request, which may only be
+	 * lowered. libfuse 2.9 offers no more than its 128 KiB buffer holds.
+	 */
+	unsigned maxWrite = 0;
+
+	/**
+	 * The largest number of bytes the kernel reads ahead, which may only be
+	 * lowered.
+	 */
+	unsigned maxReadahead = 0;
+
+	/**
+	 * The most requests, such as reads ahead, that the kernel keeps
+	 * outstanding in the background.
+	 */
+	unsigned maxBackground = 0;
+
+	/**
+	 * The number of background requests outstanding at which the kernel
+	 * considers the filesystem congested.
+	 */
+	unsigned congestionThreshold = 0;
+};
+
+} // namespace fusepp
+
+#endif /* FUSEPP_CONNECTION_H_ */
@@ -24,7 +24,7 @@ struct DirEntry {
 	virtual std::string getName() const = 0;
 	virtual std::size_t getNextOffset() const = 0;
 	virtual std::optional<uint64_t> getIndexNumber() const {
-		return std::optional<uint64_t>;
+		return std::nullopt;
 	}
 	virtual unsigned char getType() const = 0;
 	virtual std::shared_ptr<Node1> lookupNode() = 0;
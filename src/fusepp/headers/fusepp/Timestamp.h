@@ -8,12 +8,14 @@
 #ifndef FUSEPP_TIMESTAMP_H_
 #define FUSEPP_TIMESTAMP_H_
 
+#include <ctime>
+
 namespace fusepp {
 
 struct Timestamp {
 	timespec times[2];
 
-	Timestamp(timespec times[2]) : times(times) {}
+	Timestamp(timespec const times[2]) : times{times[0], times[1]} {}
 
 	timespec& accessTime() {
 		return times[0];
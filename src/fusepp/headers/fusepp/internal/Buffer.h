@@ -11,7 +11,11 @@
 #include "fusepp/internal/cfuse.h"
 #include "fusepp/Buffer.h"
 
+#include <cstdlib>
 #include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
 
 namespace fusepp{
 
@@ -22,14 +26,6 @@ namespace fusepp{
 		return const_cast<ret>(static_cast<type const *>(this)->method());\
 	}
 
-template<typename Sig>
-auto unconst();
-
-template<typename T, typename R, R const (T::*F)()>
-inline auto unconst<R (T::*)()>() {
-	return const_cast<R>((static_cast<T const *>(this)->*F)());
-}
-
 namespace internal {
 
 struct AbstractBuffer : virtual Buffer {
@@ -42,28 +38,83 @@ struct AbstractBuffer : virtual Buffer {
 	void seek(off_t offset) override;
 
 protected:
-	virtual ::fuse_bufvec const & getBufvec() const;
+	virtual ::fuse_bufvec const & getBufvec() const = 0;
 	virtual UNCONST(AbstractBuffer, ::fuse_bufvec&, getBufvec,)
+
+	friend ::fuse_bufvec & bufvec(Buffer & buffer);
+	friend ::fuse_bufvec const & bufvec(Buffer const & buffer);
 };
 
+/**
+ * @return The bufvec underlying a buffer, for handing to fuse.
+ */
+inline ::fuse_bufvec & bufvec(Buffer & buffer) {
+	// Buffer is a virtual base, so cannot be cast down statically
+	return dynamic_cast<AbstractBuffer &>(buffer).getBufvec();
+}
+
+/**
+ * @return The bufvec underlying a buffer, for handing to fuse.
+ */
+inline ::fuse_bufvec const & bufvec(Buffer const & buffer) {
+	return dynamic_cast<AbstractBuffer const &>(buffer).getBufvec();
+}
+
+/**
+ * Frees a bufvec allocated with `malloc`, as fuse frees those it is given.
+ */
+struct BufvecDeleter {
+	void operator()(::fuse_bufvec * bufvec) const {
+		free(bufvec);
+	}
+};
+
+using BufvecPtr = unique_ptr<::fuse_bufvec, BufvecDeleter>;
+
 class DynamicBuffer : public virtual AbstractBuffer {
 protected:
-	unique_ptr<::fuse_bufvec> bufvec;
+	BufvecPtr bufvec;
+
+	/**
+	 * Objects owning memory referred to by the bufvec, which must not be
+	 * handed to fuse to free.
+	 */
+	std::vector<shared_ptr<void>> owners;
 
 public:
 	DynamicBuffer(std::function<void (::fuse_buf&)>&& bufSetup);
-	DynamicBuffer(unique_ptr<::fuse_bufvec>&& bufvec);
+	DynamicBuffer(BufvecPtr&& bufvec);
+	DynamicBuffer(BufvecPtr&& bufvec, std::vector<shared_ptr<void>>&& owners);
 	virtual ~DynamicBuffer(){}
 
 	::fuse_bufvec* extractBufvec() const;
 	::fuse_bufvec* releaseBufvec();
 
+	/**
+	 * @return true iff some of this buffer's memory is shared with other objects.
+	 */
+	bool isShared() const {
+		return !owners.empty();
+	}
+
+	/**
+	 * Creates a copy of this buffer's bufvec in which every memory region is
+	 * also copied, so that fuse may free them independently of their owners.
+	 */
+	::fuse_bufvec* copyBufvec() const;
+
 	::fuse_bufvec const & getBufvec() const override;
 };
 
 inline ::fuse_bufvec* extractBufvec(shared_ptr<Buffer> buffer) {
-	internal::DynamicBuffer* dyn = static_cast<internal::DynamicBuffer*>(buffer.get());
-	return buffer.unique() ? dyn->releaseBufvec() : dyn->extractBufvec();
+	// Buffer is a virtual base, so cannot be cast down statically
+	DynamicBuffer& dyn = dynamic_cast<DynamicBuffer&>(*buffer);
+	if(dyn.isShared()) {
+		// fuse frees the memory of each buffer it is given, so shared memory
+		// has to be copied once here at the boundary.
+		return dyn.copyBufvec();
+	}
+	return buffer.use_count() == 1 ? dyn.releaseBufvec() : dyn.extractBufvec();
 }
 
 class AbstractDataBuffer : public DataBuffer, public virtual AbstractBuffer {
@@ -81,6 +132,40 @@ public:
 	off_t position() const override;
 };
 
+/**
+ * A buffer over a bufvec belonging to someone else, such as the one fuse
+ * passes to `write_buf`, which must be neither freed nor kept.
+ */
+struct BorrowedBuffer : virtual AbstractBuffer {
+	::fuse_bufvec & bufvec;
+
+	explicit BorrowedBuffer(::fuse_bufvec & bufvec) : bufvec(bufvec) {}
+
+	::fuse_bufvec const & getBufvec() const override {
+		return bufvec;
+	}
+};
+
+/**
+ * A borrowed buffer whose only container is a pipe.
+ */
+struct BorrowedPipeBuffer : BorrowedBuffer, PipeBuffer {
+	using BorrowedBuffer::BorrowedBuffer;
+
+	int getFD() const override {
+		return bufvec.buf[0].fd;
+	}
+};
+
+/**
+ * @return true iff the only container of the given bufvec is a pipe. Fuse
+ *         marks descriptors it can seek within, which a pipe's never is.
+ */
+inline bool isPipe(::fuse_bufvec const & bufvec) {
+	return bufvec.count == 1 && (bufvec.buf[0].flags & FUSE_BUF_IS_FD)
+			&& !(bufvec.buf[0].flags & FUSE_BUF_FD_SEEK);
+}
+
 struct AutomaticDataBuffer : AbstractDataBuffer {
 	::fuse_bufvec bufvec;
 
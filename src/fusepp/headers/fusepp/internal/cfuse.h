@@ -13,5 +13,6 @@
 #endif
 
 #include <fuse/fuse.h>
+#include <fuse/fuse_lowlevel.h>
 
 #endif /* FUSEPP_INTERNAL_CFUSE_H_ */
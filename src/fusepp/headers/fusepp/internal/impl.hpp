@@ -38,6 +38,30 @@ inline path_t convert_path(char const *path) {
 	return path_t(path);
 }
 
+/**
+ * Finds the node id the kernel knows a path by, from the inode number libfuse
+ * gives it through the mount point.
+ * @param mountpoint The mount point.
+ * @param path The path, relative to the mount point.
+ * @return The node id.
+ * @throws fuse_error if the path cannot be looked up.
+ */
+std::uint64_t nodeid(std::string const & mountpoint, path_t const & path);
+
+/**
+ * @return The parameters of a connection as libfuse offers them.
+ */
+Connection read_connection(::fuse_conn_info const & conn);
+
+/**
+ * Applies the parameters chosen for a connection to what libfuse offered.
+ * Only capabilities on offer are wanted, and the largest writes and reads
+ * ahead are only ever lowered.
+ * @param connection The parameters chosen.
+ * @param conn What libfuse offered, which is updated.
+ */
+void apply_connection(Connection const & connection, ::fuse_conn_info & conn);
+
 template<typename T>
 	using Handle = std::enable_if_t<std::is_base_of<NodeHandle1, T>::value, T>;
 
@@ -271,11 +295,20 @@ struct with_mount1 {
 	 * @param fi Provides open flags and receives the resultant handle.
 	 */
 	static void open_real(char const * path, struct fuse_file_info * fi) {
-		set_handle<FileHandle1>(fi, get_node(path)->open(fi->flags));
+		set_file_handle(fi, get_node(path)->open(fi->flags));
 	}
 
 	static void create_real(char const * path, mode_t mode, struct fuse_file_info * fi) {
-		set_handle<FileHandle1>(fi, get_node(path)->createAndOpen(mode, fi->flags));
+		set_file_handle(fi, get_node(path)->createAndOpen(mode, fi->flags));
+	}
+
+	/**
+	 * Puts a newly-opened @ref FileHandle in the given @ref fuse_file_info
+	 * `fh` member, along with how the kernel should treat its cache.
+	 */
+	static void set_file_handle(struct fuse_file_info * fi, unique_ptr<FileHandle1> handle) {
+		fi->keep_cache = handle->keepCache();
+		set_handle<FileHandle1>(fi, std::move(handle));
 	}
 
 	/**
@@ -283,29 +316,41 @@ struct with_mount1 {
 	 * @param path Ignored
 	 * @param fi Contains the file handle to close/release.
 	 */
-	static void release_real(char const * path, struct fuse_file_info *fi) {
+	static void release_real(char const *, struct fuse_file_info *fi) {
 		NodeHandle1 *fh = get_handle<NodeHandle1>(fi);
 		delete fh;
 		fi->fh = (uintptr_t) nullptr;
 	}
 
 	static void opendir_real(char const * path, struct fuse_file_info *fi) {
-		DirHandle1 *dh = get_node(path)->opendir(fi->flags);
-		fi->fh = (uintptr_t) dh;
+		set_handle<DirHandle1>(fi, get_node(path)->opendir(fi->flags));
 	}
 
-	static void readdir_real(char const * path, void * buf,
+	/**
+	 * Fills the buffer with entries from the @ref DirHandle in the given
+	 * @ref fuse_file_info `fh` member, starting at the given offset. Each
+	 * entry is given its next offset, so that fuse can resume reading after
+	 * the last entry that fitted.
+	 */
+	static void readdir_real(char const *, void * buf,
 			fuse_fill_dir_t filler, off_t offset, struct fuse_file_info *fi){
 		DirHandle1* dh = get_handle<DirHandle1>(fi);
-		for(shared_ptr<DirEntryIterator> it = dh->readdir(); it; it = it->next()) {
-			DirEntry const & entry = it->get();
-			if(filler(buf, entry.getName(), &entry.getAttr(), 0)) {
-				throw fuse_error(ENOMEM);
+		dh->seekdir(offset);
+		while(std::optional<AnyDirEntry> entry = dh->readdir()) {
+			DirEntry const & e = **entry;
+			struct stat statbuf = {};
+			statbuf.st_mode = DTTOIF(e.getType());
+			if(std::optional<uint64_t> ino = e.getIndexNumber()) {
+				statbuf.st_ino = *ino;
+			}
+			if(filler(buf, e.getName().c_str(), &statbuf, e.getNextOffset())) {
+				// The buffer is full
+				break;
 			}
 		}
 	}
 
-	static void fsync_real(char const * path, int datasync, struct fuse_file_info *fi) {
+	static void fsync_real(char const *, int datasync, struct fuse_file_info *fi) {
 		get_handle<NodeHandle1>(fi)->fsync(datasync);
 	}
 
@@ -313,18 +358,28 @@ struct with_mount1 {
 		get_node(path)->truncate(newLength);
 	}
 
-	static void ftruncate_real(char const * path, off_t newLength, struct fuse_file_info *fi) {
+	static void ftruncate_real(char const *, off_t newLength, struct fuse_file_info *fi) {
 		get_handle<FileHandle1>(fi)->truncate(newLength);
 	}
 
-	static void read_buf_real(char const * path, struct fuse_bufvec **bufp, size_t size, off_t off,
+	static void read_buf_real(char const *, struct fuse_bufvec **bufp, size_t size, off_t off,
 			struct fuse_file_info * fi) {
 		shared_ptr<Buffer> buf = get_handle<FileHandle1>(fi)->read(size, off);
 		*bufp = extractBufvec(buf);
 	}
 
-	static int write_buf_real(char const * path, struct fuse_bufvec *buf, off_t offset, struct fuse_file_info *fi) {
-		DynamicBuffer buffer(unique_ptr<::fuse_bufvec>(buf, [](){}));
+	/**
+	 * Passes the data of a write to the @ref FileHandle in the given
+	 * @ref fuse_file_info `fh` member. The bufvec belongs to fuse, so is only
+	 * borrowed. If fuse spliced the data into a pipe, it is passed on as a
+	 * @ref PipeBuffer, so that the handle may splice it onwards.
+	 */
+	static int write_buf_real(char const *, struct fuse_bufvec *buf, off_t offset, struct fuse_file_info *fi) {
+		if(isPipe(*buf)) {
+			BorrowedPipeBuffer buffer(*buf);
+			return get_handle<FileHandle1>(fi)->write(buffer, offset);
+		}
+		BorrowedBuffer buffer(*buf);
 		return get_handle<FileHandle1>(fi)->write(buffer, offset);
 	}
 
@@ -332,8 +387,15 @@ struct with_mount1 {
 		get_node(path)->getattr(*statbuf);
 	}
 
+	/**
+	 * Copies the target of the symbolic link at a @ref node into the buffer,
+	 * truncated and null-terminated to fit, as fuse expects.
+	 */
 	static void readlink_real(char const * path, char * link, size_t size) {
-		get_node(path)->readlink(size).copy(link, size, 0);
+		if(size == 0) {
+			throw fuse_error(EINVAL);
+		}
+		link[get_node(path)->readlink(size).copy(link, size - 1, 0)] = '\0';
 	}
 
 	static int getxattr_real(char const * path, char const * name, char * value, size_t size) {
@@ -345,6 +407,53 @@ struct with_mount1 {
 		}
 	}
 
+	static void setxattr_real(char const * path, char const * name, char const * value, size_t size, int flags) {
+		AutomaticDataBuffer buffer(const_cast<char *>(value), size);
+		get_node(path)->setxattr(std::string(name), buffer, flags);
+	}
+
+	static int listxattr_real(char const * path, char * list, size_t size) {
+		if(size==0) {
+			return get_node(path)->xattrListSize();
+		} else {
+			AutomaticDataBuffer buffer(list, size);
+			return get_node(path)->listxattr(buffer);
+		}
+	}
+
+	static void removexattr_real(char const * path, char const * name) {
+		get_node(path)->removexattr(std::string(name));
+	}
+
+	static void statfs_real(char const * path, struct statvfs * statbuf) {
+		get_node(path)->statfs(*statbuf);
+	}
+
+	static void fgetattr_real(char const *, struct stat * statbuf, struct fuse_file_info *fi) {
+		get_handle<NodeHandle1>(fi)->getattr(*statbuf);
+	}
+
+	static void lock_real(char const *, struct fuse_file_info *fi, int cmd, struct flock * lock) {
+		get_handle<FileHandle1>(fi)->lock(cmd, *lock);
+	}
+
+	static void utimens_real(char const * path, struct timespec const tv[2]) {
+		Timestamp timestamp(tv);
+		get_node(path)->utime(timestamp);
+	}
+
+#if FUSE_VERSION >= FUSE_MAKE_VERSION(3, 4)
+	static ssize_t copy_file_range_real(char const *, struct fuse_file_info *fi_in, off_t offset_in,
+			char const *, struct fuse_file_info *fi_out, off_t offset_out, size_t size, int flags) {
+		try {
+			return get_handle<FileHandle1>(fi_in)->copyFileRange(offset_in,
+					*get_handle<FileHandle1>(fi_out), offset_out, size, flags);
+		} catch (fuse_error &fe) {
+			return -fe.error;
+		}
+	}
+#endif
+
 #define FORWARD(op, type) operations->op = P_CALL_AND_CATCH(&type::op)
 #define DEPRECATED(op) operations->op = NULL
 #define FORWARD_WRAP(op, wrapper) operations->op = P_CALL_AND_CATCH(&with_mount1<get_mount>::wrapper)
@@ -368,41 +477,40 @@ struct with_mount1 {
 		FORWARD_WRAP(open, open_real);
 		DEPRECATED(read);
 		DEPRECATED(write);
-		FORWARD(statfs, Node1); //@snr
+		FORWARD_WRAP(statfs, statfs_real);
 		FORWARD(flush, FileHandle1); //@snr
 		FORWARD_WRAP(release, release_real);
 		FORWARD_WRAP(fsync, fsync_real); //@snr
-		if(implementedOps & xattr) {
-			FORWARD(setxattr, Node1); //@snr
-			FORWARD(getxattr, Node1); //@snr
-			FORWARD(listxattr, Node1); //@snr
-			FORWARD(removexattr, Node1); //@snr
-		}
+		FORWARD_WRAP(setxattr, setxattr_real);
+		FORWARD_WRAP(getxattr, getxattr_real);
+		FORWARD_WRAP(listxattr, listxattr_real);
+		FORWARD_WRAP(removexattr, removexattr_real);
 		FORWARD_WRAP(opendir, opendir_real);
 		FORWARD_WRAP(readdir, readdir_real);
 		FORWARD_WRAP(releasedir, release_real);
 		FORWARD_WRAP(fsyncdir, fsync_real);
 		FORWARD(access, Node1); //@snr
 		FORWARD_WRAP(create, create_real);
-		if(implementedOps & ftruncate)
-			FORWARD(ftruncate, FileHandle1); //@snr
-		if(implementedOps & fgetattr)
-			FORWARD(fgetattr, NodeHandle1); //@snr
-		FORWARD_FH(lock, 0);
-		FORWARD(utimens, Node1); //@snr
+		FORWARD_WRAP(ftruncate, ftruncate_real);
+		FORWARD_WRAP(fgetattr, fgetattr_real);
+		FORWARD_WRAP(lock, lock_real);
+		FORWARD_WRAP(utimens, utimens_real);
 		// bmap
 		FORWARD_FH(ioctl, 2); //@snr
 		// poll
 		FORWARD_WRAP(write_buf, write_buf_real);
 		FORWARD_WRAP(read_buf, read_buf_real);
 		// flock
-		// fallocate
+		FORWARD_FH(fallocate, 3);
+#if FUSE_VERSION >= FUSE_MAKE_VERSION(3, 4)
+		operations->copy_file_range = &with_mount1<get_mount>::copy_file_range_real;
+#endif
 
 		// flag_nullpath_ok
 		// flag_nopath
 		// flag_utime_omit_ok
 
-		// init?
+		// init is bound by fusepp::main, which negotiates the connection
 		// destroy?
 	}
 
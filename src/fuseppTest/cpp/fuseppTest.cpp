@@ -16,10 +16,19 @@
 
 #include "fusepp/internal/using_std.h"
 
+#include <functional>
+
+extern "C" {
+	#include <fcntl.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+}
+
 using namespace fusepp;
 using namespace fusepp::testing;
 
 using ::testing::_;
+using ::testing::DoAll;
 using ::testing::Return;
 using ::testing::Throw;
 
@@ -28,7 +37,7 @@ public:
 	MockMount mount;
 	MockNode node{"dummy"};
 	MockFileHandle fileHandle;
-	fuse_operations operations;
+	fuse_operations operations = {};
 
 private:
 	shared_ptr<Node> pNode{&node, [](MockNode*){}};
@@ -55,25 +64,25 @@ public:
 	EXPECT_CALL(node, method)
 
 ACTION_P(SetStatNlink, n) {
-	arg0->st_nlink = n;
+	arg0.st_nlink = n;
 }
 
 TEST_F(FuseppBindings, forwardsDirectOperationsToNode) {
-	struct stat statbuf;
+	struct stat statbuf = {};
 
-	EXPECT_NODE_CALL(getattr(&statbuf))
+	EXPECT_NODE_CALL(getattr(_))
 			.Times(1)
-			.WillOnce(SetStatNlink(17));
+			.WillOnce(DoAll(SetStatNlink(17), Return(1.0)));
 
 	EXPECT_EQ(0, operations.getattr("hello", &statbuf));
-	EXPECT_EQ(17, statbuf.st_nlink);
+	EXPECT_EQ(17u, statbuf.st_nlink);
 }
 
 TEST_F(FuseppBindings, convertsErrorsToErrorCodes) {
 	char link[20];
 	size_t size = 20;
 
-	EXPECT_NODE_CALL(readlink(link, size))
+	EXPECT_NODE_CALL(readlink(_))
 			.Times(1)
 			.WillOnce(Throw(fuse_error(3)));
 
@@ -113,23 +122,37 @@ TEST_F(FuseppBindings, forwardsLinkOperationsToNode) {
 }
 
 TEST_F(FuseppBindings, openPutsFileHandleInFileInfo) {
-	struct fuse_file_info info;
+	struct fuse_file_info info = {};
+
+	EXPECT_NODE_CALL(openHandle(info.flags))
+			.Times(1)
+			.WillOnce(Return(&fileHandle));
+
+	EXPECT_EQ(0, operations.open("Hello", &info));
+	EXPECT_EQ(&fileHandle, (void*) info.fh);
+}
 
-	EXPECT_NODE_CALL(open(info.flags))
+TEST_F(FuseppBindings, openLeavesKeepCacheToTheHandle) {
+	struct fuse_file_info info = {};
+	info.keep_cache = 1;
+
+	EXPECT_NODE_CALL(openHandle(info.flags))
 			.Times(1)
 			.WillOnce(Return(&fileHandle));
 
+	// The kernel's cache is dropped, as the handle does not keep it
 	EXPECT_EQ(0, operations.open("Hello", &info));
 	EXPECT_EQ(&fileHandle, (void*) info.fh);
+	EXPECT_EQ(0u, info.keep_cache);
 }
 
 TEST_F(FuseppBindings, forwardsFHOperationsToFileHandle) {
 
-	struct fuse_file_info info;
+	struct fuse_file_info info = {};
 	info.fh = (uint64_t) &fileHandle;
 
 	char mem[10];
-	shared_ptr<Buffer> buffer = Buffer::create(mem, 10);
+	shared_ptr<Buffer> buffer = DataBuffer::create(mem, 10);
 
 	struct fuse_bufvec* bv = nullptr;
 
@@ -140,7 +163,132 @@ TEST_F(FuseppBindings, forwardsFHOperationsToFileHandle) {
 	int res = operations.read_buf("Hello", &bv, 20, 0, &info);
 	EXPECT_EQ(0, res);
 	ASSERT_NE(nullptr, bv);
-	unique_ptr<fuse_bufvec> dispose(bv);
-	ASSERT_EQ(1, bv->count);
+	internal::BufvecPtr dispose(bv);
+	ASSERT_EQ(1u, bv->count);
 	EXPECT_EQ(mem, bv->buf->mem);
 }
+
+/**
+ * @return The error a call throws, or zero if it throws none.
+ */
+static int error_of(std::function<void()> const & call) {
+	try {
+		call();
+	} catch(fuse_error const & e) {
+		return e.error;
+	}
+	return 0;
+}
+
+TEST(FuseppNotifications, notifyStoreFailsUnlessMounted) {
+	MockMount mount;
+	char mem[10] = {};
+	shared_ptr<Buffer> data = DataBuffer::create(mem, 10);
+
+	EXPECT_EQ(ENOTCONN, error_of([&]() { mount.notifyStore("/hello", 0, *data); }));
+}
+
+TEST(FuseppNotifications, invalidateDataFailsUnlessMounted) {
+	MockMount mount;
+
+	EXPECT_EQ(ENOTCONN, error_of([&]() { mount.invalidateData("/hello"); }));
+	EXPECT_EQ(ENOTCONN, error_of([&]() { mount.invalidateData("/hello", 4096, -1); }));
+}
+
+TEST(FuseppNotifications, invalidateEntryFailsUnlessMounted) {
+	MockMount mount;
+
+	EXPECT_EQ(ENOTCONN, error_of([&]() { mount.invalidateEntry("/hello"); }));
+	EXPECT_EQ(ENOTCONN, error_of([&]() { mount.invalidateEntry("/dir/hello"); }));
+	// The root has no entry to drop, mounted or not
+	EXPECT_EQ(EINVAL, error_of([&]() { mount.invalidateEntry("/"); }));
+}
+
+TEST(FuseppNotifications, resolvesNodeIdsThroughTheMountPoint) {
+	char dir[] = "/tmp/fuseppTest.XXXXXX";
+	ASSERT_NE(nullptr, ::mkdtemp(dir));
+	std::string file = std::string(dir) + "/hello";
+	int fd = ::open(file.c_str(), O_CREAT | O_WRONLY, 0644);
+	ASSERT_LE(0, fd);
+	::close(fd);
+
+	struct stat dirStat, fileStat;
+	ASSERT_EQ(0, ::stat(dir, &dirStat));
+	ASSERT_EQ(0, ::stat(file.c_str(), &fileStat));
+
+	EXPECT_EQ(fileStat.st_ino, internal::nodeid(dir, "/hello"));
+	EXPECT_EQ(dirStat.st_ino, internal::nodeid(dir, "/"));
+	EXPECT_EQ(ENOENT, error_of([&]() { internal::nodeid(dir, "/missing"); }));
+
+	::unlink(file.c_str());
+	::rmdir(dir);
+}
+
+/**
+ * @return A connection as libfuse might offer it.
+ */
+static ::fuse_conn_info offered_connection() {
+	::fuse_conn_info conn = {};
+	conn.proto_major = 7;
+	conn.proto_minor = 26;
+	conn.capable = FUSE_CAP_ASYNC_READ | FUSE_CAP_BIG_WRITES | FUSE_CAP_SPLICE_READ;
+	// As libfuse 2.9 asks for asynchronous reads by default
+	conn.async_read = 1;
+	conn.max_write = 128 * 1024;
+	conn.max_readahead = 128 * 1024;
+	conn.max_background = 12;
+	conn.congestion_threshold = 9;
+	return conn;
+}
+
+TEST(FuseppConnection, readsWhatLibfuseOffers) {
+	Connection connection = internal::read_connection(offered_connection());
+
+	EXPECT_EQ(7u, connection.protocolMajor);
+	EXPECT_EQ(26u, connection.protocolMinor);
+	EXPECT_TRUE(connection.capable.asyncRead);
+	EXPECT_TRUE(connection.capable.bigWrites);
+	EXPECT_TRUE(connection.capable.spliceRead);
+	EXPECT_FALSE(connection.capable.posixLocks);
+	EXPECT_TRUE(connection.wanted.asyncRead);
+	EXPECT_FALSE(connection.wanted.bigWrites);
+	EXPECT_EQ(128u * 1024, connection.maxWrite);
+	EXPECT_EQ(128u * 1024, connection.maxReadahead);
+	EXPECT_EQ(12u, connection.maxBackground);
+	EXPECT_EQ(9u, connection.congestionThreshold);
+}
+
+TEST(FuseppConnection, appliesOnlyWhatLibfuseAllows) {
+	::fuse_conn_info conn = offered_connection();
+	Connection connection = internal::read_connection(conn);
+	connection.wanted.asyncRead = false;
+	connection.wanted.bigWrites = true;
+	connection.wanted.posixLocks = true;
+	connection.maxWrite = 1024 * 1024;
+	connection.maxReadahead = 1024 * 1024;
+	connection.maxBackground = 32;
+	connection.congestionThreshold = 24;
+
+	internal::apply_connection(connection, conn);
+
+	// Locks are not on offer, and larger requests than libfuse's are not made
+	EXPECT_EQ(unsigned(FUSE_CAP_BIG_WRITES), conn.want);
+	EXPECT_EQ(0u, conn.async_read);
+	EXPECT_EQ(128u * 1024, conn.max_write);
+	EXPECT_EQ(128u * 1024, conn.max_readahead);
+	EXPECT_EQ(32u, conn.max_background);
+	EXPECT_EQ(24u, conn.congestion_threshold);
+
+	connection.maxWrite = 64 * 1024;
+	connection.maxReadahead = 32 * 1024;
+	internal::apply_connection(connection, conn);
+
+	EXPECT_EQ(64u * 1024, conn.max_write);
+	EXPECT_EQ(32u * 1024, conn.max_readahead);
+
+	connection.wanted.asyncRead = true;
+	internal::apply_connection(connection, conn);
+
+	EXPECT_EQ(unsigned(FUSE_CAP_ASYNC_READ | FUSE_CAP_BIG_WRITES), conn.want);
+	EXPECT_EQ(1u, conn.async_read);
+}
@@ -12,7 +12,7 @@ public:
 	virtual ~MockNodeHandle();
 
 	MOCK_METHOD1(getattr,
-			void(struct stat *statbuf));
+			void(struct stat& statbuf));
 	MOCK_METHOD1(fsync,
 			void(bool datasync));
 	MOCK_METHOD4(ioctl,
@@ -27,16 +27,16 @@ public:
 	MOCK_METHOD2(read,
 			std::shared_ptr<Buffer>(size_t nbytes, off_t offset));
 	MOCK_METHOD2(write,
-			int(Buffer& buffer, off_t offset));
+			size_t(Buffer& buffer, off_t offset));
 	MOCK_METHOD0(flush,
 			void());
 	MOCK_METHOD2(lock,
-			void(int cmd, struct flock * flock));
+			void(int cmd, struct flock& flock));
 	MOCK_METHOD1(truncate,
 			void(off_t newLength));
 
 	MOCK_METHOD1(getattr,
-			void(struct stat *statbuf));
+			void(struct stat& statbuf));
 	MOCK_METHOD1(fsync,
 			void(bool datasync));
 	MOCK_METHOD4(ioctl,
@@ -48,11 +48,15 @@ public:
 	MockDirHandle();
 	virtual ~MockDirHandle();
 
-	MOCK_METHOD1(readdir,
-			struct dirent*(struct dirent * entry));
+	MOCK_METHOD0(readdir,
+			std::optional<AnyDirEntry>());
+	MOCK_METHOD1(seekdir,
+			void(std::size_t offset));
+	MOCK_METHOD0(telldir,
+			std::size_t());
 
 	MOCK_METHOD1(getattr,
-			void(struct stat *statbuf));
+			void(struct stat& statbuf));
 	MOCK_METHOD1(fsync,
 			void(bool datasync));
 	MOCK_METHOD4(ioctl,
@@ -65,9 +69,9 @@ public:
 	virtual ~MockNode();
 
 	MOCK_METHOD1(getattr,
-			void(struct stat *statbuf));
-	MOCK_METHOD2(readlink,
-			void(char *link, size_t size));
+			double(struct stat& statbuf));
+	MOCK_METHOD1(readlink,
+			path_t(size_t size));
 	MOCK_METHOD1(mkfifo,
 			void(mode_t mode));
 	MOCK_METHOD2(mknod,
@@ -88,28 +92,47 @@ public:
 			void(mode_t mode));
 	MOCK_METHOD2(chown,
 			void(uid_t uid, gid_t gid));
-	MOCK_METHOD1(open,
-			FileHandle1*(int flags));
-	MOCK_METHOD2(createAndOpen,
-			FileHandle1*(mode_t mode, int flags));
 	MOCK_METHOD1(statfs,
-			void(struct statvfs * statbuf));
-	MOCK_METHOD4(setxattr,
-			void(char const * name, char const * value, size_t size, int flags));
-	MOCK_METHOD3(getxattr,
-			int(char const * name, char * buf, size_t size));
-	MOCK_METHOD2(listxattr,
-			int(char * buf, size_t size));
+			void(struct statvfs& statbuf));
+	MOCK_METHOD3(setxattr,
+			void(std::string const name, DataBuffer const & value, int flags));
+	MOCK_METHOD1(xattrSize,
+			size_t(std::string const name));
+	MOCK_METHOD2(getxattr,
+			size_t(std::string const name, DataBuffer& buffer));
+	MOCK_METHOD0(xattrListSize,
+			size_t());
+	MOCK_METHOD1(listxattr,
+			size_t(DataBuffer& buffer));
 	MOCK_METHOD1(removexattr,
-			void(char const * name));
+			void(std::string const name));
 	MOCK_METHOD1(truncate,
 			void(off_t newLength));
-	MOCK_METHOD1(opendir,
-			DirHandle1*(int flags));
 	MOCK_METHOD1(access,
 			void(int mode));
-	MOCK_METHOD1(utimens,
-			void(struct timespec const tv[2]));
+	MOCK_METHOD1(utime,
+			void(Timestamp& timestamp));
+
+	// gmock cannot return the handles, which are move-only, so these
+	// return raw pointers that the overrides below take ownership of
+	MOCK_METHOD1(openHandle,
+			FileHandle1*(int flags));
+	MOCK_METHOD2(createAndOpenHandle,
+			FileHandle1*(mode_t mode, int flags));
+	MOCK_METHOD1(opendirHandle,
+			DirHandle1*(int flags));
+
+	std::unique_ptr<FileHandle1> open(int flags) override {
+		return std::unique_ptr<FileHandle1>(openHandle(flags));
+	}
+
+	std::unique_ptr<FileHandle1> createAndOpen(mode_t mode, int flags) override {
+		return std::unique_ptr<FileHandle1>(createAndOpenHandle(mode, flags));
+	}
+
+	std::unique_ptr<DirHandle1> opendir(int flags) override {
+		return std::unique_ptr<DirHandle1>(opendirHandle(flags));
+	}
 };
 
 class MockMount : public virtual Mount {
@@ -0,0 +1,273 @@
+/*
+ * BackingFile.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#include "smfs/BackingFile.h"
+
+#include <fusepp/util.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+extern "C" {
+	#include <sys/resource.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+}
+
+namespace smfs {
+
+static std::atomic<BackingFile::id_type> nextId{1};
+
+struct OpenedBackingFile : BackingFile {
+	bool const writable;
+
+	OpenedBackingFile(std::string const & path, int fd, bool writable)
+			: BackingFile(path, fd), writable(writable) {}
+
+	bool growable() const override {
+		return writable;
+	}
+};
+
+namespace {
+
+/**
+ * An open descriptor, closed once nothing uses it.
+ */
+struct Descriptor {
+	int const fd;
+
+	explicit Descriptor(int fd) : fd(fd) {}
+
+	~Descriptor() {
+		::close(fd);
+	}
+};
+
+/**
+ * The descriptors of lazily-opened backing files, of which only so many are
+ * kept open, the least recently used being closed first. A descriptor in use
+ * when it is dropped stays open until its user is done with it.
+ */
+class DescriptorCache {
+	using Entry = std::pair<BackingFile::id_type, std::shared_ptr<Descriptor>>;
+
+	std::mutex mutex;
+	std::size_t const capacity;
+
+	/**
+	 * The open descriptors, most recently used first.
+	 */
+	std::list<Entry> recent;
+	std::unordered_map<BackingFile::id_type, std::list<Entry>::iterator> index;
+
+public:
+
+	/**
+	 * Constructor for DescriptorCache. Keeps open a quarter of the descriptors
+	 * the process may have, leaving the rest for everything else.
+	 */
+	DescriptorCache() : capacity(limit()) {}
+
+	std::shared_ptr<Descriptor> get(BackingFile const & file) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			auto found = index.find(file.id);
+			if(found != index.end()) {
+				recent.splice(recent.begin(), recent, found->second);
+				return found->second->second;
+			}
+		}
+		// Opened unlocked, so a slow open holds up no one else
+		auto descriptor = std::make_shared<Descriptor>(
+				fusepp::check_ret(::open(file.path.c_str(), O_RDONLY | O_CLOEXEC)));
+		std::lock_guard<std::mutex> lock(mutex);
+		auto found = index.find(file.id);
+		if(found != index.end()) {
+			// Opened by another reader meanwhile
+			return found->second->second;
+		}
+		recent.emplace_front(file.id, descriptor);
+		index.emplace(file.id, recent.begin());
+		while(recent.size() > capacity) {
+			index.erase(recent.back().first);
+			recent.pop_back();
+		}
+		return descriptor;
+	}
+
+	void drop(BackingFile::id_type id) {
+		std::lock_guard<std::mutex> lock(mutex);
+		auto found = index.find(id);
+		if(found != index.end()) {
+			recent.erase(found->second);
+			index.erase(found);
+		}
+	}
+
+	static DescriptorCache & shared() {
+		static DescriptorCache cache;
+		return cache;
+	}
+
+private:
+	static std::size_t limit() {
+		struct rlimit rl;
+		if(::getrlimit(RLIMIT_NOFILE, &rl) != 0 || rl.rlim_cur == RLIM_INFINITY) {
+			return 1024;
+		}
+		return std::max<std::size_t>(16, rl.rlim_cur / 4);
+	}
+};
+
+/**
+ * A backing file opened only while it is being read.
+ */
+struct LazyBackingFile : BackingFile {
+	LazyBackingFile(std::string const & path) : BackingFile(path, -1) {}
+
+	~LazyBackingFile() {
+		DescriptorCache::shared().drop(id);
+	}
+
+	bool hasRawDescriptor() const override {
+		return false;
+	}
+
+	int duplicate() const override {
+		return fusepp::check_ret(::fcntl(DescriptorCache::shared().get(*this)->fd, F_DUPFD_CLOEXEC, 0));
+	}
+
+	off_t size() const override {
+		struct stat statbuf;
+		fusepp::check_ret(::fstat(DescriptorCache::shared().get(*this)->fd, &statbuf));
+		return statbuf.st_size;
+	}
+
+protected:
+	std::size_t readUnchecked(void * buf, std::size_t nbytes, off_t offset) const override {
+		return readFrom(DescriptorCache::shared().get(*this)->fd, buf, nbytes, offset);
+	}
+};
+
+} // namespace
+
+std::shared_ptr<BackingFile> BackingFile::open(std::string const & path, int flags) {
+	int fd = fusepp::check_ret(::open(path.c_str(), flags | O_CLOEXEC));
+	return std::make_shared<OpenedBackingFile>(path, fd, (flags & O_ACCMODE) != O_RDONLY);
+}
+
+std::shared_ptr<BackingFile> BackingFile::openLazily(std::string const & path) {
+	return std::make_shared<LazyBackingFile>(path);
+}
+
+BackingFile::BackingFile(std::string const & path, int fd)
+		: id(nextId++), path(path), descriptor(fd) {}
+
+BackingFile::~BackingFile() {
+	if(descriptor >= 0) {
+		::close(descriptor);
+	}
+}
+
+int BackingFile::duplicate() const {
+	return fusepp::check_ret(::fcntl(descriptor, F_DUPFD_CLOEXEC, 0));
+}
+
+off_t BackingFile::size() const {
+	struct stat statbuf;
+	fusepp::check_ret(::fstat(descriptor, &statbuf));
+	return statbuf.st_size;
+}
+
+std::size_t BackingFile::read(void * buf, std::size_t nbytes, off_t offset) const {
+	std::size_t rc = readUnchecked(buf, nbytes, offset);
+	if(blockChecksums) {
+		verifyRead(buf, rc, offset);
+	}
+	return rc;
+}
+
+std::size_t BackingFile::readUnchecked(void * buf, std::size_t nbytes, off_t offset) const {
+	return readFrom(descriptor, buf, nbytes, offset);
+}
+
+std::size_t BackingFile::readFrom(int descriptor, void * buf, std::size_t nbytes, off_t offset) {
+	char * mem = static_cast<char *>(buf);
+	std::size_t total = 0;
+	while(total < nbytes) {
+		ssize_t rc = ::pread(descriptor, mem + total, nbytes - total, offset + total);
+		if(rc < 0) {
+			if(errno == EINTR) {
+				continue;
+			}
+			throw fusepp::fuse_error::from_errno();
+		}
+		if(rc == 0) {
+			break;
+		}
+		total += rc;
+	}
+	return total;
+}
+
+void BackingFile::verifyRead(void const * buf, std::size_t nbytes, off_t offset) const {
+	BlockChecksums const & sums = *blockChecksums;
+	off_t end = std::min<off_t>(offset + nbytes, sums.size());
+	std::unique_ptr<unsigned char[]> scratch;
+	for(off_t position = offset; position < end;) {
+		std::size_t block = position / sums.blockSize();
+		off_t blockStart = static_cast<off_t>(block) * sums.blockSize();
+		off_t blockEnd = blockStart + sums.blockLengthAt(block);
+		if(!sums.verified(block)) {
+			if(blockStart >= offset && blockEnd <= offset + static_cast<off_t>(nbytes)) {
+				sums.check(block, static_cast<unsigned char const *>(buf) + (blockStart - offset));
+			} else {
+				// Only part of the block was read, so read the rest to check it
+				if(!scratch) {
+					scratch.reset(new unsigned char[sums.blockSize()]);
+				}
+				verifyBlock(block, scratch.get());
+			}
+		}
+		position = blockEnd;
+	}
+}
+
+void BackingFile::verify(off_t offset, std::size_t nbytes) const {
+	if(!blockChecksums) {
+		return;
+	}
+	BlockChecksums const & sums = *blockChecksums;
+	off_t end = std::min<off_t>(offset + nbytes, sums.size());
+	std::unique_ptr<unsigned char[]> scratch;
+	for(off_t position = offset - offset % sums.blockSize(); position < end; position += sums.blockSize()) {
+		std::size_t block = position / sums.blockSize();
+		if(!sums.verified(block)) {
+			if(!scratch) {
+				scratch.reset(new unsigned char[sums.blockSize()]);
+			}
+			verifyBlock(block, scratch.get());
+		}
+	}
+}
+
+void BackingFile::verifyBlock(std::size_t block, void * buffer) const {
+	BlockChecksums const & sums = *blockChecksums;
+	std::size_t length = sums.blockLengthAt(block);
+	if(readUnchecked(buffer, length, static_cast<off_t>(block) * sums.blockSize()) != length) {
+		// The file has been truncated since it was checksummed
+		throw fusepp::fuse_error(EIO);
+	}
+	sums.check(block, buffer);
+}
+
+} // namespace smfs
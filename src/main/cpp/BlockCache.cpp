@@ -0,0 +1,160 @@
+/*
+ * BlockCache.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#include "smfs/BlockCache.h"
+#include "smfs/StatsLine.h"
+
+#include <fusepp/common.hpp>
+
+
+namespace smfs {
+
+BlockCache::BlockCache(std::size_t budget, std::size_t blockSize)
+		: byteBudget(budget),
+		  blockLength(blockSize),
+		  inBudget(budget / 4),
+		  ghostCapacity(budget / blockSize / 2) {
+	if(blockSize == 0) {
+		throw fusepp::fuse_error(EINVAL);
+	}
+}
+
+std::shared_ptr<Block> BlockCache::get(BackingFile const & file, off_t offset) {
+	if(file.growable()) {
+		std::shared_ptr<Block> block = std::make_shared<Block>(blockLength);
+		block->resize(file.read(block->data(), blockLength, offset));
+		return block;
+	}
+
+	BlockKey key{file.id, offset};
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if(std::shared_ptr<Block> block = lookup(key)) {
+			++counters.hits;
+			counters.bytesSaved += block->size();
+			return block;
+		}
+		++counters.misses;
+	}
+
+	bool leader = false;
+	std::shared_ptr<Block> block = fills.run(key, [&]() {
+		leader = true;
+		return fetch(file, key);
+	});
+	if(!leader) {
+		std::lock_guard<std::mutex> lock(mutex);
+		++counters.coalesced;
+		counters.bytesSaved += block->size();
+	}
+	return block;
+}
+
+std::shared_ptr<Block> BlockCache::fetch(BackingFile const & file, BlockKey const & key) {
+	{
+		// The block may have been filled since our lookup, by a flight that
+		// landed before we joined
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = index.find(key);
+		if(it != index.end() && it->second.queue != Queue::ghost) {
+			return it->second.block;
+		}
+	}
+
+	// Read outside the lock, so that hits are not held up behind slow storage
+	std::shared_ptr<Block> block = std::make_shared<Block>(blockLength);
+	block->resize(file.read(block->data(), blockLength, key.offset));
+
+	std::lock_guard<std::mutex> lock(mutex);
+	counters.bytesFetched += block->size();
+	return insert(key, std::move(block));
+}
+
+std::string BlockCache::Stats::toString() const {
+	return StatsLine().count("hits", hits).count("misses", misses).count("coalesced", coalesced)
+			.ratio("hit_ratio", hitRatio(), 4).count("bytes_saved", bytesSaved)
+			.count("bytes_fetched", bytesFetched).count("evictions", evictions).str();
+}
+
+BlockCache::Stats BlockCache::stats() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return counters;
+}
+
+std::shared_ptr<Block> BlockCache::lookup(BlockKey const & key) {
+	auto it = index.find(key);
+	if(it == index.end()) {
+		return nullptr;
+	}
+	Entry &entry = it->second;
+	switch(entry.queue) {
+	case Queue::main:
+		mainQueue.splice(mainQueue.begin(), mainQueue, entry.pos);
+		return entry.block;
+	case Queue::in:
+		// Re-references while in the FIFO are assumed to be correlated
+		// (e.g. a sequential reader), so do not count towards promotion.
+		return entry.block;
+	default:
+		return nullptr;
+	}
+}
+
+std::shared_ptr<Block> BlockCache::insert(BlockKey const & key, std::shared_ptr<Block> block) {
+	auto it = index.find(key);
+	if(it != index.end() && it->second.queue != Queue::ghost) {
+		// Another reader fetched the same block while we were reading it
+		return it->second.block;
+	}
+
+	if(block->size() > byteBudget) {
+		return block;
+	}
+
+	if(it != index.end()) {
+		// Recently evicted from the FIFO, so it's part of the working set
+		Entry &entry = it->second;
+		ghostQueue.erase(entry.pos);
+		mainQueue.push_front(key);
+		entry.block = block;
+		entry.queue = Queue::main;
+		entry.pos = mainQueue.begin();
+		mainBytes += block->size();
+	} else {
+		inQueue.push_front(key);
+		index.emplace(key, Entry{block, Queue::in, inQueue.begin()});
+		inBytes += block->size();
+	}
+
+	evict();
+	return block;
+}
+
+void BlockCache::evict() {
+	while(inBytes + mainBytes > byteBudget) {
+		if(!inQueue.empty() && (inBytes > inBudget || mainQueue.empty())) {
+			Entry &entry = index.at(inQueue.back());
+			inBytes -= entry.block->size();
+			entry.block.reset();
+			entry.queue = Queue::ghost;
+			ghostQueue.splice(ghostQueue.begin(), inQueue, entry.pos);
+		} else {
+			Entry &entry = index.at(mainQueue.back());
+			mainBytes -= entry.block->size();
+			index.erase(mainQueue.back());
+			mainQueue.pop_back();
+		}
+		++counters.evictions;
+	}
+
+	while(ghostQueue.size() > ghostCapacity) {
+		index.erase(ghostQueue.back());
+		ghostQueue.pop_back();
+	}
+}
+
+} // namespace smfs
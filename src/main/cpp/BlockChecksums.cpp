@@ -0,0 +1,62 @@
+/*
+ * BlockChecksums.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "smfs/BlockChecksums.h"
+#include "smfs/BackingFile.h"
+#include "smfs/Crc32c.h"
+
+#include <fusepp/common.hpp>
+
+namespace smfs {
+
+BlockChecksums::BlockChecksums(std::size_t blockSize, off_t size, std::vector<std::uint32_t> crcs)
+		: blockLength(blockSize), length(size), crcs(std::move(crcs)),
+		  verifiedBits(new std::atomic<std::uint64_t>[(this->crcs.size() + 63) / 64]()) {
+	if(!blockSize || size < 0 || this->crcs.size() != (static_cast<std::uint64_t>(size) + blockSize - 1) / blockSize) {
+		throw fusepp::fuse_error(EINVAL);
+	}
+}
+
+std::shared_ptr<BlockChecksums> BlockChecksums::compute(BackingFile const & file, std::size_t blockSize) {
+	if(!blockSize) {
+		throw fusepp::fuse_error(EINVAL);
+	}
+	std::unique_ptr<unsigned char[]> buffer(new unsigned char[blockSize]);
+	std::vector<std::uint32_t> crcs;
+	off_t size = 0;
+	while(true) {
+		std::size_t n = file.read(buffer.get(), blockSize, size);
+		if(!n) {
+			break;
+		}
+		crcs.push_back(crc32c(buffer.get(), n));
+		size += n;
+		if(n < blockSize) {
+			break;
+		}
+	}
+	return std::make_shared<BlockChecksums>(blockSize, size, std::move(crcs));
+}
+
+std::size_t BlockChecksums::verifiedCount() const {
+	std::size_t rc = 0;
+	for(std::size_t i = 0; i < (crcs.size() + 63) / 64; ++i) {
+		rc += __builtin_popcountll(verifiedBits[i].load(std::memory_order_relaxed));
+	}
+	return rc;
+}
+
+void BlockChecksums::check(std::size_t block, void const * data) const {
+	std::uint64_t bit = std::uint64_t(1) << (block % 64);
+	if(crc32c(data, blockLengthAt(block)) != crcs[block]) {
+		verifiedBits[block / 64].fetch_and(~bit, std::memory_order_release);
+		throw fusepp::fuse_error(EIO);
+	}
+	verifiedBits[block / 64].fetch_or(bit, std::memory_order_release);
+}
+
+} // namespace smfs
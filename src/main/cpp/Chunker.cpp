@@ -0,0 +1,190 @@
+/*
+ * Chunker.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "smfs/Chunker.h"
+
+#include <fusepp/common.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
+
+namespace smfs {
+
+namespace {
+
+constexpr std::uint64_t splitmix64(std::uint64_t &state) {
+	std::uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+	return z ^ (z >> 31);
+}
+
+constexpr std::array<std::uint64_t, 256> makeGear() {
+	std::array<std::uint64_t, 256> rc{};
+	std::uint64_t state = 0x736d66736764636cull;
+	for(std::size_t i = 0; i < rc.size(); ++i) {
+		rc[i] = splitmix64(state);
+	}
+	return rc;
+}
+
+/**
+ * The random value added to the hash for each byte value. Changing this
+ * changes every chunk boundary.
+ */
+constexpr std::array<std::uint64_t, 256> gear = makeGear();
+
+constexpr std::uint64_t topBits(unsigned bits) {
+	return ~std::uint64_t(0) << (64 - bits);
+}
+
+unsigned log2(std::size_t n) {
+	unsigned rc = 0;
+	while(n >>= 1) {
+		++rc;
+	}
+	return rc;
+}
+
+std::size_t checkedAverage(std::size_t averageSize) {
+	if(averageSize < 256 || averageSize > (16 << 20)) {
+		throw fusepp::fuse_error(EINVAL);
+	}
+	return std::size_t(1) << log2(averageSize);
+}
+
+inline std::uint64_t roll(std::uint64_t hash, unsigned char byte) {
+	return (hash << 1) + gear[byte];
+}
+
+/**
+ * Finds the first position in a region at which the hash has none of the
+ * bits of a mask set.
+ *
+ * The region is divided into four lanes, each primed with the window of
+ * bytes before it so that its hashes are as if hashed from the start. The
+ * lanes are independent, so the processor can overlap them. Whatever the
+ * lanes don't cover is hashed by carrying on the last lane.
+ *
+ * @param data The data, with at least a window of bytes before the region.
+ * @return The offset after that position, or zero if there is none.
+ */
+std::size_t firstCut(unsigned char const * data, std::size_t from, std::size_t to, std::uint64_t mask) {
+	std::size_t span = (to - from) / 4;
+	unsigned char const * p0 = data + from;
+	unsigned char const * p1 = p0 + span;
+	unsigned char const * p2 = p1 + span;
+	unsigned char const * p3 = p2 + span;
+	std::uint64_t h0 = 0;
+	std::uint64_t h1 = 0;
+	std::uint64_t h2 = 0;
+	std::uint64_t h3 = 0;
+	for(std::ptrdiff_t i = -static_cast<std::ptrdiff_t>(Chunker::window); i < 0; ++i) {
+		h0 = roll(h0, p0[i]);
+		h1 = roll(h1, p1[i]);
+		h2 = roll(h2, p2[i]);
+		h3 = roll(h3, p3[i]);
+	}
+
+	std::size_t hit1 = 0;
+	std::size_t hit2 = 0;
+	std::size_t hit3 = 0;
+	for(std::size_t i = 0; i < span; ++i) {
+		h0 = roll(h0, p0[i]);
+		h1 = roll(h1, p1[i]);
+		h2 = roll(h2, p2[i]);
+		h3 = roll(h3, p3[i]);
+		if(!(h0 & mask)) {
+			return p0 + i + 1 - data;
+		}
+		if(!((h1 & mask) && (h2 & mask) && (h3 & mask))) {
+			// Lane 0 may yet find an earlier position, so keep going
+			if(!hit1 && !(h1 & mask)) {
+				hit1 = p1 + i + 1 - data;
+			}
+			if(!hit2 && !(h2 & mask)) {
+				hit2 = p2 + i + 1 - data;
+			}
+			if(!hit3 && !(h3 & mask)) {
+				hit3 = p3 + i + 1 - data;
+			}
+		}
+	}
+	if(hit1 || hit2 || hit3) {
+		return hit1 ? hit1 : hit2 ? hit2 : hit3;
+	}
+
+	for(std::size_t p = from + 4 * span; p < to; ++p) {
+		h3 = roll(h3, data[p]);
+		if(!(h3 & mask)) {
+			return p + 1;
+		}
+	}
+	return 0;
+}
+
+} // namespace
+
+Chunker::Chunker(std::size_t averageSize)
+		: averageSize(checkedAverage(averageSize)),
+		  minSize(this->averageSize / 4),
+		  maxSize(this->averageSize * 8),
+		  strictMask(topBits(log2(this->averageSize) + 2)),
+		  looseMask(topBits(log2(this->averageSize) - 2)) {}
+
+std::size_t Chunker::cut(unsigned char const * data, std::size_t length) const {
+	if(length <= minSize) {
+		return length;
+	}
+	std::size_t limit = std::min(length, maxSize);
+	std::size_t normal = std::min(limit, averageSize);
+	if(std::size_t rc = firstCut(data, minSize, normal, strictMask)) {
+		return rc;
+	}
+
+	// A loose cut point is usually found soon after the average size, so
+	// search for one a block at a time rather than dividing the whole region
+	std::size_t block = averageSize / 4;
+	for(std::size_t from = normal; from < limit; from += block) {
+		if(std::size_t rc = firstCut(data, from, std::min(limit, from + block), looseMask)) {
+			return rc;
+		}
+	}
+	return limit;
+}
+
+std::vector<off_t> Chunker::boundaries(BackingFile const & file) const {
+	std::size_t capacity = std::max<std::size_t>(4 << 20, 2 * maxSize);
+	std::unique_ptr<unsigned char[]> buffer(new unsigned char[capacity]);
+	std::vector<off_t> rc;
+
+	off_t offset = 0;
+	std::size_t start = 0;
+	std::size_t filled = 0;
+	bool eof = false;
+	while(true) {
+		if(!eof && filled - start < maxSize) {
+			std::memmove(buffer.get(), buffer.get() + start, filled - start);
+			filled -= start;
+			start = 0;
+			std::size_t n = file.read(buffer.get() + filled, capacity - filled, offset + filled);
+			eof = n < capacity - filled;
+			filled += n;
+		}
+		if(start == filled) {
+			return rc;
+		}
+		std::size_t length = cut(buffer.get() + start, filled - start);
+		start += length;
+		offset += length;
+		rc.push_back(offset);
+	}
+}
+
+} // namespace smfs
@@ -0,0 +1,238 @@
+/*
+ * CompressedFile.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "smfs/CompressedFile.h"
+#include "smfs/Lz4.h"
+#include "smfs/ThreadPool.h"
+
+#include <fusepp/util.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+extern "C" {
+	#include <unistd.h>
+}
+
+namespace smfs {
+
+namespace {
+
+constexpr char compressedMagic[8] = {'S', 'M', 'F', 'S', 'L', 'Z', '4', '\n'};
+constexpr std::uint32_t compressedVersion = 1;
+constexpr std::uint32_t compressedByteOrder = 0x01020304;
+
+/**
+ * The header at the start of a compressed container. The compressed blocks
+ * follow it, then the index: the offset of each block, and of the end of the
+ * last.
+ */
+struct CompressedHeader {
+	char magic[8];
+	std::uint32_t version;
+	std::uint32_t byteOrder;
+	std::uint64_t blockSize;
+	std::uint64_t size;
+	std::uint64_t blockCount;
+	std::uint64_t indexOffset;
+};
+
+static_assert(sizeof(CompressedHeader) == 48, "CompressedHeader must have no padding");
+
+void writeAll(int fd, void const * data, std::size_t length, off_t offset) {
+	char const * mem = static_cast<char const *>(data);
+	for(std::size_t written = 0; written < length;) {
+		ssize_t rc = ::pwrite(fd, mem + written, length - written, offset + written);
+		if(rc < 0) {
+			if(errno == EINTR) {
+				continue;
+			}
+			throw fusepp::fuse_error::from_errno();
+		}
+		written += rc;
+	}
+}
+
+/**
+ * Reads exactly the given number of bytes of a file's descriptor.
+ * @throws fusepp::fuse_error with EIO if the file is too short.
+ */
+void readExactly(int fd, void * buf, std::size_t length, off_t offset) {
+	char * mem = static_cast<char *>(buf);
+	for(std::size_t total = 0; total < length;) {
+		ssize_t rc = ::pread(fd, mem + total, length - total, offset + total);
+		if(rc < 0) {
+			if(errno == EINTR) {
+				continue;
+			}
+			throw fusepp::fuse_error::from_errno();
+		}
+		if(rc == 0) {
+			throw fusepp::fuse_error(EIO);
+		}
+		total += rc;
+	}
+}
+
+} // namespace
+
+CompressedFile::CompressedFile(std::string const & path, int fd, std::size_t blockSize, off_t size,
+		std::vector<std::uint64_t> offsets)
+		: BackingFile(path, fd), blockLength(blockSize), length(size), offsets(std::move(offsets)) {}
+
+std::shared_ptr<CompressedFile> CompressedFile::open(std::string const & path) {
+	int fd = fusepp::check_ret(::open(path.c_str(), O_RDONLY | O_CLOEXEC));
+	try {
+		CompressedHeader header;
+		try {
+			readExactly(fd, &header, sizeof(header), 0);
+		} catch(fusepp::fuse_error const & e) {
+			throw e.error == EIO ? fusepp::fuse_error(EINVAL) : e;
+		}
+		if(std::memcmp(header.magic, compressedMagic, sizeof(compressedMagic)) != 0
+				|| header.version != compressedVersion
+				|| header.byteOrder != compressedByteOrder
+				|| !header.blockSize || header.blockSize > std::numeric_limits<std::uint32_t>::max()
+				|| header.size > static_cast<std::uint64_t>(std::numeric_limits<off_t>::max())
+				|| header.blockCount != (header.size + header.blockSize - 1) / header.blockSize) {
+			throw fusepp::fuse_error(EINVAL);
+		}
+
+		std::vector<std::uint64_t> offsets(header.blockCount + 1);
+		try {
+			readExactly(fd, offsets.data(), offsets.size() * sizeof(std::uint64_t), header.indexOffset);
+		} catch(fusepp::fuse_error const & e) {
+			throw e.error == EIO ? fusepp::fuse_error(EINVAL) : e;
+		}
+		if(offsets.front() != sizeof(header) || offsets.back() != header.indexOffset) {
+			throw fusepp::fuse_error(EINVAL);
+		}
+		for(std::size_t i = 0; i < header.blockCount; ++i) {
+			// A block is never stored in more space than its data takes up
+			std::uint64_t logical = std::min(header.blockSize, header.size - i * header.blockSize);
+			if(offsets[i + 1] < offsets[i] || offsets[i + 1] - offsets[i] > logical) {
+				throw fusepp::fuse_error(EINVAL);
+			}
+		}
+		return std::shared_ptr<CompressedFile>(
+				new CompressedFile(path, fd, header.blockSize, header.size, std::move(offsets)));
+	} catch(...) {
+		::close(fd);
+		throw;
+	}
+}
+
+std::shared_ptr<BackingFile> CompressedFile::openAny(std::string const & path) {
+	std::shared_ptr<BackingFile> file = BackingFile::open(path);
+	char magic[sizeof(compressedMagic)];
+	if(file->read(magic, sizeof(magic), 0) == sizeof(magic)
+			&& std::memcmp(magic, compressedMagic, sizeof(magic)) == 0) {
+		return open(path);
+	}
+	return file;
+}
+
+void CompressedFile::compress(BackingFile const & source, std::string const & path, std::size_t blockSize) {
+	if(!blockSize || blockSize > std::numeric_limits<std::uint32_t>::max()) {
+		throw fusepp::fuse_error(EINVAL);
+	}
+	std::string temp = path + ".tmp";
+	int fd = fusepp::check_ret(::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+	try {
+		std::unique_ptr<unsigned char[]> data(new unsigned char[blockSize]);
+		std::unique_ptr<unsigned char[]> packed(new unsigned char[blockSize]);
+		std::vector<std::uint64_t> offsets{sizeof(CompressedHeader)};
+		off_t size = 0;
+		while(std::size_t n = source.read(data.get(), blockSize, size)) {
+			// Anything that does not come out smaller is stored as it is
+			std::size_t stored = n > 1 ? lz4::compress(data.get(), n, packed.get(), n - 1) : 0;
+			writeAll(fd, stored ? packed.get() : data.get(), stored ? stored : n, offsets.back());
+			offsets.push_back(offsets.back() + (stored ? stored : n));
+			size += n;
+			if(n < blockSize) {
+				break;
+			}
+		}
+
+		CompressedHeader header{};
+		std::memcpy(header.magic, compressedMagic, sizeof(compressedMagic));
+		header.version = compressedVersion;
+		header.byteOrder = compressedByteOrder;
+		header.blockSize = blockSize;
+		header.size = size;
+		header.blockCount = offsets.size() - 1;
+		header.indexOffset = offsets.back();
+		writeAll(fd, offsets.data(), offsets.size() * sizeof(std::uint64_t), header.indexOffset);
+		writeAll(fd, &header, sizeof(header), 0);
+		fusepp::check_ret(::fsync(fd));
+	} catch(...) {
+		::close(fd);
+		::unlink(temp.c_str());
+		throw;
+	}
+	::close(fd);
+	fusepp::check_ret(::rename(temp.c_str(), path.c_str()));
+}
+
+std::size_t CompressedFile::blockLengthAt(std::size_t block) const {
+	off_t start = static_cast<off_t>(block) * blockLength;
+	return static_cast<std::size_t>(std::min<off_t>(blockLength, length - start));
+}
+
+void CompressedFile::readBlock(std::size_t block, unsigned char * out) const {
+	std::size_t logical = blockLengthAt(block);
+	std::size_t stored = offsets[block + 1] - offsets[block];
+	if(stored == logical) {
+		readExactly(fd(), out, stored, offsets[block]);
+		return;
+	}
+	thread_local std::vector<unsigned char> packed;
+	packed.resize(std::max(packed.size(), stored));
+	readExactly(fd(), packed.data(), stored, offsets[block]);
+	if(lz4::decompress(packed.data(), stored, out, logical) != logical) {
+		throw fusepp::fuse_error(EIO);
+	}
+}
+
+std::size_t CompressedFile::readUnchecked(void * buf, std::size_t nbytes, off_t offset) const {
+	if(offset >= length || !nbytes) {
+		return 0;
+	}
+	nbytes = static_cast<std::size_t>(std::min<off_t>(nbytes, length - offset));
+	off_t end = offset + nbytes;
+	std::size_t first = offset / blockLength;
+	std::size_t count = (end - 1) / blockLength - first + 1;
+	unsigned char * mem = static_cast<unsigned char *>(buf);
+
+	auto readOne = [&](std::size_t i) {
+		std::size_t block = first + i;
+		off_t blockStart = static_cast<off_t>(block) * blockLength;
+		off_t blockEnd = blockStart + blockLengthAt(block);
+		off_t from = std::max(offset, blockStart);
+		off_t to = std::min(end, blockEnd);
+		if(from == blockStart && to == blockEnd) {
+			readBlock(block, mem + (from - offset));
+		} else {
+			// Only part of the block is wanted, so decompress it aside
+			thread_local std::vector<unsigned char> scratch;
+			scratch.resize(std::max(scratch.size(), blockLength));
+			readBlock(block, scratch.data());
+			std::memcpy(mem + (from - offset), scratch.data() + (from - blockStart), to - from);
+		}
+	};
+	if(count >= parallelBlocks) {
+		ThreadPool::shared().parallelFor(count, readOne);
+	} else {
+		for(std::size_t i = 0; i < count; ++i) {
+			readOne(i);
+		}
+	}
+	return nbytes;
+}
+
+} // namespace smfs
@@ -0,0 +1,234 @@
+/*
+ * Crc32c.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "smfs/Crc32c.h"
+
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+namespace smfs {
+
+namespace {
+
+/**
+ * The CRC-32C polynomial, bit-reversed.
+ */
+constexpr std::uint32_t polynomial = 0x82f63b78;
+
+/**
+ * The lengths of the interleaved streams long and shorter inputs are
+ * divided into.
+ */
+constexpr std::size_t longStream = 8192;
+constexpr std::size_t shortStream = 256;
+
+/*
+ * CRCs of the streams are combined by shifting the CRC of one past the
+ * length of the next, as if followed by that many zero bytes, and adding in
+ * the CRC of the next. Shifting is a linear operation over GF(2), so it is
+ * done with tables of its effect on each byte of the CRC.
+ */
+
+std::uint32_t gf2Times(std::uint32_t const * matrix, std::uint32_t vector) {
+	std::uint32_t rc = 0;
+	for(; vector; vector >>= 1, ++matrix) {
+		if(vector & 1) {
+			rc ^= *matrix;
+		}
+	}
+	return rc;
+}
+
+void gf2Square(std::uint32_t * square, std::uint32_t const * matrix) {
+	for(unsigned n = 0; n < 32; ++n) {
+		square[n] = gf2Times(matrix, matrix[n]);
+	}
+}
+
+/**
+ * Builds the matrix that shifts a CRC past a number of zero bytes.
+ * @param length The number of bytes, which must be a power of two.
+ */
+void zerosOperator(std::uint32_t * even, std::size_t length) {
+	std::uint32_t odd[32];
+	odd[0] = polynomial;
+	for(unsigned n = 1; n < 32; ++n) {
+		odd[n] = std::uint32_t(1) << (n - 1);
+	}
+	gf2Square(even, odd);
+	gf2Square(odd, even);
+	// odd now shifts past four zero bits, and each squaring from here on
+	// doubles the shift as the length is halved
+	while(true) {
+		gf2Square(even, odd);
+		length >>= 1;
+		if(!length) {
+			return;
+		}
+		gf2Square(odd, even);
+		length >>= 1;
+		if(!length) {
+			std::memcpy(even, odd, sizeof(odd));
+			return;
+		}
+	}
+}
+
+struct ShiftTable {
+	std::uint32_t bytes[4][256];
+
+	explicit ShiftTable(std::size_t length) {
+		std::uint32_t op[32];
+		zerosOperator(op, length);
+		for(std::uint32_t n = 0; n < 256; ++n) {
+			for(unsigned i = 0; i < 4; ++i) {
+				bytes[i][n] = gf2Times(op, n << (8 * i));
+			}
+		}
+	}
+
+	std::uint32_t shift(std::uint32_t crc) const {
+		return bytes[0][crc & 0xff] ^ bytes[1][(crc >> 8) & 0xff]
+				^ bytes[2][(crc >> 16) & 0xff] ^ bytes[3][crc >> 24];
+	}
+};
+
+struct Tables {
+	std::uint32_t software[256];
+	ShiftTable longShift{longStream};
+	ShiftTable shortShift{shortStream};
+
+	Tables() {
+		for(std::uint32_t n = 0; n < 256; ++n) {
+			std::uint32_t crc = n;
+			for(unsigned k = 0; k < 8; ++k) {
+				crc = crc & 1 ? (crc >> 1) ^ polynomial : crc >> 1;
+			}
+			software[n] = crc;
+		}
+	}
+};
+
+Tables const & tables() {
+	static Tables const rc;
+	return rc;
+}
+
+std::uint32_t software(std::uint32_t crc, unsigned char const * p, std::size_t length) {
+	std::uint32_t const * table = tables().software;
+	for(; length; --length) {
+		crc = table[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+	}
+	return crc;
+}
+
+#if defined(__x86_64__)
+#pragma GCC push_options
+#pragma GCC target("sse4.2")
+#define SMFS_CRC32C_HARDWARE
+
+inline std::uint32_t step(std::uint32_t crc, std::uint64_t word) {
+	return static_cast<std::uint32_t>(_mm_crc32_u64(crc, word));
+}
+
+inline std::uint32_t step(std::uint32_t crc, unsigned char byte) {
+	return _mm_crc32_u8(crc, byte);
+}
+
+bool haveHardware() {
+	static bool const rc = __builtin_cpu_supports("sse4.2");
+	return rc;
+}
+
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#define SMFS_CRC32C_HARDWARE
+
+inline std::uint32_t step(std::uint32_t crc, std::uint64_t word) {
+	return __crc32cd(crc, word);
+}
+
+inline std::uint32_t step(std::uint32_t crc, unsigned char byte) {
+	return __crc32cb(crc, byte);
+}
+
+constexpr bool haveHardware() {
+	return true;
+}
+
+#endif
+
+#ifdef SMFS_CRC32C_HARDWARE
+
+inline std::uint64_t word(unsigned char const * p) {
+	std::uint64_t rc;
+	std::memcpy(&rc, p, sizeof(rc));
+	return rc;
+}
+
+/**
+ * Runs three streams of a given length at once, for as long as there is
+ * enough data, then combines them.
+ */
+inline std::uint32_t interleaved(std::uint32_t crc, unsigned char const * &p, std::size_t &length,
+		std::size_t stream, ShiftTable const & shift) {
+	while(length >= 3 * stream) {
+		std::uint32_t crc1 = 0;
+		std::uint32_t crc2 = 0;
+		for(unsigned char const * end = p + stream; p < end; p += 8) {
+			crc = step(crc, word(p));
+			crc1 = step(crc1, word(p + stream));
+			crc2 = step(crc2, word(p + 2 * stream));
+		}
+		crc = shift.shift(crc) ^ crc1;
+		crc = shift.shift(crc) ^ crc2;
+		p += 2 * stream;
+		length -= 3 * stream;
+	}
+	return crc;
+}
+
+std::uint32_t hardware(std::uint32_t crc, unsigned char const * p, std::size_t length) {
+	Tables const & t = tables();
+	for(; length && reinterpret_cast<std::uintptr_t>(p) % 8; --length) {
+		crc = step(crc, *p++);
+	}
+	crc = interleaved(crc, p, length, longStream, t.longShift);
+	crc = interleaved(crc, p, length, shortStream, t.shortShift);
+	for(; length >= 8; p += 8, length -= 8) {
+		crc = step(crc, word(p));
+	}
+	for(; length; --length) {
+		crc = step(crc, *p++);
+	}
+	return crc;
+}
+
+#endif
+
+#if defined(__x86_64__)
+#pragma GCC pop_options
+#endif
+
+} // namespace
+
+std::uint32_t crc32c(void const * data, std::size_t length, std::uint32_t crc) {
+	unsigned char const * p = static_cast<unsigned char const *>(data);
+	crc = ~crc;
+#ifdef SMFS_CRC32C_HARDWARE
+	if(haveHardware()) {
+		return ~hardware(crc, p, length);
+	}
+#endif
+	return ~software(crc, p, length);
+}
+
+} // namespace smfs
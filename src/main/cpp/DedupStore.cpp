@@ -0,0 +1,205 @@
+/*
+ * DedupStore.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "smfs/DedupStore.h"
+#include "smfs/StatsLine.h"
+
+#include <fusepp/common.hpp>
+
+#include <algorithm>
+
+namespace smfs {
+
+namespace {
+
+/**
+ * The number of bytes read at once while hashing.
+ */
+constexpr std::size_t readSize = 1 << 20;
+
+/**
+ * Reads a whole segment, a buffer at a time.
+ */
+template<typename F>
+void readSegment(Segment const & segment, unsigned char * buffer, std::size_t capacity, F consume) {
+	for(std::size_t done = 0; done < segment.length;) {
+		std::size_t want = std::min(capacity, segment.length - done);
+		std::size_t n = segment.file->read(buffer, want, segment.offset + done);
+		if(n != want) {
+			// The backing file is shorter than the segment
+			throw fusepp::fuse_error(EIO);
+		}
+		consume(buffer, n);
+		done += n;
+	}
+}
+
+} // namespace
+
+std::string DedupStore::Stats::toString() const {
+	return StatsLine().count("unique", unique).count("references", references)
+			.count("logical_bytes", logicalBytes).count("unique_bytes", uniqueBytes)
+			.count("bytes_saved", savedBytes()).count("relocated", relocated).str();
+}
+
+DedupStore::References::~References() {
+	for(Digest const & digest : digests) {
+		store->release(digest);
+	}
+}
+
+DedupStore::DedupStore() {}
+
+DedupStore::DedupStore(Chunker chunker)
+		: chunker(chunker) {}
+
+std::vector<Segment> DedupStore::intern(std::vector<Segment> const & segments, std::vector<Digest> * digests) {
+	std::vector<Digest> taken;
+	try {
+		std::vector<Segment> rc = internAll(segments, taken);
+		if(digests) {
+			digests->insert(digests->end(), taken.begin(), taken.end());
+		}
+		return rc;
+	} catch(...) {
+		for(Digest const & digest : taken) {
+			release(digest);
+		}
+		throw;
+	}
+}
+
+std::vector<Segment> DedupStore::internAll(std::vector<Segment> const & segments, std::vector<Digest> & digests) {
+	std::vector<Segment> rc;
+	std::size_t capacity = chunker ? std::max(readSize, 2 * chunker->max()) : readSize;
+	std::unique_ptr<unsigned char[]> buffer(new unsigned char[capacity]);
+
+	for(Segment const & segment : segments) {
+		if(!segment.length) {
+			continue;
+		}
+		if(!chunker) {
+			Sha256 sha;
+			readSegment(segment, buffer.get(), capacity, [&](unsigned char const * data, std::size_t n) {
+				sha.update(data, n);
+			});
+			Digest digest = sha.finish();
+			rc.push_back(add(digest, segment));
+			digests.push_back(digest);
+			continue;
+		}
+
+		// Divide the segment as Chunker::boundaries does a whole file, but
+		// hash each chunk from the buffer rather than reading it twice
+		std::size_t start = 0;
+		std::size_t filled = 0;
+		std::size_t done = 0;
+		while(done < segment.length) {
+			if(filled - start < chunker->max() && done + (filled - start) < segment.length) {
+				std::memmove(buffer.get(), buffer.get() + start, filled - start);
+				filled -= start;
+				start = 0;
+				std::size_t want = std::min(capacity - filled, segment.length - done - filled);
+				std::size_t n = segment.file->read(buffer.get() + filled, want, segment.offset + done + filled);
+				if(n != want) {
+					throw fusepp::fuse_error(EIO);
+				}
+				filled += n;
+			}
+			std::size_t length = chunker->cut(buffer.get() + start, filled - start);
+			Digest digest = Sha256::of(buffer.get() + start, length);
+			rc.push_back(add(digest, Segment{segment.file, segment.offset + off_t(done), length}));
+			digests.push_back(digest);
+			start += length;
+			done += length;
+		}
+	}
+	return rc;
+}
+
+Segment DedupStore::add(Digest const & digest, Segment const & segment) {
+	// Checked unlocked, as it reads the canonical location
+	std::optional<Segment> canonical = find(digest);
+	bool intact = canonical && holds(*canonical, digest);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	counters.references += 1;
+	counters.logicalBytes += segment.length;
+
+	auto file = fileIndex.find(segment.file->id);
+	auto it = index.find(digest);
+	if(it != index.end()) {
+		it->second.references += 1;
+		Segment current{files[it->second.file], it->second.offset, it->second.length};
+		if(intact || !canonical || current.file != canonical->file || current.offset != canonical->offset) {
+			// Checked, or placed by another caller since it was looked up
+			return current;
+		}
+		if(file == fileIndex.end()) {
+			file = fileIndex.emplace(segment.file->id, static_cast<std::uint32_t>(files.size())).first;
+			files.push_back(segment.file);
+		}
+		it->second.file = file->second;
+		it->second.offset = segment.offset;
+		counters.relocated += 1;
+		return segment;
+	}
+
+	if(file == fileIndex.end()) {
+		file = fileIndex.emplace(segment.file->id, static_cast<std::uint32_t>(files.size())).first;
+		files.push_back(segment.file);
+	}
+	index.emplace(digest, Location{file->second, 1, segment.offset, segment.length});
+	counters.unique += 1;
+	counters.uniqueBytes += segment.length;
+	return segment;
+}
+
+bool DedupStore::holds(Segment const & segment, Digest const & digest) {
+	std::unique_ptr<unsigned char[]> buffer(new unsigned char[std::min(readSize, segment.length)]);
+	Sha256 sha;
+	try {
+		readSegment(segment, buffer.get(), std::min(readSize, segment.length), [&](unsigned char const * data, std::size_t n) {
+			sha.update(data, n);
+		});
+	} catch(fusepp::fuse_error const &) {
+		return false;
+	}
+	return sha.finish() == digest;
+}
+
+void DedupStore::release(Digest const & digest) {
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = index.find(digest);
+	if(it == index.end()) {
+		return;
+	}
+	counters.references -= 1;
+	counters.logicalBytes -= it->second.length;
+	if(--it->second.references == 0) {
+		// The backing file stays in the table, since other entries may use it
+		counters.unique -= 1;
+		counters.uniqueBytes -= it->second.length;
+		index.erase(it);
+	}
+}
+
+std::optional<Segment> DedupStore::find(Digest const & digest) const {
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = index.find(digest);
+	if(it == index.end()) {
+		return std::nullopt;
+	}
+	return Segment{files[it->second.file], it->second.offset, it->second.length};
+}
+
+DedupStore::Stats DedupStore::stats() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return counters;
+}
+
+} // namespace smfs
@@ -0,0 +1,77 @@
+/*
+ * DeltaLog.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "smfs/DeltaLog.h"
+
+#include <fusepp/util.hpp>
+
+#include <cstdlib>
+#include <vector>
+
+extern "C" {
+	#include <unistd.h>
+}
+
+namespace smfs {
+
+DeltaLog::DeltaLog(std::string directory) : dir(std::move(directory)) {}
+
+std::shared_ptr<BackingFile> DeltaLog::backing() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return file;
+}
+
+off_t DeltaLog::size() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return end;
+}
+
+std::pair<std::shared_ptr<BackingFile>, off_t> DeltaLog::reserve(std::size_t nbytes) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if(!file) {
+		std::string name = dir + "/delta-XXXXXX";
+		std::vector<char> path(name.begin(), name.end());
+		path.push_back('\0');
+		int fd = fusepp::check_ret(::mkstemp(path.data()));
+		::close(fd);
+		file = BackingFile::open(path.data(), O_RDWR);
+	}
+	off_t offset = end;
+	end += nbytes;
+	return {file, offset};
+}
+
+Segment DeltaLog::append(void const * data, std::size_t nbytes) {
+	return append(nbytes, [data, nbytes](BackingFile const & log, off_t offset) {
+		char const * mem = static_cast<char const *>(data);
+		for(std::size_t written = 0; written < nbytes;) {
+			ssize_t rc = ::pwrite(log.fd(), mem + written, nbytes - written, offset + written);
+			if(rc < 0) {
+				if(errno == EINTR) {
+					continue;
+				}
+				throw fusepp::fuse_error::from_errno();
+			}
+			written += rc;
+		}
+	});
+}
+
+Segment DeltaLog::append(std::size_t nbytes, Fill const & fill) {
+	std::pair<std::shared_ptr<BackingFile>, off_t> place = reserve(nbytes);
+	fill(*place.first, place.second);
+	return Segment{std::move(place.first), place.second, nbytes};
+}
+
+void DeltaLog::sync() const {
+	std::shared_ptr<BackingFile> log = backing();
+	if(log) {
+		fusepp::check_ret(::fdatasync(log->fd()));
+	}
+}
+
+} // namespace smfs
@@ -0,0 +1,111 @@
+/*
+ * DeviceLoad.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "smfs/DeviceLoad.h"
+#include "smfs/StatsLine.h"
+
+#include <map>
+#include <mutex>
+
+namespace smfs {
+
+/*
+ * ======================================================
+ * LatencyHistogram
+ * ======================================================
+ */
+
+std::size_t LatencyHistogram::bucket(std::uint64_t micros) {
+	if(micros < 4) {
+		return micros;
+	}
+	unsigned power = 63 - __builtin_clzll(micros);
+	std::size_t rc = 4 + (power - 2) * 4 + ((micros >> (power - 2)) & 3);
+	return rc < bucketCount ? rc : bucketCount - 1;
+}
+
+std::uint64_t LatencyHistogram::bucketLimit(std::size_t bucket) {
+	if(bucket < 4) {
+		return bucket + 1;
+	}
+	unsigned power = (bucket - 4) / 4 + 2;
+	return (5 + (bucket - 4) % 4) << (power - 2);
+}
+
+void LatencyHistogram::record(std::chrono::nanoseconds latency) {
+	std::uint64_t micros = latency.count() > 0 ? latency.count() / 1000 : 0;
+	counts[bucket(micros)].fetch_add(1, std::memory_order_relaxed);
+	if(recorded.fetch_add(1, std::memory_order_relaxed) % decayInterval == decayInterval - 1) {
+		for(std::atomic<std::uint64_t> &count : counts) {
+			count.store(count.load(std::memory_order_relaxed) / 2, std::memory_order_relaxed);
+		}
+	}
+}
+
+std::uint64_t LatencyHistogram::samples() const {
+	std::uint64_t rc = 0;
+	for(std::atomic<std::uint64_t> const & count : counts) {
+		rc += count.load(std::memory_order_relaxed);
+	}
+	return rc;
+}
+
+std::chrono::nanoseconds LatencyHistogram::percentile(double fraction) const {
+	std::uint64_t snapshot[bucketCount];
+	std::uint64_t total = 0;
+	for(std::size_t i = 0; i < bucketCount; ++i) {
+		snapshot[i] = counts[i].load(std::memory_order_relaxed);
+		total += snapshot[i];
+	}
+	if(!total) {
+		return std::chrono::nanoseconds(0);
+	}
+	double target = fraction * total;
+	std::uint64_t seen = 0;
+	for(std::size_t i = 0; i < bucketCount; ++i) {
+		seen += snapshot[i];
+		if(seen >= target && snapshot[i]) {
+			return std::chrono::microseconds(bucketLimit(i));
+		}
+	}
+	return std::chrono::microseconds(bucketLimit(bucketCount - 1));
+}
+
+/*
+ * ======================================================
+ * DeviceLoad
+ * ======================================================
+ */
+
+std::shared_ptr<DeviceLoad> DeviceLoad::of(dev_t device) {
+	static std::mutex lock;
+	static std::map<dev_t, std::weak_ptr<DeviceLoad>> devices;
+	std::lock_guard<std::mutex> guard(lock);
+	std::weak_ptr<DeviceLoad> &entry = devices[device];
+	std::shared_ptr<DeviceLoad> rc = entry.lock();
+	if(!rc) {
+		rc = std::make_shared<DeviceLoad>();
+		entry = rc;
+	}
+	return rc;
+}
+
+void DeviceLoad::finished(std::chrono::nanoseconds latency) {
+	pending.fetch_sub(1, std::memory_order_relaxed);
+	histogram.record(latency);
+	// An exponentially weighted moving average, with the first sample taken as is
+	std::uint64_t sample = latency.count() > 0 ? latency.count() : 0;
+	std::uint64_t average = averageNanos.load(std::memory_order_relaxed);
+	averageNanos.store(average ? average - average / 8 + sample / 8 : sample, std::memory_order_relaxed);
+}
+
+std::string DeviceLoad::toString() const {
+	return StatsLine().count("queue", queueDepth()).count("average_us", averageLatency().count() / 1000)
+			.count("p95_us", histogram.percentile(0.95).count() / 1000).count("samples", histogram.samples()).str();
+}
+
+} // namespace smfs
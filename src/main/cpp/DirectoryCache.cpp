@@ -0,0 +1,167 @@
+/*
+ * DirectoryCache.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "smfs/DirectoryCache.h"
+
+#include <fusepp/common.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+extern "C" {
+	#include <dirent.h>
+	#include <fcntl.h>
+}
+
+namespace smfs {
+
+/*
+ * ======================================================
+ * Directory
+ * ======================================================
+ */
+
+namespace {
+
+/**
+ * The approximate overhead of an entry in a directory's vector, and in the
+ * heap block holding its name.
+ */
+constexpr std::size_t entryOverhead = sizeof(DirectoryEntry) + 16;
+
+std::size_t footprintOf(std::vector<DirectoryEntry> const & entries) {
+	std::size_t rc = sizeof(Directory);
+	for(DirectoryEntry const & entry : entries) {
+		rc += entryOverhead + entry.name.size();
+	}
+	return rc;
+}
+
+std::vector<DirectoryEntry> sorted(std::vector<DirectoryEntry> entries) {
+	std::sort(entries.begin(), entries.end(), [](DirectoryEntry const & a, DirectoryEntry const & b) {
+		return a.name < b.name;
+	});
+	return entries;
+}
+
+} // namespace
+
+Directory::Directory(std::vector<DirectoryEntry> entries)
+		: list(sorted(std::move(entries))), bytes(footprintOf(list)) {}
+
+std::shared_ptr<Directory const> Directory::load(std::string const & path) {
+	DIR * dir = ::opendir(path.c_str());
+	if(!dir) {
+		throw fusepp::fuse_error::from_errno();
+	}
+	int fd = ::dirfd(dir);
+	std::vector<DirectoryEntry> entries;
+	while(struct dirent * entry = ::readdir(dir)) {
+		if(std::strcmp(entry->d_name, ".") == 0 || std::strcmp(entry->d_name, "..") == 0) {
+			continue;
+		}
+		DirectoryEntry loaded{entry->d_name, {}};
+		if(::fstatat(fd, entry->d_name, &loaded.attributes, AT_SYMLINK_NOFOLLOW) != 0) {
+			// Removed since the directory was read
+			continue;
+		}
+		entries.push_back(std::move(loaded));
+	}
+	::closedir(dir);
+	return std::make_shared<Directory const>(std::move(entries));
+}
+
+DirectoryEntry const * Directory::find(std::string const & name) const {
+	auto it = std::lower_bound(list.begin(), list.end(), name, [](DirectoryEntry const & entry, std::string const & name) {
+		return entry.name < name;
+	});
+	return it != list.end() && it->name == name ? &*it : nullptr;
+}
+
+/*
+ * ======================================================
+ * DirectoryCache
+ * ======================================================
+ */
+
+DirectoryCache::DirectoryCache(std::size_t budget) : byteBudget(budget) {}
+
+std::shared_ptr<Directory const> DirectoryCache::get(std::string const & path) {
+	std::uint64_t generation;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = cached.find(path);
+		if(it != cached.end()) {
+			lru.splice(lru.begin(), lru, it->second.position);
+			++counters.hits;
+			return it->second.directory;
+		}
+		generation = invalidations;
+	}
+
+	bool leader = false;
+	std::shared_ptr<Directory const> directory = loads.run(path, [&]() {
+		leader = true;
+		return Directory::load(path);
+	});
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if(!leader) {
+		++counters.coalesced;
+	} else {
+		++counters.loads;
+		// Don't cache a directory that may have been read before an
+		// invalidation of it
+		if(generation == invalidations) {
+			insert(path, directory);
+		}
+	}
+	return directory;
+}
+
+void DirectoryCache::invalidate(std::string const & path) {
+	std::lock_guard<std::mutex> lock(mutex);
+	++invalidations;
+	auto it = cached.find(path);
+	if(it != cached.end()) {
+		used -= it->second.directory->footprint();
+		lru.erase(it->second.position);
+		cached.erase(it);
+	}
+}
+
+std::size_t DirectoryCache::size() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return used;
+}
+
+DirectoryCache::Stats DirectoryCache::stats() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return counters;
+}
+
+void DirectoryCache::insert(std::string const & path, std::shared_ptr<Directory const> const & directory) {
+	if(cached.count(path)) {
+		return;
+	}
+	lru.push_front(path);
+	cached.emplace(path, Cached{directory, lru.begin()});
+	used += directory->footprint();
+	evict();
+}
+
+void DirectoryCache::evict() {
+	while(used > byteBudget && lru.size() > 1) {
+		auto it = cached.find(lru.back());
+		used -= it->second.directory->footprint();
+		cached.erase(it);
+		lru.pop_back();
+		++counters.evictions;
+	}
+}
+
+} // namespace smfs
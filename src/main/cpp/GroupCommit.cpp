@@ -0,0 +1,139 @@
+/*
+ * GroupCommit.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "smfs/GroupCommit.h"
+#include "smfs/MergedFile.h"
+#include "smfs/StatsLine.h"
+#include "smfs/ThreadPool.h"
+
+#include <fusepp/util.hpp>
+
+#include <map>
+#include <unordered_set>
+
+extern "C" {
+	#include <sys/stat.h>
+	#include <unistd.h>
+}
+
+namespace smfs {
+
+std::string GroupCommit::Stats::toString() const {
+	return StatsLine().count("requests", requests).count("rounds", rounds)
+			.count("file_syncs", fileSyncs).count("filesystem_syncs", filesystemSyncs)
+			.count("journal_syncs", journalSyncs).str();
+}
+
+GroupCommit::GroupCommit(std::size_t syncfsThreshold, ThreadPool * pool)
+		: syncfsThreshold(syncfsThreshold), pool(pool ? *pool : ThreadPool::io()) {}
+
+GroupCommit::Stats GroupCommit::stats() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return counters;
+}
+
+void GroupCommit::sync(std::vector<std::shared_ptr<BackingFile>> const & files,
+		std::vector<std::shared_ptr<MergedFile const>> const & merged) {
+	if(files.empty() && merged.empty()) {
+		return;
+	}
+	std::unique_lock<std::mutex> lock(mutex);
+	++counters.requests;
+	std::shared_ptr<Round> mine = next;
+	mine->files.insert(mine->files.end(), files.begin(), files.end());
+	mine->merged.insert(mine->merged.end(), merged.begin(), merged.end());
+	while(!mine->done) {
+		if(committing) {
+			finished.wait(lock);
+			continue;
+		}
+		// Commits the next round, which holds this request, for everyone in it
+		committing = true;
+		std::shared_ptr<Round> round = std::move(next);
+		next = std::make_shared<Round>();
+		lock.unlock();
+		try {
+			commit(*round);
+		} catch(...) {
+			// Failing everyone in the round, and leaving the next to commit
+			round->error = std::current_exception();
+		}
+		lock.lock();
+		committing = false;
+		round->done = true;
+		++counters.rounds;
+		finished.notify_all();
+	}
+	if(mine->error) {
+		std::rethrow_exception(mine->error);
+	}
+}
+
+void GroupCommit::commit(Round & round) {
+	// Each file once, grouped by the filesystem it is on
+	std::unordered_set<BackingFile::id_type> seen;
+	std::map<dev_t, std::vector<BackingFile const *>> byFilesystem;
+	try {
+		for(std::shared_ptr<BackingFile> const & file : round.files) {
+			if(seen.insert(file->id).second) {
+				struct stat statbuf;
+				fusepp::check_ret(::fstat(file->fd(), &statbuf));
+				byFilesystem[statbuf.st_dev].push_back(file.get());
+			}
+		}
+	} catch(...) {
+		round.error = std::current_exception();
+		return;
+	}
+
+	// Each sync is of a single file, or of a whole filesystem through any file on it
+	std::vector<std::pair<int, bool>> syncs;
+	for(auto const & entry : byFilesystem) {
+		if(entry.second.size() >= syncfsThreshold) {
+			syncs.emplace_back(entry.second.front()->fd(), true);
+		} else {
+			for(BackingFile const * file : entry.second) {
+				syncs.emplace_back(file->fd(), false);
+			}
+		}
+	}
+
+	std::mutex errorLock;
+	pool.parallelFor(syncs.size(), [&](std::size_t i) {
+		// Every sync is attempted, even once one has failed
+		int rc = syncs[i].second ? ::syncfs(syncs[i].first) : ::fdatasync(syncs[i].first);
+		if(rc < 0) {
+			std::lock_guard<std::mutex> lock(errorLock);
+			if(!round.error) {
+				round.error = std::make_exception_ptr(fusepp::fuse_error::from_errno());
+			}
+		}
+	});
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for(auto const & sync : syncs) {
+			++(sync.second ? counters.filesystemSyncs : counters.fileSyncs);
+		}
+	}
+	if(round.error) {
+		// The journals must not refer to data that may not be durable
+		return;
+	}
+
+	// The first sync of a journal covers the edits of every file on it
+	std::unordered_set<MergedFile const *> synced;
+	for(std::shared_ptr<MergedFile const> const & file : round.merged) {
+		if(synced.insert(file.get()).second) {
+			file->sync();
+			std::lock_guard<std::mutex> lock(mutex);
+			++counters.journalSyncs;
+		}
+	}
+}
+
+} // namespace smfs
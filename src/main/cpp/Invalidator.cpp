@@ -0,0 +1,118 @@
+/*
+ * Invalidator.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "smfs/Invalidator.h"
+#include "smfs/StatsLine.h"
+
+#include <fusepp/common.hpp>
+
+#include <algorithm>
+
+namespace smfs {
+
+std::string Invalidator::Stats::toString() const {
+	return StatsLine().count("changes", changes).count("merged", merged).count("notifications", notifications)
+			.count("uncached", uncached).count("errors", errors).str();
+}
+
+Invalidator::Invalidator(Sink sink)
+		: sink(std::move(sink)), worker([this]() { run(); }) {}
+
+Invalidator::~Invalidator() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	worker.join();
+}
+
+void Invalidator::changed(std::string const & path, off_t offset, off_t length) {
+	Change change;
+	change.path = path;
+	change.offset = offset;
+	change.length = length;
+	report(std::move(change));
+}
+
+void Invalidator::added(std::string const & path) {
+	Change change;
+	change.path = path;
+	change.entry = true;
+	report(std::move(change));
+}
+
+void Invalidator::report(Change change) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		++counters.changes;
+		auto found = pendingIndex.find({change.entry, change.path});
+		if(found == pendingIndex.end()) {
+			pendingIndex.emplace(std::make_pair(change.entry, change.path), pending.size());
+			pending.push_back(std::move(change));
+		} else {
+			++counters.merged;
+			Change & into = pending[found->second];
+			if(!change.entry) {
+				// Covers both ranges, and everything between them
+				off_t end = into.length && change.length
+						? std::max(into.offset + into.length, change.offset + change.length) : 0;
+				into.offset = std::min(into.offset, change.offset);
+				into.length = end ? end - into.offset : 0;
+			}
+			return;
+		}
+	}
+	wake.notify_all();
+}
+
+Invalidator::Stats Invalidator::wait() const {
+	std::unique_lock<std::mutex> lock(mutex);
+	wake.wait(lock, [this]() { return stopping || (pending.empty() && !passingOn); });
+	return counters;
+}
+
+Invalidator::Stats Invalidator::stats() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return counters;
+}
+
+void Invalidator::run() {
+	std::unique_lock<std::mutex> lock(mutex);
+	while(true) {
+		wake.wait(lock, [this]() { return stopping || !pending.empty(); });
+		if(stopping) {
+			return;
+		}
+		std::vector<Change> batch;
+		batch.swap(pending);
+		pendingIndex.clear();
+		passingOn = true;
+		lock.unlock();
+
+		for(Change const & change : batch) {
+			try {
+				sink(change);
+				std::lock_guard<std::mutex> guard(mutex);
+				++counters.notifications;
+			} catch(fusepp::fuse_error const & e) {
+				std::lock_guard<std::mutex> guard(mutex);
+				++(e.error == ENOENT ? counters.uncached : counters.errors);
+			}
+			std::lock_guard<std::mutex> guard(mutex);
+			if(stopping) {
+				break;
+			}
+		}
+
+		lock.lock();
+		passingOn = false;
+		wake.notify_all();
+	}
+}
+
+} // namespace smfs
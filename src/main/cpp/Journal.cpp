@@ -0,0 +1,298 @@
+/*
+ * Journal.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "smfs/Journal.h"
+#include "smfs/details/Manifest.h"
+
+#include <fusepp/util.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+extern "C" {
+	#include <sys/stat.h>
+	#include <unistd.h>
+}
+
+namespace smfs {
+
+using namespace details;
+
+namespace {
+
+/**
+ * The kind of the internal records that assign identifiers to backing file
+ * paths, so that segments need not repeat them.
+ */
+constexpr unsigned char backingRecord = 3;
+
+/**
+ * Each record is preceded by its length and checksum.
+ */
+constexpr std::size_t frameHeader = 8;
+
+std::uint32_t checksum(char const * data, std::size_t length) {
+	// FNV-1a
+	std::uint32_t hash = 2166136261u;
+	for(std::size_t i = 0; i < length; ++i) {
+		hash = (hash ^ static_cast<unsigned char>(data[i])) * 16777619u;
+	}
+	return hash;
+}
+
+void putString(std::string &out, std::string const & s) {
+	putVarint(out, s.size());
+	out += s;
+}
+
+std::string getString(unsigned char const * &p, unsigned char const * end) {
+	std::uint64_t length = getVarint(p, end);
+	if(length > static_cast<std::uint64_t>(end - p)) {
+		throw fusepp::fuse_error(EIO);
+	}
+	std::string rc(reinterpret_cast<char const *>(p), length);
+	p += length;
+	return rc;
+}
+
+int create(std::string const & path) {
+	return fusepp::check_ret(::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644));
+}
+
+} // namespace
+
+Journal::Journal(std::string const & path, std::uint64_t lastSequence)
+		: fd(create(path)), lastSequence(lastSequence), durableSequence(lastSequence) {}
+
+Journal::~Journal() {
+	std::unique_lock<std::mutex> lock(mutex);
+	while(flushing) {
+		committed.wait(lock);
+	}
+	if(!pending.empty() && !failure) {
+		try {
+			flush(lock);
+		} catch(...) {
+			// Nothing waits on these records
+		}
+	}
+	::close(fd);
+}
+
+void Journal::frame(std::string const & payload) {
+	std::uint32_t header[2] = {
+			static_cast<std::uint32_t>(payload.size()),
+			checksum(payload.data(), payload.size())
+	};
+	pending.append(reinterpret_cast<char const *>(header), sizeof(header));
+	pending += payload;
+	bytes += sizeof(header) + payload.size();
+}
+
+std::uint64_t Journal::append(JournalRecord::Kind kind, std::string const & path,
+		off_t offset, std::size_t length, SegmentTree const & segments,
+		std::shared_ptr<BackingFile> data) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if(failure) {
+		throw fusepp::fuse_error(EIO);
+	}
+	if(data && std::find(pendingData.begin(), pendingData.end(), data) == pendingData.end()) {
+		pendingData.push_back(std::move(data));
+	}
+
+	std::uint64_t sequence = lastSequence + 1;
+	std::string payload;
+	payload.push_back(kind);
+	putVarint(payload, sequence);
+	putString(payload, path);
+	putVarint(payload, offset);
+	putVarint(payload, length);
+	putVarint(payload, segments.count());
+	segments.forEachExtent(0, segments.size(), [&](Segment const & segment, off_t, std::size_t) {
+		auto it = backingIds.find(segment.file->path);
+		if(it == backingIds.end()) {
+			it = backingIds.emplace(segment.file->path, backingIds.size()).first;
+			std::string definition(1, backingRecord);
+			putVarint(definition, it->second);
+			putString(definition, it->first);
+			frame(definition);
+		}
+		putVarint(payload, it->second);
+		putVarint(payload, segment.offset);
+		putVarint(payload, segment.length);
+	});
+	frame(payload);
+	return lastSequence = sequence;
+}
+
+void Journal::flush(std::unique_lock<std::mutex> &lock) {
+	flushing = true;
+	std::string batch;
+	batch.swap(pending);
+	std::vector<std::shared_ptr<BackingFile>> data;
+	data.swap(pendingData);
+	std::uint64_t upTo = lastSequence;
+	lock.unlock();
+
+	std::exception_ptr error;
+	try {
+		for(std::shared_ptr<BackingFile> const & file : data) {
+			fusepp::check_ret(::fdatasync(file->fd()));
+		}
+		std::size_t written = 0;
+		while(written < batch.size()) {
+			ssize_t rc = ::write(fd, batch.data() + written, batch.size() - written);
+			if(rc < 0) {
+				if(errno == EINTR) {
+					continue;
+				}
+				throw fusepp::fuse_error::from_errno();
+			}
+			written += rc;
+		}
+		fusepp::check_ret(::fdatasync(fd));
+	} catch(...) {
+		error = std::current_exception();
+	}
+
+	lock.lock();
+	flushing = false;
+	if(error) {
+		failure = error;
+	} else {
+		durableSequence = upTo;
+	}
+	committed.notify_all();
+	if(error) {
+		std::rethrow_exception(error);
+	}
+}
+
+void Journal::sync(std::uint64_t sequence) {
+	std::unique_lock<std::mutex> lock(mutex);
+	while(durableSequence < sequence) {
+		if(failure) {
+			std::rethrow_exception(failure);
+		}
+		if(flushing) {
+			committed.wait(lock);
+		} else {
+			flush(lock);
+		}
+	}
+}
+
+void Journal::rotate(std::string const & path) {
+	std::unique_lock<std::mutex> lock(mutex);
+	while(flushing) {
+		committed.wait(lock);
+	}
+	// Records appended while flushing may refer to this file's backing ids
+	while(!pending.empty()) {
+		flush(lock);
+	}
+	if(failure) {
+		std::rethrow_exception(failure);
+	}
+	int next = create(path);
+	::close(fd);
+	fd = next;
+	backingIds.clear();
+	bytes = 0;
+}
+
+std::uint64_t Journal::sequence() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return lastSequence;
+}
+
+std::uint64_t Journal::size() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return bytes;
+}
+
+std::uint64_t Journal::replay(std::string const & path,
+		std::function<std::shared_ptr<BackingFile>(std::string const &)> const & open,
+		std::function<void(JournalRecord const &)> const & fn) {
+	int fd = fusepp::check_ret(::open(path.c_str(), O_RDWR | O_CLOEXEC));
+	std::string data;
+	try {
+		char buf[65536];
+		ssize_t rc;
+		while((rc = ::read(fd, buf, sizeof(buf))) != 0) {
+			if(rc < 0) {
+				if(errno == EINTR) {
+					continue;
+				}
+				throw fusepp::fuse_error::from_errno();
+			}
+			data.append(buf, rc);
+		}
+	} catch(...) {
+		::close(fd);
+		throw;
+	}
+
+	std::unordered_map<std::uint64_t, std::shared_ptr<BackingFile>> backing;
+	std::size_t good = 0;
+	while(data.size() - good >= frameHeader) {
+		std::uint32_t header[2];
+		std::memcpy(header, data.data() + good, sizeof(header));
+		char const * payload = data.data() + good + frameHeader;
+		if(header[0] == 0 || header[0] > data.size() - good - frameHeader
+				|| checksum(payload, header[0]) != header[1]) {
+			break;
+		}
+
+		unsigned char const * p = reinterpret_cast<unsigned char const *>(payload);
+		unsigned char const * end = p + header[0];
+		try {
+			unsigned char kind = *p++;
+			if(kind == backingRecord) {
+				std::uint64_t id = getVarint(p, end);
+				backing[id] = open(getString(p, end));
+			} else if(kind == JournalRecord::create || kind == JournalRecord::splice) {
+				JournalRecord record;
+				record.kind = static_cast<JournalRecord::Kind>(kind);
+				record.sequence = getVarint(p, end);
+				record.path = getString(p, end);
+				record.offset = getVarint(p, end);
+				record.length = getVarint(p, end);
+				std::uint64_t count = getVarint(p, end);
+				for(std::uint64_t i = 0; i < count; ++i) {
+					auto it = backing.find(getVarint(p, end));
+					if(it == backing.end()) {
+						throw fusepp::fuse_error(EIO);
+					}
+					off_t offset = getVarint(p, end);
+					record.segments.push_back(Segment{it->second, offset, getVarint(p, end)});
+				}
+				fn(record);
+			} else {
+				throw fusepp::fuse_error(EIO);
+			}
+		} catch(...) {
+			// A record that passed its checksum but cannot be decoded was not
+			// torn, so is not discarded
+			::close(fd);
+			throw;
+		}
+		good += frameHeader + header[0];
+	}
+
+	if(good < data.size()) {
+		if(::ftruncate(fd, good) != 0 || ::fdatasync(fd) != 0) {
+			fusepp::fuse_error err = fusepp::fuse_error::from_errno();
+			::close(fd);
+			throw err;
+		}
+	}
+	::close(fd);
+	return good;
+}
+
+} // namespace smfs
@@ -0,0 +1,232 @@
+/*
+ * Lz4.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "smfs/Lz4.h"
+
+#include <fusepp/common.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+namespace smfs {
+namespace lz4 {
+
+namespace {
+
+constexpr std::size_t minMatch = 4;
+
+/**
+ * The last match must start at least this many bytes before the end.
+ */
+constexpr std::size_t matchLimit = 12;
+
+/**
+ * The last this many bytes are always literals.
+ */
+constexpr std::size_t lastLiterals = 5;
+
+constexpr std::size_t maxOffset = 65535;
+
+constexpr unsigned hashBits = 14;
+
+inline std::uint32_t read32(unsigned char const * p) {
+	std::uint32_t rc;
+	std::memcpy(&rc, p, sizeof(rc));
+	return rc;
+}
+
+inline std::uint64_t read64(unsigned char const * p) {
+	std::uint64_t rc;
+	std::memcpy(&rc, p, sizeof(rc));
+	return rc;
+}
+
+inline std::uint32_t hash(std::uint32_t sequence) {
+	return (sequence * 2654435761u) >> (32 - hashBits);
+}
+
+/**
+ * Finds where a match stops.
+ * @param p The position after the part of the match found so far.
+ * @param q The corresponding position in the earlier copy.
+ * @param end The position the match may not extend past.
+ */
+inline unsigned char const * extend(unsigned char const * p, unsigned char const * q, unsigned char const * end) {
+	while(p + 8 <= end) {
+		std::uint64_t diff = read64(p) ^ read64(q);
+		if(diff) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+			return p + __builtin_ctzll(diff) / 8;
+#else
+			return p + __builtin_clzll(diff) / 8;
+#endif
+		}
+		p += 8;
+		q += 8;
+	}
+	while(p < end && *p == *q) {
+		++p;
+		++q;
+	}
+	return p;
+}
+
+/**
+ * Writes the remainder of a length that does not fit in its token nibble.
+ * @return Whether there was room.
+ */
+inline bool putLength(unsigned char * &op, unsigned char const * end, std::size_t length) {
+	for(; length >= 255; length -= 255) {
+		if(op == end) {
+			return false;
+		}
+		*op++ = 255;
+	}
+	if(op == end) {
+		return false;
+	}
+	*op++ = static_cast<unsigned char>(length);
+	return true;
+}
+
+inline std::size_t getLength(unsigned char const * &ip, unsigned char const * end) {
+	std::size_t rc = 0;
+	unsigned char byte;
+	do {
+		if(ip == end) {
+			throw fusepp::fuse_error(EIO);
+		}
+		byte = *ip++;
+		rc += byte;
+	} while(byte == 255);
+	return rc;
+}
+
+/**
+ * Writes a sequence of literals, followed by a match unless `matchLength` is zero.
+ * @return Whether there was room.
+ */
+bool putSequence(unsigned char * &op, unsigned char const * end, unsigned char const * literals,
+		std::size_t literalLength, std::size_t offset, std::size_t matchLength) {
+	if(op == end) {
+		return false;
+	}
+	unsigned char * token = op++;
+	*token = static_cast<unsigned char>(std::min<std::size_t>(literalLength, 15) << 4);
+	if(literalLength >= 15 && !putLength(op, end, literalLength - 15)) {
+		return false;
+	}
+	if(static_cast<std::size_t>(end - op) < literalLength) {
+		return false;
+	}
+	std::memcpy(op, literals, literalLength);
+	op += literalLength;
+	if(!matchLength) {
+		return true;
+	}
+
+	if(end - op < 2) {
+		return false;
+	}
+	*op++ = static_cast<unsigned char>(offset);
+	*op++ = static_cast<unsigned char>(offset >> 8);
+	std::size_t code = matchLength - minMatch;
+	*token |= static_cast<unsigned char>(std::min<std::size_t>(code, 15));
+	return code < 15 || putLength(op, end, code - 15);
+}
+
+} // namespace
+
+std::size_t compress(void const * src, std::size_t length, void * dst, std::size_t capacity) {
+	unsigned char const * const base = static_cast<unsigned char const *>(src);
+	unsigned char const * const end = base + length;
+	unsigned char * op = static_cast<unsigned char *>(dst);
+	unsigned char const * const opEnd = op + capacity;
+	unsigned char const * anchor = base;
+
+	if(length > matchLimit) {
+		std::unique_ptr<std::uint32_t[]> table(new std::uint32_t[std::size_t(1) << hashBits]());
+		unsigned char const * const matchEnd = end - lastLiterals;
+		unsigned char const * ip = base;
+		while(ip < end - matchLimit) {
+			std::uint32_t sequence = read32(ip);
+			std::uint32_t &slot = table[hash(sequence)];
+			unsigned char const * ref = base + slot;
+			slot = static_cast<std::uint32_t>(ip - base);
+			if(ref >= ip || static_cast<std::size_t>(ip - ref) > maxOffset || read32(ref) != sequence) {
+				++ip;
+				continue;
+			}
+
+			unsigned char const * p = extend(ip + minMatch, ref + minMatch, matchEnd);
+			if(!putSequence(op, opEnd, anchor, ip - anchor, ip - ref, p - ip)) {
+				return 0;
+			}
+			ip = anchor = p;
+		}
+	}
+	if(!putSequence(op, opEnd, anchor, end - anchor, 0, 0)) {
+		return 0;
+	}
+	return op - static_cast<unsigned char *>(dst);
+}
+
+std::size_t decompress(void const * src, std::size_t length, void * dst, std::size_t capacity) {
+	unsigned char const * ip = static_cast<unsigned char const *>(src);
+	unsigned char const * const end = ip + length;
+	unsigned char * const base = static_cast<unsigned char *>(dst);
+	unsigned char * op = base;
+	unsigned char * const opEnd = base + capacity;
+
+	while(ip < end) {
+		unsigned token = *ip++;
+		std::size_t literalLength = token >> 4;
+		if(literalLength == 15) {
+			literalLength += getLength(ip, end);
+		}
+		if(static_cast<std::size_t>(end - ip) < literalLength || static_cast<std::size_t>(opEnd - op) < literalLength) {
+			throw fusepp::fuse_error(EIO);
+		}
+		std::memcpy(op, ip, literalLength);
+		ip += literalLength;
+		op += literalLength;
+		if(ip == end) {
+			break;
+		}
+
+		if(end - ip < 2) {
+			throw fusepp::fuse_error(EIO);
+		}
+		std::size_t offset = ip[0] | (std::size_t(ip[1]) << 8);
+		ip += 2;
+		std::size_t matchLength = token & 15;
+		if(matchLength == 15) {
+			matchLength += getLength(ip, end);
+		}
+		matchLength += minMatch;
+		if(!offset || offset > static_cast<std::size_t>(op - base)
+				|| static_cast<std::size_t>(opEnd - op) < matchLength) {
+			throw fusepp::fuse_error(EIO);
+		}
+		unsigned char const * match = op - offset;
+		if(offset >= matchLength) {
+			std::memcpy(op, match, matchLength);
+			op += matchLength;
+		} else {
+			// The match overlaps the output, repeating its last `offset` bytes
+			for(std::size_t i = 0; i < matchLength; ++i) {
+				*op++ = match[i];
+			}
+		}
+	}
+	return op - base;
+}
+
+} // namespace lz4
+} // namespace smfs
@@ -0,0 +1,350 @@
+/*
+ * Manifest.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "smfs/Manifest.h"
+#include "smfs/CompressedFile.h"
+#include "smfs/MergedFile.h"
+#include "smfs/MerkleTree.h"
+
+#include <fusepp/util.hpp>
+
+#include <cstring>
+
+extern "C" {
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+}
+
+namespace smfs {
+
+using namespace details;
+
+/*
+ * ======================================================
+ * Manifest
+ * ======================================================
+ */
+
+namespace {
+
+/**
+ * Checks that a table lies within the mapping.
+ */
+void checkTable(std::size_t length, std::uint64_t offset, std::uint64_t count, std::size_t entrySize) {
+	if(offset > length || offset % 8 || count > (length - offset) / entrySize) {
+		throw fusepp::fuse_error(EINVAL);
+	}
+}
+
+void checkString(ManifestHeader const & header, ManifestString const & s) {
+	if(s.offset > header.stringsSize || s.length > header.stringsSize - s.offset) {
+		throw fusepp::fuse_error(EINVAL);
+	}
+}
+
+} // namespace
+
+std::shared_ptr<Manifest const> Manifest::open(std::string const & path) {
+	int fd = fusepp::check_ret(::open(path.c_str(), O_RDONLY | O_CLOEXEC));
+	struct stat statbuf;
+	if(::fstat(fd, &statbuf) != 0) {
+		fusepp::fuse_error err = fusepp::fuse_error::from_errno();
+		::close(fd);
+		throw err;
+	}
+	std::size_t length = statbuf.st_size;
+	if(length < sizeof(ManifestHeader)) {
+		::close(fd);
+		throw fusepp::fuse_error(EINVAL);
+	}
+	void * mapping = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if(mapping == MAP_FAILED) {
+		throw fusepp::fuse_error::from_errno();
+	}
+	return std::shared_ptr<Manifest const>(new Manifest(mapping, length));
+}
+
+Manifest::Manifest(void * mapping, std::size_t length)
+		: mapping(mapping), length(length), header(static_cast<ManifestHeader const *>(mapping)) {
+	unsigned char const * base = static_cast<unsigned char const *>(mapping);
+	try {
+		if(std::memcmp(header->magic, manifestMagic, sizeof(manifestMagic)) != 0
+				|| header->version != manifestVersion
+				|| header->byteOrder != manifestByteOrder
+				|| header->length != length) {
+			throw fusepp::fuse_error(EINVAL);
+		}
+		checkTable(length, header->stringsOffset, header->stringsSize, 1);
+		checkTable(length, header->backingOffset, header->backingCount, sizeof(ManifestBacking));
+		checkTable(length, header->filesOffset, header->fileCount, sizeof(ManifestFile));
+		checkTable(length, header->checkpointsOffset, header->checkpointCount, sizeof(ManifestCheckpoint));
+		checkTable(length, header->recordsOffset, header->recordsSize, 1);
+		checkTable(length, header->checksumsOffset, header->checksumCount, sizeof(std::uint32_t));
+		checkTable(length, header->digestsOffset, header->digestCount, sizeof(Digest));
+
+		backingTable = reinterpret_cast<ManifestBacking const *>(base + header->backingOffset);
+		fileTable = reinterpret_cast<ManifestFile const *>(base + header->filesOffset);
+		checkpoints = reinterpret_cast<ManifestCheckpoint const *>(base + header->checkpointsOffset);
+		records = base + header->recordsOffset;
+		checksumTable = reinterpret_cast<std::uint32_t const *>(base + header->checksumsOffset);
+		digestTable = base + header->digestsOffset;
+
+		for(std::size_t i = 0; i < header->backingCount; ++i) {
+			ManifestBacking const & backing = backingTable[i];
+			checkString(*header, backing.path);
+			if(backing.checksumBlockSize) {
+				std::uint64_t count = (backing.checksummedSize + backing.checksumBlockSize - 1) / backing.checksumBlockSize;
+				if(backing.firstChecksum > header->checksumCount
+						|| count > header->checksumCount - backing.firstChecksum) {
+					throw fusepp::fuse_error(EINVAL);
+				}
+			}
+		}
+		for(std::size_t i = 0; i < header->fileCount; ++i) {
+			ManifestFile const & file = fileTable[i];
+			checkString(*header, file.path);
+			std::uint64_t expected = (file.segmentCount + manifestCheckpointStride - 1) / manifestCheckpointStride;
+			if(file.checkpointCount != expected
+					|| (file.size == 0) != (file.segmentCount == 0)
+					|| file.firstCheckpoint > header->checkpointCount
+					|| file.checkpointCount > header->checkpointCount - file.firstCheckpoint) {
+				throw fusepp::fuse_error(EINVAL);
+			}
+			if(file.merkleLeafSize) {
+				std::uint64_t nodes = MerkleTree::nodeCount(MerkleTree::leafCount(file.size, file.merkleLeafSize));
+				if(file.firstDigest > header->digestCount || nodes > header->digestCount - file.firstDigest) {
+					throw fusepp::fuse_error(EINVAL);
+				}
+			}
+		}
+		for(std::size_t i = 0; i < header->checkpointCount; ++i) {
+			if(checkpoints[i].record >= header->recordsSize) {
+				throw fusepp::fuse_error(EINVAL);
+			}
+		}
+		for(std::size_t i = 0; i < header->fileCount; ++i) {
+			ManifestFile const & file = fileTable[i];
+			if(file.checkpointCount && checkpoints[file.firstCheckpoint].start != 0) {
+				throw fusepp::fuse_error(EINVAL);
+			}
+		}
+	} catch(...) {
+		::munmap(mapping, length);
+		throw;
+	}
+
+	opened.reset(new std::once_flag[header->backingCount]);
+	backingFiles.resize(header->backingCount);
+}
+
+Manifest::~Manifest() {
+	::munmap(mapping, length);
+}
+
+std::shared_ptr<BackingFile> const & Manifest::backing(std::size_t index) const {
+	std::call_once(opened[index], [&]() {
+		ManifestBacking const & entry = backingTable[index];
+		std::shared_ptr<BackingFile> file = CompressedFile::openAny(std::string(string(entry.path)));
+		if(entry.checksumBlockSize) {
+			std::uint32_t const * first = checksumTable + entry.firstChecksum;
+			std::size_t count = (entry.checksummedSize + entry.checksumBlockSize - 1) / entry.checksumBlockSize;
+			file->attachChecksums(std::make_shared<BlockChecksums>(entry.checksumBlockSize, entry.checksummedSize,
+					std::vector<std::uint32_t>(first, first + count)));
+		}
+		backingFiles[index] = std::move(file);
+	});
+	return backingFiles[index];
+}
+
+std::shared_ptr<MerkleTree const> Manifest::merkleTree(std::size_t file) const {
+	ManifestFile const & entry = fileTable[file];
+	if(!entry.merkleLeafSize) {
+		return nullptr;
+	}
+	std::vector<Digest> nodes(MerkleTree::nodeCount(MerkleTree::leafCount(entry.size, entry.merkleLeafSize)));
+	std::memcpy(nodes.data(), digestTable + entry.firstDigest * sizeof(Digest), nodes.size() * sizeof(Digest));
+	return std::make_shared<MerkleTree>(entry.merkleLeafSize, entry.size, std::move(nodes));
+}
+
+std::vector<Segment> Manifest::segments(std::size_t file) const {
+	std::vector<Segment> rc;
+	rc.reserve(segmentCount(file));
+	forEachExtent(file, 0, size(file), [&](Segment const & segment, off_t, std::size_t) {
+		rc.push_back(segment);
+	});
+	return rc;
+}
+
+std::vector<off_t> Manifest::boundaries(std::size_t file) const {
+	ManifestFile const & entry = fileTable[file];
+	std::vector<off_t> rc;
+	rc.reserve(entry.segmentCount);
+	if(!entry.segmentCount) {
+		return rc;
+	}
+	RecordDecoder decoder(records + checkpoints[entry.firstCheckpoint].record, records + header->recordsSize);
+	off_t end = 0;
+	for(std::size_t index = 0; index < entry.segmentCount; ++index) {
+		if(index % manifestCheckpointStride == 0) {
+			decoder.reset();
+		}
+		end += decoder.next().length;
+		rc.push_back(end);
+	}
+	return rc;
+}
+
+/*
+ * ======================================================
+ * ManifestWriter
+ * ======================================================
+ */
+
+ManifestString ManifestWriter::intern(std::string const & s) {
+	ManifestString rc{strings.size(), s.size()};
+	strings += s;
+	return rc;
+}
+
+std::uint64_t ManifestWriter::backing(std::string const & path, BlockChecksums const * sums) {
+	auto it = backingIndex.find(path);
+	if(it != backingIndex.end()) {
+		if(sums && !backingTable[it->second].checksumBlockSize) {
+			recordChecksums(backingTable[it->second], *sums);
+		}
+		return it->second;
+	}
+	backingTable.push_back(ManifestBacking{intern(path), 0, 0, 0});
+	if(sums) {
+		recordChecksums(backingTable.back(), *sums);
+	}
+	return backingIndex[path] = backingTable.size() - 1;
+}
+
+void ManifestWriter::recordChecksums(ManifestBacking &entry, BlockChecksums const & sums) {
+	entry.checksumBlockSize = sums.blockSize();
+	entry.checksummedSize = sums.size();
+	entry.firstChecksum = checksums.size();
+	checksums.insert(checksums.end(), sums.checksums().begin(), sums.checksums().end());
+}
+
+void ManifestWriter::computeChecksums(std::size_t blockSize) {
+	for(ManifestBacking &entry : backingTable) {
+		if(!entry.checksumBlockSize) {
+			std::string path = strings.substr(entry.path.offset, entry.path.length);
+			recordChecksums(entry, *BlockChecksums::compute(*CompressedFile::openAny(path), blockSize));
+		}
+	}
+}
+
+void ManifestWriter::addRecord(ManifestFile &entry, RecordEncoder &encoder, SegmentRecord const & record) {
+	if(entry.segmentCount % manifestCheckpointStride == 0) {
+		checkpoints.push_back(ManifestCheckpoint{entry.size, records.size()});
+		++entry.checkpointCount;
+		encoder.reset();
+	}
+	encoder.put(records, record);
+	entry.size += record.length;
+	++entry.segmentCount;
+}
+
+void ManifestWriter::add(std::string const & path, MergedFile const & file) {
+	MergedFile::Snapshot snapshot = file.snapshot();
+	ManifestFile entry{intern(path), 0, 0, checkpoints.size(), 0, snapshot.sequence, 0, 0};
+	RecordEncoder encoder;
+	snapshot.forEachExtent(0, snapshot.size(), [&](Segment const & segment, off_t inSegment, std::size_t length) {
+		addRecord(entry, encoder, SegmentRecord{backing(segment.file->path, segment.file->checksums().get()),
+				segment.offset + inSegment, length});
+	});
+	if(snapshot.merkle) {
+		entry.merkleLeafSize = snapshot.merkle->leafSize();
+		entry.firstDigest = digests.size() / sizeof(Digest);
+		digests.append(reinterpret_cast<char const *>(snapshot.merkle->all().data()),
+				snapshot.merkle->all().size() * sizeof(Digest));
+	}
+	fileTable.push_back(entry);
+}
+
+void ManifestWriter::addRanges(std::string const & path, std::string const & backingPath,
+		std::vector<off_t> const & ends, std::uint64_t sequence) {
+	ManifestFile entry{intern(path), 0, 0, checkpoints.size(), 0, sequence, 0, 0};
+	RecordEncoder encoder;
+	std::uint64_t file = backing(backingPath);
+	off_t start = 0;
+	for(off_t end : ends) {
+		addRecord(entry, encoder, SegmentRecord{file, start, static_cast<std::size_t>(end - start)});
+		start = end;
+	}
+	fileTable.push_back(entry);
+}
+
+namespace {
+
+template<typename T>
+void appendTable(std::string &out, std::uint64_t &offset, T const * data, std::size_t bytes) {
+	out.resize((out.size() + 7) & ~std::size_t(7));
+	offset = out.size();
+	out.append(reinterpret_cast<char const *>(data), bytes);
+}
+
+void writeAll(int fd, std::string const & data) {
+	std::size_t written = 0;
+	while(written < data.size()) {
+		ssize_t rc = ::write(fd, data.data() + written, data.size() - written);
+		if(rc < 0) {
+			if(errno == EINTR) {
+				continue;
+			}
+			throw fusepp::fuse_error::from_errno();
+		}
+		written += rc;
+	}
+}
+
+} // namespace
+
+void ManifestWriter::write(std::string const & path) const {
+	ManifestHeader header{};
+	std::memcpy(header.magic, manifestMagic, sizeof(manifestMagic));
+	header.version = manifestVersion;
+	header.byteOrder = manifestByteOrder;
+
+	std::string out(sizeof(header), '\0');
+	appendTable(out, header.stringsOffset, strings.data(), strings.size());
+	header.stringsSize = strings.size();
+	appendTable(out, header.backingOffset, backingTable.data(), backingTable.size() * sizeof(ManifestBacking));
+	header.backingCount = backingTable.size();
+	appendTable(out, header.filesOffset, fileTable.data(), fileTable.size() * sizeof(ManifestFile));
+	header.fileCount = fileTable.size();
+	appendTable(out, header.checkpointsOffset, checkpoints.data(), checkpoints.size() * sizeof(ManifestCheckpoint));
+	header.checkpointCount = checkpoints.size();
+	appendTable(out, header.recordsOffset, records.data(), records.size());
+	header.recordsSize = records.size();
+	appendTable(out, header.checksumsOffset, checksums.data(), checksums.size() * sizeof(std::uint32_t));
+	header.checksumCount = checksums.size();
+	appendTable(out, header.digestsOffset, digests.data(), digests.size());
+	header.digestCount = digests.size() / sizeof(Digest);
+	header.length = out.size();
+	std::memcpy(&out[0], &header, sizeof(header));
+
+	std::string temp = path + ".tmp";
+	int fd = fusepp::check_ret(::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+	try {
+		writeAll(fd, out);
+		fusepp::check_ret(::fsync(fd));
+	} catch(...) {
+		::close(fd);
+		::unlink(temp.c_str());
+		throw;
+	}
+	::close(fd);
+	fusepp::check_ret(::rename(temp.c_str(), path.c_str()));
+}
+
+} // namespace smfs
@@ -0,0 +1,204 @@
+/*
+ * ManifestStore.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "smfs/ManifestStore.h"
+#include "smfs/CompressedFile.h"
+#include "smfs/Manifest.h"
+
+#include <fusepp/util.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <map>
+#include <unordered_map>
+
+extern "C" {
+	#include <dirent.h>
+	#include <unistd.h>
+}
+
+namespace smfs {
+
+namespace {
+
+constexpr char const * journalPrefix = "journal.";
+
+/**
+ * How often the background compactor checks the size of the journals.
+ */
+constexpr std::chrono::milliseconds compactorInterval(500);
+
+} // namespace
+
+ManifestStore::ManifestStore(std::string directory, std::uint64_t compactThreshold)
+		: directory(std::move(directory)), compactThreshold(compactThreshold) {}
+
+ManifestStore::~ManifestStore() {
+	{
+		std::lock_guard<std::mutex> lock(compactorLock);
+		stopping = true;
+	}
+	wake.notify_all();
+	if(compactor.joinable()) {
+		compactor.join();
+	}
+}
+
+std::string ManifestStore::manifestPath() const {
+	return directory + "/manifest";
+}
+
+std::string ManifestStore::journalPath(std::uint64_t generation) const {
+	return directory + "/" + journalPrefix + std::to_string(generation);
+}
+
+std::vector<std::uint64_t> ManifestStore::journalGenerations() const {
+	DIR * dir = ::opendir(directory.c_str());
+	if(!dir) {
+		throw fusepp::fuse_error::from_errno();
+	}
+	std::vector<std::uint64_t> rc;
+	std::size_t prefixLength = std::char_traits<char>::length(journalPrefix);
+	while(struct dirent * entry = ::readdir(dir)) {
+		std::string name = entry->d_name;
+		if(name.compare(0, prefixLength, journalPrefix) == 0 && name.size() > prefixLength) {
+			char * end;
+			std::uint64_t generation = std::strtoull(name.c_str() + prefixLength, &end, 10);
+			if(*end == '\0') {
+				rc.push_back(generation);
+			}
+		}
+	}
+	::closedir(dir);
+	std::sort(rc.begin(), rc.end());
+	return rc;
+}
+
+void ManifestStore::syncDirectory() const {
+	int fd = fusepp::check_ret(::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+	int rc = ::fsync(fd);
+	::close(fd);
+	fusepp::check_ret(rc);
+}
+
+ManifestStore::Files ManifestStore::recover(std::shared_ptr<BlockCache> cache) {
+	std::lock_guard<std::mutex> lock(compactLock);
+
+	std::map<std::string, std::pair<std::shared_ptr<MergedFile>, std::uint64_t>> files;
+	std::uint64_t lastSequence = 0;
+
+	if(::access(manifestPath().c_str(), F_OK) == 0) {
+		std::shared_ptr<Manifest const> manifest = Manifest::open(manifestPath());
+		for(std::size_t i = 0; i < manifest->fileCount(); ++i) {
+			std::uint64_t sequence = manifest->sequence(i);
+			files[std::string(manifest->path(i))] = {std::make_shared<MergedFile>(manifest, i, cache), sequence};
+			lastSequence = std::max(lastSequence, sequence);
+		}
+	}
+
+	std::unordered_map<std::string, std::shared_ptr<BackingFile>> backing;
+	auto open = [&](std::string const & path) {
+		std::shared_ptr<BackingFile> &file = backing[path];
+		if(!file) {
+			file = CompressedFile::openAny(path);
+		}
+		return file;
+	};
+
+	std::vector<std::uint64_t> generations = journalGenerations();
+	for(std::uint64_t g : generations) {
+		replayedBytes += Journal::replay(journalPath(g), open, [&](JournalRecord const & record) {
+			lastSequence = std::max(lastSequence, record.sequence);
+			auto it = files.find(record.path);
+			if(it != files.end() && record.sequence <= it->second.second) {
+				// Already reflected in the base manifest
+				return;
+			}
+
+			if(record.kind == JournalRecord::create) {
+				if(it != files.end()) {
+					throw fusepp::fuse_error(EIO);
+				}
+				files[record.path] = {std::make_shared<MergedFile>(record.segments, cache), record.sequence};
+			} else {
+				if(it == files.end()) {
+					throw fusepp::fuse_error(EIO);
+				}
+				it->second.first->splice(record.offset, record.length, SegmentTree(record.segments));
+				it->second.second = record.sequence;
+			}
+		});
+	}
+
+	generation = generations.empty() ? 1 : generations.back() + 1;
+	journal = std::make_shared<Journal>(journalPath(generation), lastSequence);
+	syncDirectory();
+
+	Files rc;
+	for(auto &entry : files) {
+		entry.second.first->attach(journal, entry.first, entry.second.second);
+		rc.emplace_back(entry.first, entry.second.first);
+	}
+	return rc;
+}
+
+std::shared_ptr<MergedFile> ManifestStore::create(std::string const & path, std::vector<Segment> segments,
+		std::shared_ptr<BlockCache> cache) {
+	std::shared_ptr<MergedFile> file = std::make_shared<MergedFile>(std::move(segments), std::move(cache));
+	std::uint64_t sequence = journal->append(JournalRecord::create, path, 0, 0, *file->segments());
+	file->attach(journal, path, sequence);
+	return file;
+}
+
+void ManifestStore::compact(Files const & files) {
+	std::lock_guard<std::mutex> lock(compactLock);
+
+	// Edits from here on go to the new journal, which is kept
+	std::uint64_t next = generation + 1;
+	journal->rotate(journalPath(next));
+	generation = next;
+	syncDirectory();
+
+	ManifestWriter writer;
+	for(auto const & entry : files) {
+		writer.add(entry.first, *entry.second);
+	}
+	writer.write(manifestPath());
+	syncDirectory();
+
+	for(std::uint64_t g : journalGenerations()) {
+		if(g < next) {
+			::unlink(journalPath(g).c_str());
+		}
+	}
+	replayedBytes = 0;
+}
+
+void ManifestStore::startCompactor(std::function<Files()> files) {
+	compactor = std::thread([this, files]() {
+		std::unique_lock<std::mutex> lock(compactorLock);
+		while(!wake.wait_for(lock, compactorInterval, [this]() { return stopping; })) {
+			if(journalSize() < compactThreshold) {
+				continue;
+			}
+			lock.unlock();
+			try {
+				compact(files());
+			} catch(fusepp::fuse_error const &) {
+				// The journals are kept, so try again later
+			}
+			lock.lock();
+		}
+	});
+}
+
+std::uint64_t ManifestStore::journalSize() const {
+	return replayedBytes + journal->size();
+}
+
+} // namespace smfs
@@ -0,0 +1,346 @@
+/*
+ * MergedFile.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#include "smfs/MergedFile.h"
+#include "smfs/MerkleTree.h"
+#include "smfs/ThreadPool.h"
+
+#include <fusepp/common.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <utility>
+
+namespace smfs {
+
+MergedFile::MergedFile(std::vector<Segment> segments, std::shared_ptr<BlockCache> cache)
+		: layout(std::make_shared<SegmentTree>(segments)),
+		  blockCache(std::move(cache)) {}
+
+MergedFile::MergedFile(std::shared_ptr<Manifest const> manifest, std::size_t index, std::shared_ptr<BlockCache> cache)
+		: blockCache(std::move(cache)),
+		  manifest(std::move(manifest)),
+		  manifestIndex(index),
+		  journalSequence(this->manifest->sequence(index)),
+		  merkle(this->manifest->merkleTree(index)) {}
+
+std::shared_ptr<SegmentTree const> MergedFile::loaded() const {
+	std::shared_ptr<SegmentTree const> tree = std::atomic_load(&layout);
+	if(!tree) {
+		tree = std::make_shared<SegmentTree>(manifest->segments(manifestIndex));
+		std::atomic_store(&layout, tree);
+	}
+	return tree;
+}
+
+SegmentTree MergedFile::range(off_t offset, std::size_t nbytes) const {
+	std::shared_ptr<SegmentTree const> tree = std::atomic_load(&layout);
+	if(tree) {
+		return tree->range(offset, nbytes);
+	}
+	std::vector<Segment> segments;
+	manifest->forEachExtent(manifestIndex, offset, nbytes, [&](Segment const & segment, off_t inSegment, std::size_t length) {
+		segments.push_back(Segment{segment.file, segment.offset + inSegment, length});
+	});
+	return SegmentTree(segments);
+}
+
+std::size_t MergedFile::read(void * buf, std::size_t nbytes, off_t offset) const {
+	struct Extent {
+		BackingFile const * file;
+		off_t offset;
+		std::size_t length;
+		char * out;
+	};
+
+	if(offset >= size()) {
+		return 0;
+	}
+	// Hold on to the segments, so their files stay open while they are read
+	SegmentTree segments = range(offset, nbytes);
+	std::vector<Extent> extents;
+	std::vector<std::vector<Extent const *>> byFile;
+	std::unordered_map<BackingFile const *, std::size_t> fileIndex;
+	char * out = static_cast<char *>(buf);
+	segments.forEachExtent(0, segments.size(), [&](Segment const & segment, off_t inSegment, std::size_t length) {
+		extents.push_back(Extent{segment.file.get(), segment.offset + inSegment, length, out});
+		out += length;
+	});
+	for(Extent const & extent : extents) {
+		auto inserted = fileIndex.emplace(extent.file, byFile.size());
+		if(inserted.second) {
+			byFile.emplace_back();
+		}
+		byFile[inserted.first->second].push_back(&extent);
+	}
+
+	auto readExtent = [&](Extent const & extent) {
+		if(blockCache) {
+			char * to = extent.out;
+			blockCache->read(*extent.file, extent.offset, extent.length,
+					[&](std::shared_ptr<Block> block, std::size_t inBlock, std::size_t n) {
+				std::memcpy(to, block->data() + inBlock, n);
+				to += n;
+			});
+			if(to != extent.out + extent.length) {
+				throw fusepp::fuse_error(EIO);
+			}
+		} else if(extent.file->read(extent.out, extent.length, extent.offset) != extent.length) {
+			throw fusepp::fuse_error(EIO);
+		}
+	};
+	std::size_t total = out - static_cast<char *>(buf);
+	if(byFile.size() > 1 && total >= parallelReadSize) {
+		// Each backing file is read in order on one thread, so each device sees
+		// a sequential stream
+		ThreadPool::io().parallelFor(byFile.size(), [&](std::size_t i) {
+			for(Extent const * extent : byFile[i]) {
+				readExtent(*extent);
+			}
+		});
+	} else {
+		for(Extent const & extent : extents) {
+			readExtent(extent);
+		}
+	}
+	return total;
+}
+
+bool MergedFile::readsInParallel(off_t offset, std::size_t nbytes) const {
+	if(nbytes < parallelReadSize) {
+		return false;
+	}
+	BackingFile const * first = nullptr;
+	bool several = false;
+	forEachExtent(offset, nbytes, [&](Segment const & segment, off_t, std::size_t) {
+		if(!first) {
+			first = segment.file.get();
+		} else if(segment.file.get() != first) {
+			several = true;
+		}
+	});
+	return several;
+}
+
+MergedFile::Snapshot MergedFile::snapshot() const {
+	std::lock_guard<std::mutex> lock(editLock);
+	return Snapshot{std::atomic_load(&layout), manifest, manifestIndex, journalSequence, version,
+			merkleVersion == version ? merkle : nullptr};
+}
+
+std::shared_ptr<MerkleTree const> MergedFile::merkleTree() const {
+	// Concurrent callers wait for a single build rather than each hashing
+	std::lock_guard<std::mutex> building(merkleLock);
+	Snapshot current = snapshot();
+	if(current.merkle) {
+		return current.merkle;
+	}
+	std::shared_ptr<MerkleTree const> tree = std::make_shared<MerkleTree>(MerkleTree::build(current));
+	std::lock_guard<std::mutex> lock(editLock);
+	if(version == current.version) {
+		merkle = tree;
+		merkleVersion = version;
+	}
+	return tree;
+}
+
+std::shared_ptr<MerkleTree const> MergedFile::merkleTreeInBackground(std::shared_ptr<MergedFile const> file) {
+	{
+		std::lock_guard<std::mutex> lock(file->editLock);
+		if(file->merkle && file->merkleVersion == file->version) {
+			return file->merkle;
+		}
+		if(file->merkleError) {
+			int error = file->merkleError;
+			file->merkleError = 0;
+			file->merkleRequested = UINT64_MAX;
+			throw fusepp::fuse_error(error);
+		}
+		if(file->merkleRequested == file->version) {
+			return nullptr;
+		}
+		file->merkleRequested = file->version;
+	}
+	ThreadPool::shared().submit([file]() {
+		try {
+			file->merkleTree();
+		} catch(fusepp::fuse_error const & e) {
+			std::lock_guard<std::mutex> lock(file->editLock);
+			file->merkleError = e.error;
+		}
+	});
+	return nullptr;
+}
+
+void MergedFile::attach(std::shared_ptr<Journal> journal, std::string path, std::uint64_t sequence) {
+	this->journal = std::move(journal);
+	journalPath = std::move(path);
+	journalSequence = sequence;
+}
+
+void MergedFile::listen(std::function<void(off_t offset, off_t length)> listener) {
+	this->listener = std::move(listener);
+}
+
+void MergedFile::hold(DedupStore::References references) {
+	interned.emplace(std::move(references));
+}
+
+void MergedFile::sync() const {
+	std::uint64_t sequence;
+	{
+		std::lock_guard<std::mutex> lock(editLock);
+		sequence = journalSequence;
+	}
+	if(journal) {
+		journal->sync(sequence);
+	}
+}
+
+void MergedFile::abandon(std::uint64_t editVersion, std::shared_ptr<SegmentTree const> previous,
+		off_t offset, off_t length, bool notify) {
+	{
+		std::lock_guard<std::mutex> lock(editLock);
+		// The journal's failure sticks, so every edit after this one fails
+		// too; whichever of them is abandoned first, the earliest wins
+		if(editVersion < abandonedFrom) {
+			abandonedFrom = editVersion;
+			++version;
+			std::atomic_store(&layout, std::move(previous));
+		}
+	}
+	if(notify && listener) {
+		listener(offset, length);
+	}
+}
+
+void MergedFile::splice(off_t offset, std::size_t nbytes, SegmentTree const & replacement) {
+	edit([&](SegmentTree const & current) {
+		if(offset > current.size()) {
+			throw fusepp::fuse_error(EINVAL);
+		}
+		return Splice{offset, nbytes, replacement};
+	});
+}
+
+std::size_t MergedFile::write(DeltaLog & log, void const * data, std::size_t nbytes, off_t offset) {
+	if(offset > size()) {
+		throw fusepp::fuse_error(EINVAL);
+	}
+	if(!nbytes) {
+		return 0;
+	}
+	return placeWritten(log.append(data, nbytes), offset);
+}
+
+std::size_t MergedFile::write(DeltaLog & log, std::size_t nbytes, off_t offset, DeltaLog::Fill const & fill) {
+	if(offset > size()) {
+		throw fusepp::fuse_error(EINVAL);
+	}
+	if(!nbytes) {
+		return 0;
+	}
+	return placeWritten(log.append(nbytes, fill), offset);
+}
+
+std::size_t MergedFile::placeWritten(Segment const & written, off_t offset) {
+	edit([&](SegmentTree const & current) {
+		if(offset > current.size()) {
+			throw fusepp::fuse_error(EINVAL);
+		}
+		return Splice{offset, written.length, SegmentTree(std::vector<Segment>{written})};
+	}, false, written.file);
+	return written.length;
+}
+
+namespace {
+
+/**
+ * @return The ranges of backing files making up some segments, with ranges
+ *         that follow on from one another joined, so that the same data is
+ *         always described the same way.
+ */
+std::vector<Segment> runs(SegmentTree const & tree, off_t offset, std::size_t nbytes) {
+	std::vector<Segment> rc;
+	tree.forEachExtent(offset, nbytes, [&](Segment const & segment, off_t inSegment, std::size_t length) {
+		off_t start = segment.offset + inSegment;
+		if(!rc.empty() && rc.back().file == segment.file
+				&& rc.back().offset + static_cast<off_t>(rc.back().length) == start) {
+			rc.back().length += length;
+		} else {
+			rc.push_back(Segment{segment.file, start, length});
+		}
+	});
+	return rc;
+}
+
+} // namespace
+
+bool MergedFile::replaceIfUnchanged(off_t offset, SegmentTree const & expected, SegmentTree const & replacement) {
+	if(expected.size() != replacement.size()) {
+		throw fusepp::fuse_error(EINVAL);
+	}
+	std::size_t length = expected.size();
+	std::vector<Segment> wanted = runs(expected, 0, length);
+	return edit([&](SegmentTree const & current) -> std::optional<Splice> {
+		if(offset + static_cast<off_t>(length) > current.size()) {
+			return std::nullopt;
+		}
+		std::vector<Segment> now = runs(current, offset, length);
+		bool same = now.size() == wanted.size() && std::equal(now.begin(), now.end(), wanted.begin(),
+				[](Segment const & a, Segment const & b) {
+			return a.file == b.file && a.offset == b.offset && a.length == b.length;
+		});
+		if(!same) {
+			return std::nullopt;
+		}
+		return Splice{offset, length, replacement};
+	}, false);
+}
+
+std::size_t MergedFile::copyFrom(MergedFile const & source, off_t sourceOffset, off_t offset, std::size_t nbytes) {
+	SegmentTree copied = source.range(sourceOffset, nbytes);
+	std::size_t length = copied.size();
+
+	edit([&](SegmentTree const & current) {
+		if(offset > current.size()) {
+			throw fusepp::fuse_error(EINVAL);
+		}
+		return Splice{offset, length, copied};
+	});
+	return length;
+}
+
+std::size_t MergedFile::append(MergedFile const & source) {
+	SegmentTree appended = source.range(0, source.size());
+
+	edit([&](SegmentTree const & current) {
+		return Splice{current.size(), 0, appended};
+	});
+	return appended.size();
+}
+
+void MergedFile::cut(off_t offset, std::size_t nbytes) {
+	edit([&](SegmentTree const & current) {
+		if(offset > current.size()) {
+			throw fusepp::fuse_error(EINVAL);
+		}
+		return Splice{offset, nbytes, SegmentTree()};
+	});
+}
+
+void MergedFile::truncate(off_t length) {
+	edit([&](SegmentTree const & current) {
+		if(length > current.size()) {
+			throw fusepp::fuse_error(EINVAL);
+		}
+		return Splice{length, static_cast<std::size_t>(current.size() - length), SegmentTree()};
+	});
+}
+
+} // namespace smfs
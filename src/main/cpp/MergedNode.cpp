@@ -0,0 +1,405 @@
+/*
+ * MergedNode.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#include "smfs/MergedNode.h"
+#include "smfs/MerkleTree.h"
+#include "smfs/Mount.h"
+#include "smfs/ioctl.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <utility>
+
+extern "C" {
+	#include <linux/falloc.h>
+	#include <unistd.h>
+}
+
+namespace smfs {
+
+/**
+ * The time, in seconds, for which the kernel may cache a merged file's attributes.
+ */
+static constexpr double attrTimeout = 1.0;
+
+/**
+ * The block size merged files report, to which the ranges they collapse must
+ * be aligned.
+ */
+static constexpr off_t blockSize = 4096;
+
+static void fill_stat(MergedFile const & file, Mount const & mount, struct stat& statbuf) {
+	std::memset(&statbuf, 0, sizeof(statbuf));
+	statbuf.st_mode = S_IFREG | (mount.writable() ? 0644 : 0444);
+	statbuf.st_nlink = 1;
+	statbuf.st_uid = ::getuid();
+	statbuf.st_gid = ::getgid();
+	statbuf.st_size = file.size();
+	statbuf.st_blksize = blockSize;
+	statbuf.st_blocks = (file.size() + 511) / 512;
+}
+
+/**
+ * Gets a merged file's Merkle tree without hashing the file in the calling
+ * request, which could take minutes for a large file.
+ * @throws fusepp::fuse_error with EAGAIN if the tree is still being built.
+ */
+static std::shared_ptr<MerkleTree const> built_merkle_tree(std::shared_ptr<MergedFile const> const & file) {
+	std::shared_ptr<MerkleTree const> tree = MergedFile::merkleTreeInBackground(file);
+	if(!tree) {
+		throw fusepp::fuse_error(EAGAIN);
+	}
+	return tree;
+}
+
+/**
+ * Gets the value of one of the extended attributes smfs defines for merged files.
+ * @throws fusepp::fuse_error with ENODATA if there is no such attribute, or
+ *         with EAGAIN if the file's Merkle tree is still being built.
+ */
+static std::string xattr_value(std::shared_ptr<MergedFile const> const & file, Mount & mount, std::string const & name) {
+	if(name == cacheStatsXattr && file->cache()) {
+		return file->cache()->stats().toString();
+	}
+	if(name == dedupStatsXattr) {
+		if(std::shared_ptr<DedupStore> dedup = mount.dedupStore()) {
+			return dedup->stats().toString();
+		}
+	}
+	if(name == scrubStatsXattr) {
+		if(std::shared_ptr<Scrubber const> scrubber = mount.scrubber()) {
+			return scrubber->stats().toString();
+		}
+	}
+	if(name == compactionStatsXattr) {
+		if(std::shared_ptr<SegmentCompactor const> compactor = mount.segmentCompactor()) {
+			return compactor->stats().toString();
+		}
+	}
+	if(name == prewarmStatsXattr) {
+		if(std::shared_ptr<Prewarmer const> prewarmer = mount.prewarmer()) {
+			return prewarmer->stats().toString();
+		}
+	}
+	if(name == invalidationStatsXattr) {
+		return mount.invalidator().stats().toString();
+	}
+	if(name == syncStatsXattr) {
+		return mount.groupCommit().stats().toString();
+	}
+	if(name == writeStatsXattr) {
+		return mount.writeCounters()->stats().toString();
+	}
+	if(name == fragmentationXattr) {
+		return SegmentCompactor::measure(*file).toString();
+	}
+	if(name == merkleXattr) {
+		std::shared_ptr<MerkleTree const> tree = built_merkle_tree(file);
+		return "leaf_size=" + std::to_string(tree->leafSize()) + " leaves=" + std::to_string(tree->leafCount())
+				+ " root=" + Sha256::hex(tree->root()) + "\n";
+	}
+	std::size_t prefixLength = std::strlen(merkleProofXattrPrefix);
+	if(name.compare(0, prefixLength, merkleProofXattrPrefix) == 0) {
+		std::string index = name.substr(prefixLength);
+		std::shared_ptr<MerkleTree const> tree = built_merkle_tree(file);
+		if(index.empty() || index.find_first_not_of("0123456789") != std::string::npos
+				|| index.size() > 19 || std::stoull(index) >= tree->leafCount()) {
+			throw fusepp::fuse_error(ENODATA);
+		}
+		std::string rc;
+		for(Digest const & sibling : tree->proof(std::stoull(index))) {
+			rc += Sha256::hex(sibling) + "\n";
+		}
+		return rc;
+	}
+	throw fusepp::fuse_error(ENODATA);
+}
+
+/*
+ * ======================================================
+ * MergedFileHandle
+ * ======================================================
+ */
+
+/**
+ * @return The number of bytes of writes a handle opened with the given flags
+ *         should buffer.
+ */
+static size_t coalescing_threshold(Mount const & mount, int flags) {
+	if((flags & O_ACCMODE) == O_RDONLY || (flags & (O_DIRECT | O_SYNC | O_DSYNC))) {
+		// Each write must reach the log before it returns
+		return 0;
+	}
+	return mount.writeCoalescing();
+}
+
+MergedFileHandle::MergedFileHandle(std::shared_ptr<MergedFile> file, Mount & mount, int flags)
+		: file(std::move(file)), mount(mount), openFlags(flags),
+		  coalescer([this](void const * data, size_t nbytes, off_t offset) {
+			  this->file->write(*deltaLog(), data, nbytes, offset);
+			  dirty = true;
+		  }, coalescing_threshold(mount, flags), mount.writeCounters()) {}
+
+MergedFileHandle::~MergedFileHandle() noexcept {
+	try {
+		coalescer.flush();
+	} catch(fusepp::fuse_error const &) {
+		// Already reported by flush, if the kernel called it
+	}
+}
+
+std::shared_ptr<DeltaLog> MergedFileHandle::deltaLog() {
+	std::lock_guard<std::mutex> lock(logLock);
+	if(!log) {
+		log = mount.deltaLog(*file);
+	}
+	return log;
+}
+
+void MergedFileHandle::checkWritable() const {
+	if((openFlags & O_ACCMODE) == O_RDONLY) {
+		throw fusepp::fuse_error(EBADF);
+	}
+}
+
+void MergedFileHandle::getattr(struct stat& statbuf) {
+	coalescer.flush();
+	fill_stat(*file, mount, statbuf);
+}
+
+std::shared_ptr<fusepp::Buffer> MergedFileHandle::read(size_t nbytes, off_t offset) {
+	coalescer.flush();
+	fusepp::CompoundBufferBuilder builder;
+	if(file->readsInParallel(offset, nbytes)) {
+		// Spread across devices, so fan out rather than read extent by extent
+		std::shared_ptr<char> mem(new char[nbytes], std::default_delete<char[]>());
+		size_t n = file->read(mem.get(), nbytes, offset);
+		builder.add(fusepp::DataBuffer::create(mem, mem.get(), n));
+		return builder.build();
+	}
+	BlockCache * cache = file->cache().get();
+	file->forEachExtent(offset, nbytes, [&](Segment const & segment, off_t inSegment, size_t length) {
+		off_t backingOffset = segment.offset + inSegment;
+		if(cache) {
+			size_t got = 0;
+			cache->read(*segment.file, backingOffset, length,
+					[&](std::shared_ptr<Block> block, size_t inBlock, size_t n) {
+				char * mem = block->data() + inBlock;
+				builder.add(fusepp::DataBuffer::create(std::move(block), mem, n));
+				got += n;
+			});
+			// The segment promised the data, so a short read is the backing file's fault
+			if(got != length) {
+				throw fusepp::fuse_error(EIO);
+			}
+		} else if(segment.file->hasRawDescriptor()) {
+			// The data is passed on by descriptor, so check it first
+			segment.file->verify(backingOffset, length);
+			builder.add(segment.file->fd(), backingOffset, length);
+		} else {
+			std::shared_ptr<char> mem(new char[length], std::default_delete<char[]>());
+			if(segment.file->read(mem.get(), length, backingOffset) != length) {
+				throw fusepp::fuse_error(EIO);
+			}
+			builder.add(fusepp::DataBuffer::create(mem, mem.get(), length));
+		}
+	});
+	return builder.build();
+}
+
+size_t MergedFileHandle::write(fusepp::Buffer& buffer, off_t offset) {
+	checkWritable();
+	std::shared_ptr<DeltaLog> log = deltaLog();
+	size_t nbytes = buffer.remaining();
+	// Checked now rather than when the write is flushed, so the error reaches the writer
+	if(offset > coalescer.size(file->size())) {
+		throw fusepp::fuse_error(EINVAL);
+	}
+	if(dynamic_cast<fusepp::PipeBuffer *>(&buffer) && nbytes >= coalescer.threshold()) {
+		// Too large to buffer, so spliced from fuse's pipe straight into the log
+		coalescer.writeThrough(nbytes, [&]() {
+			nbytes = file->write(*log, nbytes, offset, [&](BackingFile const & backing, off_t at) {
+				if(fusepp::FileBuffer::create(backing.fd(), at, nbytes)->copyDataFrom(buffer) != nbytes) {
+					throw fusepp::fuse_error(EIO);
+				}
+			});
+			dirty = true;
+		});
+	} else {
+		std::unique_ptr<char[]> mem(new char[nbytes]);
+		nbytes = fusepp::DataBuffer::create(mem.get(), nbytes)->copyDataFrom(buffer);
+		coalescer.write(mem.get(), nbytes, offset);
+	}
+	if(openFlags & O_DSYNC) {
+		fsync(true);
+	}
+	return nbytes;
+}
+
+void MergedFileHandle::flush() {
+	coalescer.flush();
+}
+
+void MergedFileHandle::fsync(bool) {
+	coalescer.flush();
+	if(!dirty.exchange(false)) {
+		return;
+	}
+	std::shared_ptr<BackingFile> written = deltaLog()->backing();
+	try {
+		mount.groupCommit().sync({written}, {file});
+	} catch(fusepp::fuse_error const &) {
+		dirty = true;
+		throw;
+	}
+}
+
+void MergedFileHandle::truncate(off_t newLength) {
+	checkWritable();
+	coalescer.flush();
+	file->truncate(newLength);
+}
+
+size_t MergedFileHandle::copyFileRange(off_t offsetIn, fusepp::FileHandle1& out,
+		off_t offsetOut, size_t nbytes, int flags) {
+	MergedFileHandle * dest = dynamic_cast<MergedFileHandle *>(&out);
+	if(!dest) {
+		throw fusepp::fuse_error(EXDEV);
+	}
+	if(flags != 0) {
+		throw fusepp::fuse_error(EINVAL);
+	}
+	dest->checkWritable();
+	coalescer.flush();
+	dest->coalescer.flush();
+	return dest->file->copyFrom(*file, offsetIn, offsetOut, nbytes);
+}
+
+void MergedFileHandle::fallocate(int mode, off_t offset, off_t length) {
+	if(mode != FALLOC_FL_COLLAPSE_RANGE) {
+		throw fusepp::fuse_error(EOPNOTSUPP);
+	}
+	checkWritable();
+	coalescer.flush();
+	// As for local filesystems, whole blocks only, and never up to the end
+	// of the file, which is what truncate is for
+	if(offset % blockSize || length % blockSize || length <= 0 || offset + length >= file->size()) {
+		throw fusepp::fuse_error(EINVAL);
+	}
+	file->cut(offset, length);
+}
+
+void MergedFileHandle::ioctl(int cmd, void *, unsigned int, void * data) {
+	coalescer.flush();
+	switch(static_cast<unsigned int>(cmd)) {
+	case SMFS_IOC_APPEND: {
+		checkWritable();
+		smfs_ioc_append const * args = static_cast<smfs_ioc_append const *>(data);
+		fusepp::path_t source(args->source, ::strnlen(args->source, sizeof(args->source)));
+		std::shared_ptr<MergedFile> sourceFile = mount.mergedFile(source);
+		if(!sourceFile) {
+			throw fusepp::fuse_error(ENOENT);
+		}
+		file->append(*sourceFile);
+		break;
+	}
+	case SMFS_IOC_CUT: {
+		checkWritable();
+		smfs_ioc_cut const * args = static_cast<smfs_ioc_cut const *>(data);
+		file->cut(args->offset, args->length);
+		break;
+	}
+	case SMFS_IOC_COPY_RANGE: {
+		checkWritable();
+		smfs_ioc_copy_range * args = static_cast<smfs_ioc_copy_range *>(data);
+		fusepp::path_t source(args->source, ::strnlen(args->source, sizeof(args->source)));
+		std::shared_ptr<MergedFile> sourceFile = mount.mergedFile(source);
+		if(!sourceFile) {
+			throw fusepp::fuse_error(ENOENT);
+		}
+		args->copied = file->copyFrom(*sourceFile, args->source_offset, args->offset, args->length);
+		break;
+	}
+	case SMFS_IOC_SCRUB: {
+		checkWritable();
+		smfs_ioc_scrub const * args = static_cast<smfs_ioc_scrub const *>(data);
+		mount.scrub(args->bytes_per_second);
+		break;
+	}
+	case SMFS_IOC_COMPACT: {
+		checkWritable();
+		smfs_ioc_compact const * args = static_cast<smfs_ioc_compact const *>(data);
+		CompactionPolicy policy;
+		policy.interval = args->interval_seconds;
+		mount.compactSegments(args->bytes_per_second, policy);
+		break;
+	}
+	case SMFS_IOC_PREWARM: {
+		checkWritable();
+		smfs_ioc_prewarm const * args = static_cast<smfs_ioc_prewarm const *>(data);
+		fusepp::path_t path(args->path, ::strnlen(args->path, sizeof(args->path)));
+		if(path.empty()) {
+			mount.prewarmHotFiles();
+		} else if(mount.mergedFile(path)) {
+			mount.prewarm({path}, args->bytes_per_second);
+		} else {
+			throw fusepp::fuse_error(ENOENT);
+		}
+		break;
+	}
+	default:
+		throw fusepp::fuse_error(ENOTTY);
+	}
+}
+
+bool MergedFileHandle::keepCache() const {
+	return mount.kernelCaching() > 0;
+}
+
+/*
+ * ======================================================
+ * MergedNode
+ * ======================================================
+ */
+
+MergedNode::MergedNode(fusepp::path_t rel_path, std::shared_ptr<MergedFile> file, Mount & mount)
+		: Node1(rel_path), file(std::move(file)), mount(mount) {}
+
+double MergedNode::getattr(struct stat& statbuf) {
+	fill_stat(*file, mount, statbuf);
+	return attrTimeout;
+}
+
+std::unique_ptr<fusepp::FileHandle1> MergedNode::open(int flags) {
+	if((flags & O_ACCMODE) != O_RDONLY && !mount.writable()) {
+		throw fusepp::fuse_error(EROFS);
+	}
+	return std::make_unique<MergedFileHandle>(file, mount, flags);
+}
+
+void MergedNode::truncate(off_t newLength) {
+	if(!mount.writable()) {
+		throw fusepp::fuse_error(EROFS);
+	}
+	file->truncate(newLength);
+}
+
+size_t MergedNode::xattrSize(std::string const name) {
+	return xattr_value(file, mount, name).size();
+}
+
+size_t MergedNode::getxattr(std::string const name, fusepp::DataBuffer& buffer) {
+	std::string value = xattr_value(file, mount, name);
+	if(value.size() > buffer.size()) {
+		throw fusepp::fuse_error(ERANGE);
+	}
+	value.copy(static_cast<char *>(buffer.data()), value.size());
+	return value.size();
+}
+
+} // namespace smfs
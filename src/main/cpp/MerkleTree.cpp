@@ -0,0 +1,207 @@
+/*
+ * MerkleTree.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "smfs/MerkleTree.h"
+
+#include <fusepp/common.hpp>
+
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace smfs {
+
+namespace {
+
+constexpr std::uint8_t leafPrefix = 0;
+constexpr std::uint8_t nodePrefix = 1;
+
+} // namespace
+
+MerkleTree::MerkleTree(std::size_t leafSize, off_t size)
+		: leafLength(leafSize), length(size) {
+	if(!leafSize || size < 0) {
+		throw fusepp::fuse_error(EINVAL);
+	}
+	layOut(leafCount(size, leafSize));
+}
+
+MerkleTree::MerkleTree(std::size_t leafSize, off_t size, std::vector<Digest> nodes)
+		: MerkleTree(leafSize, size) {
+	if(nodes.size() != this->nodes.size()) {
+		throw fusepp::fuse_error(EINVAL);
+	}
+	this->nodes = std::move(nodes);
+}
+
+void MerkleTree::layOut(std::size_t leaves) {
+	levelStarts.assign(1, 0);
+	std::size_t total = leaves;
+	for(std::size_t n = leaves; n > 1;) {
+		n = (n + 1) / 2;
+		levelStarts.push_back(total);
+		total += n;
+	}
+	nodes.resize(total);
+}
+
+std::size_t MerkleTree::nodeCount(std::size_t leaves) {
+	std::size_t total = leaves;
+	for(std::size_t n = leaves; n > 1;) {
+		n = (n + 1) / 2;
+		total += n;
+	}
+	return total;
+}
+
+Digest MerkleTree::hashLeaf(void const * data, std::size_t length) {
+	Sha256 sha;
+	sha.update(&leafPrefix, 1);
+	sha.update(data, length);
+	return sha.finish();
+}
+
+Digest MerkleTree::hashNodes(Digest const & left, Digest const & right) {
+	Sha256 sha;
+	sha.update(&nodePrefix, 1);
+	sha.update(left.data(), left.size());
+	sha.update(right.data(), right.size());
+	return sha.finish();
+}
+
+MerkleTree MerkleTree::build(MergedFile::Snapshot const & snapshot, std::size_t leafSize, unsigned threads) {
+	MerkleTree tree(leafSize, snapshot.size());
+	std::size_t leaves = tree.leafCount();
+	if(!threads) {
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+	threads = static_cast<unsigned>(std::min<std::size_t>(threads, leaves));
+
+	std::mutex errorLock;
+	std::exception_ptr error;
+	auto hashLeaves = [&](std::size_t first, std::size_t last) {
+		try {
+			std::unique_ptr<unsigned char[]> buffer(new unsigned char[leafSize]);
+			for(std::size_t i = first; i < last; ++i) {
+				off_t offset = static_cast<off_t>(i) * leafSize;
+				std::size_t n = static_cast<std::size_t>(std::min<off_t>(leafSize, tree.length - offset));
+				std::size_t filled = 0;
+				snapshot.forEachExtent(offset, n, [&](Segment const & segment, off_t inSegment, std::size_t length) {
+					if(segment.file->read(buffer.get() + filled, length, segment.offset + inSegment) != length) {
+						throw fusepp::fuse_error(EIO);
+					}
+					filled += length;
+				});
+				tree.nodes[i] = hashLeaf(buffer.get(), n);
+			}
+		} catch(...) {
+			std::lock_guard<std::mutex> lock(errorLock);
+			if(!error) {
+				error = std::current_exception();
+			}
+		}
+	};
+
+	// Each thread hashes a contiguous run of leaves, so reads stay sequential
+	std::vector<std::thread> workers;
+	for(unsigned t = 1; t < threads; ++t) {
+		workers.emplace_back(hashLeaves, leaves * t / threads, leaves * (t + 1) / threads);
+	}
+	hashLeaves(0, leaves / threads);
+	for(std::thread &worker : workers) {
+		worker.join();
+	}
+	if(error) {
+		std::rethrow_exception(error);
+	}
+	tree.hashUpper();
+	return tree;
+}
+
+void MerkleTree::hashUpper() {
+	for(std::size_t level = 1; level < levels(); ++level) {
+		Digest const * below = &nodes[levelStarts[level - 1]];
+		std::size_t belowWidth = width(level - 1);
+		Digest * here = &nodes[levelStarts[level]];
+		for(std::size_t i = 0; i < width(level); ++i) {
+			here[i] = 2 * i + 1 < belowWidth ? hashNodes(below[2 * i], below[2 * i + 1]) : below[2 * i];
+		}
+	}
+}
+
+bool MerkleTree::verify(Digest const & root, std::size_t leaves, std::size_t leaf, Digest const & digest,
+		std::vector<Digest> const & proof) {
+	if(leaf >= leaves) {
+		return false;
+	}
+	Digest hash = digest;
+	std::size_t used = 0;
+	for(std::size_t i = leaf, n = leaves; n > 1; i >>= 1, n = (n + 1) / 2) {
+		if((i ^ 1) < n) {
+			if(used == proof.size()) {
+				return false;
+			}
+			hash = i & 1 ? hashNodes(proof[used], hash) : hashNodes(hash, proof[used]);
+			++used;
+		}
+	}
+	return used == proof.size() && hash == root;
+}
+
+std::vector<Digest> MerkleTree::proof(std::size_t leaf) const {
+	std::vector<Digest> rc;
+	for(std::size_t level = 0, i = leaf; level + 1 < levels(); ++level, i >>= 1) {
+		if(Digest const * sibling = node(level, i ^ 1)) {
+			rc.push_back(*sibling);
+		}
+	}
+	return rc;
+}
+
+std::vector<std::pair<off_t, off_t>> MerkleTree::diff(MerkleTree const & other) const {
+	if(leafLength != other.leafLength) {
+		throw fusepp::fuse_error(EINVAL);
+	}
+	std::size_t ourLeaves = leafCount();
+	std::size_t theirLeaves = other.leafCount();
+	std::size_t leaves = std::max(ourLeaves, theirLeaves);
+	off_t end = std::max(length, other.length);
+	std::vector<std::pair<off_t, off_t>> rc;
+
+	// A node at (level, index) covers the same leaves in both trees, except
+	// where one tree ends part way through it
+	auto walk = [&](auto &self, std::size_t level, std::size_t index) -> void {
+		std::size_t first = index << level;
+		if(first >= leaves) {
+			return;
+		}
+		Digest const * ours = node(level, index);
+		Digest const * theirs = other.node(level, index);
+		std::size_t last = (index + 1) << level;
+		if(ours && theirs && std::min(last, ourLeaves) == std::min(last, theirLeaves) && *ours == *theirs) {
+			return;
+		}
+		if(level) {
+			self(self, level - 1, 2 * index);
+			self(self, level - 1, 2 * index + 1);
+			return;
+		}
+		off_t offset = static_cast<off_t>(index) * leafLength;
+		off_t to = std::min<off_t>(offset + leafLength, end);
+		if(!rc.empty() && rc.back().first + rc.back().second == offset) {
+			rc.back().second = to - rc.back().first;
+		} else {
+			rc.emplace_back(offset, to - offset);
+		}
+	};
+	walk(walk, std::max(levels(), other.levels()) - 1, 0);
+	return rc;
+}
+
+} // namespace smfs
@@ -0,0 +1,574 @@
+/*
+ * Mount.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#include "smfs/Mount.h"
+#include "smfs/Coalesced.h"
+#include "smfs/MergedNode.h"
+#include "smfs/SplitNode.h"
+
+#include <fusepp/util.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <optional>
+#include <unordered_set>
+#include <utility>
+
+extern "C" {
+	#include <fcntl.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+}
+
+namespace smfs {
+
+namespace {
+
+void impliedDirAttributes(struct stat& statbuf) {
+	std::memset(&statbuf, 0, sizeof(statbuf));
+	statbuf.st_mode = S_IFDIR | 0755;
+	statbuf.st_nlink = 2;
+	statbuf.st_uid = ::getuid();
+	statbuf.st_gid = ::getgid();
+}
+
+fusepp::path_t childPath(fusepp::path_t const & parent, std::string const & name) {
+	return parent == "/" ? parent + name : parent + "/" + name;
+}
+
+fusepp::path_t parentPath(fusepp::path_t const & path) {
+	std::size_t slash = path.rfind('/');
+	return slash == 0 || slash == fusepp::path_t::npos ? "/" : path.substr(0, slash);
+}
+
+} // namespace
+
+/**
+ * An entry listed by an @ref ImpliedDirHandle.
+ */
+class ImpliedDirEntry : public fusepp::DirEntry {
+	std::string name;
+	std::size_t next;
+	unsigned char type;
+	fusepp::path_t path;
+	Mount * mount;
+
+public:
+	ImpliedDirEntry(std::string name, std::size_t next, mode_t mode, fusepp::path_t path, Mount & mount)
+			: name(std::move(name)), next(next), type(IFTODT(mode)), path(std::move(path)), mount(&mount) {}
+
+	std::string getName() const override {
+		return name;
+	}
+
+	std::size_t getNextOffset() const override {
+		return next;
+	}
+
+	unsigned char getType() const override {
+		return type;
+	}
+
+	std::shared_ptr<fusepp::Node1> lookupNode() override {
+		return mount->get_node(path);
+	}
+};
+
+/**
+ * An open handle to a directory implied by the paths beneath it.
+ *
+ * The entries are listed once, when the directory is opened. Positions are
+ * indices into that listing, with "." and ".." at positions zero and one.
+ */
+class ImpliedDirHandle : public fusepp::DirHandle1 {
+	fusepp::path_t const rel_path;
+	std::vector<std::pair<std::string, mode_t>> const entries;
+	Mount & mount;
+	std::size_t position = 0;
+
+public:
+	ImpliedDirHandle(fusepp::path_t rel_path, std::map<std::string, mode_t> const & entries, Mount & mount)
+			: rel_path(std::move(rel_path)), entries(entries.begin(), entries.end()), mount(mount) {}
+
+	void getattr(struct stat& statbuf) override {
+		impliedDirAttributes(statbuf);
+	}
+
+	std::optional<fusepp::AnyDirEntry> readdir() override {
+		std::size_t index = position;
+		if(index >= entries.size() + 2) {
+			return std::nullopt;
+		}
+		++position;
+		if(index < 2) {
+			fusepp::path_t path = index == 0 ? rel_path : parentPath(rel_path);
+			return fusepp::AnyDirEntry(ImpliedDirEntry(index == 0 ? "." : "..", position, S_IFDIR, path, mount));
+		}
+		auto const & entry = entries[index - 2];
+		return fusepp::AnyDirEntry(ImpliedDirEntry(entry.first, position, entry.second,
+				childPath(rel_path, entry.first), mount));
+	}
+
+	void seekdir(std::size_t offset) override {
+		position = offset;
+	}
+
+	std::size_t telldir() override {
+		return position;
+	}
+};
+
+/**
+ * A directory implied by the paths of the merged files and split views
+ * beneath it.
+ */
+struct ImpliedDirNode : fusepp::Node1 {
+	Mount & mount;
+
+	ImpliedDirNode(fusepp::path_t rel_path, Mount & mount) : Node1(rel_path), mount(mount) {}
+
+	double getattr(struct stat& statbuf) override {
+		impliedDirAttributes(statbuf);
+		return 1.0;
+	}
+
+	std::unique_ptr<fusepp::DirHandle1> opendir(int) override {
+		return std::make_unique<ImpliedDirHandle>(rel_path, mount.impliedEntries(rel_path), mount);
+	}
+};
+
+/**
+ * A path at which nothing exists.
+ */
+struct MissingNode : fusepp::Node1 {
+	MissingNode(fusepp::path_t rel_path) : Node1(rel_path) {}
+
+	double getattr(struct stat&) override {
+		throw fusepp::fuse_error(ENOENT);
+	}
+
+	std::unique_ptr<fusepp::FileHandle1> open(int) override {
+		throw fusepp::fuse_error(ENOENT);
+	}
+};
+
+Mount::Mount(std::shared_ptr<BlockCache> cache)
+		: blockCache(std::move(cache)) {}
+
+Mount::Mount(std::shared_ptr<BlockCache> cache, std::unique_ptr<ManifestStore> store)
+		: blockCache(std::move(cache)), store(std::move(store)) {
+	for(auto &entry : this->store->recover(blockCache)) {
+		track(entry.first, *entry.second);
+		files.emplace(std::move(entry.first), std::move(entry.second));
+	}
+	this->store->startCompactor([this]() {
+		std::lock_guard<std::mutex> lock(mutex);
+		return ManifestStore::Files(files.begin(), files.end());
+	});
+}
+
+void Mount::setDedupStore(std::shared_ptr<DedupStore> dedup) {
+	std::lock_guard<std::mutex> lock(mutex);
+	this->dedup = std::move(dedup);
+}
+
+std::shared_ptr<DedupStore> Mount::dedupStore() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return dedup;
+}
+
+void Mount::setDeltaDirectory(std::string directory) {
+	std::lock_guard<std::mutex> lock(mutex);
+	deltaDir = std::move(directory);
+}
+
+bool Mount::writable() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return !deltaDir.empty();
+}
+
+std::shared_ptr<DeltaLog> Mount::deltaLog(MergedFile const & file) {
+	std::lock_guard<std::mutex> lock(mutex);
+	auto found = deltaLogs.find(&file);
+	if(found != deltaLogs.end()) {
+		return found->second;
+	}
+	if(deltaDir.empty()) {
+		throw fusepp::fuse_error(EROFS);
+	}
+	return deltaLogs[&file] = std::make_shared<DeltaLog>(deltaDir);
+}
+
+void Mount::setWriteCoalescing(std::size_t threshold) {
+	std::lock_guard<std::mutex> lock(mutex);
+	coalescingThreshold = threshold;
+}
+
+std::size_t Mount::writeCoalescing() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return coalescingThreshold;
+}
+
+std::shared_ptr<MergedFile> Mount::addMergedFile(fusepp::path_t const & path, std::vector<Segment> segments) {
+	// Hashing reads every segment, so is done before taking the lock
+	std::optional<DedupStore::References> interned;
+	if(std::shared_ptr<DedupStore> dedup = dedupStore()) {
+		std::vector<Digest> digests;
+		segments = dedup->intern(segments, &digests);
+		// Released if the file cannot be added
+		interned.emplace(std::move(dedup), std::move(digests));
+	}
+	fusepp::path_t entry = connected() ? firstNewEntry(path) : fusepp::path_t();
+	std::shared_ptr<MergedFile> file;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if(files.count(path)) {
+			throw fusepp::fuse_error(EEXIST);
+		}
+		file = store
+				? store->create(path, std::move(segments), blockCache)
+				: std::make_shared<MergedFile>(std::move(segments), blockCache);
+		if(interned) {
+			file->hold(std::move(*interned));
+		}
+		track(path, *file);
+		files.emplace(path, file);
+	}
+	if(!entry.empty()) {
+		invalidations.added(entry);
+	}
+	file->sync();
+	return file;
+}
+
+void Mount::addManifest(std::shared_ptr<Manifest const> const & manifest) {
+	if(store || dedupStore()) {
+		for(std::size_t i = 0; i < manifest->fileCount(); ++i) {
+			addMergedFile(fusepp::path_t(manifest->path(i)), manifest->segments(i));
+		}
+		return;
+	}
+	std::vector<fusepp::path_t> entries;
+	if(connected()) {
+		for(std::size_t i = 0; i < manifest->fileCount(); ++i) {
+			entries.push_back(firstNewEntry(fusepp::path_t(manifest->path(i))));
+		}
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for(std::size_t i = 0; i < manifest->fileCount(); ++i) {
+			fusepp::path_t path(manifest->path(i));
+			std::shared_ptr<MergedFile> file = std::make_shared<MergedFile>(manifest, i, blockCache);
+			track(path, *file);
+			if(!files.emplace(path, file).second) {
+				throw fusepp::fuse_error(EEXIST);
+			}
+		}
+	}
+	for(fusepp::path_t const & entry : entries) {
+		invalidations.added(entry);
+	}
+}
+
+void Mount::addSplitView(fusepp::path_t const & path, std::shared_ptr<SplitView const> view) {
+	fusepp::path_t entry = connected() ? firstNewEntry(path) : fusepp::path_t();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if(files.count(path) || !splits.emplace(path, std::move(view)).second) {
+			throw fusepp::fuse_error(EEXIST);
+		}
+	}
+	if(!entry.empty()) {
+		invalidations.added(entry);
+	}
+}
+
+void Mount::saveManifest(std::string const & path) const {
+	ManifestWriter writer;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for(auto const & entry : files) {
+			writer.add(entry.first, *entry.second);
+		}
+	}
+	writer.write(path);
+}
+
+void Mount::scrub(std::uint64_t bytesPerSecond) {
+	std::vector<std::pair<fusepp::path_t, std::shared_ptr<MergedFile>>> all;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		all.assign(files.begin(), files.end());
+	}
+	std::vector<std::shared_ptr<BackingFile>> backing;
+	std::unordered_set<BackingFile::id_type> seen;
+	for(auto const & entry : all) {
+		MergedFile const & file = *entry.second;
+		file.forEachExtent(0, file.size(), [&](Segment const & segment, off_t, std::size_t) {
+			if(segment.file->checksums() && seen.insert(segment.file->id).second) {
+				backing.push_back(segment.file);
+			}
+		});
+	}
+
+	std::shared_ptr<Scrubber> scrubber = std::make_shared<Scrubber>(std::move(backing), bytesPerSecond);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		latestScrub.swap(scrubber);
+	}
+	// Stopped even if someone else still holds it
+	if(scrubber) {
+		scrubber->stop();
+	}
+}
+
+std::shared_ptr<Scrubber const> Mount::scrubber() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return latestScrub;
+}
+
+void Mount::compactSegments(std::uint64_t bytesPerSecond, CompactionPolicy policy) {
+	if(!writable()) {
+		throw fusepp::fuse_error(EROFS);
+	}
+	std::shared_ptr<SegmentCompactor> compactor = std::make_shared<SegmentCompactor>([this]() {
+		std::vector<std::shared_ptr<MergedFile>> all;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			for(auto const & entry : files) {
+				all.push_back(entry.second);
+			}
+		}
+		std::vector<SegmentCompactor::Target> targets;
+		for(std::shared_ptr<MergedFile> &file : all) {
+			std::shared_ptr<DeltaLog> log = deltaLog(*file);
+			targets.emplace_back(std::move(file), std::move(log));
+		}
+		return targets;
+	}, policy, bytesPerSecond);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		latestCompaction.swap(compactor);
+	}
+	// Stopped even if someone else still holds it
+	if(compactor) {
+		compactor->stop();
+	}
+}
+
+std::shared_ptr<SegmentCompactor const> Mount::segmentCompactor() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return latestCompaction;
+}
+
+void Mount::setKernelCaching(double timeout) {
+	std::lock_guard<std::mutex> lock(mutex);
+	cacheTimeout = timeout;
+}
+
+double Mount::kernelCaching() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return cacheTimeout;
+}
+
+std::string Mount::options() const {
+	double timeout = kernelCaching();
+	if(timeout <= 0) {
+		return std::string();
+	}
+	char buf[128];
+	int n = std::snprintf(buf, sizeof(buf), "entry_timeout=%g,negative_timeout=%g,attr_timeout=%g",
+			timeout, timeout, timeout);
+	return std::string(buf, n);
+}
+
+void Mount::track(fusepp::path_t const & path, MergedFile & file) {
+	file.listen([this, path](off_t offset, off_t length) {
+		if(connected()) {
+			invalidations.changed(path, offset, length);
+		}
+	});
+}
+
+fusepp::path_t Mount::firstNewEntry(fusepp::path_t const & path) const {
+	// The kernel cannot have looked up anything beneath a missing directory
+	for(std::string::size_type slash = path.find('/', 1); slash != std::string::npos;
+			slash = path.find('/', slash + 1)) {
+		fusepp::path_t ancestor = path.substr(0, slash);
+		if(!isDirectory(ancestor)) {
+			return ancestor;
+		}
+	}
+	return path;
+}
+
+void Mount::invalidate(Invalidator::Change const & change) {
+	if(change.entry) {
+		invalidateEntry(change.path);
+	} else {
+		invalidateData(change.path, change.offset, change.length);
+	}
+}
+
+void Mount::setHotFiles(std::vector<fusepp::path_t> paths, std::uint64_t bytesPerSecond) {
+	std::lock_guard<std::mutex> lock(mutex);
+	hotFiles = std::move(paths);
+	hotBytesPerSecond = bytesPerSecond;
+}
+
+void Mount::init(fusepp::Connection & connection) {
+	connection.wanted.asyncRead = true;
+	// Otherwise libfuse 2.9 is sent writes a page at a time
+	connection.wanted.bigWrites = true;
+	// Written data then arrives in pipes, to be spliced into delta logs
+	connection.wanted.spliceRead = true;
+	connection.wanted.spliceMove = true;
+}
+
+void Mount::mounted() {
+	bool any;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		any = !hotFiles.empty();
+	}
+	if(any) {
+		prewarmHotFiles();
+	}
+}
+
+void Mount::prewarmHotFiles() {
+	std::vector<fusepp::path_t> paths;
+	std::uint64_t bytesPerSecond;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		paths = hotFiles;
+		bytesPerSecond = hotBytesPerSecond;
+	}
+	prewarm(paths, bytesPerSecond);
+}
+
+void Mount::prewarm(std::vector<fusepp::path_t> const & paths, std::uint64_t bytesPerSecond) {
+	if(mountpoint().empty()) {
+		throw fusepp::fuse_error(ENOTCONN);
+	}
+	std::vector<Prewarmer::Target> targets;
+	for(fusepp::path_t const & path : paths) {
+		if(std::shared_ptr<MergedFile> file = mergedFile(path)) {
+			targets.emplace_back(path, std::move(file));
+		}
+	}
+
+	std::shared_ptr<Prewarmer> prewarmer = std::make_shared<Prewarmer>(std::move(targets),
+			[this](Prewarmer::Target const & target, off_t offset, std::size_t length) {
+		storeInKernel(target, offset, length);
+	}, bytesPerSecond);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		latestPrewarm.swap(prewarmer);
+	}
+	// Stopped even if someone else still holds it
+	if(prewarmer) {
+		prewarmer->stop();
+	}
+}
+
+std::shared_ptr<Prewarmer const> Mount::prewarmer() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return latestPrewarm;
+}
+
+void Mount::storeInKernel(Prewarmer::Target const & target, off_t offset, std::size_t length) {
+	// Read as a handle would, so that backing descriptors are spliced across
+	MergedFileHandle handle(target.second, *this, O_RDONLY);
+	std::shared_ptr<fusepp::Buffer> data = handle.read(length, offset);
+	notifyStore(target.first, offset, *data);
+}
+
+std::shared_ptr<MergedFile> Mount::mergedFile(fusepp::path_t const & path) const {
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = files.find(path);
+	return it == files.end() ? nullptr : it->second;
+}
+
+bool Mount::isDirectory(fusepp::path_t const & path) const {
+	if(path == "/") {
+		return true;
+	}
+	fusepp::path_t prefix = path + "/";
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = files.lower_bound(prefix);
+	if(it != files.end() && it->first.compare(0, prefix.size(), prefix) == 0) {
+		return true;
+	}
+	auto split = splits.lower_bound(prefix);
+	return split != splits.end() && split->first.compare(0, prefix.size(), prefix) == 0;
+}
+
+std::map<std::string, mode_t> Mount::impliedEntries(fusepp::path_t const & path) const {
+	fusepp::path_t prefix = path == "/" ? path : path + "/";
+	std::map<std::string, mode_t> entries;
+	auto add = [&](fusepp::path_t const & beneath, mode_t type) {
+		if(beneath.size() == prefix.size()) {
+			// A split view at the root
+			return;
+		}
+		std::size_t slash = beneath.find('/', prefix.size());
+		if(slash == fusepp::path_t::npos) {
+			entries.emplace(beneath.substr(prefix.size()), type);
+		} else {
+			entries[beneath.substr(prefix.size(), slash - prefix.size())] = S_IFDIR;
+		}
+	};
+	std::lock_guard<std::mutex> lock(mutex);
+	for(auto it = files.lower_bound(prefix); it != files.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+		add(it->first, S_IFREG);
+	}
+	for(auto it = splits.lower_bound(prefix); it != splits.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+		add(it->first, S_IFDIR);
+	}
+	return entries;
+}
+
+std::shared_ptr<SplitView const> Mount::splitView(fusepp::path_t const & path, std::string &inView) const {
+	std::lock_guard<std::mutex> lock(mutex);
+	for(auto const & entry : splits) {
+		fusepp::path_t const & root = entry.first;
+		if(root == "/") {
+			inView = path;
+			return entry.second;
+		}
+		if(path.compare(0, root.size(), root) == 0
+				&& (path.size() == root.size() || path[root.size()] == '/')) {
+			inView = path.substr(root.size());
+			return entry.second;
+		}
+	}
+	return nullptr;
+}
+
+std::shared_ptr<fusepp::Node1> Mount::get_node(fusepp::path_t rel_path) {
+	return nodeFlights.run(rel_path, [this, &rel_path]() {
+		return makeNode(rel_path);
+	});
+}
+
+std::shared_ptr<fusepp::Node1> Mount::makeNode(fusepp::path_t const & rel_path) {
+	if(std::shared_ptr<MergedFile> file = mergedFile(rel_path)) {
+		return std::make_shared<Coalesced<MergedNode>>(rel_path, std::move(file), *this);
+	}
+	std::string inView;
+	if(std::shared_ptr<SplitView const> view = splitView(rel_path, inView)) {
+		SplitView::Resolved resolved = view->resolve(inView);
+		return std::make_shared<Coalesced<SplitNode>>(rel_path, std::move(view), std::move(resolved), blockCache, *this);
+	}
+	if(isDirectory(rel_path)) {
+		return std::make_shared<ImpliedDirNode>(rel_path, *this);
+	}
+	return std::make_shared<MissingNode>(rel_path);
+}
+
+} // namespace smfs
@@ -0,0 +1,69 @@
+/*
+ * Prewarmer.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "smfs/Prewarmer.h"
+#include "smfs/StatsLine.h"
+
+#include <fusepp/common.hpp>
+
+#include <algorithm>
+
+namespace smfs {
+
+std::string Prewarmer::Stats::toString() const {
+	return StatsLine().count("files", files).count("bytes", bytes).count("skipped", skipped)
+			.count("errors", errors).flag("finished", finished).flag("stopped", stopped).str();
+}
+
+Prewarmer::Prewarmer(std::vector<Target> targets, Store store, std::uint64_t bytesPerSecond, std::size_t chunkSize)
+		: targets(std::move(targets)), store(std::move(store)), chunkSize(std::max<std::size_t>(chunkSize, 1)),
+		  task(bytesPerSecond, [this](Task &) { run(); }) {}
+
+void Prewarmer::stop() {
+	task.stop();
+}
+
+Prewarmer::Stats Prewarmer::wait() const {
+	return task.wait();
+}
+
+Prewarmer::Stats Prewarmer::stats() const {
+	return task.stats();
+}
+
+void Prewarmer::run() {
+	for(Target const & target : targets) {
+		off_t size = target.second->size();
+		bool complete = true;
+		for(off_t offset = 0; offset < size; ) {
+			std::size_t length = std::min<off_t>(chunkSize, size - offset);
+			try {
+				store(target, offset, length);
+			} catch(fusepp::fuse_error const & e) {
+				task.update([&](Stats & counters) {
+					++(e.error == ENOENT ? counters.skipped : counters.errors);
+				});
+				complete = false;
+				break;
+			}
+			offset += length;
+			task.update([&](Stats & counters) {
+				counters.bytes += length;
+			});
+			if(!task.pace(length)) {
+				return;
+			}
+		}
+		if(complete) {
+			task.update([](Stats & counters) {
+				++counters.files;
+			});
+		}
+	}
+}
+
+} // namespace smfs
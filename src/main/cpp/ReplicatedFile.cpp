@@ -0,0 +1,212 @@
+/*
+ * ReplicatedFile.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "smfs/ReplicatedFile.h"
+#include "smfs/StatsLine.h"
+#include "smfs/ThreadPool.h"
+
+#include <fusepp/util.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <mutex>
+
+extern "C" {
+	#include <sys/stat.h>
+	#include <unistd.h>
+}
+
+namespace smfs {
+
+namespace {
+
+/**
+ * The number of threads reads of replicas are made on. Reads only ever wait
+ * on storage, never on one another, so a fixed pool cannot deadlock, though
+ * reads queue behind one another once every thread is busy.
+ */
+constexpr unsigned readThreads = 32;
+
+ThreadPool & readPool() {
+	static ThreadPool pool(readThreads);
+	return pool;
+}
+
+using clock = std::chrono::steady_clock;
+
+int dupFirst(std::vector<ReplicatedFile::Replica> const & replicas) {
+	if(replicas.empty()) {
+		throw fusepp::fuse_error(EINVAL);
+	}
+	return replicas.front().file->duplicate();
+}
+
+} // namespace
+
+/**
+ * The shared state of a read, which outlives the call if a replica answers
+ * after another already has.
+ */
+struct ReplicatedFile::Request {
+	std::size_t const nbytes;
+	off_t const offset;
+	std::mutex mutex;
+	std::condition_variable done;
+	std::vector<bool> tried;
+	std::size_t outstanding = 0;
+	bool answered = false;
+	std::size_t winner = 0;
+	std::unique_ptr<char[]> data;
+	std::size_t length = 0;
+	std::exception_ptr error;
+
+	Request(std::size_t nbytes, off_t offset, std::size_t replicas)
+			: nbytes(nbytes), offset(offset), tried(replicas) {}
+};
+
+std::string ReplicatedFile::Stats::toString() const {
+	return StatsLine().count("reads", reads).count("hedged", hedged).count("hedge_wins", hedgeWins)
+			.count("failovers", failovers).str();
+}
+
+std::shared_ptr<ReplicatedFile> ReplicatedFile::open(std::vector<std::string> const & paths, HedgePolicy policy) {
+	std::vector<Replica> replicas;
+	for(std::string const & path : paths) {
+		std::shared_ptr<BackingFile> file = BackingFile::open(path);
+		struct stat statbuf;
+		fusepp::check_ret(::fstat(file->fd(), &statbuf));
+		replicas.push_back(Replica{std::move(file), DeviceLoad::of(statbuf.st_dev)});
+	}
+	return std::make_shared<ReplicatedFile>(std::move(replicas), policy);
+}
+
+ReplicatedFile::ReplicatedFile(std::vector<Replica> replicas, HedgePolicy policy)
+		: BackingFile(replicas.empty() ? std::string() : replicas.front().file->path, dupFirst(replicas)),
+		  copies(std::move(replicas)), policy(policy) {}
+
+off_t ReplicatedFile::size() const {
+	return copies.front().file->size();
+}
+
+ReplicatedFile::Stats ReplicatedFile::stats() const {
+	Stats rc;
+	rc.reads = reads.load();
+	rc.hedged = hedged.load();
+	rc.hedgeWins = hedgeWins.load();
+	rc.failovers = failovers.load();
+	return rc;
+}
+
+std::chrono::nanoseconds ReplicatedFile::hedgeDelay(Replica const & replica) const {
+	LatencyHistogram const & latencies = replica.device->latencies();
+	if(latencies.samples() < policy.warmupSamples) {
+		return policy.initialDelay;
+	}
+	return std::max(policy.minimumDelay, latencies.percentile(policy.percentile));
+}
+
+void ReplicatedFile::launch(std::shared_ptr<Request> const & request, std::size_t index) const {
+	readPool().submit([request, replica = copies[index], index]() {
+		std::unique_ptr<char[]> data(new char[request->nbytes]);
+		std::size_t n = 0;
+		std::exception_ptr error;
+		clock::time_point start = clock::now();
+		replica.device->started();
+		try {
+			n = replica.file->read(data.get(), request->nbytes, request->offset);
+		} catch(...) {
+			error = std::current_exception();
+		}
+		replica.device->finished(clock::now() - start);
+
+		std::lock_guard<std::mutex> lock(request->mutex);
+		--request->outstanding;
+		if(error) {
+			if(!request->error) {
+				request->error = error;
+			}
+		} else if(!request->answered) {
+			request->answered = true;
+			request->winner = index;
+			request->data = std::move(data);
+			request->length = n;
+		}
+		request->done.notify_all();
+	});
+}
+
+std::size_t ReplicatedFile::readUnchecked(void * buf, std::size_t nbytes, off_t offset) const {
+	++reads;
+	if(copies.size() == 1) {
+		Replica const & replica = copies.front();
+		clock::time_point start = clock::now();
+		replica.device->started();
+		try {
+			std::size_t rc = replica.file->read(buf, nbytes, offset);
+			replica.device->finished(clock::now() - start);
+			return rc;
+		} catch(...) {
+			replica.device->finished(clock::now() - start);
+			throw;
+		}
+	}
+
+	std::shared_ptr<Request> request = std::make_shared<Request>(nbytes, offset, copies.size());
+	std::unique_lock<std::mutex> lock(request->mutex);
+	// Picks the least loaded replica not yet tried, and sends the read to it
+	auto sendToBest = [&]() {
+		std::size_t best = copies.size();
+		for(std::size_t i = 0; i < copies.size(); ++i) {
+			if(!request->tried[i] && (best == copies.size() || copies[i].device->score() < copies[best].device->score())) {
+				best = i;
+			}
+		}
+		if(best < copies.size()) {
+			request->tried[best] = true;
+			++request->outstanding;
+			lock.unlock();
+			launch(request, best);
+			lock.lock();
+		}
+		return best;
+	};
+
+	clock::time_point deadline = clock::now() + hedgeDelay(copies[sendToBest()]);
+	bool hedgeSent = false;
+	// The replica the current hedge went to, if any
+	std::size_t hedge = copies.size();
+	while(!request->answered) {
+		if(!request->outstanding) {
+			// Every read sent so far has failed
+			std::size_t next = sendToBest();
+			if(next == copies.size()) {
+				std::rethrow_exception(request->error);
+			}
+			++failovers;
+			deadline = clock::now() + hedgeDelay(copies[next]);
+			hedgeSent = false;
+			hedge = copies.size();
+		} else if(hedgeSent) {
+			request->done.wait(lock);
+		} else if(request->done.wait_until(lock, deadline) == std::cv_status::timeout && !request->answered) {
+			hedgeSent = true;
+			hedge = sendToBest();
+			if(hedge < copies.size()) {
+				++hedged;
+			}
+		}
+	}
+	if(request->winner == hedge) {
+		++hedgeWins;
+	}
+	std::memcpy(buf, request->data.get(), request->length);
+	return request->length;
+}
+
+} // namespace smfs
@@ -0,0 +1,74 @@
+/*
+ * Scrubber.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "smfs/Scrubber.h"
+#include "smfs/StatsLine.h"
+
+#include <fusepp/common.hpp>
+
+namespace smfs {
+
+std::string Scrubber::Stats::toString() const {
+	return StatsLine().count("files", files).count("blocks", blocks).count("bytes", bytes)
+			.count("damaged", damaged).count("errors", errors)
+			.flag("finished", finished).flag("stopped", stopped).str();
+}
+
+Scrubber::Scrubber(std::vector<std::shared_ptr<BackingFile>> files, std::uint64_t bytesPerSecond)
+		: files(std::move(files)), task(bytesPerSecond, [this](Task &) { run(); }) {}
+
+void Scrubber::stop() {
+	task.stop();
+}
+
+Scrubber::Stats Scrubber::wait() const {
+	return task.wait();
+}
+
+Scrubber::Stats Scrubber::stats() const {
+	return task.stats();
+}
+
+void Scrubber::run() {
+	std::unique_ptr<unsigned char[]> buffer;
+	std::size_t capacity = 0;
+
+	for(std::shared_ptr<BackingFile> const & file : files) {
+		BlockChecksums const * sums = file->checksums().get();
+		if(!sums) {
+			continue;
+		}
+		if(capacity < sums->blockSize()) {
+			capacity = sums->blockSize();
+			buffer.reset(new unsigned char[capacity]);
+		}
+		for(std::size_t block = 0; block < sums->count(); ++block) {
+			bool damaged = false;
+			bool error = false;
+			try {
+				file->verifyBlock(block, buffer.get());
+			} catch(fusepp::fuse_error const & e) {
+				(e.error == EIO ? damaged : error) = true;
+			}
+			std::size_t length = sums->blockLengthAt(block);
+			task.update([&](Stats & counters) {
+				++counters.blocks;
+				counters.bytes += length;
+				counters.damaged += damaged;
+				counters.errors += error;
+			});
+			if(!task.pace(length)) {
+				return;
+			}
+		}
+		task.update([](Stats & counters) {
+			++counters.files;
+		});
+	}
+}
+
+} // namespace smfs
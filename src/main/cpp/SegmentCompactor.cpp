@@ -0,0 +1,288 @@
+/*
+ * SegmentCompactor.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "smfs/SegmentCompactor.h"
+#include "smfs/StatsLine.h"
+
+#include <fusepp/util.hpp>
+
+#include <algorithm>
+#include <unordered_map>
+
+extern "C" {
+	#include <fcntl.h>
+	#include <sys/stat.h>
+}
+
+namespace smfs {
+
+namespace {
+
+/**
+ * Counts the segments overlapping each window of a file.
+ */
+std::vector<std::uint32_t> windowCounts(SegmentTree const & tree, std::size_t windowSize) {
+	std::vector<std::uint32_t> rc((tree.size() + windowSize - 1) / windowSize);
+	off_t position = 0;
+	tree.forEachExtent(0, tree.size(), [&](Segment const &, off_t, std::size_t length) {
+		if(!length) {
+			return;
+		}
+		std::size_t first = position / windowSize;
+		std::size_t last = (position + length - 1) / windowSize;
+		for(std::size_t w = first; w <= last; ++w) {
+			++rc[w];
+		}
+		position += length;
+	});
+	return rc;
+}
+
+/**
+ * Intersects two sorted lists of disjoint ranges.
+ */
+std::vector<std::pair<off_t, off_t>> intersect(std::vector<std::pair<off_t, off_t>> const & a,
+		std::vector<std::pair<off_t, off_t>> const & b) {
+	std::vector<std::pair<off_t, off_t>> rc;
+	auto i = a.begin();
+	auto j = b.begin();
+	while(i != a.end() && j != b.end()) {
+		off_t start = std::max(i->first, j->first);
+		off_t end = std::min(i->second, j->second);
+		if(start < end) {
+			rc.emplace_back(start, end);
+		}
+		(i->second < j->second ? i : j)++;
+	}
+	return rc;
+}
+
+} // namespace
+
+std::string Fragmentation::toString() const {
+	return StatsLine().count("size", size).count("segments", segments).count("mean_segment", meanSegmentSize())
+			.count("windows", windows).count("fragmented_windows", fragmentedWindows)
+			.count("fragmented_bytes", fragmentedBytes).count("worst_window", worstWindow).str();
+}
+
+std::string SegmentCompactor::Stats::toString() const {
+	return StatsLine().count("passes", passes).count("files", files).count("windows", windows)
+			.count("bytes", bytes).count("segments_removed", segmentsRemoved).count("conflicts", conflicts)
+			.count("reclaimed_bytes", reclaimedBytes).count("errors", errors)
+			.flag("finished", finished).flag("stopped", stopped).str();
+}
+
+Fragmentation SegmentCompactor::measure(MergedFile const & file, CompactionPolicy const & policy) {
+	std::shared_ptr<SegmentTree const> tree = file.segments();
+	Fragmentation rc;
+	rc.size = tree->size();
+	rc.segments = tree->count();
+	std::vector<std::uint32_t> counts = windowCounts(*tree, policy.windowSize);
+	rc.windows = counts.size();
+	for(std::size_t w = 0; w < counts.size(); ++w) {
+		rc.worstWindow = std::max<std::uint64_t>(rc.worstWindow, counts[w]);
+		if(counts[w] > policy.maxSegments) {
+			++rc.fragmentedWindows;
+			rc.fragmentedBytes += std::min<std::uint64_t>(policy.windowSize, rc.size - w * policy.windowSize);
+		}
+	}
+	return rc;
+}
+
+SegmentCompactor::SegmentCompactor(std::vector<Target> targets, CompactionPolicy policy, std::uint64_t bytesPerSecond)
+		: SegmentCompactor([targets = std::move(targets)]() { return targets; }, policy, bytesPerSecond) {}
+
+SegmentCompactor::SegmentCompactor(Targets targets, CompactionPolicy policy, std::uint64_t bytesPerSecond)
+		: targets(std::move(targets)), policy(policy), task(bytesPerSecond, [this](Task &) { run(); }) {}
+
+void SegmentCompactor::stop() {
+	task.stop();
+}
+
+SegmentCompactor::Stats SegmentCompactor::wait() const {
+	return task.wait();
+}
+
+SegmentCompactor::Stats SegmentCompactor::stats() const {
+	return task.stats();
+}
+
+std::size_t SegmentCompactor::compact(Target const & target, SegmentTree const & tree, off_t offset, std::size_t length) {
+	SegmentTree expected = tree.range(offset, length);
+	std::unique_ptr<char[]> data(new char[length]);
+	char * out = data.get();
+	expected.forEachExtent(0, length, [&](Segment const & segment, off_t inSegment, std::size_t n) {
+		if(segment.file->read(out, n, segment.offset + inSegment) != n) {
+			// The backing file is shorter than its segment
+			throw fusepp::fuse_error(EIO);
+		}
+		out += n;
+	});
+
+	Segment compacted = target.second->append(data.get(), length);
+	if(target.first->journalled()) {
+		target.second->sync();
+	}
+	bool replaced = target.first->replaceIfUnchanged(offset, expected, SegmentTree(std::vector<Segment>{compacted}));
+
+	task.update([&](Stats & counters) {
+		if(replaced) {
+			++counters.windows;
+			counters.bytes += length;
+			counters.segmentsRemoved += expected.count() - 1;
+		} else {
+			++counters.conflicts;
+		}
+	});
+	return length;
+}
+
+void SegmentCompactor::run() {
+	do {
+		std::vector<Target> current;
+		try {
+			current = targets();
+		} catch(fusepp::fuse_error const &) {
+			task.update([](Stats & counters) {
+				++counters.errors;
+			});
+		}
+		if(!compactAll(current) || !reclaim(current)) {
+			return;
+		}
+		task.update([](Stats & counters) {
+			++counters.passes;
+		});
+	} while(policy.interval > 0 && task.pause(policy.interval));
+}
+
+bool SegmentCompactor::compactAll(std::vector<Target> const & current) {
+	for(Target const & target : current) {
+		std::shared_ptr<SegmentTree const> tree = target.first->segments();
+		std::vector<std::uint32_t> counts = windowCounts(*tree, policy.windowSize);
+		for(std::size_t w = 0; w < counts.size(); ++w) {
+			if(counts[w] <= policy.maxSegments) {
+				continue;
+			}
+			off_t offset = static_cast<off_t>(w) * policy.windowSize;
+			std::size_t length = std::min<off_t>(policy.windowSize, tree->size() - offset);
+			try {
+				compact(target, *tree, offset, length);
+			} catch(fusepp::fuse_error const &) {
+				task.update([](Stats & counters) {
+					++counters.errors;
+				});
+			}
+			if(!task.pace(length)) {
+				return false;
+			}
+		}
+		task.update([](Stats & counters) {
+			++counters.files;
+		});
+	}
+	return true;
+}
+
+bool SegmentCompactor::reclaim(std::vector<Target> const & current) {
+	auto before = unreferenced(current);
+	if(before.empty()) {
+		return true;
+	}
+	// Reads of the segments just replaced, and writes not yet placed, may still be under way
+	if(!task.pause(policy.reclaimDelay)) {
+		return false;
+	}
+	for(auto const & log : unreferenced(current)) {
+		auto earlier = before.find(log.first);
+		if(earlier == before.end()) {
+			continue;
+		}
+		int fd = log.second.first->fd();
+		try {
+			struct stat statbuf;
+			fusepp::check_ret(::fstat(fd, &statbuf));
+			blkcnt_t blocks = statbuf.st_blocks;
+			off_t blockSize = statbuf.st_blksize;
+			for(auto const & range : intersect(earlier->second.second, log.second.second)) {
+				// Only whole blocks can be freed
+				off_t start = (range.first + blockSize - 1) / blockSize * blockSize;
+				off_t end = range.second / blockSize * blockSize;
+				if(start < end) {
+					fusepp::check_ret(::fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, start, end - start));
+				}
+			}
+			fusepp::check_ret(::fstat(fd, &statbuf));
+			task.update([&](Stats & counters) {
+				// Blocks freed before, or written since, may not show up
+				counters.reclaimedBytes += std::max<blkcnt_t>(blocks - statbuf.st_blocks, 0) * 512;
+			});
+		} catch(fusepp::fuse_error const &) {
+			task.update([](Stats & counters) {
+				++counters.errors;
+			});
+		}
+	}
+	return true;
+}
+
+std::map<std::string, std::pair<std::shared_ptr<BackingFile>, SegmentCompactor::Ranges>> SegmentCompactor::unreferenced(
+		std::vector<Target> const & current) {
+	// Measured before the files are looked at, so that anything appended
+	// and placed meanwhile is not taken for unreferenced
+	std::map<std::string, std::pair<std::shared_ptr<BackingFile>, off_t>> logs;
+	for(Target const & target : current) {
+		if(std::shared_ptr<BackingFile> backing = target.second->backing()) {
+			logs.emplace(backing->path, std::make_pair(backing, target.second->size()));
+		}
+	}
+
+	// Logs are matched by path, since a file loaded from a manifest opens
+	// its own backing files
+	std::map<std::string, Ranges> referenced;
+	std::unordered_map<BackingFile const *, Ranges *> known;
+	for(Target const & target : current) {
+		MergedFile::Snapshot snapshot = target.first->snapshot();
+		snapshot.forEachExtent(0, snapshot.size(), [&](Segment const & segment, off_t inSegment, std::size_t length) {
+			auto found = known.find(segment.file.get());
+			if(found == known.end()) {
+				found = known.emplace(segment.file.get(),
+						logs.count(segment.file->path) ? &referenced[segment.file->path] : nullptr).first;
+			}
+			if(found->second) {
+				off_t start = segment.offset + inSegment;
+				found->second->emplace_back(start, start + static_cast<off_t>(length));
+			}
+		});
+	}
+
+	std::map<std::string, std::pair<std::shared_ptr<BackingFile>, Ranges>> rc;
+	for(auto const & log : logs) {
+		Ranges & used = referenced[log.first];
+		std::sort(used.begin(), used.end());
+		Ranges unused;
+		off_t position = 0;
+		for(auto const & range : used) {
+			if(range.first > position) {
+				unused.emplace_back(position, std::min(range.first, log.second.second));
+			}
+			position = std::max(position, range.second);
+		}
+		if(position < log.second.second) {
+			unused.emplace_back(position, log.second.second);
+		}
+		unused.erase(std::remove_if(unused.begin(), unused.end(), [](std::pair<off_t, off_t> const & range) {
+			return range.first >= range.second;
+		}), unused.end());
+		if(!unused.empty()) {
+			rc.emplace(log.first, std::make_pair(log.second.first, std::move(unused)));
+		}
+	}
+	return rc;
+}
+
+} // namespace smfs
@@ -0,0 +1,49 @@
+/*
+ * SegmentList.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#include "smfs/SegmentList.h"
+
+#include <utility>
+
+namespace smfs {
+
+SegmentList::SegmentList(std::vector<Segment> segments) {
+	this->segments.reserve(segments.size());
+	starts.reserve(segments.size() + 1);
+	off_t start = 0;
+	for(Segment &segment : segments) {
+		// Empty segments would make offset lookups ambiguous
+		if(segment.length == 0) {
+			continue;
+		}
+		starts.push_back(start);
+		start += segment.length;
+		this->segments.push_back(std::move(segment));
+	}
+	starts.push_back(start);
+}
+
+std::vector<Segment> SegmentList::slice(off_t offset, std::size_t nbytes) const {
+	std::vector<Segment> rc;
+	forEachExtent(offset, nbytes, [&](Segment const & segment, off_t inSegment, std::size_t length) {
+		rc.push_back(Segment{segment.file, segment.offset + inSegment, length});
+	});
+	return rc;
+}
+
+SegmentList SegmentList::splice(off_t offset, std::size_t nbytes, std::vector<Segment> const & replacement) const {
+	std::vector<Segment> rc = slice(0, offset);
+	rc.insert(rc.end(), replacement.begin(), replacement.end());
+	off_t end = offset + nbytes;
+	if(end < size()) {
+		std::vector<Segment> tail = slice(end, size() - end);
+		rc.insert(rc.end(), tail.begin(), tail.end());
+	}
+	return SegmentList(std::move(rc));
+}
+
+} // namespace smfs
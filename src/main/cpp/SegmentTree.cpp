@@ -0,0 +1,347 @@
+/*
+ * SegmentTree.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "smfs/SegmentTree.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace smfs {
+
+using namespace details;
+
+namespace {
+
+/*
+ * ======================================================
+ * Node construction
+ * ======================================================
+ */
+
+inline off_t length(Segment const & segment) {
+	return segment.length;
+}
+
+inline off_t length(TreeNodePtr const & node) {
+	return node->size();
+}
+
+inline std::size_t weight(Segment const &) {
+	return 1;
+}
+
+inline std::size_t weight(TreeNodePtr const & node) {
+	return node->segments;
+}
+
+template<typename Node, typename E>
+void fill(Node &node, E* slots, E const * first, E const * last) {
+	off_t end = 0;
+	for(E const * e = first; e != last; ++e, ++node.count) {
+		end += length(*e);
+		node.ends[node.count] = end;
+		node.segments += weight(*e);
+		slots[node.count] = *e;
+	}
+}
+
+/**
+ * Leaves are always at height zero, so take the height only to share an
+ * overload set with inner nodes.
+ */
+TreeNodePtr make(unsigned, Segment const * first, Segment const * last) {
+	if(first == last) {
+		return nullptr;
+	}
+	std::shared_ptr<TreeLeaf> node = std::make_shared<TreeLeaf>();
+	fill(*node, node->entries, first, last);
+	return node;
+}
+
+TreeNodePtr make(unsigned height, TreeNodePtr const * first, TreeNodePtr const * last) {
+	if(first == last) {
+		return nullptr;
+	}
+	std::shared_ptr<TreeInner> node = std::make_shared<TreeInner>(height);
+	fill(*node, node->children, first, last);
+	return node;
+}
+
+template<typename E>
+TreeNodePtr make(unsigned height, std::vector<E> const & entries) {
+	return make(height, entries.data(), entries.data() + entries.size());
+}
+
+/**
+ * Packs a list of entries into as few nodes as possible, of as even a size
+ * as possible. If more than one node is needed, each is at least half full.
+ */
+template<typename E>
+std::vector<TreeNodePtr> pack(unsigned height, std::vector<E> const & entries) {
+	std::vector<TreeNodePtr> rc;
+	std::size_t n = entries.size();
+	std::size_t nodes = (n + treeFanout - 1) / treeFanout;
+	E const * e = entries.data();
+	for(std::size_t i = 0; i < nodes; ++i) {
+		std::size_t size = n / nodes + (i < n % nodes ? 1 : 0);
+		rc.push_back(make(height, e, e + size));
+		e += size;
+	}
+	return rc;
+}
+
+void appendEntries(std::vector<Segment> &entries, TreeNode const & node) {
+	TreeLeaf const & l = leaf(node);
+	for(unsigned i = 0; i < node.count; ++i) {
+		Segment const & segment = l.entries[i];
+		if(!entries.empty()) {
+			// Merge with the previous segment if they are contiguous
+			Segment &prev = entries.back();
+			if(prev.file == segment.file && prev.offset + static_cast<off_t>(prev.length) == segment.offset) {
+				prev.length += segment.length;
+				continue;
+			}
+		}
+		entries.push_back(segment);
+	}
+}
+
+void appendEntries(std::vector<TreeNodePtr> &entries, TreeNode const & node) {
+	TreeInner const & in = inner(node);
+	entries.insert(entries.end(), in.children, in.children + node.count);
+}
+
+/*
+ * ======================================================
+ * Joining
+ * ======================================================
+ */
+
+/**
+ * Combines the entries of two nodes of the same height, without looking
+ * any deeper. Used to top up underfull nodes from their siblings.
+ */
+std::vector<TreeNodePtr> rebalance(TreeNodePtr const & a, TreeNodePtr const & b) {
+	if(a->height == 0) {
+		std::vector<Segment> entries;
+		appendEntries(entries, *a);
+		appendEntries(entries, *b);
+		return pack(0, entries);
+	} else {
+		std::vector<TreeNodePtr> entries;
+		appendEntries(entries, *a);
+		appendEntries(entries, *b);
+		return pack(a->height, entries);
+	}
+}
+
+/**
+ * If the child at index `i` is underfull, merges it with a sibling.
+ */
+void repair(std::vector<TreeNodePtr> &children, std::size_t i) {
+	if(children.size() < 2 || children[i]->count >= treeMinFill) {
+		return;
+	}
+	std::size_t j = i > 0 ? i - 1 : i;
+	std::vector<TreeNodePtr> merged = rebalance(children[j], children[j+1]);
+	children.erase(children.begin() + j, children.begin() + j + 2);
+	children.insert(children.begin() + j, merged.begin(), merged.end());
+}
+
+/**
+ * Joins two nodes of the same height, repairing underfull nodes along the
+ * seam between them at every level.
+ * @return One or two nodes of the same height as the given nodes.
+ */
+std::vector<TreeNodePtr> join(TreeNodePtr const & a, TreeNodePtr const & b) {
+	if(a->height == 0) {
+		return rebalance(a, b);
+	}
+	TreeInner const & left = inner(*a);
+	TreeInner const & right = inner(*b);
+
+	std::vector<TreeNodePtr> seam = join(left.children[left.count-1], right.children[0]);
+
+	std::vector<TreeNodePtr> children(left.children, left.children + left.count - 1);
+	std::size_t at = children.size();
+	children.insert(children.end(), seam.begin(), seam.end());
+	children.insert(children.end(), right.children + 1, right.children + right.count);
+	if(seam.size() == 1) {
+		repair(children, at);
+	}
+	return pack(a->height, children);
+}
+
+/**
+ * Joins a node onto the right-hand edge of a taller node.
+ * @return One or two nodes of the same height as `a`.
+ */
+std::vector<TreeNodePtr> joinRight(TreeNodePtr const & a, TreeNodePtr const & b) {
+	TreeInner const & left = inner(*a);
+	TreeNodePtr const & last = left.children[left.count-1];
+	std::vector<TreeNodePtr> parts = last->height == b->height ? join(last, b) : joinRight(last, b);
+
+	std::vector<TreeNodePtr> children(left.children, left.children + left.count - 1);
+	std::size_t at = children.size();
+	children.insert(children.end(), parts.begin(), parts.end());
+	if(parts.size() == 1) {
+		repair(children, at);
+	}
+	return pack(a->height, children);
+}
+
+/**
+ * Joins a node onto the left-hand edge of a taller node.
+ * @return One or two nodes of the same height as `b`.
+ */
+std::vector<TreeNodePtr> joinLeft(TreeNodePtr const & a, TreeNodePtr const & b) {
+	TreeInner const & right = inner(*b);
+	TreeNodePtr const & first = right.children[0];
+	std::vector<TreeNodePtr> parts = first->height == a->height ? join(a, first) : joinLeft(a, first);
+
+	std::vector<TreeNodePtr> children(parts);
+	children.insert(children.end(), right.children + 1, right.children + right.count);
+	if(parts.size() == 1) {
+		repair(children, 0);
+	}
+	return pack(b->height, children);
+}
+
+/**
+ * Builds a root above a list of nodes of the same height.
+ */
+TreeNodePtr grow(std::vector<TreeNodePtr> nodes) {
+	while(nodes.size() > 1) {
+		nodes = pack(nodes.front()->height + 1, nodes);
+	}
+	return nodes.empty() ? nullptr : nodes.front();
+}
+
+/*
+ * ======================================================
+ * Splitting
+ * ======================================================
+ */
+
+std::pair<TreeNodePtr, TreeNodePtr> split(TreeNodePtr const & node, off_t offset) {
+	if(offset <= 0) {
+		return {nullptr, node};
+	}
+	if(offset >= node->size()) {
+		return {node, nullptr};
+	}
+	unsigned i = node->find(offset);
+	off_t inEntry = offset - node->start(i);
+
+	if(node->height == 0) {
+		TreeLeaf const & l = leaf(*node);
+		std::vector<Segment> left(l.entries, l.entries + i);
+		std::vector<Segment> right;
+		Segment const & segment = l.entries[i];
+		if(inEntry > 0) {
+			left.push_back(Segment{segment.file, segment.offset, static_cast<std::size_t>(inEntry)});
+			right.push_back(Segment{segment.file, segment.offset + inEntry, segment.length - inEntry});
+		} else {
+			right.push_back(segment);
+		}
+		right.insert(right.end(), l.entries + i + 1, l.entries + node->count);
+		return {make(0, left), make(0, right)};
+	}
+
+	TreeInner const & in = inner(*node);
+	std::vector<TreeNodePtr> left(in.children, in.children + i);
+	std::vector<TreeNodePtr> right;
+	if(inEntry > 0) {
+		std::pair<TreeNodePtr, TreeNodePtr> parts = split(in.children[i], inEntry);
+		left.push_back(parts.first);
+		right.push_back(parts.second);
+	} else {
+		right.push_back(in.children[i]);
+	}
+	right.insert(right.end(), in.children + i + 1, in.children + node->count);
+	return {make(node->height, left), make(node->height, right)};
+}
+
+} // namespace
+
+/*
+ * ======================================================
+ * SegmentTree
+ * ======================================================
+ */
+
+SegmentTree::SegmentTree(TreeNodePtr root) : root(std::move(root)) {
+	// Splits can leave chains of single-child nodes at the top
+	while(this->root && this->root->height > 0 && this->root->count == 1) {
+		this->root = inner(*this->root).children[0];
+	}
+}
+
+SegmentTree::SegmentTree(std::vector<Segment> const & segments) {
+	std::vector<Segment> entries;
+	entries.reserve(segments.size());
+	for(Segment const & segment : segments) {
+		if(segment.length > 0) {
+			entries.push_back(segment);
+		}
+	}
+	root = grow(pack(0, entries));
+}
+
+std::vector<Segment> SegmentTree::slice(off_t offset, std::size_t nbytes) const {
+	std::vector<Segment> rc;
+	forEachExtent(offset, nbytes, [&](Segment const & segment, off_t inSegment, std::size_t length) {
+		rc.push_back(Segment{segment.file, segment.offset + inSegment, length});
+	});
+	return rc;
+}
+
+std::pair<SegmentTree, SegmentTree> SegmentTree::split(off_t offset) const {
+	if(!root) {
+		return {};
+	}
+	std::pair<TreeNodePtr, TreeNodePtr> parts = smfs::split(root, offset);
+	return {SegmentTree(parts.first), SegmentTree(parts.second)};
+}
+
+SegmentTree SegmentTree::range(off_t offset, std::size_t nbytes) const {
+	return split(offset).second.split(nbytes).first;
+}
+
+SegmentTree SegmentTree::concat(SegmentTree const & left, SegmentTree const & right) {
+	if(!left.root) {
+		return right;
+	}
+	if(!right.root) {
+		return left;
+	}
+	TreeNodePtr const & a = left.root;
+	TreeNodePtr const & b = right.root;
+	if(a->height == b->height) {
+		return SegmentTree(grow(join(a, b)));
+	} else if(a->height > b->height) {
+		return SegmentTree(grow(joinRight(a, b)));
+	} else {
+		return SegmentTree(grow(joinLeft(a, b)));
+	}
+}
+
+SegmentTree SegmentTree::splice(off_t offset, std::size_t nbytes, SegmentTree const & replacement) const {
+	SegmentTree before = split(offset).first;
+	SegmentTree after = split(offset + nbytes).second;
+	return concat(concat(before, replacement), after);
+}
+
+SegmentTree SegmentTree::insert(off_t offset, Segment const & segment) const {
+	return splice(offset, 0, SegmentTree(std::vector<Segment>{segment}));
+}
+
+SegmentTree SegmentTree::erase(off_t offset, std::size_t nbytes) const {
+	return splice(offset, nbytes, SegmentTree());
+}
+
+} // namespace smfs
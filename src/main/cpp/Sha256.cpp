@@ -0,0 +1,134 @@
+/*
+ * Sha256.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "smfs/Sha256.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace smfs {
+
+namespace {
+
+constexpr std::uint32_t roundConstants[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+inline std::uint32_t rotr(std::uint32_t x, unsigned n) {
+	return (x >> n) | (x << (32 - n));
+}
+
+} // namespace
+
+Sha256::Sha256()
+		: state{0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19} {}
+
+void Sha256::compress(std::uint8_t const * chunk) {
+	std::uint32_t w[64];
+	for(unsigned i = 0; i < 16; ++i) {
+		w[i] = std::uint32_t(chunk[4 * i]) << 24 | std::uint32_t(chunk[4 * i + 1]) << 16
+				| std::uint32_t(chunk[4 * i + 2]) << 8 | std::uint32_t(chunk[4 * i + 3]);
+	}
+	for(unsigned i = 16; i < 64; ++i) {
+		std::uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+		std::uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+		w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+	}
+
+	std::uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+	std::uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+	for(unsigned i = 0; i < 64; ++i) {
+		std::uint32_t s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+		std::uint32_t ch = (e & f) ^ (~e & g);
+		std::uint32_t t1 = h + s1 + ch + roundConstants[i] + w[i];
+		std::uint32_t s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+		std::uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+		std::uint32_t t2 = s0 + maj;
+		h = g;
+		g = f;
+		f = e;
+		e = d + t1;
+		d = c;
+		c = b;
+		b = a;
+		a = t1 + t2;
+	}
+	state[0] += a;
+	state[1] += b;
+	state[2] += c;
+	state[3] += d;
+	state[4] += e;
+	state[5] += f;
+	state[6] += g;
+	state[7] += h;
+}
+
+void Sha256::update(void const * data, std::size_t length) {
+	std::uint8_t const * bytes = static_cast<std::uint8_t const *>(data);
+	total += length;
+	if(buffered) {
+		std::size_t n = std::min(length, sizeof(block) - buffered);
+		std::memcpy(block + buffered, bytes, n);
+		buffered += n;
+		bytes += n;
+		length -= n;
+		if(buffered < sizeof(block)) {
+			return;
+		}
+		compress(block);
+		buffered = 0;
+	}
+	for(; length >= sizeof(block); bytes += sizeof(block), length -= sizeof(block)) {
+		compress(bytes);
+	}
+	std::memcpy(block, bytes, length);
+	buffered = length;
+}
+
+Digest Sha256::finish() {
+	std::uint64_t bits = total * 8;
+	std::uint8_t padding[72] = {0x80};
+	std::size_t padLength = (buffered < 56 ? 56 : 120) - buffered;
+	for(unsigned i = 0; i < 8; ++i) {
+		padding[padLength + i] = static_cast<std::uint8_t>(bits >> (56 - 8 * i));
+	}
+	update(padding, padLength + 8);
+
+	Digest rc;
+	for(unsigned i = 0; i < 8; ++i) {
+		rc[4 * i] = static_cast<std::uint8_t>(state[i] >> 24);
+		rc[4 * i + 1] = static_cast<std::uint8_t>(state[i] >> 16);
+		rc[4 * i + 2] = static_cast<std::uint8_t>(state[i] >> 8);
+		rc[4 * i + 3] = static_cast<std::uint8_t>(state[i]);
+	}
+	return rc;
+}
+
+Digest Sha256::of(void const * data, std::size_t length) {
+	Sha256 sha;
+	sha.update(data, length);
+	return sha.finish();
+}
+
+std::string Sha256::hex(Digest const & digest) {
+	static char const digits[] = "0123456789abcdef";
+	std::string rc;
+	for(std::uint8_t byte : digest) {
+		rc += digits[byte >> 4];
+		rc += digits[byte & 0xf];
+	}
+	return rc;
+}
+
+} // namespace smfs
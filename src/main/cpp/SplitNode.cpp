@@ -0,0 +1,175 @@
+/*
+ * SplitNode.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "smfs/SplitNode.h"
+#include "smfs/MergedNode.h"
+#include "smfs/Mount.h"
+
+#include <utility>
+
+namespace smfs {
+
+namespace {
+
+/**
+ * The time, in seconds, for which the kernel may cache the attributes of
+ * nodes in a split view.
+ */
+constexpr double attrTimeout = 1.0;
+
+fusepp::path_t childPath(fusepp::path_t const & parent, std::string const & name) {
+	return parent == "/" ? parent + name : parent + "/" + name;
+}
+
+fusepp::path_t parentPath(fusepp::path_t const & path) {
+	std::size_t slash = path.rfind('/');
+	return slash == 0 || slash == fusepp::path_t::npos ? "/" : path.substr(0, slash);
+}
+
+/**
+ * A handle to a chunk of a split file.
+ */
+class ChunkHandle : public MergedFileHandle {
+public:
+	using MergedFileHandle::MergedFileHandle;
+
+	/**
+	 * Changes to backing hierarchies are not tracked, so cached data is never kept.
+	 */
+	bool keepCache() const override {
+		return false;
+	}
+};
+
+/**
+ * An entry listed by a @ref SplitDirHandle.
+ */
+class SplitDirEntry : public fusepp::DirEntry {
+	std::string name;
+	std::size_t next;
+	unsigned char type;
+	fusepp::path_t path;
+	Mount * mount;
+
+public:
+	SplitDirEntry(std::string name, std::size_t next, mode_t mode, fusepp::path_t path, Mount & mount)
+			: name(std::move(name)), next(next), type(IFTODT(mode)), path(std::move(path)), mount(&mount) {}
+
+	std::string getName() const override {
+		return name;
+	}
+
+	std::size_t getNextOffset() const override {
+		return next;
+	}
+
+	unsigned char getType() const override {
+		return type;
+	}
+
+	std::shared_ptr<fusepp::Node1> lookupNode() override {
+		return mount->get_node(path);
+	}
+};
+
+} // namespace
+
+/*
+ * ======================================================
+ * SplitDirHandle
+ * ======================================================
+ */
+
+SplitDirHandle::SplitDirHandle(fusepp::path_t rel_path, SplitView const & view, SplitView::Resolved resolved,
+		Mount & mount)
+		: rel_path(std::move(rel_path)), resolved(std::move(resolved)),
+		  entries(view.list(this->resolved)), mount(mount) {}
+
+void SplitDirHandle::getattr(struct stat& statbuf) {
+	statbuf = resolved.attributes;
+}
+
+std::optional<fusepp::AnyDirEntry> SplitDirHandle::readdir() {
+	std::size_t index = position;
+	if(index >= entries.size() + 2) {
+		return std::nullopt;
+	}
+	++position;
+	if(index < 2) {
+		fusepp::path_t path = index == 0 ? rel_path : parentPath(rel_path);
+		return fusepp::AnyDirEntry(SplitDirEntry(index == 0 ? "." : "..", position, S_IFDIR, path, mount));
+	}
+	DirectoryEntry const & entry = entries[index - 2];
+	return fusepp::AnyDirEntry(SplitDirEntry(entry.name, position, entry.attributes.st_mode,
+			childPath(rel_path, entry.name), mount));
+}
+
+void SplitDirHandle::seekdir(std::size_t offset) {
+	position = offset;
+}
+
+std::size_t SplitDirHandle::telldir() {
+	return position;
+}
+
+/*
+ * ======================================================
+ * SplitNode
+ * ======================================================
+ */
+
+SplitNode::SplitNode(fusepp::path_t rel_path, std::shared_ptr<SplitView const> view, SplitView::Resolved resolved,
+		std::shared_ptr<BlockCache> cache, Mount & mount)
+		: Node1(rel_path), view(std::move(view)), resolved(std::move(resolved)), cache(std::move(cache)), mount(mount) {}
+
+std::tuple<std::shared_ptr<fusepp::Node1>, double> SplitNode::lookup(std::string name) {
+	SplitView::Resolved child = view->lookup(resolved, name);
+	if(child.kind == SplitView::Resolved::missing) {
+		throw fusepp::fuse_error(ENOENT);
+	}
+	std::shared_ptr<fusepp::Node1> node = std::make_shared<SplitNode>(childPath(rel_path, name), view,
+			std::move(child), cache, mount);
+	return std::make_tuple(std::move(node), attrTimeout);
+}
+
+double SplitNode::getattr(struct stat& statbuf) {
+	if(resolved.kind == SplitView::Resolved::missing) {
+		throw fusepp::fuse_error(ENOENT);
+	}
+	statbuf = resolved.attributes;
+	return attrTimeout;
+}
+
+std::unique_ptr<fusepp::FileHandle1> SplitNode::open(int flags) {
+	switch(resolved.kind) {
+	case SplitView::Resolved::chunk:
+		break;
+	case SplitView::Resolved::missing:
+		throw fusepp::fuse_error(ENOENT);
+	default:
+		throw fusepp::fuse_error(EISDIR);
+	}
+	if((flags & O_ACCMODE) != O_RDONLY) {
+		throw fusepp::fuse_error(EROFS);
+	}
+	std::vector<Segment> segments{{BackingFile::open(resolved.backingPath), resolved.offset, resolved.length}};
+	return std::make_unique<ChunkHandle>(std::make_shared<MergedFile>(std::move(segments), cache), mount, flags);
+}
+
+std::unique_ptr<fusepp::DirHandle1> SplitNode::opendir(int) {
+	switch(resolved.kind) {
+	case SplitView::Resolved::directory:
+	case SplitView::Resolved::splitFile:
+		return std::make_unique<SplitDirHandle>(rel_path, *view, resolved, mount);
+	case SplitView::Resolved::missing:
+		throw fusepp::fuse_error(ENOENT);
+	default:
+		throw fusepp::fuse_error(ENOTDIR);
+	}
+}
+
+} // namespace smfs
@@ -0,0 +1,281 @@
+/*
+ * SplitView.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "smfs/SplitView.h"
+
+#include <fusepp/util.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+
+namespace smfs {
+
+namespace {
+
+constexpr mode_t writeBits = S_IWUSR | S_IWGRP | S_IWOTH;
+
+/**
+ * Presents the attributes of a backing directory. The view is read-only.
+ */
+struct stat directoryAttributes(struct stat attributes) {
+	attributes.st_mode &= ~writeBits;
+	return attributes;
+}
+
+/**
+ * Presents the attributes of a backing file as a directory, searchable by
+ * whoever could read the file.
+ */
+struct stat splitFileAttributes(struct stat attributes) {
+	mode_t read = attributes.st_mode & (S_IRUSR | S_IRGRP | S_IROTH);
+	attributes.st_mode = S_IFDIR | read | (read >> 2);
+	attributes.st_nlink = 2;
+	attributes.st_blocks = 0;
+	return attributes;
+}
+
+bool isPresented(struct stat const & attributes) {
+	return S_ISDIR(attributes.st_mode) || S_ISREG(attributes.st_mode);
+}
+
+} // namespace
+
+SplitView::SplitView(std::string root, std::size_t chunkSize, std::shared_ptr<DirectoryCache> cache)
+		: SplitView(std::move(root), chunkSize, std::nullopt, std::move(cache), nullptr) {
+	if(chunkSize == 0) {
+		throw fusepp::fuse_error(EINVAL);
+	}
+}
+
+SplitView::SplitView(std::string root, Chunker chunker, std::shared_ptr<DirectoryCache> cache,
+		std::shared_ptr<Manifest const> boundaries)
+		: SplitView(std::move(root), chunker.average(), chunker, std::move(cache), std::move(boundaries)) {}
+
+SplitView::SplitView(std::string root, std::size_t chunkSize, std::optional<Chunker> chunker,
+		std::shared_ptr<DirectoryCache> cache, std::shared_ptr<Manifest const> boundaries)
+		: root(std::move(root)), chunkLength(chunkSize), chunker(std::move(chunker)), cache(std::move(cache)),
+		  savedBoundaries(std::move(boundaries)) {
+	fusepp::check_ret(::stat(this->root.c_str(), &rootAttributes));
+	if(!S_ISDIR(rootAttributes.st_mode)) {
+		throw fusepp::fuse_error(ENOTDIR);
+	}
+}
+
+SplitView::Resolved SplitView::resolve(std::string const & path) const {
+	Resolved current;
+	current.kind = Resolved::directory;
+	current.backingPath = root;
+	current.backingAttributes = rootAttributes;
+	current.attributes = directoryAttributes(rootAttributes);
+
+	std::size_t start = 0;
+	while(current.kind != Resolved::missing && start < path.size()) {
+		std::size_t end = path.find('/', start);
+		if(end == std::string::npos) {
+			end = path.size();
+		}
+		if(end > start) {
+			current = lookup(current, path.substr(start, end - start));
+		}
+		start = end + 1;
+	}
+	return current;
+}
+
+SplitView::Resolved SplitView::lookup(Resolved const & parent, std::string const & name) const {
+	switch(parent.kind) {
+	case Resolved::directory: {
+		std::shared_ptr<Directory const> directory = cache->get(parent.backingPath);
+		DirectoryEntry const * entry = directory->find(name);
+		Resolved rc;
+		if(!entry || !isPresented(entry->attributes)) {
+			return rc;
+		}
+		rc.backingPath = parent.backingPath + "/" + name;
+		rc.backingAttributes = entry->attributes;
+		if(S_ISDIR(entry->attributes.st_mode)) {
+			rc.kind = Resolved::directory;
+			rc.attributes = directoryAttributes(entry->attributes);
+		} else {
+			rc.kind = Resolved::splitFile;
+			rc.attributes = splitFileAttributes(entry->attributes);
+		}
+		return rc;
+	}
+	case Resolved::splitFile: {
+		char * end;
+		std::size_t index = std::strtoull(name.c_str(), &end, 10);
+		if(*end != '\0' || name != chunkName(index)) {
+			return Resolved();
+		}
+		Layout chunks = layout(parent);
+		if(index >= chunks.count()) {
+			return Resolved();
+		}
+		return chunk(parent, chunks, index);
+	}
+	default:
+		return Resolved();
+	}
+}
+
+std::vector<DirectoryEntry> SplitView::list(Resolved const & parent) const {
+	std::vector<DirectoryEntry> rc;
+	switch(parent.kind) {
+	case Resolved::directory:
+		for(DirectoryEntry const & entry : cache->get(parent.backingPath)->entries()) {
+			if(S_ISDIR(entry.attributes.st_mode)) {
+				rc.push_back(DirectoryEntry{entry.name, directoryAttributes(entry.attributes)});
+			} else if(S_ISREG(entry.attributes.st_mode)) {
+				rc.push_back(DirectoryEntry{entry.name, splitFileAttributes(entry.attributes)});
+			}
+		}
+		return rc;
+	case Resolved::splitFile: {
+		Layout chunks = layout(parent);
+		std::size_t count = chunks.count();
+		rc.reserve(count);
+		for(std::size_t i = 0; i < count; ++i) {
+			rc.push_back(DirectoryEntry{chunkName(i), chunk(parent, chunks, i).attributes});
+		}
+		return rc;
+	}
+	default:
+		throw fusepp::fuse_error(ENOTDIR);
+	}
+}
+
+std::string SplitView::chunkName(std::size_t index) {
+	char buf[24];
+	int n = std::snprintf(buf, sizeof(buf), "%08zu", index);
+	return std::string(buf, n);
+}
+
+std::size_t SplitView::Layout::count() const {
+	return ends ? ends->size() : (fileSize + chunkSize - 1) / chunkSize;
+}
+
+off_t SplitView::Layout::start(std::size_t index) const {
+	if(ends) {
+		return index ? (*ends)[index - 1] : 0;
+	}
+	return static_cast<off_t>(index) * chunkSize;
+}
+
+off_t SplitView::Layout::end(std::size_t index) const {
+	if(ends) {
+		return (*ends)[index];
+	}
+	return std::min<off_t>(fileSize, static_cast<off_t>(index + 1) * chunkSize);
+}
+
+SplitView::Layout SplitView::layout(Resolved const & file) const {
+	return Layout{file.backingAttributes.st_size, chunkLength, chunker ? boundaries(file) : nullptr};
+}
+
+SplitView::Boundaries SplitView::boundaries(Resolved const & file) const {
+	std::uint64_t current = version(file.backingAttributes);
+	{
+		std::lock_guard<std::mutex> lock(boundariesLock);
+		auto it = knownBoundaries.find(file.backingPath);
+		if(it != knownBoundaries.end() && it->second.version == current) {
+			return it->second.ends;
+		}
+	}
+
+	Boundaries rc = saved(file);
+	if(!rc) {
+		rc = chunking.run(file.backingPath, [&]() {
+			return std::make_shared<std::vector<off_t> const>(chunker->boundaries(*BackingFile::open(file.backingPath)));
+		});
+	}
+	std::lock_guard<std::mutex> lock(boundariesLock);
+	knownBoundaries[file.backingPath] = Known{current, rc};
+	return rc;
+}
+
+SplitView::Boundaries SplitView::saved(Resolved const & file) const {
+	if(!savedBoundaries) {
+		return nullptr;
+	}
+	std::call_once(indexed, [this]() {
+		for(std::size_t i = 0; i < savedBoundaries->fileCount(); ++i) {
+			savedIndex.emplace(savedBoundaries->path(i), i);
+		}
+	});
+	auto it = savedIndex.find(file.backingPath);
+	if(it == savedIndex.end() || savedBoundaries->size(it->second) != file.backingAttributes.st_size
+			|| savedBoundaries->sequence(it->second) != version(file.backingAttributes)) {
+		return nullptr;
+	}
+	return std::make_shared<std::vector<off_t> const>(savedBoundaries->boundaries(it->second));
+}
+
+std::uint64_t SplitView::version(struct stat const & attributes) {
+	std::uint64_t const fields[] = {
+		static_cast<std::uint64_t>(attributes.st_dev),
+		static_cast<std::uint64_t>(attributes.st_ino),
+		static_cast<std::uint64_t>(attributes.st_size),
+		static_cast<std::uint64_t>(attributes.st_mtim.tv_sec),
+		static_cast<std::uint64_t>(attributes.st_mtim.tv_nsec),
+		static_cast<std::uint64_t>(attributes.st_ctim.tv_sec),
+		static_cast<std::uint64_t>(attributes.st_ctim.tv_nsec)
+	};
+	// FNV-1a over the fields
+	std::uint64_t hash = 14695981039346656037ull;
+	for(std::uint64_t field : fields) {
+		for(int i = 0; i < 8; ++i) {
+			hash = (hash ^ ((field >> (i * 8)) & 0xff)) * 1099511628211ull;
+		}
+	}
+	return hash ? hash : 1;
+}
+
+void SplitView::saveBoundaries(std::string const & path) const {
+	std::map<std::string, Known> all;
+	{
+		std::lock_guard<std::mutex> lock(boundariesLock);
+		all.insert(knownBoundaries.begin(), knownBoundaries.end());
+	}
+	if(savedBoundaries) {
+		// Keep the saved boundaries of files this view hasn't used
+		for(std::size_t i = 0; i < savedBoundaries->fileCount(); ++i) {
+			std::string file(savedBoundaries->path(i));
+			if(!all.count(file)) {
+				all.emplace(file, Known{savedBoundaries->sequence(i),
+						std::make_shared<std::vector<off_t> const>(savedBoundaries->boundaries(i))});
+			}
+		}
+	}
+
+	ManifestWriter writer;
+	for(auto const & entry : all) {
+		writer.addRanges(entry.first, entry.first, *entry.second.ends, entry.second.version);
+	}
+	writer.write(path);
+}
+
+SplitView::Resolved SplitView::chunk(Resolved const & file, Layout const & layout, std::size_t index) const {
+	Resolved rc;
+	rc.kind = Resolved::chunk;
+	rc.backingPath = file.backingPath;
+	rc.backingAttributes = file.backingAttributes;
+	rc.index = index;
+	rc.offset = layout.start(index);
+	rc.length = layout.end(index) - rc.offset;
+
+	rc.attributes = file.backingAttributes;
+	rc.attributes.st_mode = S_IFREG | (file.backingAttributes.st_mode & (S_IRUSR | S_IRGRP | S_IROTH));
+	rc.attributes.st_nlink = 1;
+	rc.attributes.st_size = rc.length;
+	rc.attributes.st_blocks = (rc.length + 511) / 512;
+	return rc;
+}
+
+} // namespace smfs
@@ -0,0 +1,42 @@
+/*
+ * StatsLine.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "smfs/StatsLine.h"
+
+#include <cstdio>
+
+namespace smfs {
+
+StatsLine & StatsLine::count(char const * name, std::uint64_t value) {
+	this->name(name);
+	line += std::to_string(value);
+	return *this;
+}
+
+StatsLine & StatsLine::ratio(char const * name, double value, int precision) {
+	this->name(name);
+	char buf[64];
+	int n = std::snprintf(buf, sizeof(buf), "%.*f", precision, value);
+	line.append(buf, n);
+	return *this;
+}
+
+StatsLine & StatsLine::flag(char const * name, bool value) {
+	this->name(name);
+	line += value ? '1' : '0';
+	return *this;
+}
+
+void StatsLine::name(char const * name) {
+	if(!line.empty()) {
+		line += ' ';
+	}
+	line += name;
+	line += '=';
+}
+
+} // namespace smfs
@@ -0,0 +1,129 @@
+/*
+ * StripedLayout.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "smfs/StripedLayout.h"
+
+#include <fusepp/util.hpp>
+
+#include <algorithm>
+
+extern "C" {
+	#include <unistd.h>
+}
+
+namespace smfs {
+
+namespace {
+
+void writeAll(int fd, char const * data, std::size_t length, off_t offset) {
+	for(std::size_t written = 0; written < length;) {
+		ssize_t rc = ::pwrite(fd, data + written, length - written, offset + written);
+		if(rc < 0) {
+			if(errno == EINTR) {
+				continue;
+			}
+			throw fusepp::fuse_error::from_errno();
+		}
+		written += rc;
+	}
+}
+
+/**
+ * The descriptors of the members being written, closed however the write
+ * ends.
+ */
+struct Descriptors {
+	std::vector<int> fds;
+
+	Descriptors() = default;
+	Descriptors(Descriptors const &other) = delete;
+	Descriptors& operator=(Descriptors const &other) = delete;
+
+	~Descriptors() {
+		for(int fd : fds) {
+			::close(fd);
+		}
+	}
+};
+
+} // namespace
+
+StripedLayout::StripedLayout(std::vector<std::string> directories, std::size_t stripeSize)
+		: dirs(std::move(directories)), stripeLength(stripeSize) {
+	if(dirs.empty() || !stripeLength) {
+		throw fusepp::fuse_error(EINVAL);
+	}
+}
+
+off_t StripedLayout::memberSize(off_t size, std::size_t stripeSize, std::size_t count, std::size_t member) {
+	off_t stripes = size / stripeSize;
+	off_t rc = (stripes / count + (static_cast<off_t>(member) < stripes % static_cast<off_t>(count))) * stripeSize;
+	if(static_cast<off_t>(member) == stripes % static_cast<off_t>(count)) {
+		// This member holds the partial stripe at the end, if there is one
+		rc += size % stripeSize;
+	}
+	return rc;
+}
+
+off_t StripedLayout::write(BackingFile const & source, std::string const & name) const {
+	Descriptors members;
+	for(std::string const & dir : dirs) {
+		std::string path = dir + "/" + name;
+		members.fds.push_back(fusepp::check_ret(::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)));
+	}
+	std::vector<int> const & fds = members.fds;
+	std::unique_ptr<char[]> stripe(new char[stripeLength]);
+	off_t size = 0;
+	for(std::size_t i = 0;; ++i) {
+		std::size_t n = source.read(stripe.get(), stripeLength, size);
+		writeAll(fds[i % fds.size()], stripe.get(), n, (i / fds.size()) * stripeLength);
+		size += n;
+		if(n < stripeLength) {
+			break;
+		}
+	}
+	for(int fd : fds) {
+		fusepp::check_ret(::fsync(fd));
+	}
+	return size;
+}
+
+std::vector<Segment> StripedLayout::open(std::string const & name) const {
+	std::vector<std::shared_ptr<BackingFile>> members;
+	for(std::string const & dir : dirs) {
+		members.push_back(BackingFile::open(dir + "/" + name));
+	}
+	return segments(members, stripeLength);
+}
+
+std::vector<Segment> StripedLayout::segments(std::vector<std::shared_ptr<BackingFile>> const & members,
+		std::size_t stripeSize) {
+	if(members.empty() || !stripeSize) {
+		throw fusepp::fuse_error(EINVAL);
+	}
+	off_t size = 0;
+	std::vector<off_t> sizes;
+	for(std::shared_ptr<BackingFile> const & member : members) {
+		sizes.push_back(member->size());
+		size += sizes.back();
+	}
+	for(std::size_t i = 0; i < members.size(); ++i) {
+		if(sizes[i] != memberSize(size, stripeSize, members.size(), i)) {
+			throw fusepp::fuse_error(EINVAL);
+		}
+	}
+
+	std::vector<Segment> rc;
+	for(off_t offset = 0; offset < size; offset += stripeSize) {
+		std::size_t i = offset / stripeSize;
+		rc.push_back(Segment{members[i % members.size()], static_cast<off_t>(i / members.size() * stripeSize),
+				static_cast<std::size_t>(std::min<off_t>(stripeSize, size - offset))});
+	}
+	return rc;
+}
+
+} // namespace smfs
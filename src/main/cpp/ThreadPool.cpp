@@ -0,0 +1,103 @@
+/*
+ * ThreadPool.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "smfs/ThreadPool.h"
+
+#include <algorithm>
+
+namespace smfs {
+
+ThreadPool::ThreadPool(unsigned threads) {
+	if(!threads) {
+		threads = std::max(1u, std::thread::hardware_concurrency()) - 1;
+	}
+	for(unsigned i = 0; i < threads; ++i) {
+		workers.emplace_back([this]() { work(); });
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	for(std::thread &worker : workers) {
+		worker.join();
+	}
+}
+
+ThreadPool & ThreadPool::shared() {
+	static ThreadPool pool;
+	return pool;
+}
+
+ThreadPool & ThreadPool::io() {
+	static ThreadPool pool(ioThreads);
+	return pool;
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+	if(workers.empty()) {
+		task();
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		queue.push_back(std::move(task));
+	}
+	wake.notify_one();
+}
+
+void ThreadPool::work() {
+	std::unique_lock<std::mutex> lock(mutex);
+	while(true) {
+		wake.wait(lock, [this]() { return stopping || !queue.empty(); });
+		if(queue.empty()) {
+			return;
+		}
+		std::function<void()> task = std::move(queue.front());
+		queue.pop_front();
+		lock.unlock();
+		task();
+		lock.lock();
+	}
+}
+
+void ThreadPool::Batch::run() {
+	std::size_t ran = 0;
+	for(std::size_t i; (i = next.fetch_add(1)) < count; ++ran) {
+		if(failed.load(std::memory_order_relaxed)) {
+			// Skip whatever had not been started by the time of the failure
+			continue;
+		}
+		try {
+			(*body)(i);
+		} catch(...) {
+			std::lock_guard<std::mutex> lock(mutex);
+			if(!error) {
+				error = std::current_exception();
+			}
+			failed = true;
+		}
+	}
+	if(ran) {
+		std::lock_guard<std::mutex> lock(mutex);
+		finished += ran;
+	}
+	done.notify_all();
+}
+
+void ThreadPool::Batch::wait() {
+	std::unique_lock<std::mutex> lock(mutex);
+	done.wait(lock, [this]() { return finished == count; });
+	if(error) {
+		std::rethrow_exception(error);
+	}
+}
+
+} // namespace smfs
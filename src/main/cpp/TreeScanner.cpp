@@ -0,0 +1,291 @@
+/*
+ * TreeScanner.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "smfs/TreeScanner.h"
+
+#include <fusepp/common.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+extern "C" {
+	#include <dirent.h>
+	#include <fcntl.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+}
+
+namespace smfs {
+
+namespace {
+
+/**
+ * The size of the buffer each worker reads directory entries into. Large
+ * directories are read in few system calls.
+ */
+constexpr std::size_t direntBufferSize = 256 * 1024;
+
+/**
+ * The state of a single scan, shared between its workers.
+ */
+class Scan {
+	struct Worker {
+		std::mutex lock;
+
+		/**
+		 * Directories waiting to be scanned, as paths relative to the root.
+		 */
+		std::deque<std::string> tasks;
+
+		std::vector<ScannedFile> found;
+		TreeScanner::Stats counters;
+	};
+
+	std::string const root;
+	std::vector<std::unique_ptr<Worker>> workers;
+
+	/**
+	 * The number of directories queued or being scanned. The scan is
+	 * complete when this reaches zero.
+	 */
+	std::atomic<std::size_t> pending{0};
+
+	/**
+	 * The number of directories queued, and not yet taken by a worker.
+	 */
+	std::atomic<std::size_t> queued{0};
+
+	/**
+	 * Wakes workers with nothing to do when a directory is queued, or the
+	 * scan ends.
+	 */
+	std::mutex idleLock;
+	std::condition_variable idle;
+
+	std::atomic<bool> failed{false};
+	std::mutex errorLock;
+	std::exception_ptr error;
+
+public:
+	Scan(std::string root, unsigned threads) : root(std::move(root)) {
+		for(unsigned i = 0; i < threads; ++i) {
+			workers.emplace_back(new Worker);
+		}
+	}
+
+	std::vector<ScannedFile> run(TreeScanner::Stats &stats) {
+		push(0, "");
+		std::vector<std::thread> threads;
+		for(unsigned w = 1; w < workers.size(); ++w) {
+			threads.emplace_back(&Scan::work, this, w);
+		}
+		work(0);
+		for(std::thread &t : threads) {
+			t.join();
+		}
+		if(error) {
+			std::rethrow_exception(error);
+		}
+
+		std::size_t total = 0;
+		for(auto const & worker : workers) {
+			total += worker->found.size();
+		}
+		std::vector<ScannedFile> rc;
+		rc.reserve(total);
+		stats = TreeScanner::Stats();
+		for(auto const & worker : workers) {
+			std::move(worker->found.begin(), worker->found.end(), std::back_inserter(rc));
+			stats.directories += worker->counters.directories;
+			stats.files += worker->counters.files;
+			stats.bytes += worker->counters.bytes;
+			stats.steals += worker->counters.steals;
+		}
+		std::sort(rc.begin(), rc.end(), [](ScannedFile const & a, ScannedFile const & b) {
+			return a.path < b.path;
+		});
+		return rc;
+	}
+
+private:
+	void push(unsigned w, std::string path) {
+		++pending;
+		{
+			std::lock_guard<std::mutex> lock(workers[w]->lock);
+			workers[w]->tasks.push_back(std::move(path));
+		}
+		++queued;
+		wakeIdle(false);
+	}
+
+	void wakeIdle(bool all) {
+		// Taken so that a worker cannot miss the wakeup between checking for
+		// work and waiting
+		std::lock_guard<std::mutex> lock(idleLock);
+		if(all) {
+			idle.notify_all();
+		} else {
+			idle.notify_one();
+		}
+	}
+
+	/**
+	 * Takes the newest of a worker's own tasks, or failing that, steals the
+	 * oldest task of another worker.
+	 */
+	bool take(unsigned w, std::string &path) {
+		{
+			Worker &own = *workers[w];
+			std::lock_guard<std::mutex> lock(own.lock);
+			if(!own.tasks.empty()) {
+				path = std::move(own.tasks.back());
+				own.tasks.pop_back();
+				--queued;
+				return true;
+			}
+		}
+		for(unsigned i = 1; i < workers.size(); ++i) {
+			Worker &victim = *workers[(w + i) % workers.size()];
+			std::lock_guard<std::mutex> lock(victim.lock);
+			if(!victim.tasks.empty()) {
+				path = std::move(victim.tasks.front());
+				victim.tasks.pop_front();
+				--queued;
+				++workers[w]->counters.steals;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void work(unsigned w) {
+		std::unique_ptr<char[]> buffer(new char[direntBufferSize]);
+		std::string path;
+		while(pending > 0 && !failed) {
+			if(!take(w, path)) {
+				// Every queued directory has been taken, so wait for those
+				// being scanned to queue more, or for the scan to end
+				std::unique_lock<std::mutex> lock(idleLock);
+				idle.wait(lock, [this]() { return queued > 0 || pending == 0 || failed; });
+				continue;
+			}
+			try {
+				scanDirectory(w, path, buffer.get());
+			} catch(...) {
+				std::lock_guard<std::mutex> lock(errorLock);
+				if(!error) {
+					error = std::current_exception();
+				}
+				failed = true;
+			}
+			if(--pending == 0 || failed) {
+				wakeIdle(true);
+			}
+		}
+	}
+
+	void scanDirectory(unsigned w, std::string const & path, char * buffer) {
+		Worker &worker = *workers[w];
+		std::string full = path.empty() ? root : root + "/" + path;
+		int fd = ::open(full.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+		if(fd < 0) {
+			if(errno == ENOENT && !path.empty()) {
+				// Removed since its parent was read
+				return;
+			}
+			throw fusepp::fuse_error::from_errno();
+		}
+		try {
+			while(true) {
+				ssize_t n = ::getdents64(fd, buffer, direntBufferSize);
+				if(n < 0) {
+					throw fusepp::fuse_error::from_errno();
+				}
+				if(n == 0) {
+					break;
+				}
+				for(ssize_t offset = 0; offset < n;) {
+					struct dirent64 const * entry = reinterpret_cast<struct dirent64 const *>(buffer + offset);
+					offset += entry->d_reclen;
+					addEntry(w, fd, path, entry->d_name, entry->d_type);
+				}
+			}
+		} catch(...) {
+			::close(fd);
+			throw;
+		}
+		::close(fd);
+		++worker.counters.directories;
+	}
+
+	void addEntry(unsigned w, int dirfd, std::string const & parent, char const * name, unsigned char type) {
+		if(std::strcmp(name, ".") == 0 || std::strcmp(name, "..") == 0) {
+			return;
+		}
+		if(type != DT_DIR && type != DT_REG && type != DT_UNKNOWN) {
+			return;
+		}
+		std::string path = parent.empty() ? std::string(name) : parent + "/" + name;
+		if(type == DT_DIR) {
+			push(w, std::move(path));
+			return;
+		}
+
+		// Only ask for the type if the directory entry didn't give it
+		struct statx attributes;
+		unsigned mask = type == DT_UNKNOWN ? STATX_TYPE | STATX_SIZE : STATX_SIZE;
+		if(::statx(dirfd, name, AT_SYMLINK_NOFOLLOW, mask, &attributes) != 0) {
+			if(errno == ENOENT) {
+				return;
+			}
+			throw fusepp::fuse_error::from_errno();
+		}
+		if(type == DT_UNKNOWN) {
+			if(S_ISDIR(attributes.stx_mode)) {
+				push(w, std::move(path));
+				return;
+			}
+			if(!S_ISREG(attributes.stx_mode)) {
+				return;
+			}
+		}
+
+		Worker &worker = *workers[w];
+		worker.found.push_back(ScannedFile{std::move(path), attributes.stx_size});
+		++worker.counters.files;
+		worker.counters.bytes += attributes.stx_size;
+	}
+};
+
+} // namespace
+
+TreeScanner::TreeScanner(unsigned threads)
+		: threadCount(threads ? threads : std::max(1u, std::thread::hardware_concurrency())) {}
+
+std::vector<ScannedFile> TreeScanner::scan(std::string const & root) {
+	return Scan(root, threadCount).run(counters);
+}
+
+std::vector<Segment> TreeScanner::segments(std::string const & root) {
+	std::vector<Segment> rc;
+	for(ScannedFile const & file : scan(root)) {
+		if(file.size) {
+			// Opened only when read, as there may be far more files than descriptors
+			rc.push_back(Segment{BackingFile::openLazily(root + "/" + file.path), 0, file.size});
+		}
+	}
+	return rc;
+}
+
+} // namespace smfs
@@ -0,0 +1,126 @@
+/*
+ * WriteCoalescer.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "smfs/WriteCoalescer.h"
+#include "smfs/StatsLine.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace smfs {
+
+std::string WriteCoalescer::Stats::toString() const {
+	return StatsLine().count("writes", writes).count("bytes", bytes).count("backing_writes", backingWrites)
+			.count("write_through", writeThrough).ratio("ratio", ratio(), 2).str();
+}
+
+WriteCoalescer::Stats WriteCoalescer::Counters::stats() const {
+	Stats rc;
+	rc.writes = writes.load(std::memory_order_relaxed);
+	rc.bytes = bytes.load(std::memory_order_relaxed);
+	rc.backingWrites = backingWrites.load(std::memory_order_relaxed);
+	rc.writeThrough = writeThrough.load(std::memory_order_relaxed);
+	return rc;
+}
+
+WriteCoalescer::WriteCoalescer(Sink sink, std::size_t threshold, std::shared_ptr<Counters> counters)
+		: sink(std::move(sink)), limit(threshold), counters(std::move(counters)) {}
+
+std::pair<off_t, std::size_t> WriteCoalescer::pending() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	if(buffer.empty()) {
+		// The start of the last buffer may be past the end of a since-truncated file
+		return {0, 0};
+	}
+	return {start, buffer.size()};
+}
+
+off_t WriteCoalescer::size(off_t size) const {
+	std::lock_guard<std::mutex> lock(mutex);
+	if(buffer.empty()) {
+		return size;
+	}
+	return std::max(size, start + static_cast<off_t>(buffer.size()));
+}
+
+void WriteCoalescer::write(void const * data, std::size_t nbytes, off_t offset) {
+	++counters->writes;
+	counters->bytes += nbytes;
+	if(!limit) {
+		// Nothing is ever buffered, so there is no order to keep
+		++counters->writeThrough;
+		++counters->backingWrites;
+		sink(data, nbytes, offset);
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	off_t end = start + static_cast<off_t>(buffer.size());
+	if(!buffer.empty() && (offset < start || offset > end)) {
+		flushLocked();
+	}
+	if(buffer.empty()) {
+		start = offset;
+		buffer.reserve(limit);
+	}
+	// Overwrites any buffered data the write overlaps, and extends past the rest
+	std::size_t at = offset - start;
+	buffer.resize(std::max(buffer.size(), at + nbytes));
+	std::memcpy(buffer.data() + at, data, nbytes);
+	if(buffer.size() >= limit) {
+		flushAligned();
+	}
+}
+
+void WriteCoalescer::writeThrough(std::size_t nbytes, std::function<void()> const & write) {
+	++counters->writes;
+	counters->bytes += nbytes;
+	++counters->writeThrough;
+	std::lock_guard<std::mutex> lock(mutex);
+	flushLocked();
+	++counters->backingWrites;
+	write();
+}
+
+void WriteCoalescer::flush() {
+	std::lock_guard<std::mutex> lock(mutex);
+	flushLocked();
+}
+
+void WriteCoalescer::flushLocked() {
+	if(buffer.empty()) {
+		return;
+	}
+	std::vector<char> data;
+	data.swap(buffer);
+	++counters->backingWrites;
+	sink(data.data(), data.size(), start);
+	// Keeps the allocation for the next run of writes
+	data.clear();
+	buffer.swap(data);
+}
+
+void WriteCoalescer::flushAligned() {
+	off_t end = start + static_cast<off_t>(buffer.size());
+	off_t aligned = end - end % static_cast<off_t>(alignment);
+	if(aligned <= start) {
+		flushLocked();
+		return;
+	}
+	std::size_t length = aligned - start;
+	++counters->backingWrites;
+	try {
+		sink(buffer.data(), length, start);
+	} catch(...) {
+		buffer.clear();
+		throw;
+	}
+	buffer.erase(buffer.begin(), buffer.begin() + length);
+	start = aligned;
+}
+
+} // namespace smfs
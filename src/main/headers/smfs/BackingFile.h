@@ -0,0 +1,204 @@
+/*
+ * BackingFile.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_BACKINGFILE_H_
+#define SMFS_BACKINGFILE_H_
+
+#include "smfs/BlockChecksums.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+extern "C" {
+	#include <sys/types.h> // for off_t
+	#include <fcntl.h>
+}
+
+namespace smfs {
+
+/**
+ * An open file on the backing storage from which the data of smfs files is
+ * ultimately read.
+ *
+ * Each backing file is given an identifier that is unique for the lifetime of
+ * the process, so that it can be used as a cache key even after the file has
+ * been closed and its descriptor reused.
+ *
+ * A backing file may have @ref BlockChecksums, in which case data read from
+ * it is verified against them.
+ *
+ * Subclasses may store their data differently, such as @ref CompressedFile,
+ * by overriding @ref size and @ref readUnchecked.
+ */
+class BackingFile {
+public:
+	/**
+	 * The type used to identify backing files.
+	 */
+	using id_type = std::uint64_t;
+
+	/**
+	 * The identifier of this backing file.
+	 */
+	id_type const id;
+
+	/**
+	 * The path with which this backing file was opened.
+	 */
+	std::string const path;
+
+	/**
+	 * Opens the file at the given path.
+	 * @param path The path of the file to open.
+	 * @param flags The flags to pass to `open`.
+	 * @return A shared pointer to the newly-opened backing file.
+	 * @throws fusepp::fuse_error if the file could not be opened.
+	 */
+	static std::shared_ptr<BackingFile> open(std::string const & path, int flags = O_RDONLY);
+
+	/**
+	 * Refers to the file at the given path, for reading, without keeping it
+	 * open. The file is opened when read, through a cache of descriptors
+	 * shared by all such files that keeps only so many open at once, so any
+	 * number of files may be referred to. Such a file has no raw descriptor.
+	 * @param path The path of the file.
+	 * @return A shared pointer to the backing file.
+	 */
+	static std::shared_ptr<BackingFile> openLazily(std::string const & path);
+
+	BackingFile(BackingFile const &other) = delete;
+	BackingFile& operator=(BackingFile const &other) = delete;
+
+	/**
+	 * Closes the underlying file descriptor, if it is kept open.
+	 */
+	virtual ~BackingFile();
+
+	/**
+	 * @return The file descriptor of this backing file, or -1 if it is opened
+	 *         lazily.
+	 */
+	int fd() const {
+		return descriptor;
+	}
+
+	/**
+	 * Opens a new descriptor for this backing file, even if it is opened
+	 * lazily.
+	 * @return The descriptor, which the caller must close.
+	 * @throws fusepp::fuse_error if the file could not be opened.
+	 */
+	virtual int duplicate() const;
+
+	/**
+	 * @return The current size, in bytes, of this backing file.
+	 * @throws fusepp::fuse_error if the size could not be determined.
+	 */
+	virtual off_t size() const;
+
+	/**
+	 * @return Whether the data of this backing file can be read straight from
+	 *         its descriptor, so that the descriptor can be passed on instead
+	 *         of the data.
+	 */
+	virtual bool hasRawDescriptor() const {
+		return true;
+	}
+
+	/**
+	 * @return Whether this backing file was opened for writing, as a delta
+	 *         log is, and so may still grow or change under its readers.
+	 */
+	virtual bool growable() const {
+		return false;
+	}
+
+	/**
+	 * Reads data from this backing file.
+	 *
+	 * Short reads are retried until either the requested number of bytes have
+	 * been read or the end of the file is reached.
+	 *
+	 * @param buf The memory to read the data into.
+	 * @param nbytes The number of bytes to read.
+	 * @param offset The offset within the file to read from.
+	 * @return The number of bytes actually read, which is only less than
+	 *         `nbytes` at the end of the file.
+	 * @throws fusepp::fuse_error if an error occurs, or with EIO if the data
+	 *         does not match this file's checksums.
+	 */
+	virtual std::size_t read(void * buf, std::size_t nbytes, off_t offset) const;
+
+	/**
+	 * Sets the checksums to verify data read from this file against. This
+	 * must be done before the file is shared between threads.
+	 * @param checksums The checksums of this file.
+	 */
+	void attachChecksums(std::shared_ptr<BlockChecksums const> checksums) {
+		blockChecksums = std::move(checksums);
+	}
+
+	/**
+	 * @return The checksums of this file, or `nullptr` if it has none.
+	 */
+	std::shared_ptr<BlockChecksums const> const & checksums() const {
+		return blockChecksums;
+	}
+
+	/**
+	 * Verifies a range of this file against its checksums, reading any
+	 * blocks overlapping it that have not yet been verified. This is for
+	 * callers that pass the file's descriptor on rather than reading from it.
+	 * @param offset The offset within the file at which the range begins.
+	 * @param nbytes The number of bytes in the range.
+	 * @throws fusepp::fuse_error if the blocks cannot be read, or with EIO if
+	 *         they do not match their checksums.
+	 */
+	void verify(off_t offset, std::size_t nbytes) const;
+
+	/**
+	 * Reads a block of this file and verifies it against its checksum, even
+	 * if it has been verified before.
+	 * @param block The index of the block to verify.
+	 * @param buffer Space for at least a block of data.
+	 * @throws fusepp::fuse_error if the block cannot be read, or with EIO if
+	 *         it does not match its checksum.
+	 */
+	void verifyBlock(std::size_t block, void * buffer) const;
+
+protected:
+
+	/**
+	 * Constructor for BackingFile. Takes ownership of the given descriptor.
+	 * @param path The path the descriptor was opened with.
+	 * @param fd The open file descriptor.
+	 */
+	BackingFile(std::string const & path, int fd);
+
+	/**
+	 * Reads data from this backing file without verifying it.
+	 * @see read
+	 */
+	virtual std::size_t readUnchecked(void * buf, std::size_t nbytes, off_t offset) const;
+
+	/**
+	 * Reads from a descriptor as @ref readUnchecked does, retrying short reads.
+	 */
+	static std::size_t readFrom(int descriptor, void * buf, std::size_t nbytes, off_t offset);
+
+private:
+	int const descriptor;
+	std::shared_ptr<BlockChecksums const> blockChecksums;
+
+	void verifyRead(void const * buf, std::size_t nbytes, off_t offset) const;
+};
+
+} // namespace smfs
+
+#endif /* SMFS_BACKINGFILE_H_ */
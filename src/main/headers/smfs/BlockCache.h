@@ -0,0 +1,254 @@
+/*
+ * BlockCache.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_BLOCKCACHE_H_
+#define SMFS_BLOCKCACHE_H_
+
+#include "smfs/BackingFile.h"
+#include "smfs/SingleFlight.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace smfs {
+
+/**
+ * A fixed-size block of data read from a @ref BackingFile.
+ *
+ * Blocks are shared between the @ref BlockCache and any readers still using
+ * them, so a block evicted from the cache remains valid until its last reader
+ * releases it.
+ */
+class Block {
+	std::unique_ptr<char[]> const mem;
+	std::size_t length;
+
+public:
+
+	/**
+	 * Constructor for Block.
+	 * @param capacity The maximum number of bytes the block can hold.
+	 */
+	explicit Block(std::size_t capacity) : mem(new char[capacity]), length(capacity) {}
+
+	char * data() {
+		return mem.get();
+	}
+
+	char const * data() const {
+		return mem.get();
+	}
+
+	/**
+	 * @return The number of valid bytes in this block. This is only less
+	 *         than the cache's block size for the last block of a file.
+	 */
+	std::size_t size() const {
+		return length;
+	}
+
+	void resize(std::size_t size) {
+		length = size;
+	}
+};
+
+/**
+ * Identifies a block within a backing file.
+ */
+struct BlockKey {
+	BackingFile::id_type file;
+	off_t offset;
+
+	friend bool operator==(BlockKey const &a, BlockKey const &b) {
+		return a.file == b.file && a.offset == b.offset;
+	}
+};
+
+struct BlockKeyHash {
+	std::size_t operator()(BlockKey const &key) const {
+		return std::hash<std::uint64_t>()(key.file * 0x9e3779b97f4a7c15ull ^ key.offset);
+	}
+};
+
+/**
+ * A cache of fixed-size blocks of backing file data, bounded by a byte budget.
+ *
+ * Replacement follows the 2Q policy: blocks seen for the first time enter a
+ * small FIFO queue, and are only promoted to the main LRU queue if they are
+ * requested again after having been evicted from it. A single sequential scan
+ * therefore cannot flush the working set out of the cache.
+ */
+class BlockCache {
+public:
+
+	/**
+	 * The default size of each block.
+	 */
+	static constexpr std::size_t defaultBlockSize = 128 * 1024;
+
+	/**
+	 * Counters describing how effective a cache has been.
+	 */
+	struct Stats {
+		std::uint64_t hits = 0;
+		std::uint64_t misses = 0;
+
+		/**
+		 * The number of misses served by joining a read of the same block
+		 * already in progress for another reader.
+		 */
+		std::uint64_t coalesced = 0;
+
+		/**
+		 * The number of bytes served from the cache, and so not read from
+		 * backing storage.
+		 */
+		std::uint64_t bytesSaved = 0;
+
+		/**
+		 * The number of bytes read from backing storage to fill the cache.
+		 */
+		std::uint64_t bytesFetched = 0;
+
+		std::uint64_t evictions = 0;
+
+		/**
+		 * @return The fraction of block lookups that were served from the
+		 *         cache, or zero if there have been none.
+		 */
+		double hitRatio() const {
+			std::uint64_t total = hits + misses;
+			return total ? static_cast<double>(hits) / total : 0.0;
+		}
+
+		/**
+		 * @return A human-readable, single-line summary of these statistics.
+		 */
+		std::string toString() const;
+	};
+
+	/**
+	 * Constructor for BlockCache.
+	 * @param budget The maximum number of bytes of block data to keep cached.
+	 * @param blockSize The size of each block.
+	 */
+	explicit BlockCache(std::size_t budget, std::size_t blockSize = defaultBlockSize);
+
+	BlockCache(BlockCache const &other) = delete;
+	BlockCache& operator=(BlockCache const &other) = delete;
+
+	/**
+	 * @return The size of each block held by this cache.
+	 */
+	std::size_t blockSize() const {
+		return blockLength;
+	}
+
+	/**
+	 * @return The maximum number of bytes of block data held by this cache.
+	 */
+	std::size_t budget() const {
+		return byteBudget;
+	}
+
+	/**
+	 * Gets a block of data, reading it from the backing file if it is not
+	 * already cached. Concurrent misses on the same block share a single read.
+	 * Blocks of growable files (see @ref BackingFile::growable) are read
+	 * afresh every time and never cached, since a cached block would miss
+	 * data written into it later, such as the short last block of a delta log
+	 * that is then appended to.
+	 *
+	 * @param file The file to get the block from.
+	 * @param offset The offset of the block, which must be a multiple of the
+	 *               block size.
+	 * @return The requested block.
+	 * @throws fusepp::fuse_error if the block could not be read.
+	 */
+	std::shared_ptr<Block> get(BackingFile const & file, off_t offset);
+
+	/**
+	 * Invokes the given function for each block overlapping a range of a
+	 * backing file, in order. Blocks are read into the cache as necessary.
+	 * Iteration stops early at the end of the backing file.
+	 *
+	 * @param file The file to read.
+	 * @param offset The offset within the file at which the range begins.
+	 * @param nbytes The number of bytes in the range.
+	 * @param fn A function taking the arguments
+	 *           `(std::shared_ptr<Block> block, std::size_t offsetInBlock, std::size_t length)`.
+	 * @throws fusepp::fuse_error if a block could not be read.
+	 */
+	template<typename F>
+	void read(BackingFile const & file, off_t offset, std::size_t nbytes, F&& fn) {
+		off_t end = offset + nbytes;
+		while(offset < end) {
+			off_t blockOffset = offset - offset % blockLength;
+			std::shared_ptr<Block> block = get(file, blockOffset);
+			std::size_t inBlock = offset - blockOffset;
+			if(inBlock >= block->size()) {
+				break;
+			}
+			std::size_t length = std::min<off_t>(block->size() - inBlock, end - offset);
+			fn(std::move(block), inBlock, length);
+			offset += length;
+		}
+	}
+
+	/**
+	 * @return A snapshot of this cache's statistics.
+	 */
+	Stats stats() const;
+
+private:
+	enum class Queue { in, main, ghost };
+
+	struct Entry {
+		std::shared_ptr<Block> block;
+		Queue queue;
+		std::list<BlockKey>::iterator pos;
+	};
+
+	std::size_t const byteBudget;
+	std::size_t const blockLength;
+
+	/**
+	 * The number of bytes the FIFO queue may hold before its blocks are
+	 * evicted in preference to those in the main queue.
+	 */
+	std::size_t const inBudget;
+
+	/**
+	 * The number of evicted block keys to remember.
+	 */
+	std::size_t const ghostCapacity;
+
+	mutable std::mutex mutex;
+	std::unordered_map<BlockKey, Entry, BlockKeyHash> index;
+	std::list<BlockKey> inQueue;
+	std::list<BlockKey> mainQueue;
+	std::list<BlockKey> ghostQueue;
+	std::size_t inBytes = 0;
+	std::size_t mainBytes = 0;
+	Stats counters;
+	SingleFlight<BlockKey, std::shared_ptr<Block>, BlockKeyHash> fills;
+
+	std::shared_ptr<Block> fetch(BackingFile const & file, BlockKey const & key);
+	std::shared_ptr<Block> lookup(BlockKey const & key);
+	std::shared_ptr<Block> insert(BlockKey const & key, std::shared_ptr<Block> block);
+	void evict();
+};
+
+} // namespace smfs
+
+#endif /* SMFS_BLOCKCACHE_H_ */
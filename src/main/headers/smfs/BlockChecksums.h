@@ -0,0 +1,133 @@
+/*
+ * BlockChecksums.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_BLOCKCHECKSUMS_H_
+#define SMFS_BLOCKCHECKSUMS_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+extern "C" {
+	#include <sys/types.h> // for off_t
+}
+
+namespace smfs {
+
+class BackingFile;
+
+/**
+ * The CRC-32C checksums of each fixed-size block of a backing file, along
+ * with which of them have been verified since the file was opened.
+ *
+ * Blocks are verified lazily, as they are first read, and only once: a
+ * verified block is assumed to stay intact while the file is open, so hot
+ * data costs nothing to check after its first read. A scrub re-verifies
+ * every block regardless.
+ *
+ * Only the first @ref size bytes of the file are covered. Anything appended
+ * to the file afterwards is read unchecked.
+ */
+class BlockChecksums {
+	std::size_t const blockLength;
+	off_t const length;
+	std::vector<std::uint32_t> const crcs;
+	std::unique_ptr<std::atomic<std::uint64_t>[]> const verifiedBits;
+
+public:
+
+	/**
+	 * The default size of each checksummed block, chosen to match a
+	 * @ref BlockCache so that each cached block is checked as a whole.
+	 */
+	static constexpr std::size_t defaultBlockSize = 128 * 1024;
+
+	/**
+	 * Constructor for BlockChecksums.
+	 * @param blockSize The size of each block.
+	 * @param size The number of bytes of the file covered.
+	 * @param crcs The checksum of each block, the last of which may be short.
+	 * @throws fusepp::fuse_error with EINVAL if the block size is zero, or
+	 *         there are not as many checksums as blocks.
+	 */
+	BlockChecksums(std::size_t blockSize, off_t size, std::vector<std::uint32_t> crcs);
+
+	BlockChecksums(BlockChecksums const &other) = delete;
+	BlockChecksums& operator=(BlockChecksums const &other) = delete;
+
+	/**
+	 * Checksums the whole of a file as it is now.
+	 * @param file The file to checksum.
+	 * @param blockSize The size of each block.
+	 * @throws fusepp::fuse_error if the file cannot be read.
+	 */
+	static std::shared_ptr<BlockChecksums> compute(BackingFile const & file, std::size_t blockSize = defaultBlockSize);
+
+	/**
+	 * @return The size of each block.
+	 */
+	std::size_t blockSize() const {
+		return blockLength;
+	}
+
+	/**
+	 * @return The number of bytes of the file covered by the checksums.
+	 */
+	off_t size() const {
+		return length;
+	}
+
+	/**
+	 * @return The checksum of each block.
+	 */
+	std::vector<std::uint32_t> const & checksums() const {
+		return crcs;
+	}
+
+	/**
+	 * @return The number of blocks.
+	 */
+	std::size_t count() const {
+		return crcs.size();
+	}
+
+	/**
+	 * @return The number of bytes in a block.
+	 */
+	std::size_t blockLengthAt(std::size_t block) const {
+		off_t start = static_cast<off_t>(block) * blockLength;
+		return static_cast<std::size_t>(std::min<off_t>(blockLength, length - start));
+	}
+
+	/**
+	 * @return Whether a block has been verified.
+	 */
+	bool verified(std::size_t block) const {
+		return verifiedBits[block / 64].load(std::memory_order_acquire) & (std::uint64_t(1) << (block % 64));
+	}
+
+	/**
+	 * @return The number of blocks that have been verified.
+	 */
+	std::size_t verifiedCount() const;
+
+	/**
+	 * Checks the contents of a block against its checksum, and records the
+	 * result.
+	 * @param block The index of the block.
+	 * @param data The whole contents of the block.
+	 * @throws fusepp::fuse_error with EIO if the contents do not match.
+	 */
+	void check(std::size_t block, void const * data) const;
+};
+
+} // namespace smfs
+
+#endif /* SMFS_BLOCKCHECKSUMS_H_ */
@@ -0,0 +1,104 @@
+/*
+ * Chunker.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_CHUNKER_H_
+#define SMFS_CHUNKER_H_
+
+#include "smfs/BackingFile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace smfs {
+
+/**
+ * Divides data into content-defined chunks, following FastCDC.
+ *
+ * A cut point is placed after any byte at which a gear hash of the 64 bytes
+ * ending there has its top bits clear, so chunk boundaries move with the
+ * content around them rather than with absolute offsets: inserting bytes
+ * into a file changes only the chunks near the insertion. Chunk sizes are
+ * normalised towards the average by requiring more bits to be clear before
+ * the average size is reached than after it, and are bounded to between a
+ * quarter of and eight times the average.
+ *
+ * Because the hash only depends on the last 64 bytes, the bytes before the
+ * minimum chunk size need not be hashed at all, and a region can be divided
+ * between several independent hash chains, each starting a window early.
+ * The recurrence within a chain is serial, but the processor can overlap
+ * interleaved chains, which roughly doubles throughput over a single one.
+ *
+ * The gear table is fixed, so boundaries are stable between runs.
+ */
+class Chunker {
+	std::size_t const averageSize;
+	std::size_t const minSize;
+	std::size_t const maxSize;
+	std::uint64_t const strictMask;
+	std::uint64_t const looseMask;
+
+public:
+
+	/**
+	 * The number of bytes each hash is computed over.
+	 */
+	static constexpr std::size_t window = 64;
+
+	/**
+	 * Constructor for Chunker.
+	 * @param averageSize The target average chunk size, which is rounded
+	 *                    down to a power of two.
+	 * @throws fusepp::fuse_error with EINVAL if the average size is less than
+	 *         256 bytes, or more than 16 MiB.
+	 */
+	explicit Chunker(std::size_t averageSize = 8192);
+
+	/**
+	 * @return The size of the smallest chunk, other than the last of a file.
+	 */
+	std::size_t min() const {
+		return minSize;
+	}
+
+	/**
+	 * @return The target average chunk size.
+	 */
+	std::size_t average() const {
+		return averageSize;
+	}
+
+	/**
+	 * @return The size of the largest chunk.
+	 */
+	std::size_t max() const {
+		return maxSize;
+	}
+
+	/**
+	 * Finds the first cut point in some data.
+	 * @param data The data, beginning at the start of a chunk.
+	 * @param length The number of bytes of data. To find the same cut point
+	 *               as in the whole file, this must be at least @ref max
+	 *               bytes unless the data runs to the end of the file.
+	 * @return The length of the first chunk.
+	 */
+	std::size_t cut(unsigned char const * data, std::size_t length) const;
+
+	/**
+	 * Divides a whole file into chunks.
+	 * @param file The file to read.
+	 * @return The offset of the end of each chunk, in order. The last is the
+	 *         size of the file, and there are none if it is empty.
+	 * @throws fusepp::fuse_error if the file cannot be read.
+	 */
+	std::vector<off_t> boundaries(BackingFile const & file) const;
+};
+
+} // namespace smfs
+
+#endif /* SMFS_CHUNKER_H_ */
@@ -0,0 +1,64 @@
+/*
+ * Coalesced.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_COALESCED_H_
+#define SMFS_COALESCED_H_
+
+#include "fuse.hpp"
+#include "smfs/SingleFlight.h"
+
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+
+namespace smfs {
+
+/**
+ * Extends a @ref fusepp::Node1 type so that concurrent calls to its `getattr`
+ * or `lookup` (of the same name) are collapsed into a single call to the
+ * base class's implementation, whose result is shared by all the callers.
+ *
+ * This is worthwhile for nodes whose attributes or children are expensive to
+ * determine (e.g. by stat'ing slow backing storage), and which many processes
+ * are likely to query at the same time. Callers only share a call if they
+ * share the node instance, so mounts should hand the same instance to
+ * concurrent callers for a path.
+ *
+ * @tparam Base The node type to extend.
+ */
+template<typename Base>
+class Coalesced : public Base {
+	using Attributes = std::pair<struct stat, double>;
+	using Lookup = std::tuple<std::shared_ptr<fusepp::Node1>, double>;
+
+	SingleFlight<bool, Attributes> attrFlights;
+	SingleFlight<std::string, Lookup> lookupFlights;
+
+public:
+	using Base::Base;
+
+	double getattr(struct stat& statbuf) override {
+		Attributes attrs = attrFlights.run(true, [this]() {
+			Attributes rc;
+			rc.second = Base::getattr(rc.first);
+			return rc;
+		});
+		statbuf = attrs.first;
+		return attrs.second;
+	}
+
+	Lookup lookup(std::string name) override {
+		return lookupFlights.run(name, [this, &name]() {
+			return Base::lookup(name);
+		});
+	}
+};
+
+} // namespace smfs
+
+#endif /* SMFS_COALESCED_H_ */
@@ -0,0 +1,142 @@
+/*
+ * CompressedFile.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_COMPRESSEDFILE_H_
+#define SMFS_COMPRESSEDFILE_H_
+
+#include "smfs/BackingFile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace smfs {
+
+/**
+ * A backing file stored in a seekable compressed container, which reads as
+ * the data it contains.
+ *
+ * The data is divided into fixed-size blocks, each compressed with LZ4
+ * independently of the others, and followed by an index of where each
+ * block starts. A read hence only decompresses the blocks it overlaps. A
+ * read overlapping several blocks decompresses them on the shared
+ * @ref ThreadPool at once. A block that does not compress is stored as it
+ * is.
+ *
+ * Decompressed data is not kept, so a compressed file is best read through
+ * a @ref BlockCache, which holds on to what has been decompressed. The
+ * block size of the container should divide that of the cache, so that
+ * each miss decompresses whole blocks.
+ *
+ * Since the descriptor of a compressed file does not hold its data, it
+ * cannot be passed on to be read from directly (see @ref hasRawDescriptor).
+ */
+class CompressedFile : public BackingFile {
+	std::size_t const blockLength;
+	off_t const length;
+	std::vector<std::uint64_t> const offsets;
+
+public:
+
+	/**
+	 * The default number of bytes of data in each block.
+	 */
+	static constexpr std::size_t defaultBlockSize = 64 * 1024;
+
+	/**
+	 * The number of blocks a read must overlap to be decompressed on
+	 * several threads.
+	 */
+	static constexpr std::size_t parallelBlocks = 4;
+
+	/**
+	 * Opens the compressed container at the given path.
+	 * @param path The path of the container.
+	 * @return A shared pointer to the newly-opened file.
+	 * @throws fusepp::fuse_error if the file could not be opened, or with
+	 *         EINVAL if it is not a valid container.
+	 */
+	static std::shared_ptr<CompressedFile> open(std::string const & path);
+
+	/**
+	 * Opens a file to read the data of segments from: as a compressed file if
+	 * it is a compressed container, or else as an ordinary backing file.
+	 * @param path The path of the file.
+	 * @return A shared pointer to the newly-opened file.
+	 * @throws fusepp::fuse_error if the file could not be opened, or with
+	 *         EINVAL if it appears to be a container but is not valid.
+	 */
+	static std::shared_ptr<BackingFile> openAny(std::string const & path);
+
+	/**
+	 * Writes the contents of a file to a new compressed container. The
+	 * container is written to a temporary file and renamed into place, so
+	 * that it is never seen partially written.
+	 * @param source The file to compress, which is read as it is now.
+	 * @param path The path to write the container to.
+	 * @param blockSize The number of bytes of data in each block.
+	 * @throws fusepp::fuse_error if the source cannot be read or the
+	 *         container cannot be written, or with EINVAL if the block size is
+	 *         zero or over 4 GiB.
+	 */
+	static void compress(BackingFile const & source, std::string const & path,
+			std::size_t blockSize = defaultBlockSize);
+
+	/**
+	 * @return The number of bytes of data in each block.
+	 */
+	std::size_t blockSize() const {
+		return blockLength;
+	}
+
+	/**
+	 * @return The number of blocks.
+	 */
+	std::size_t blockCount() const {
+		return offsets.size() - 1;
+	}
+
+	/**
+	 * @return The number of bytes the blocks take up once compressed.
+	 */
+	off_t compressedSize() const {
+		return offsets.back() - offsets.front();
+	}
+
+	/**
+	 * @return The size of the data in the container.
+	 */
+	off_t size() const override {
+		return length;
+	}
+
+	bool hasRawDescriptor() const override {
+		return false;
+	}
+
+protected:
+	std::size_t readUnchecked(void * buf, std::size_t nbytes, off_t offset) const override;
+
+private:
+	CompressedFile(std::string const & path, int fd, std::size_t blockSize, off_t size,
+			std::vector<std::uint64_t> offsets);
+
+	std::size_t blockLengthAt(std::size_t block) const;
+
+	/**
+	 * Decompresses a whole block.
+	 * @param out Space for the block's data.
+	 * @throws fusepp::fuse_error with EIO if the block is damaged.
+	 */
+	void readBlock(std::size_t block, unsigned char * out) const;
+};
+
+} // namespace smfs
+
+#endif /* SMFS_COMPRESSEDFILE_H_ */
@@ -0,0 +1,32 @@
+/*
+ * Crc32c.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_CRC32C_H_
+#define SMFS_CRC32C_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace smfs {
+
+/**
+ * Computes the CRC-32C (Castagnoli) checksum of some data.
+ *
+ * Uses the SSE 4.2 or ARMv8 CRC instructions where the processor has them.
+ * Long inputs are divided into three interleaved streams, whose CRCs are
+ * combined afterwards, so that the instruction's latency is hidden.
+ *
+ * @param data The data to checksum.
+ * @param length The number of bytes of data.
+ * @param crc The checksum of any preceding data, to continue from.
+ * @return The checksum of the preceding data followed by this data.
+ */
+std::uint32_t crc32c(void const * data, std::size_t length, std::uint32_t crc = 0);
+
+} // namespace smfs
+
+#endif /* SMFS_CRC32C_H_ */
@@ -0,0 +1,217 @@
+/*
+ * DedupStore.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_DEDUPSTORE_H_
+#define SMFS_DEDUPSTORE_H_
+
+#include "smfs/BackingFile.h"
+#include "smfs/Chunker.h"
+#include "smfs/Segment.h"
+#include "smfs/Sha256.h"
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace smfs {
+
+struct DigestHash {
+	std::size_t operator()(Digest const & digest) const {
+		// The digest is already uniformly distributed
+		std::size_t rc;
+		std::memcpy(&rc, digest.data(), sizeof(rc));
+		return rc;
+	}
+};
+
+/**
+ * A content-addressed index of segment data, so that identical data
+ * appearing in several places is referred to, and cached, only once.
+ *
+ * Interning a segment hashes its contents with SHA-256, optionally after
+ * dividing it into content-defined chunks. The first location seen with
+ * some contents becomes the canonical location for them; segments interned
+ * afterwards with the same contents are replaced with segments referring to
+ * the canonical location. Since a @ref BlockCache is keyed by location,
+ * merged files sharing contents then share the cached blocks too.
+ *
+ * Each distinct content is reference counted, and dropped from the index
+ * when the last reference is released. A merged file holds its references
+ * in @ref References for as long as its contents are those it was interned
+ * with.
+ *
+ * Backing files may be changed behind the store's back, so the canonical
+ * location of some contents is read back and checked each time the contents
+ * are found again. If it no longer holds them, the location they were just
+ * found at becomes canonical instead.
+ */
+class DedupStore {
+public:
+
+	/**
+	 * Counters describing the effect of deduplication.
+	 */
+	struct Stats {
+
+		/**
+		 * The number of distinct contents in the index.
+		 */
+		std::uint64_t unique = 0;
+
+		/**
+		 * The number of references to contents in the index.
+		 */
+		std::uint64_t references = 0;
+
+		/**
+		 * The number of bytes referred to, counting shared contents once for
+		 * each reference.
+		 */
+		std::uint64_t logicalBytes = 0;
+
+		/**
+		 * The number of bytes of distinct contents.
+		 */
+		std::uint64_t uniqueBytes = 0;
+
+		/**
+		 * The number of times contents were found to be missing from their
+		 * canonical location, and given a new one.
+		 */
+		std::uint64_t relocated = 0;
+
+		/**
+		 * @return The number of bytes that need not be stored, or cached,
+		 *         separately because their contents are shared.
+		 */
+		std::uint64_t savedBytes() const {
+			return logicalBytes - uniqueBytes;
+		}
+
+		/**
+		 * @return A human-readable, single-line summary of these statistics.
+		 */
+		std::string toString() const;
+	};
+
+private:
+	/**
+	 * The canonical location of some contents. Backing files are held by
+	 * index into a table, to keep entries small.
+	 */
+	struct Location {
+		std::uint32_t file;
+		std::uint32_t references;
+		off_t offset;
+		std::uint64_t length;
+	};
+
+	std::optional<Chunker> const chunker;
+	mutable std::mutex mutex;
+	std::unordered_map<Digest, Location, DigestHash> index;
+	std::vector<std::shared_ptr<BackingFile>> files;
+	std::unordered_map<BackingFile::id_type, std::uint32_t> fileIndex;
+	Stats counters;
+
+public:
+
+	/**
+	 * References to interned contents, released when destroyed.
+	 */
+	class References {
+		std::shared_ptr<DedupStore> store;
+		std::vector<Digest> digests;
+
+	public:
+
+		/**
+		 * Constructor for References.
+		 * @param store The store the contents were interned in.
+		 * @param digests The digests given by @ref intern.
+		 */
+		References(std::shared_ptr<DedupStore> store, std::vector<Digest> digests)
+				: store(std::move(store)), digests(std::move(digests)) {}
+
+		References(References &&other) noexcept
+				: store(std::move(other.store)), digests(std::move(other.digests)) {
+			other.digests.clear();
+		}
+
+		References(References const &other) = delete;
+		References& operator=(References const &other) = delete;
+
+		/**
+		 * Releases the references.
+		 */
+		~References();
+	};
+
+	/**
+	 * Constructs a store that identifies whole segments by their contents.
+	 */
+	DedupStore();
+
+	/**
+	 * Constructs a store that divides segments into content-defined chunks,
+	 * and identifies each chunk by its contents. This finds shared data even
+	 * where segments overlap only in part.
+	 * @param chunker The chunker to divide segments with.
+	 */
+	explicit DedupStore(Chunker chunker);
+
+	DedupStore(DedupStore const &other) = delete;
+	DedupStore& operator=(DedupStore const &other) = delete;
+
+	/**
+	 * Interns the contents of some segments, taking a reference to each.
+	 * @param segments The segments to intern.
+	 * @param digests If not `nullptr`, receives the digest of each interned
+	 *                segment, for releasing them later.
+	 * @return Segments with the same contents, referring to the canonical
+	 *         location of each.
+	 * @throws fusepp::fuse_error if the segments cannot be read, in which
+	 *         case no references are taken.
+	 */
+	std::vector<Segment> intern(std::vector<Segment> const & segments, std::vector<Digest> * digests = nullptr);
+
+	/**
+	 * Releases a reference to some contents.
+	 * @param digest The digest of the contents, as given by @ref intern.
+	 */
+	void release(Digest const & digest);
+
+	/**
+	 * Looks up the canonical location of some contents.
+	 * @param digest The digest of the contents.
+	 * @return The location, or an empty optional if the contents are not in
+	 *         the index.
+	 */
+	std::optional<Segment> find(Digest const & digest) const;
+
+	/**
+	 * @return A snapshot of the counters for this store.
+	 */
+	Stats stats() const;
+
+private:
+	std::vector<Segment> internAll(std::vector<Segment> const & segments, std::vector<Digest> & digests);
+	Segment add(Digest const & digest, Segment const & segment);
+
+	/**
+	 * @return Whether a segment can be read and has the given digest.
+	 */
+	static bool holds(Segment const & segment, Digest const & digest);
+};
+
+} // namespace smfs
+
+#endif /* SMFS_DEDUPSTORE_H_ */
@@ -0,0 +1,112 @@
+/*
+ * DeltaLog.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_DELTALOG_H_
+#define SMFS_DELTALOG_H_
+
+#include "smfs/Segment.h"
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace smfs {
+
+/**
+ * An append-only backing file holding the data written to a merged file.
+ *
+ * Writes to merged files never modify their existing backing files. The data
+ * written is instead appended to a delta log, and the merged file's segments
+ * are pointed at the new bytes. Writes at random offsets hence become
+ * sequential appends, and backing files are only ever read.
+ *
+ * The log's backing file is created in its directory with a unique name on
+ * the first append, so that a log costs nothing until it is written to.
+ * Appends reserve their place in the log and then write concurrently.
+ */
+class DeltaLog {
+	std::string const dir;
+	mutable std::mutex mutex;
+	std::shared_ptr<BackingFile> file;
+	off_t end = 0;
+
+public:
+
+	/**
+	 * A function that writes data into the log itself, taking the log's
+	 * backing file and the offset to write at.
+	 */
+	using Fill = std::function<void(BackingFile const & log, off_t offset)>;
+
+	/**
+	 * Constructor for DeltaLog.
+	 * @param directory The directory to create the log's backing file in.
+	 */
+	explicit DeltaLog(std::string directory);
+
+	DeltaLog(DeltaLog const &other) = delete;
+	DeltaLog& operator=(DeltaLog const &other) = delete;
+
+	/**
+	 * @return The directory the log is kept in.
+	 */
+	std::string const & directory() const {
+		return dir;
+	}
+
+	/**
+	 * @return The backing file of the log, or `nullptr` if nothing has been
+	 *         appended to it yet.
+	 */
+	std::shared_ptr<BackingFile> backing() const;
+
+	/**
+	 * @return The number of bytes appended to the log.
+	 */
+	off_t size() const;
+
+	/**
+	 * Appends data to the log.
+	 * @param data The data to append.
+	 * @param nbytes The number of bytes to append.
+	 * @return The segment of the log holding the data.
+	 * @throws fusepp::fuse_error if the log could not be created or written.
+	 */
+	Segment append(void const * data, std::size_t nbytes);
+
+	/**
+	 * Appends data that the caller writes into the log, such as data spliced
+	 * from a pipe, which need never be copied into memory.
+	 * @param nbytes The number of bytes to append.
+	 * @param fill A function writing exactly `nbytes` bytes at the offset it
+	 *             is given, or throwing if it cannot.
+	 * @return The segment of the log holding the data.
+	 * @throws fusepp::fuse_error if the log could not be created, or anything
+	 *         `fill` throws.
+	 */
+	Segment append(std::size_t nbytes, Fill const & fill);
+
+	/**
+	 * Waits for everything appended to the log to be durable.
+	 * @throws fusepp::fuse_error if the log could not be synced.
+	 */
+	void sync() const;
+
+private:
+	/**
+	 * Reserves space at the end of the log, creating it if necessary.
+	 * @return The log's backing file, and the offset of the space.
+	 */
+	std::pair<std::shared_ptr<BackingFile>, off_t> reserve(std::size_t nbytes);
+};
+
+} // namespace smfs
+
+#endif /* SMFS_DELTALOG_H_ */
@@ -0,0 +1,144 @@
+/*
+ * DeviceLoad.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_DEVICELOAD_H_
+#define SMFS_DEVICELOAD_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+extern "C" {
+	#include <sys/types.h> // for dev_t
+}
+
+namespace smfs {
+
+/**
+ * A histogram of latencies, from which percentiles can be estimated to
+ * within a quarter of a power of two.
+ *
+ * Older samples are decayed, by halving every count once every
+ * @ref decayInterval samples, so that the histogram follows a device whose
+ * latency changes. Recording is lock-free, and concurrent records may race
+ * with a decay, which only makes the estimate slightly less exact.
+ */
+class LatencyHistogram {
+public:
+
+	/**
+	 * The number of samples after which counts are halved.
+	 */
+	static constexpr std::uint64_t decayInterval = 1024;
+
+	/**
+	 * Records a latency.
+	 */
+	void record(std::chrono::nanoseconds latency);
+
+	/**
+	 * @return The number of samples held, after decay.
+	 */
+	std::uint64_t samples() const;
+
+	/**
+	 * Estimates a percentile of the samples held.
+	 * @param fraction The fraction of samples that should be no slower, such
+	 *                 as 0.95 for the 95th percentile.
+	 * @return The upper bound of the bucket containing the percentile, or
+	 *         zero if there are no samples.
+	 */
+	std::chrono::nanoseconds percentile(double fraction) const;
+
+private:
+	/**
+	 * Four buckets for each power of two microseconds, up to about a day.
+	 */
+	static constexpr std::size_t bucketCount = 4 + 4 * 36;
+
+	std::atomic<std::uint64_t> counts[bucketCount] = {};
+	std::atomic<std::uint64_t> recorded{0};
+
+	static std::size_t bucket(std::uint64_t micros);
+	static std::uint64_t bucketLimit(std::size_t bucket);
+};
+
+/**
+ * The load on a backing device: the number of reads in flight to it, and
+ * how long reads of it have been taking.
+ *
+ * Loads are shared by every replica on the same device, as found by
+ * @ref of, so that reads of one file take account of reads of others.
+ */
+class DeviceLoad {
+	std::atomic<std::uint32_t> pending{0};
+	std::atomic<std::uint64_t> averageNanos{0};
+	LatencyHistogram histogram;
+
+public:
+
+	/**
+	 * @return The load on the device with the given number, shared by every
+	 *         caller asking after the same device.
+	 */
+	static std::shared_ptr<DeviceLoad> of(dev_t device);
+
+	/**
+	 * Records the start of a read.
+	 */
+	void started() {
+		pending.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	/**
+	 * Records the end of a read, whether or not it succeeded.
+	 * @param latency How long the read took.
+	 */
+	void finished(std::chrono::nanoseconds latency);
+
+	/**
+	 * @return The number of reads in flight.
+	 */
+	std::uint32_t queueDepth() const {
+		return pending.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * @return The recent average latency of reads, weighted towards the latest.
+	 */
+	std::chrono::nanoseconds averageLatency() const {
+		return std::chrono::nanoseconds(averageNanos.load(std::memory_order_relaxed));
+	}
+
+	/**
+	 * @return The histogram of recent latencies.
+	 */
+	LatencyHistogram const & latencies() const {
+		return histogram;
+	}
+
+	/**
+	 * @return How long a new read can be expected to wait, the lower the
+	 *         better: the average latency times the number of reads it would
+	 *         queue behind.
+	 */
+	double score() const {
+		return static_cast<double>(queueDepth() + 1) * (averageNanos.load(std::memory_order_relaxed) + 1);
+	}
+
+	/**
+	 * @return The load, as `key=value` pairs on one line.
+	 */
+	std::string toString() const;
+};
+
+} // namespace smfs
+
+#endif /* SMFS_DEVICELOAD_H_ */
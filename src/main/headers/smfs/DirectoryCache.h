@@ -0,0 +1,181 @@
+/*
+ * DirectoryCache.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_DIRECTORYCACHE_H_
+#define SMFS_DIRECTORYCACHE_H_
+
+#include "smfs/SingleFlight.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+extern "C" {
+	#include <sys/stat.h>
+}
+
+namespace smfs {
+
+/**
+ * An entry in a @ref Directory.
+ */
+struct DirectoryEntry {
+	std::string name;
+
+	/**
+	 * The attributes of the entry, as given by `lstat`.
+	 */
+	struct stat attributes;
+};
+
+/**
+ * The metadata of a single directory in the backing filesystem: the names
+ * and attributes of its entries, excluding "." and "..". Directories are
+ * immutable once loaded.
+ */
+class Directory {
+	std::vector<DirectoryEntry> const list;
+	std::size_t const bytes;
+
+public:
+
+	/**
+	 * Constructor for Directory.
+	 * @param entries The entries of the directory, in any order.
+	 */
+	explicit Directory(std::vector<DirectoryEntry> entries);
+
+	/**
+	 * Reads a directory, and the attributes of all of its entries.
+	 * @param path The path of the directory to read.
+	 * @return The directory.
+	 * @throws fusepp::fuse_error if the directory cannot be read.
+	 */
+	static std::shared_ptr<Directory const> load(std::string const & path);
+
+	/**
+	 * @return The entries of this directory, sorted by name.
+	 */
+	std::vector<DirectoryEntry> const & entries() const {
+		return list;
+	}
+
+	/**
+	 * Looks up an entry by name.
+	 * @param name The name of the entry.
+	 * @return The entry, or `nullptr` if there is none with the name.
+	 */
+	DirectoryEntry const * find(std::string const & name) const;
+
+	/**
+	 * @return An estimate of the number of bytes of memory used by this directory.
+	 */
+	std::size_t footprint() const {
+		return bytes;
+	}
+};
+
+/**
+ * A cache of @ref Directory metadata, loaded from the backing filesystem on
+ * first use and bounded by a byte budget.
+ *
+ * Nothing is read until a directory is asked for, so the cost of reaching a
+ * path depends only on the number of directories above it, not on the size
+ * of the tree. The least recently used directories are evicted once the
+ * budget is exceeded; directories still referenced by callers stay valid.
+ */
+class DirectoryCache {
+public:
+
+	/**
+	 * Counters describing how effective a cache has been.
+	 */
+	struct Stats {
+		std::uint64_t hits = 0;
+
+		/**
+		 * The number of directories read from the backing filesystem.
+		 */
+		std::uint64_t loads = 0;
+
+		/**
+		 * The number of misses served by joining a load of the same
+		 * directory already in progress for another caller.
+		 */
+		std::uint64_t coalesced = 0;
+
+		std::uint64_t evictions = 0;
+	};
+
+private:
+	using Lru = std::list<std::string>;
+
+	struct Cached {
+		std::shared_ptr<Directory const> directory;
+		Lru::iterator position;
+	};
+
+	std::size_t const byteBudget;
+	mutable std::mutex mutex;
+	std::unordered_map<std::string, Cached> cached;
+	Lru lru;
+	std::size_t used = 0;
+	std::uint64_t invalidations = 0;
+	Stats counters;
+	SingleFlight<std::string, std::shared_ptr<Directory const>> loads;
+
+public:
+
+	/**
+	 * Constructor for DirectoryCache.
+	 * @param budget The maximum number of bytes of directory metadata to keep
+	 *               cached. The most recently used directory is always kept,
+	 *               even if it alone exceeds the budget.
+	 */
+	explicit DirectoryCache(std::size_t budget);
+
+	DirectoryCache(DirectoryCache const &other) = delete;
+	DirectoryCache& operator=(DirectoryCache const &other) = delete;
+
+	/**
+	 * Gets a directory, loading it if it is not already cached. Concurrent
+	 * misses on the same directory share a single load.
+	 * @param path The path of the directory in the backing filesystem.
+	 * @return The directory.
+	 * @throws fusepp::fuse_error if the directory cannot be read.
+	 */
+	std::shared_ptr<Directory const> get(std::string const & path);
+
+	/**
+	 * Discards a cached directory, so that it is read again on next use.
+	 * @param path The path of the directory in the backing filesystem.
+	 */
+	void invalidate(std::string const & path);
+
+	/**
+	 * @return The number of bytes of directory metadata currently cached.
+	 */
+	std::size_t size() const;
+
+	/**
+	 * @return A snapshot of the counters for this cache.
+	 */
+	Stats stats() const;
+
+private:
+	void insert(std::string const & path, std::shared_ptr<Directory const> const & directory);
+	void evict();
+};
+
+} // namespace smfs
+
+#endif /* SMFS_DIRECTORYCACHE_H_ */
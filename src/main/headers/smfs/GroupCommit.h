@@ -0,0 +1,139 @@
+/*
+ * GroupCommit.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_GROUPCOMMIT_H_
+#define SMFS_GROUPCOMMIT_H_
+
+#include "smfs/BackingFile.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace smfs {
+
+class MergedFile;
+class ThreadPool;
+
+/**
+ * Makes the data written to backing files durable, along with the journalled
+ * edits of merged files that refer to it, merging the requests of concurrent
+ * callers into shared commit rounds.
+ *
+ * Only one round is committed at a time. Callers arriving while a round is
+ * being committed join the next, which one of them commits as soon as the
+ * current round finishes, on behalf of them all. A file requested by several
+ * callers in a round is synced once.
+ *
+ * A round syncs each of its files in parallel. Where a round holds at least
+ * a given number of files on the same filesystem, that filesystem is synced
+ * once with `syncfs` instead, which is cheaper than syncing each file when
+ * there are many.
+ *
+ * Once its files are synced, a round syncs the journal of each of its merged
+ * files (see @ref MergedFile::sync). Files sharing a journal share its sync,
+ * so a round costs one journal sync however many files it holds.
+ */
+class GroupCommit {
+public:
+
+	/**
+	 * The default number of files on one filesystem from which a round syncs
+	 * the filesystem rather than the files.
+	 */
+	static constexpr std::size_t defaultSyncfsThreshold = 32;
+
+	/**
+	 * Counters describing how well requests have been merged.
+	 */
+	struct Stats {
+		std::uint64_t requests = 0;
+		std::uint64_t rounds = 0;
+
+		/**
+		 * The number of files synced individually.
+		 */
+		std::uint64_t fileSyncs = 0;
+
+		/**
+		 * The number of filesystems synced as a whole.
+		 */
+		std::uint64_t filesystemSyncs = 0;
+
+		/**
+		 * The number of merged files whose journalled edits were synced.
+		 */
+		std::uint64_t journalSyncs = 0;
+
+		/**
+		 * @return A human-readable, single-line summary of these statistics.
+		 */
+		std::string toString() const;
+	};
+
+private:
+	/**
+	 * The files to sync in one round, and how it went.
+	 */
+	struct Round {
+		std::vector<std::shared_ptr<BackingFile>> files;
+		std::vector<std::shared_ptr<MergedFile const>> merged;
+		bool done = false;
+		std::exception_ptr error;
+	};
+
+	std::size_t const syncfsThreshold;
+	ThreadPool & pool;
+	mutable std::mutex mutex;
+	std::condition_variable finished;
+	std::shared_ptr<Round> next = std::make_shared<Round>();
+	bool committing = false;
+	Stats counters;
+
+public:
+
+	/**
+	 * Constructor for GroupCommit.
+	 * @param syncfsThreshold The number of files on one filesystem from which
+	 *                        a round syncs the filesystem rather than the files.
+	 * @param pool The pool to sync files on, or `nullptr` for the shared pool
+	 *             for I/O (see @ref ThreadPool::io).
+	 */
+	explicit GroupCommit(std::size_t syncfsThreshold = defaultSyncfsThreshold, ThreadPool * pool = nullptr);
+
+	GroupCommit(GroupCommit const &other) = delete;
+	GroupCommit& operator=(GroupCommit const &other) = delete;
+
+	/**
+	 * Waits for everything written to some files so far to be durable, and
+	 * then for the edits made to some merged files so far.
+	 * @param files The files to sync.
+	 * @param merged The merged files whose journalled edits to sync.
+	 * @throws fusepp::fuse_error if any file in the round could not be
+	 *         synced, since it cannot be told which of the round's callers
+	 *         the file mattered to.
+	 */
+	void sync(std::vector<std::shared_ptr<BackingFile>> const & files,
+			std::vector<std::shared_ptr<MergedFile const>> const & merged = {});
+
+	/**
+	 * @return A snapshot of the counters.
+	 */
+	Stats stats() const;
+
+private:
+	void commit(Round & round);
+};
+
+} // namespace smfs
+
+#endif /* SMFS_GROUPCOMMIT_H_ */
@@ -0,0 +1,163 @@
+/*
+ * Invalidator.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_INVALIDATOR_H_
+#define SMFS_INVALIDATOR_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+extern "C" {
+	#include <sys/types.h> // for off_t
+}
+
+namespace smfs {
+
+/**
+ * Tells a cache, such as the kernel's, of the changes made to the files it
+ * caches, so that it may keep what it holds for as long as it likes.
+ *
+ * Changes are reported as they are made, and passed on in order of first
+ * report by a background thread, never by the thread making the change.
+ * This matters for the kernel, which may be holding locks on a file while
+ * the change is made, and would wait forever for them to be released before
+ * dropping the file's pages. Changes reported to the same file before they
+ * are passed on are merged into one covering them all.
+ */
+class Invalidator {
+public:
+
+	/**
+	 * A change to pass on.
+	 */
+	struct Change {
+		/**
+		 * The path of the file or entry that changed.
+		 */
+		std::string path;
+
+		/**
+		 * Whether the entry at the path was added, rather than the data of
+		 * the file at the path changed.
+		 */
+		bool entry = false;
+
+		/**
+		 * The offset at which the file's data changed.
+		 */
+		off_t offset = 0;
+
+		/**
+		 * The number of bytes changed, or zero if all of the data from the
+		 * offset on may have changed.
+		 */
+		off_t length = 0;
+	};
+
+	/**
+	 * The function changes are passed on to.
+	 */
+	using Sink = std::function<void(Change const & change)>;
+
+	/**
+	 * Counters describing the changes passed on.
+	 */
+	struct Stats {
+		std::uint64_t changes = 0;
+
+		/**
+		 * The number of changes merged into another before being passed on.
+		 */
+		std::uint64_t merged = 0;
+
+		std::uint64_t notifications = 0;
+
+		/**
+		 * The number of changes to files and entries the cache did not hold.
+		 */
+		std::uint64_t uncached = 0;
+
+		std::uint64_t errors = 0;
+
+		/**
+		 * @return A human-readable, single-line summary of these statistics.
+		 */
+		std::string toString() const;
+	};
+
+private:
+	Sink const sink;
+	mutable std::mutex mutex;
+	mutable std::condition_variable wake;
+	bool stopping = false;
+	std::vector<Change> pending;
+	std::map<std::pair<bool, std::string>, std::size_t> pendingIndex;
+	bool passingOn = false;
+	Stats counters;
+	std::thread worker;
+
+public:
+
+	/**
+	 * Constructor for Invalidator.
+	 * @param sink The function to pass changes on to. It throws
+	 *             `fusepp::fuse_error` with ENOENT if the file, or the entry's
+	 *             directory, no longer exists.
+	 */
+	explicit Invalidator(Sink sink);
+
+	/**
+	 * Stops passing on changes. Any not yet passed on are dropped.
+	 */
+	~Invalidator();
+
+	Invalidator(Invalidator const &other) = delete;
+	Invalidator& operator=(Invalidator const &other) = delete;
+
+	/**
+	 * Reports a change to a file's data.
+	 * @param path The path of the file.
+	 * @param offset The offset at which the data changed.
+	 * @param length The number of bytes changed, or zero if all of the data
+	 *               from the offset on may have changed.
+	 */
+	void changed(std::string const & path, off_t offset, off_t length);
+
+	/**
+	 * Reports an entry that has been added, which the cache may hold as
+	 * missing.
+	 * @param path The path of the entry.
+	 */
+	void added(std::string const & path);
+
+	/**
+	 * Waits for every change reported so far to have been passed on.
+	 * @return The statistics then.
+	 */
+	Stats wait() const;
+
+	/**
+	 * @return A snapshot of the counters.
+	 */
+	Stats stats() const;
+
+private:
+	void report(Change change);
+	void run();
+};
+
+} // namespace smfs
+
+#endif /* SMFS_INVALIDATOR_H_ */
@@ -0,0 +1,171 @@
+/*
+ * Journal.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_JOURNAL_H_
+#define SMFS_JOURNAL_H_
+
+#include "smfs/BackingFile.h"
+#include "smfs/Segment.h"
+#include "smfs/SegmentTree.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace smfs {
+
+/**
+ * A mutation of the set of merged files, as recorded in a @ref Journal.
+ */
+struct JournalRecord {
+	enum Kind : unsigned char {
+		/**
+		 * Creates a merged file at `path` from `segments`.
+		 */
+		create = 1,
+
+		/**
+		 * Replaces `length` bytes at `offset` of the merged file at `path`
+		 * with `segments`.
+		 */
+		splice = 2,
+	};
+
+	Kind kind;
+
+	/**
+	 * The position of this mutation in the order in which mutations were
+	 * made. Sequence numbers increase across journals.
+	 */
+	std::uint64_t sequence;
+
+	std::string path;
+	off_t offset;
+	std::size_t length;
+	std::vector<Segment> segments;
+};
+
+/**
+ * An append-only log of mutations to merged files.
+ *
+ * Records are buffered as they are appended, and made durable by @ref sync.
+ * Concurrent syncs are committed together: one caller writes and
+ * `fdatasync`s everything appended so far while the others wait for it, so
+ * the cost of each `fdatasync` is shared by every mutation made while the
+ * previous one was in progress.
+ *
+ * A record may depend on data written elsewhere, such as to a delta log, in
+ * which case that file is synced before the record is written out, so that
+ * the journal never refers to data that could be lost.
+ *
+ * Each record is framed with its length and a checksum, so that a record torn
+ * by a crash is detected, and discarded, on replay.
+ */
+class Journal {
+	mutable std::mutex mutex;
+	std::condition_variable committed;
+	int fd;
+	std::uint64_t lastSequence;
+	std::uint64_t durableSequence;
+	std::uint64_t bytes = 0;
+	bool flushing = false;
+	std::exception_ptr failure;
+	std::string pending;
+	std::vector<std::shared_ptr<BackingFile>> pendingData;
+	std::unordered_map<std::string, std::uint64_t> backingIds;
+
+public:
+
+	/**
+	 * Creates a new, empty journal file.
+	 * @param path The path of the journal file to create.
+	 * @param lastSequence The sequence number of the last mutation made, so
+	 *                     that the next record appended is given the next.
+	 * @throws fusepp::fuse_error if the file cannot be created.
+	 */
+	Journal(std::string const & path, std::uint64_t lastSequence);
+
+	~Journal();
+
+	Journal(Journal const &other) = delete;
+	Journal& operator=(Journal const &other) = delete;
+
+	/**
+	 * Appends a record to the journal, without waiting for it to be durable.
+	 * Records are ordered by the order of calls to this method.
+	 *
+	 * @param kind The kind of mutation.
+	 * @param path The path of the merged file mutated.
+	 * @param offset The offset at which a splice begins.
+	 * @param length The number of bytes replaced by a splice.
+	 * @param segments The segments of a created file, or those spliced in.
+	 * @param data A file holding data the segments refer to that may not be
+	 *             durable yet, to sync before the record is written out, or
+	 *             `nullptr` if there is none.
+	 * @return The sequence number of the record.
+	 * @throws fusepp::fuse_error with EIO if the journal has failed.
+	 */
+	std::uint64_t append(JournalRecord::Kind kind, std::string const & path,
+			off_t offset, std::size_t length, SegmentTree const & segments,
+			std::shared_ptr<BackingFile> data = nullptr);
+
+	/**
+	 * Waits for a record, and every record before it, to be durable.
+	 * @param sequence The sequence number of the record.
+	 * @throws fusepp::fuse_error if the journal could not be written. A journal
+	 *         that has failed to write fails all later calls.
+	 */
+	void sync(std::uint64_t sequence);
+
+	/**
+	 * Closes the current journal file, after writing out any buffered records,
+	 * and continues in a new one. Each journal file is self-contained.
+	 * @param path The path of the new journal file.
+	 * @throws fusepp::fuse_error if the file cannot be created.
+	 */
+	void rotate(std::string const & path);
+
+	/**
+	 * @return The sequence number of the last record appended.
+	 */
+	std::uint64_t sequence() const;
+
+	/**
+	 * @return The number of bytes appended to the current journal file.
+	 */
+	std::uint64_t size() const;
+
+	/**
+	 * Reads the records from a journal file, in order. A torn or corrupt
+	 * record, and anything after it, is assumed to have been lost in a crash
+	 * and is truncated from the file.
+	 *
+	 * @param path The path of the journal file.
+	 * @param open A function taking the path of a backing file and returning
+	 *             the opened `std::shared_ptr<BackingFile>`.
+	 * @param fn A function taking each `JournalRecord const &`.
+	 * @return The number of bytes of valid records in the file.
+	 * @throws fusepp::fuse_error if the file cannot be read.
+	 */
+	static std::uint64_t replay(std::string const & path,
+			std::function<std::shared_ptr<BackingFile>(std::string const &)> const & open,
+			std::function<void(JournalRecord const &)> const & fn);
+
+private:
+	void frame(std::string const & payload);
+	void flush(std::unique_lock<std::mutex> &lock);
+};
+
+} // namespace smfs
+
+#endif /* SMFS_JOURNAL_H_ */
@@ -0,0 +1,56 @@
+/*
+ * Lz4.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_LZ4_H_
+#define SMFS_LZ4_H_
+
+#include <cstddef>
+
+namespace smfs {
+namespace lz4 {
+
+/*
+ * A compressor and decompressor for the LZ4 block format, which is fast to
+ * decompress and compresses text such as logs well. Output is compatible
+ * with other LZ4 implementations, though the compressor is a simple greedy
+ * one.
+ */
+
+/**
+ * @return The most space compressing the given number of bytes can take.
+ */
+constexpr std::size_t bound(std::size_t length) {
+	return length + length / 255 + 16;
+}
+
+/**
+ * Compresses a block of data.
+ * @param src The data to compress.
+ * @param length The number of bytes of data.
+ * @param dst The memory to write the compressed data to.
+ * @param capacity The number of bytes available at `dst`.
+ * @return The number of bytes of compressed data, or zero if it would not
+ *         fit in `capacity` bytes.
+ */
+std::size_t compress(void const * src, std::size_t length, void * dst, std::size_t capacity);
+
+/**
+ * Decompresses a block of data.
+ * @param src The compressed data.
+ * @param length The number of bytes of compressed data.
+ * @param dst The memory to write the decompressed data to.
+ * @param capacity The number of bytes available at `dst`.
+ * @return The number of bytes of decompressed data.
+ * @throws fusepp::fuse_error with EIO if the data is malformed, or would
+ *         decompress to more than `capacity` bytes.
+ */
+std::size_t decompress(void const * src, std::size_t length, void * dst, std::size_t capacity);
+
+} // namespace lz4
+} // namespace smfs
+
+#endif /* SMFS_LZ4_H_ */
@@ -0,0 +1,246 @@
+/*
+ * Manifest.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_MANIFEST_H_
+#define SMFS_MANIFEST_H_
+
+#include "smfs/BackingFile.h"
+#include "smfs/Segment.h"
+#include "smfs/details/Manifest.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace smfs {
+
+class MergedFile;
+class MerkleTree;
+
+/**
+ * A persisted description of a set of merged files, memory-mapped from disk.
+ *
+ * Manifests are used in place: opening one only validates its tables, and
+ * segments are decoded as they are looked up, starting from the nearest of
+ * a sparse set of checkpoints. Backing files are opened as they are first
+ * used. Opening a manifest hence takes time independent of the number of
+ * segments it describes.
+ *
+ * @see details::ManifestHeader for the file format.
+ */
+class Manifest {
+	void * mapping;
+	std::size_t length;
+	details::ManifestHeader const * header;
+	details::ManifestBacking const * backingTable;
+	details::ManifestFile const * fileTable;
+	details::ManifestCheckpoint const * checkpoints;
+	unsigned char const * records;
+	std::uint32_t const * checksumTable;
+	unsigned char const * digestTable;
+
+	mutable std::unique_ptr<std::once_flag[]> opened;
+	mutable std::vector<std::shared_ptr<BackingFile>> backingFiles;
+
+	Manifest(void * mapping, std::size_t length);
+
+public:
+
+	/**
+	 * Maps and validates the manifest at the given path.
+	 * @param path The path of the manifest file.
+	 * @return The opened manifest.
+	 * @throws fusepp::fuse_error if the file cannot be read, or with EINVAL if
+	 *         it is not a manifest of a supported version.
+	 */
+	static std::shared_ptr<Manifest const> open(std::string const & path);
+
+	~Manifest();
+
+	Manifest(Manifest const &other) = delete;
+	Manifest& operator=(Manifest const &other) = delete;
+
+	/**
+	 * @return The number of merged files described by this manifest.
+	 */
+	std::size_t fileCount() const {
+		return header->fileCount;
+	}
+
+	/**
+	 * @return The path of a merged file, relative to the mount point.
+	 */
+	std::string_view path(std::size_t file) const {
+		return string(fileTable[file].path);
+	}
+
+	/**
+	 * @return The size, in bytes, of a merged file.
+	 */
+	off_t size(std::size_t file) const {
+		return fileTable[file].size;
+	}
+
+	/**
+	 * @return The number of segments making up a merged file.
+	 */
+	std::size_t segmentCount(std::size_t file) const {
+		return fileTable[file].segmentCount;
+	}
+
+	/**
+	 * @return The journal sequence number of the last edit reflected in a
+	 *         merged file, or for files added as ranges, the number they
+	 *         were added with.
+	 */
+	std::uint64_t sequence(std::size_t file) const {
+		return fileTable[file].sequence;
+	}
+
+	/**
+	 * @return The Merkle tree recorded for a merged file, or `nullptr` if
+	 *         there is none.
+	 */
+	std::shared_ptr<MerkleTree const> merkleTree(std::size_t file) const;
+
+	/**
+	 * Gets a backing file referenced by this manifest, opening it if this is
+	 * the first time it has been used. If the manifest records checksums for
+	 * the file, they are attached to it.
+	 * @param index The index of the backing file.
+	 * @throws fusepp::fuse_error if the file cannot be opened.
+	 */
+	std::shared_ptr<BackingFile> const & backing(std::size_t index) const;
+
+	/**
+	 * Invokes the given function for each segment of a merged file that
+	 * overlaps a range of bytes, in order.
+	 * @see SegmentTree::forEachExtent
+	 * @throws fusepp::fuse_error with EIO if the segment records are malformed.
+	 */
+	template<typename F>
+	void forEachExtent(std::size_t file, off_t offset, std::size_t nbytes, F&& fn) const {
+		details::ManifestFile const & entry = fileTable[file];
+		off_t end = std::min<off_t>(entry.size, offset + nbytes);
+		if(offset >= end) {
+			return;
+		}
+		details::ManifestCheckpoint const * first = checkpoints + entry.firstCheckpoint;
+		details::ManifestCheckpoint const * cp = std::upper_bound(first, first + entry.checkpointCount, offset,
+				[](off_t offset, details::ManifestCheckpoint const & cp) { return offset < static_cast<off_t>(cp.start); }) - 1;
+
+		std::size_t index = (cp - first) * details::manifestCheckpointStride;
+		details::RecordDecoder decoder(records + cp->record, records + header->recordsSize);
+		for(off_t start = cp->start; index < entry.segmentCount && start < end; ++index) {
+			if(index % details::manifestCheckpointStride == 0) {
+				decoder.reset();
+			}
+			details::SegmentRecord record = decoder.next();
+			off_t segmentEnd = start + record.length;
+			if(segmentEnd > offset) {
+				if(record.backing >= header->backingCount) {
+					throw fusepp::fuse_error(EIO);
+				}
+				off_t from = std::max(offset, start);
+				Segment segment{backing(record.backing), record.offset, record.length};
+				fn(segment, from - start, static_cast<std::size_t>(std::min(end, segmentEnd) - from));
+			}
+			start = segmentEnd;
+		}
+	}
+
+	/**
+	 * Decodes all of the segments of a merged file.
+	 */
+	std::vector<Segment> segments(std::size_t file) const;
+
+	/**
+	 * Decodes the boundaries between the segments of a merged file, without
+	 * opening their backing files.
+	 * @return The offset within the merged file of the end of each segment.
+	 * @throws fusepp::fuse_error with EIO if the segment records are malformed.
+	 */
+	std::vector<off_t> boundaries(std::size_t file) const;
+
+private:
+	std::string_view string(details::ManifestString const & s) const {
+		return std::string_view(reinterpret_cast<char const *>(mapping) + header->stringsOffset + s.offset, s.length);
+	}
+};
+
+/**
+ * Builds a @ref Manifest from a set of merged files.
+ */
+class ManifestWriter {
+	std::string strings;
+	std::vector<details::ManifestBacking> backingTable;
+	std::unordered_map<std::string, std::uint64_t> backingIndex;
+	std::vector<details::ManifestFile> fileTable;
+	std::vector<details::ManifestCheckpoint> checkpoints;
+	std::string records;
+	std::vector<std::uint32_t> checksums;
+	std::string digests;
+
+public:
+
+	/**
+	 * Adds a merged file to the manifest, encoding a snapshot of its contents
+	 * along with the sequence number of the last journalled edit it reflects.
+	 * The checksums of its backing files, if they have any, are recorded too,
+	 * as is its Merkle tree if it has been built for the snapshot.
+	 * @param path The path of the file, relative to the mount point.
+	 * @param file The file to add.
+	 */
+	void add(std::string const & path, MergedFile const & file);
+
+	/**
+	 * Adds a file made up of consecutive ranges of a single backing file,
+	 * starting at its beginning. Each range is kept as a separate segment,
+	 * even though they are contiguous, so that the boundaries between them
+	 * are recorded.
+	 * @param path The path of the file.
+	 * @param backingPath The path of the backing file.
+	 * @param ends The offset of the end of each range, in increasing order.
+	 * @param sequence The number to record as the file's sequence number,
+	 *                 such as a version of the backing file the ranges were
+	 *                 found in.
+	 */
+	void addRanges(std::string const & path, std::string const & backingPath, std::vector<off_t> const & ends,
+			std::uint64_t sequence = 0);
+
+	/**
+	 * Checksums every backing file referenced so far that has no checksums
+	 * recorded, reading each in full.
+	 * @param blockSize The size of each checksummed block.
+	 * @throws fusepp::fuse_error if a backing file cannot be read.
+	 */
+	void computeChecksums(std::size_t blockSize = BlockChecksums::defaultBlockSize);
+
+	/**
+	 * Writes the manifest to disk. The file is written in full and synced
+	 * before being renamed into place, so that the manifest at the path is
+	 * always complete.
+	 * @param path The path to write the manifest to.
+	 * @throws fusepp::fuse_error if the file cannot be written.
+	 */
+	void write(std::string const & path) const;
+
+private:
+	details::ManifestString intern(std::string const & s);
+	std::uint64_t backing(std::string const & path, BlockChecksums const * sums = nullptr);
+	void recordChecksums(details::ManifestBacking &entry, BlockChecksums const & sums);
+	void addRecord(details::ManifestFile &entry, details::RecordEncoder &encoder, details::SegmentRecord const & record);
+};
+
+} // namespace smfs
+
+#endif /* SMFS_MANIFEST_H_ */
@@ -0,0 +1,127 @@
+/*
+ * ManifestStore.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_MANIFESTSTORE_H_
+#define SMFS_MANIFESTSTORE_H_
+
+#include "smfs/BlockCache.h"
+#include "smfs/Journal.h"
+#include "smfs/MergedFile.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace smfs {
+
+/**
+ * Persists a set of merged files in a directory, as a base @ref Manifest
+ * and a @ref Journal of the edits made since it was written.
+ *
+ * The directory holds `manifest` and one or more `journal.<generation>`
+ * files. Compaction moves the journal on to a new generation, writes a new
+ * base manifest from snapshots of the files, then deletes the old journals.
+ * Each file's entry in the manifest records the sequence number of the last
+ * edit it reflects, so that edits made while the manifest was being written
+ * are neither lost nor applied twice when the journals are replayed.
+ */
+class ManifestStore {
+public:
+	using Files = std::vector<std::pair<std::string, std::shared_ptr<MergedFile>>>;
+
+private:
+	std::string const directory;
+	std::uint64_t const compactThreshold;
+	std::shared_ptr<Journal> journal;
+	std::uint64_t generation = 0;
+	std::atomic<std::uint64_t> replayedBytes{0};
+	std::mutex compactLock;
+
+	std::mutex compactorLock;
+	std::condition_variable wake;
+	bool stopping = false;
+	std::thread compactor;
+
+public:
+
+	/**
+	 * Constructor for ManifestStore. @ref recover must be called before the
+	 * store is used.
+	 * @param directory The directory to store the manifest and journals in.
+	 * @param compactThreshold The size, in bytes, that the journals may grow
+	 *                         to before the background compactor writes a new
+	 *                         base manifest.
+	 */
+	explicit ManifestStore(std::string directory, std::uint64_t compactThreshold = 64 << 20);
+
+	/**
+	 * Stops the background compactor, if it was started.
+	 */
+	~ManifestStore();
+
+	ManifestStore(ManifestStore const &other) = delete;
+	ManifestStore& operator=(ManifestStore const &other) = delete;
+
+	/**
+	 * Loads the base manifest and replays the journals over it, then starts a
+	 * new journal. Torn records at the end of a journal are discarded.
+	 * @param cache The block cache for the loaded files to read through.
+	 * @return The files, attached to the new journal.
+	 * @throws fusepp::fuse_error if the store cannot be read, or with EIO if
+	 *         the journal is inconsistent with the manifest.
+	 */
+	Files recover(std::shared_ptr<BlockCache> cache = nullptr);
+
+	/**
+	 * Creates a new merged file and journals its creation. The creation is
+	 * not durable until @ref MergedFile::sync is called on the file.
+	 * @param path The path of the file.
+	 * @param segments The segments making up the file.
+	 * @param cache The block cache for the file to read through.
+	 * @return The new file, attached to the journal.
+	 */
+	std::shared_ptr<MergedFile> create(std::string const & path, std::vector<Segment> segments,
+			std::shared_ptr<BlockCache> cache = nullptr);
+
+	/**
+	 * Writes a new base manifest and deletes the journals it supersedes.
+	 * Edits may continue while this is in progress.
+	 * @param files All of the files in the store.
+	 * @throws fusepp::fuse_error if the manifest cannot be written, in which
+	 *         case the old journals are kept.
+	 */
+	void compact(Files const & files);
+
+	/**
+	 * Starts a background thread that compacts the store whenever the
+	 * journals grow beyond the threshold.
+	 * @param files A function returning all of the files in the store.
+	 */
+	void startCompactor(std::function<Files()> files);
+
+	/**
+	 * @return The number of bytes in the journals since the last compaction.
+	 */
+	std::uint64_t journalSize() const;
+
+private:
+	std::string manifestPath() const;
+	std::string journalPath(std::uint64_t generation) const;
+	std::vector<std::uint64_t> journalGenerations() const;
+	void syncDirectory() const;
+};
+
+} // namespace smfs
+
+#endif /* SMFS_MANIFESTSTORE_H_ */
@@ -0,0 +1,502 @@
+/*
+ * MergedFile.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_MERGEDFILE_H_
+#define SMFS_MERGEDFILE_H_
+
+#include "smfs/BlockCache.h"
+#include "smfs/DedupStore.h"
+#include "smfs/DeltaLog.h"
+#include "smfs/Journal.h"
+#include "smfs/Manifest.h"
+#include "smfs/SegmentTree.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace smfs {
+
+class MerkleTree;
+
+/**
+ * A file whose contents are the concatenation of a list of @ref Segment "segments".
+ *
+ * The segment tree may be edited to change the file's contents without
+ * moving any data. Edits replace the tree as a whole, so readers always see
+ * either the old or the new contents, never a mixture. Since the tree is
+ * persistent, each edit costs O(log N) in the number of segments.
+ *
+ * A file loaded from a @ref Manifest reads its segments from the manifest in
+ * place until it is first edited, when they are decoded into a tree.
+ *
+ * A file attached to a @ref Journal records each edit in the journal, and
+ * waits for the edit to be durable before returning. If the journal fails,
+ * the edits it could not make durable are rolled back, and the file refuses
+ * any further edits. Writes are the exception: as with any filesystem, they
+ * are only durable once @ref sync is called, and if that fails they are
+ * left in place, though the file still refuses any further edits.
+ *
+ * The file's @ref MerkleTree is built on demand, either by the caller or in
+ * the background, and kept until the file is next edited.
+ *
+ * A listener may be told of each edit that changes the file's contents other
+ * than by writing to it, so that caches of the contents may be kept up to date.
+ *
+ * A file whose segments were interned in a @ref DedupStore holds the
+ * references taken until it is first edited.
+ */
+class MergedFile {
+	mutable std::shared_ptr<SegmentTree const> layout;
+	mutable std::mutex editLock;
+	std::shared_ptr<BlockCache> const blockCache;
+	std::shared_ptr<Manifest const> const manifest;
+	std::size_t const manifestIndex = 0;
+	std::shared_ptr<Journal> journal;
+	std::string journalPath;
+	std::uint64_t journalSequence = 0;
+	std::uint64_t version = 0;
+	std::uint64_t abandonedFrom = UINT64_MAX;
+	std::function<void(off_t offset, off_t length)> listener;
+	std::optional<DedupStore::References> interned;
+	mutable std::shared_ptr<MerkleTree const> merkle;
+	mutable std::uint64_t merkleVersion = 0;
+	mutable std::uint64_t merkleRequested = UINT64_MAX;
+	mutable int merkleError = 0;
+	mutable std::mutex merkleLock;
+
+public:
+
+	/**
+	 * The number of bytes a read must cover to be spread across several
+	 * backing files in parallel.
+	 */
+	static constexpr std::size_t parallelReadSize = 128 * 1024;
+
+	/**
+	 * A consistent view of a file's contents, along with the sequence number
+	 * of the last journalled edit they reflect.
+	 */
+	struct Snapshot {
+		/**
+		 * The file's segments, or `nullptr` if they are still read from the manifest.
+		 */
+		std::shared_ptr<SegmentTree const> tree;
+		std::shared_ptr<Manifest const> manifest;
+		std::size_t index;
+		std::uint64_t sequence;
+
+		/**
+		 * The number of edits made to the file before the snapshot was taken.
+		 */
+		std::uint64_t version;
+
+		/**
+		 * The hash tree of the snapshot, or `nullptr` if it has not been built.
+		 */
+		std::shared_ptr<MerkleTree const> merkle;
+
+		off_t size() const {
+			return tree ? tree->size() : manifest->size(index);
+		}
+
+		template<typename F>
+		void forEachExtent(off_t offset, std::size_t nbytes, F&& fn) const {
+			if(tree) {
+				tree->forEachExtent(offset, nbytes, std::forward<F>(fn));
+			} else {
+				manifest->forEachExtent(index, offset, nbytes, std::forward<F>(fn));
+			}
+		}
+	};
+
+	/**
+	 * Constructor for MergedFile.
+	 * @param segments The segments making up the file, in order.
+	 * @param cache The block cache through which backing data should be read,
+	 *              or `nullptr` to read directly from the backing files.
+	 */
+	MergedFile(std::vector<Segment> segments, std::shared_ptr<BlockCache> cache = nullptr);
+
+	/**
+	 * Constructs a merged file described by a manifest.
+	 * @param manifest The manifest describing the file.
+	 * @param index The index of the file within the manifest.
+	 * @param cache The block cache through which backing data should be read,
+	 *              or `nullptr` to read directly from the backing files.
+	 */
+	MergedFile(std::shared_ptr<Manifest const> manifest, std::size_t index, std::shared_ptr<BlockCache> cache = nullptr);
+
+	/**
+	 * @return The current segment tree of this file. If the file is still
+	 *         being read from a manifest, the tree is built first.
+	 */
+	std::shared_ptr<SegmentTree const> segments() const {
+		std::shared_ptr<SegmentTree const> tree = std::atomic_load(&layout);
+		if(tree) {
+			return tree;
+		}
+		std::lock_guard<std::mutex> lock(editLock);
+		return loaded();
+	}
+
+	/**
+	 * @return The size, in bytes, of this file.
+	 */
+	off_t size() const {
+		std::shared_ptr<SegmentTree const> tree = std::atomic_load(&layout);
+		return tree ? tree->size() : manifest->size(manifestIndex);
+	}
+
+	/**
+	 * @return The block cache used by this file, or `nullptr` if it has none.
+	 */
+	std::shared_ptr<BlockCache> const & cache() const {
+		return blockCache;
+	}
+
+	/**
+	 * Reads a range of this file into memory, through its block cache if it
+	 * has one.
+	 *
+	 * If the range is at least @ref parallelReadSize bytes and spread across
+	 * several backing files, as a range of a striped file is, the extents in
+	 * each backing file are read on the @ref ThreadPool::io pool at once, so
+	 * that each backing device is kept busy.
+	 *
+	 * @param buf The memory to read the data into.
+	 * @param nbytes The number of bytes to read.
+	 * @param offset The offset within this file to read from.
+	 * @return The number of bytes read, which is only less than `nbytes` at
+	 *         the end of the file.
+	 * @throws fusepp::fuse_error if an error occurs, or with EIO if a backing
+	 *         file is shorter than its segments.
+	 */
+	std::size_t read(void * buf, std::size_t nbytes, off_t offset) const;
+
+	/**
+	 * @return Whether a read of the given range would be spread across
+	 *         several backing files, and read from them in parallel.
+	 * @see read
+	 */
+	bool readsInParallel(off_t offset, std::size_t nbytes) const;
+
+	/**
+	 * Invokes the given function for each segment overlapping a range of this
+	 * file, in order, as it is at the time of the call.
+	 * @see SegmentTree::forEachExtent
+	 */
+	template<typename F>
+	void forEachExtent(off_t offset, std::size_t nbytes, F&& fn) const {
+		std::shared_ptr<SegmentTree const> tree = std::atomic_load(&layout);
+		if(tree) {
+			tree->forEachExtent(offset, nbytes, std::forward<F>(fn));
+		} else {
+			manifest->forEachExtent(manifestIndex, offset, nbytes, std::forward<F>(fn));
+		}
+	}
+
+	/**
+	 * @return A consistent view of this file's contents.
+	 */
+	Snapshot snapshot() const;
+
+	/**
+	 * Gets the hash tree of this file's current contents, building it if it
+	 * has not been built since the file was last edited.
+	 * @throws fusepp::fuse_error if the file cannot be read.
+	 */
+	std::shared_ptr<MerkleTree const> merkleTree() const;
+
+	/**
+	 * Gets the hash tree of a file's current contents if it has been built,
+	 * and otherwise starts building it on the @ref ThreadPool::shared pool,
+	 * for callers such as FUSE requests that should not wait for the whole
+	 * file to be read.
+	 * @param file The file.
+	 * @return The tree, or `nullptr` while it is being built.
+	 * @throws fusepp::fuse_error if the last build failed, in which case the
+	 *         next call starts another.
+	 */
+	static std::shared_ptr<MerkleTree const> merkleTreeInBackground(std::shared_ptr<MergedFile const> file);
+
+	/**
+	 * Starts recording edits to this file in a journal. This must be done
+	 * before the file is shared between threads.
+	 * @param journal The journal to record edits in.
+	 * @param path The path the file is recorded under.
+	 * @param sequence The sequence number of the last journalled edit that
+	 *                 the file's current contents reflect.
+	 */
+	void attach(std::shared_ptr<Journal> journal, std::string path, std::uint64_t sequence);
+
+	/**
+	 * Sets the function told of each edit that changes this file's contents
+	 * other than by writing to it, once the edit has been made. This must be
+	 * done before the file is shared between threads.
+	 * @param listener The function, taking the offset at which the contents
+	 *                 changed and the number of bytes changed, or zero if all
+	 *                 of the contents from the offset on may have moved.
+	 */
+	void listen(std::function<void(off_t offset, off_t length)> listener);
+
+	/**
+	 * Holds the references taken by interning this file's segments, until
+	 * the file is first edited or destroyed. This must be done before the
+	 * file is shared between threads.
+	 * @param references The references.
+	 */
+	void hold(DedupStore::References references);
+
+	/**
+	 * Waits for the last edit made to this file, and the data of any write
+	 * before it, to be durable in its journal. Does nothing if this file is
+	 * not attached to a journal, in which case the caller must sync the
+	 * delta logs written to itself.
+	 * @throws fusepp::fuse_error if the journal could not be written.
+	 */
+	void sync() const;
+
+	/**
+	 * Replaces a range of this file's contents with the given segments.
+	 * @param offset The offset at which the range to replace begins. Must not
+	 *               be beyond the end of this file.
+	 * @param nbytes The number of bytes to replace. Any part of the range
+	 *               beyond the end of the file is ignored.
+	 * @param replacement The segments to put in place of the range.
+	 * @throws fusepp::fuse_error with EINVAL if `offset` is beyond the end
+	 *         of the file.
+	 */
+	void splice(off_t offset, std::size_t nbytes, SegmentTree const & replacement);
+
+	/**
+	 * Writes data to this file, without modifying any of its backing files.
+	 * The data is appended to a delta log, and the range written is replaced
+	 * by the segment of the log holding it. Writes that follow on from one
+	 * another in both the file and the log join into a single segment.
+	 *
+	 * Neither the data nor the edit is durable until @ref sync is called.
+	 * If this file is attached to a journal, the log is synced before the
+	 * edit is written to the journal, so that the journal never refers to
+	 * data that could be lost.
+	 *
+	 * @param log The log to append the data to.
+	 * @param data The data to write.
+	 * @param nbytes The number of bytes to write.
+	 * @param offset The offset within this file to write to. Must not be
+	 *               beyond the end of this file.
+	 * @return The number of bytes written.
+	 * @throws fusepp::fuse_error if the log could not be written, or with
+	 *         EINVAL if `offset` is beyond the end of the file, since merged
+	 *         files cannot contain holes.
+	 */
+	std::size_t write(DeltaLog & log, void const * data, std::size_t nbytes, off_t offset);
+
+	/**
+	 * Writes data to this file as @ref write does, but has the caller write
+	 * the data into the log itself (see @ref DeltaLog::append).
+	 * @param log The log to append the data to.
+	 * @param nbytes The number of bytes to write.
+	 * @param offset The offset within this file to write to. Must not be
+	 *               beyond the end of this file.
+	 * @param fill The function to write the data into the log with.
+	 * @return The number of bytes written.
+	 * @throws fusepp::fuse_error if the log could not be written, or with
+	 *         EINVAL if `offset` is beyond the end of the file.
+	 */
+	std::size_t write(DeltaLog & log, std::size_t nbytes, off_t offset, DeltaLog::Fill const & fill);
+
+	/**
+	 * Replaces a range of this file's segments with others holding the same
+	 * data, provided the range has not been edited since it was read, as when
+	 * compacting the range into fewer segments.
+	 * @param offset The offset at which the range begins.
+	 * @param expected The segments the range is expected to consist of, as
+	 *                 returned by `segments()->range(offset, length)`.
+	 * @param replacement The segments to put in place of the range, which must
+	 *                    be the same length.
+	 * @return Whether the range was replaced, which it is not if it no longer
+	 *         consists of the expected segments.
+	 * @throws fusepp::fuse_error if the journal could not be written, or with
+	 *         EINVAL if the replacement is not the same length.
+	 */
+	bool replaceIfUnchanged(off_t offset, SegmentTree const & expected, SegmentTree const & replacement);
+
+	/**
+	 * @return Whether edits to this file are recorded in a journal.
+	 */
+	bool journalled() const {
+		return journal != nullptr;
+	}
+
+	/**
+	 * Copies a range of another merged file's contents into this file, by
+	 * referencing the other file's segments. No data is moved. The copied
+	 * range overwrites the existing contents, extending the file if needed.
+	 *
+	 * @param source The file to copy from. May be this file.
+	 * @param sourceOffset The offset within the source file to copy from.
+	 * @param offset The offset within this file to copy to. Must not be
+	 *               beyond the end of this file.
+	 * @param nbytes The number of bytes to copy.
+	 * @return The number of bytes copied, which is less than `nbytes` if the
+	 *         range extends beyond the end of the source file.
+	 * @throws fusepp::fuse_error with EINVAL if `offset` is beyond the end of
+	 *         this file, since merged files cannot contain holes.
+	 */
+	std::size_t copyFrom(MergedFile const & source, off_t sourceOffset, off_t offset, std::size_t nbytes);
+
+	/**
+	 * Appends the whole of another merged file's contents to the end of this
+	 * file, by referencing the other file's segments. No data is moved.
+	 * @param source The file to append. May be this file.
+	 * @return The number of bytes appended.
+	 */
+	std::size_t append(MergedFile const & source);
+
+	/**
+	 * Removes a range of bytes from this file, closing up the gap, by editing
+	 * the segment tree. No data is moved.
+	 * @param offset The offset at which the range to remove begins.
+	 * @param nbytes The number of bytes to remove. Any part of the range
+	 *               beyond the end of the file is ignored.
+	 * @throws fusepp::fuse_error with EINVAL if `offset` is beyond the end
+	 *         of the file.
+	 */
+	void cut(off_t offset, std::size_t nbytes);
+
+	/**
+	 * Shortens this file by discarding any segments beyond the given length.
+	 * @param length The new length of the file.
+	 * @throws fusepp::fuse_error with EINVAL if the file would need to be
+	 *         extended, since merged files cannot contain holes.
+	 */
+	void truncate(off_t length);
+
+private:
+
+	/**
+	 * Gets the segment tree of this file, building it from the manifest if
+	 * necessary. Must be called with `editLock` held.
+	 */
+	std::shared_ptr<SegmentTree const> loaded() const;
+
+	/**
+	 * Gets the segments describing a range of this file, without building the
+	 * whole segment tree if the file is still being read from a manifest.
+	 */
+	SegmentTree range(off_t offset, std::size_t nbytes) const;
+
+	/**
+	 * Points a range of this file at data just appended to a delta log.
+	 */
+	std::size_t placeWritten(Segment const & written, off_t offset);
+
+	/**
+	 * A replacement of a range of a file's segments.
+	 */
+	struct Splice {
+		off_t offset;
+		std::size_t length;
+		SegmentTree segments;
+	};
+
+	/**
+	 * Replaces this file's segment tree with an edited copy, serialised
+	 * against other edits, and journals the edit if the file is attached to a
+	 * journal. The edit is visible to readers as soon as it is journalled, but
+	 * this only returns once it is durable. If it cannot be made durable, it
+	 * is rolled back, along with any edit made since, before this throws.
+	 * @param fn A function taking the current `SegmentTree const &` and
+	 *           returning the @ref Splice to make, or an empty
+	 *           `std::optional<Splice>` to make none.
+	 * @param notify Whether to tell the listener of the edit.
+	 * @param written The delta log holding data just written that the edit
+	 *                refers to, if any. Such an edit is left to be made
+	 *                durable, along with the log, by the next @ref sync.
+	 * @return Whether an edit was made.
+	 * @throws fusepp::fuse_error if the journal could not be written, or with
+	 *         EIO if it has failed before.
+	 */
+	template<typename F>
+	bool edit(F&& fn, bool notify = true, std::shared_ptr<BackingFile> written = nullptr) {
+		// Writes are left for the next sync to make durable
+		bool wait = journal && !written;
+		std::uint64_t sequence;
+		std::uint64_t editVersion;
+		std::shared_ptr<SegmentTree const> previous;
+		// Released once unlocked, as this file no longer has the interned contents
+		std::optional<DedupStore::References> released;
+		off_t changedOffset;
+		off_t changedLength;
+		{
+			std::lock_guard<std::mutex> lock(editLock);
+			if(abandonedFrom != UINT64_MAX) {
+				throw fusepp::fuse_error(EIO);
+			}
+			std::shared_ptr<SegmentTree const> current = loaded();
+			std::optional<Splice> splice = fn(*current);
+			if(!splice) {
+				return false;
+			}
+			std::shared_ptr<SegmentTree const> edited = std::make_shared<SegmentTree>(
+					current->splice(splice->offset, splice->length, splice->segments));
+			if(journal) {
+				journalSequence = journal->append(JournalRecord::splice, journalPath,
+						splice->offset, splice->length, splice->segments, std::move(written));
+			}
+			sequence = journalSequence;
+			editVersion = ++version;
+			previous = std::move(current);
+			if(interned) {
+				released.emplace(std::move(*interned));
+				interned.reset();
+			}
+			std::atomic_store(&layout, std::move(edited));
+			changedOffset = splice->offset;
+			// A replacement of a different length moves everything after it
+			changedLength = splice->segments.size() == static_cast<off_t>(splice->length)
+					? static_cast<off_t>(splice->length) : 0;
+		}
+		// Readers already see the edit, durable or not
+		if(notify && listener) {
+			listener(changedOffset, changedLength);
+		}
+		if(wait) {
+			try {
+				journal->sync(sequence);
+			} catch(fusepp::fuse_error const &) {
+				abandon(editVersion, std::move(previous), changedOffset, changedLength, notify);
+				throw;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * Rolls back an edit that could not be made durable, and any made since,
+	 * and refuses any further edits.
+	 * @param editVersion The version the edit made.
+	 * @param previous The segment tree from before the edit.
+	 * @param offset The offset of the range the edit changed.
+	 * @param length The length of the range, or zero if everything from the
+	 *               offset on changed.
+	 * @param notify Whether to tell the listener of the rollback.
+	 */
+	void abandon(std::uint64_t editVersion, std::shared_ptr<SegmentTree const> previous,
+			off_t offset, off_t length, bool notify);
+};
+
+} // namespace smfs
+
+#endif /* SMFS_MERGEDFILE_H_ */
@@ -0,0 +1,243 @@
+/*
+ * MergedNode.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_MERGEDNODE_H_
+#define SMFS_MERGEDNODE_H_
+
+#include "fuse.hpp"
+#include "smfs/MergedFile.h"
+#include "smfs/WriteCoalescer.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace smfs {
+
+class Mount;
+
+/**
+ * The name of the extended attribute through which a merged file's block
+ * cache statistics are reported.
+ */
+constexpr char const * cacheStatsXattr = "user.smfs.cache_stats";
+
+/**
+ * The name of the extended attribute through which the mount's deduplication
+ * statistics are reported.
+ */
+constexpr char const * dedupStatsXattr = "user.smfs.dedup_stats";
+
+/**
+ * The name of the extended attribute through which the progress of the
+ * mount's latest scrub is reported.
+ */
+constexpr char const * scrubStatsXattr = "user.smfs.scrub_stats";
+
+/**
+ * The name of the extended attribute through which the progress of the
+ * mount's latest segment compaction is reported.
+ */
+constexpr char const * compactionStatsXattr = "user.smfs.compaction_stats";
+
+/**
+ * The name of the extended attribute through which the mount's write
+ * coalescing statistics are reported.
+ */
+constexpr char const * writeStatsXattr = "user.smfs.write_stats";
+
+/**
+ * The name of the extended attribute through which the mount's group commit
+ * statistics are reported.
+ */
+constexpr char const * syncStatsXattr = "user.smfs.sync_stats";
+
+/**
+ * The name of the extended attribute through which the progress of the
+ * mount's latest prewarm of the kernel's page cache is reported.
+ */
+constexpr char const * prewarmStatsXattr = "user.smfs.prewarm_stats";
+
+/**
+ * The name of the extended attribute through which the statistics of the
+ * mount's notifications to the kernel of changes are reported.
+ */
+constexpr char const * invalidationStatsXattr = "user.smfs.invalidation_stats";
+
+/**
+ * The name of the extended attribute through which the fragmentation of a
+ * merged file's segments is reported.
+ */
+constexpr char const * fragmentationXattr = "user.smfs.fragmentation";
+
+/**
+ * The name of the extended attribute through which a merged file's Merkle
+ * tree is summarised, as its leaf size, number of leaves and root. The tree
+ * is built in the background, and reading this or a proof fails with EAGAIN
+ * until it has been.
+ */
+constexpr char const * merkleXattr = "user.smfs.merkle";
+
+/**
+ * The prefix of the names of the extended attributes through which the
+ * proof of each leaf of a merged file's Merkle tree is reported. The prefix
+ * is followed by the index of the leaf in decimal, and the value is the
+ * hash of each sibling along the leaf's path, from the bottom up, in
+ * hexadecimal on a line of its own.
+ */
+constexpr char const * merkleProofXattrPrefix = "user.smfs.merkle_proof.";
+
+/**
+ * An open handle to a @ref MergedFile.
+ *
+ * If the mount coalesces writes, small writes made through the handle are
+ * buffered in a @ref WriteCoalescer of its own, which is flushed before the
+ * handle reads, edits or reports the attributes of the file, and when it is
+ * flushed, synced or closed. Until then, the @ref MergedNode of the file
+ * reports its size without the buffered data.
+ */
+class MergedFileHandle : public fusepp::FileHandle1 {
+	std::shared_ptr<MergedFile> const file;
+	Mount & mount;
+	int const openFlags;
+	std::mutex logLock;
+	std::shared_ptr<DeltaLog> log;
+	std::atomic<bool> dirty{false};
+	WriteCoalescer coalescer;
+
+public:
+
+	/**
+	 * Constructor for MergedFileHandle.
+	 * @param file The file to open.
+	 * @param mount The mount containing the file.
+	 * @param flags The flags the file was opened with.
+	 */
+	MergedFileHandle(std::shared_ptr<MergedFile> file, Mount & mount, int flags);
+
+	/**
+	 * Appends any writes still buffered to the file's delta log. Errors
+	 * doing so cannot be reported, so are ignored; they are reported by
+	 * @ref flush, which the kernel calls on every close before this.
+	 */
+	~MergedFileHandle() noexcept;
+
+	/**
+	 * @return The file this is a handle to.
+	 */
+	std::shared_ptr<MergedFile> const & merged() const {
+		return file;
+	}
+
+	void getattr(struct stat& statbuf) override;
+
+	/**
+	 * Reads data from the merged file. Without a block cache, ranges of
+	 * backing files that have a raw descriptor are referred to by descriptor,
+	 * so libfuse can splice them without copying. The returned buffer shares
+	 * cached blocks, but libfuse frees every memory region of a reply, so
+	 * those (and anything else read into memory) are copied once more as the
+	 * reply is handed to it.
+	 */
+	std::shared_ptr<fusepp::Buffer> read(size_t nbytes, off_t offset) override;
+
+	/**
+	 * Writes data to the merged file by appending it to the file's delta log
+	 * (see @ref MergedFile::write), so no backing file is modified. The data
+	 * may be buffered, if the handle coalesces writes. Writes too large to
+	 * buffer that fuse passes on in a pipe are spliced into the log, without
+	 * being copied into memory. Writes are only durable once synced, unless
+	 * the handle was opened with `O_SYNC` or `O_DSYNC`, when each is synced
+	 * before returning.
+	 */
+	size_t write(fusepp::Buffer& buffer, off_t offset) override;
+
+	/**
+	 * Appends any buffered writes to the file's delta log.
+	 */
+	void flush() override;
+
+	/**
+	 * Appends any buffered writes to the file's delta log, and waits for
+	 * everything written through this handle to be durable. Nothing is synced
+	 * if nothing has been written since the last sync. Otherwise the log is
+	 * synced, and then the file's journal if it has one, in a round shared
+	 * with any concurrent syncs on the mount (see @ref GroupCommit).
+	 *
+	 * A sync of data alone does the same, since the journalled edits are
+	 * needed to find the data, as a file's size is for `fdatasync`.
+	 */
+	void fsync(bool datasync) override;
+
+	void truncate(off_t newLength) override;
+
+	/**
+	 * Copies data into another merged file by splicing segments into its
+	 * segment list, so no data is moved. Copies to any other kind of file
+	 * fail with `EXDEV`.
+	 */
+	size_t copyFileRange(off_t offsetIn, fusepp::FileHandle1& out, off_t offsetOut, size_t nbytes, int flags) override;
+
+	/**
+	 * Supports only `FALLOC_FL_COLLAPSE_RANGE`, which removes the range from
+	 * the file's segment list. As on local filesystems, the range must be
+	 * aligned to the file's 4 KiB block size, and end before the end of the
+	 * file, or this fails with EINVAL.
+	 */
+	void fallocate(int mode, off_t offset, off_t length) override;
+
+	/**
+	 * Performs one of the segment list edits defined in smfs/ioctl.h.
+	 */
+	void ioctl(int cmd, void * arg, unsigned int flags, void * data) override;
+
+	/**
+	 * @return Whether the mount has kernel caching on, the kernel being told
+	 *         of any change made to the file other than through it.
+	 */
+	bool keepCache() const override;
+
+private:
+	void checkWritable() const;
+
+	/**
+	 * @return The delta log this handle writes to.
+	 * @throws fusepp::fuse_error with EROFS if the mount has none.
+	 */
+	std::shared_ptr<DeltaLog> deltaLog();
+};
+
+/**
+ * A node presenting a @ref MergedFile as a regular file.
+ *
+ * Once the mount has a directory for delta logs, merged files may be written
+ * to, truncated, and have ranges of other merged files copied into them.
+ * Until then they are presented read-only, and fail opens for writing with
+ * EROFS.
+ */
+class MergedNode : public fusepp::Node1 {
+	std::shared_ptr<MergedFile> const file;
+	Mount & mount;
+
+public:
+
+	MergedNode(fusepp::path_t rel_path, std::shared_ptr<MergedFile> file, Mount & mount);
+
+	double getattr(struct stat& statbuf) override;
+
+	std::unique_ptr<fusepp::FileHandle1> open(int flags) override;
+
+	void truncate(off_t newLength) override;
+
+	size_t xattrSize(std::string const name) override;
+
+	size_t getxattr(std::string const name, fusepp::DataBuffer& buffer) override;
+};
+
+} // namespace smfs
+
+#endif /* SMFS_MERGEDNODE_H_ */
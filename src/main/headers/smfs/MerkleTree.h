@@ -0,0 +1,175 @@
+/*
+ * MerkleTree.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_MERKLETREE_H_
+#define SMFS_MERKLETREE_H_
+
+#include "smfs/MergedFile.h"
+#include "smfs/Sha256.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace smfs {
+
+/**
+ * A hash tree over the contents of a merged file, divided into fixed-size
+ * leaves.
+ *
+ * Each leaf is hashed with SHA-256, and each pair of nodes is hashed
+ * together to form the level above, up to a single root. A node without a
+ * pair is carried up to the next level unchanged. Leaves and interior nodes
+ * are hashed with different prefixes, so that one cannot be passed off as
+ * the other.
+ *
+ * A reader can hence verify any leaf against the root with one hash per
+ * level of the tree, given the siblings along its path (see @ref proof), and
+ * two trees can be compared by descending only into the subtrees whose
+ * hashes differ (see @ref diff).
+ *
+ * The nodes are held level by level, leaves first, in a single array, which
+ * is also how they are stored in a manifest.
+ */
+class MerkleTree {
+	std::size_t leafLength;
+	off_t length;
+	std::vector<Digest> nodes;
+	std::vector<std::size_t> levelStarts;
+
+public:
+
+	/**
+	 * The default number of bytes of file in each leaf.
+	 */
+	static constexpr std::size_t defaultLeafSize = 64 * 1024;
+
+	/**
+	 * Constructs a tree from its nodes.
+	 * @param leafSize The number of bytes of file in each leaf.
+	 * @param size The size of the file.
+	 * @param nodes Every node of the tree, level by level from the leaves up,
+	 *              as returned by @ref all.
+	 * @throws fusepp::fuse_error with EINVAL if the number of nodes is wrong
+	 *         for the size of file.
+	 */
+	MerkleTree(std::size_t leafSize, off_t size, std::vector<Digest> nodes);
+
+	/**
+	 * Builds the tree of a snapshot of a merged file, hashing leaves on
+	 * several threads at once.
+	 * @param snapshot The contents to build the tree of.
+	 * @param leafSize The number of bytes of file in each leaf.
+	 * @param threads The number of threads to hash with, or zero to use one
+	 *                for each processor.
+	 * @throws fusepp::fuse_error if the file cannot be read.
+	 */
+	static MerkleTree build(MergedFile::Snapshot const & snapshot, std::size_t leafSize = defaultLeafSize,
+			unsigned threads = 0);
+
+	/**
+	 * @return The number of leaves in the tree of a file. There is always at
+	 *         least one, so that an empty file has a root.
+	 */
+	static std::size_t leafCount(off_t size, std::size_t leafSize) {
+		return size ? (size + leafSize - 1) / leafSize : 1;
+	}
+
+	/**
+	 * @return The total number of nodes in a tree of the given number of leaves.
+	 */
+	static std::size_t nodeCount(std::size_t leaves);
+
+	/**
+	 * @return The hash of a leaf with the given contents.
+	 */
+	static Digest hashLeaf(void const * data, std::size_t length);
+
+	/**
+	 * @return The hash of an interior node with the given children.
+	 */
+	static Digest hashNodes(Digest const & left, Digest const & right);
+
+	/**
+	 * Checks that a leaf belongs to a tree, given the siblings along its path.
+	 * @param root The root of the tree.
+	 * @param leaves The number of leaves in the tree.
+	 * @param leaf The index of the leaf.
+	 * @param digest The hash of the leaf, as given by @ref hashLeaf.
+	 * @param proof The siblings along the path, as given by @ref proof.
+	 * @return Whether the leaf belongs to the tree.
+	 */
+	static bool verify(Digest const & root, std::size_t leaves, std::size_t leaf, Digest const & digest,
+			std::vector<Digest> const & proof);
+
+	std::size_t leafSize() const {
+		return leafLength;
+	}
+
+	off_t size() const {
+		return length;
+	}
+
+	std::size_t leafCount() const {
+		return levelStarts.size() > 1 ? levelStarts[1] : 1;
+	}
+
+	Digest const & root() const {
+		return nodes.back();
+	}
+
+	Digest const & leaf(std::size_t index) const {
+		return nodes[index];
+	}
+
+	/**
+	 * @return Every node of the tree, level by level from the leaves up.
+	 */
+	std::vector<Digest> const & all() const {
+		return nodes;
+	}
+
+	/**
+	 * Gets the siblings along the path from a leaf to the root, from the
+	 * bottom up. Levels at which the path's node has no pair contribute none.
+	 * @param leaf The index of the leaf.
+	 */
+	std::vector<Digest> proof(std::size_t leaf) const;
+
+	/**
+	 * Finds the ranges of file in which this tree's file differs from
+	 * another's, without visiting subtrees that are the same in both.
+	 * @param other The tree to compare with, which must have the same leaf size.
+	 * @return The offset and length of each range that differs, in order and
+	 *         with adjacent ranges joined.
+	 * @throws fusepp::fuse_error with EINVAL if the leaf sizes differ.
+	 */
+	std::vector<std::pair<off_t, off_t>> diff(MerkleTree const & other) const;
+
+private:
+	MerkleTree(std::size_t leafSize, off_t size);
+
+	std::size_t levels() const {
+		return levelStarts.size();
+	}
+
+	std::size_t width(std::size_t level) const {
+		return (level + 1 < levelStarts.size() ? levelStarts[level + 1] : nodes.size()) - levelStarts[level];
+	}
+
+	Digest const * node(std::size_t level, std::size_t index) const {
+		return level < levels() && index < width(level) ? &nodes[levelStarts[level] + index] : nullptr;
+	}
+
+	void layOut(std::size_t leaves);
+	void hashUpper();
+};
+
+} // namespace smfs
+
+#endif /* SMFS_MERKLETREE_H_ */
@@ -0,0 +1,383 @@
+/*
+ * Mount.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_MOUNT_H_
+#define SMFS_MOUNT_H_
+
+#include "fuse.hpp"
+#include "smfs/BlockCache.h"
+#include "smfs/DedupStore.h"
+#include "smfs/GroupCommit.h"
+#include "smfs/Invalidator.h"
+#include "smfs/Manifest.h"
+#include "smfs/ManifestStore.h"
+#include "smfs/MergedFile.h"
+#include "smfs/Prewarmer.h"
+#include "smfs/Scrubber.h"
+#include "smfs/SegmentCompactor.h"
+#include "smfs/SingleFlight.h"
+#include "smfs/SplitView.h"
+#include "smfs/WriteCoalescer.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace smfs {
+
+/**
+ * The root of an smfs filesystem, presenting a set of merged files at
+ * paths within the mount. Directories are implied by the paths of the files
+ * they contain.
+ *
+ * If given a @ref ManifestStore, the mount loads its files from the store and
+ * journals every change to them there.
+ *
+ * Split views may also be mounted at paths within the mount, presenting
+ * backing directory hierarchies whose metadata is loaded on demand.
+ *
+ * If given a @ref DedupStore, the mount interns the segments of each merged
+ * file added to it, so that files sharing contents share cached blocks. Each
+ * file holds its references in the store until it is first changed.
+ *
+ * If given a directory for delta logs, merged files may be written to. Each
+ * file written to gets a @ref DeltaLog of its own in the directory. Small
+ * writes made through a handle may be coalesced before they reach the log
+ * (see @ref setWriteCoalescing).
+ *
+ * Designated hot files may be streamed into the kernel's page cache once the
+ * filesystem is mounted, or whenever asked (see @ref prewarm), so that the
+ * first reads of them are served from memory.
+ *
+ * Once mounted, the kernel is told of each change to a merged file made
+ * other than through the kernel, such as an ioctl edit, and of each file
+ * added, so that it may cache merged files and their metadata for long
+ * periods (see @ref setKernelCaching).
+ *
+ * The kernel is asked to send reads and writes in large requests, and to
+ * splice written data out to the filesystem where it can (see @ref init).
+ */
+class Mount : public fusepp::Mount1 {
+	std::shared_ptr<BlockCache> const blockCache;
+	SingleFlight<fusepp::path_t, std::shared_ptr<fusepp::Node1>> nodeFlights;
+	mutable std::mutex mutex;
+	std::map<fusepp::path_t, std::shared_ptr<MergedFile>> files;
+	std::map<fusepp::path_t, std::shared_ptr<SplitView const>> splits;
+	std::shared_ptr<DedupStore> dedup;
+	std::string deltaDir;
+	std::map<MergedFile const *, std::shared_ptr<DeltaLog>> deltaLogs;
+	std::size_t coalescingThreshold = 0;
+	std::shared_ptr<WriteCoalescer::Counters> const coalescingCounters = std::make_shared<WriteCoalescer::Counters>();
+	GroupCommit commits;
+	std::vector<fusepp::path_t> hotFiles;
+	std::uint64_t hotBytesPerSecond = 0;
+	double cacheTimeout = 0;
+	// Declared last, so that its compactor stops before the files are destroyed
+	std::unique_ptr<ManifestStore> const store;
+	// Declared after everything they read through, so that they stop first
+	std::shared_ptr<Scrubber> latestScrub;
+	std::shared_ptr<SegmentCompactor> latestCompaction;
+	std::shared_ptr<Prewarmer> latestPrewarm;
+	Invalidator invalidations{[this](Invalidator::Change const & change) { invalidate(change); }};
+
+public:
+
+	/**
+	 * Constructor for Mount.
+	 * @param cache The block cache to read merged files through, or `nullptr`
+	 *              to read directly from backing files.
+	 */
+	explicit Mount(std::shared_ptr<BlockCache> cache = nullptr);
+
+	/**
+	 * Constructs a mount whose files are persisted in a store. The store is
+	 * recovered, and its background compactor started.
+	 * @param cache The block cache to read merged files through, or `nullptr`
+	 *              to read directly from backing files.
+	 * @param store The store to load files from and journal changes to.
+	 * @throws fusepp::fuse_error if the store cannot be recovered.
+	 */
+	Mount(std::shared_ptr<BlockCache> cache, std::unique_ptr<ManifestStore> store);
+
+	/**
+	 * Sets the store through which the segments of merged files added to this
+	 * mount afterwards are deduplicated.
+	 * @param dedup The store, or `nullptr` to stop deduplicating.
+	 */
+	void setDedupStore(std::shared_ptr<DedupStore> dedup);
+
+	/**
+	 * @return The store through which segments are deduplicated, or `nullptr`
+	 *         if there is none.
+	 */
+	std::shared_ptr<DedupStore> dedupStore() const;
+
+	/**
+	 * Sets the directory in which delta logs of the data written to merged
+	 * files are kept. Until this is set, merged files are presented read-only,
+	 * and cannot be opened for writing or truncated.
+	 * @param directory The directory, or an empty string to stop writes.
+	 */
+	void setDeltaDirectory(std::string directory);
+
+	/**
+	 * @return Whether merged files may be written to, which they may once
+	 *         there is a directory for delta logs.
+	 */
+	bool writable() const;
+
+	/**
+	 * Gets the delta log that data written to a merged file is appended to,
+	 * creating it if need be.
+	 * @param file The merged file.
+	 * @return The file's log.
+	 * @throws fusepp::fuse_error with EROFS if there is no directory for
+	 *         delta logs.
+	 */
+	std::shared_ptr<DeltaLog> deltaLog(MergedFile const & file);
+
+	/**
+	 * Sets how many bytes of small sequential writes each handle opened
+	 * afterwards buffers before appending them to its file's delta log as
+	 * one. Buffered data is appended when the handle is flushed, synced or
+	 * closed, and before it reads or is `fstat`ed, but is not seen by other
+	 * handles until then, nor in the size `stat` reports for the file's path.
+	 * Handles opened with `O_DIRECT`, `O_SYNC` or `O_DSYNC` never buffer
+	 * writes.
+	 * @param threshold The number of bytes, or zero to stop buffering writes.
+	 */
+	void setWriteCoalescing(std::size_t threshold);
+
+	/**
+	 * @return The number of bytes of writes each handle buffers, or zero if
+	 *         writes are not buffered.
+	 */
+	std::size_t writeCoalescing() const;
+
+	/**
+	 * @return The counters in which the writes made through every handle
+	 *         opened on this mount are recorded.
+	 */
+	std::shared_ptr<WriteCoalescer::Counters> const & writeCounters() const {
+		return coalescingCounters;
+	}
+
+	/**
+	 * @return The group commit through which handles on this mount make
+	 *         their writes durable.
+	 */
+	GroupCommit & groupCommit() {
+		return commits;
+	}
+
+	/**
+	 * Adds a merged file to this mount.
+	 * @param path The path of the file, relative to the mount point and
+	 *             beginning with '/'.
+	 * @param segments The segments making up the file.
+	 * @return The newly-added file.
+	 * @throws fusepp::fuse_error with EEXIST if there is already a file at the
+	 *         path, or another error if the segments cannot be read to
+	 *         deduplicate them.
+	 */
+	std::shared_ptr<MergedFile> addMergedFile(fusepp::path_t const & path, std::vector<Segment> segments);
+
+	/**
+	 * Adds the merged files described by a manifest to this mount. The files
+	 * read their segments from the manifest in place, unless this mount has a
+	 * store, in which case they are copied into it, or a deduplication store,
+	 * in which case they are interned.
+	 * @param manifest The manifest to add files from.
+	 * @throws fusepp::fuse_error with EEXIST if a file in the manifest has the
+	 *         same path as one already in this mount. Files before it in the
+	 *         manifest will have been added.
+	 */
+	void addManifest(std::shared_ptr<Manifest const> const & manifest);
+
+	/**
+	 * Mounts a split view at a path within this mount. Nothing is read from
+	 * the view's backing hierarchy until a path within it is accessed.
+	 * @param path The path to present the root of the view at, relative to
+	 *             the mount point and beginning with '/'.
+	 * @param view The view to mount.
+	 * @throws fusepp::fuse_error with EEXIST if there is already a file or
+	 *         split view at the path.
+	 */
+	void addSplitView(fusepp::path_t const & path, std::shared_ptr<SplitView const> view);
+
+	/**
+	 * Writes a manifest describing all of the merged files in this mount.
+	 * @param path The path to write the manifest to.
+	 * @throws fusepp::fuse_error if the manifest cannot be written.
+	 */
+	void saveManifest(std::string const & path) const;
+
+	/**
+	 * Starts verifying the backing files of every merged file in this mount
+	 * against their checksums, in the background. Any scrub already in
+	 * progress is stopped.
+	 * @param bytesPerSecond The maximum rate to read at, or zero for no limit.
+	 */
+	void scrub(std::uint64_t bytesPerSecond);
+
+	/**
+	 * @return The latest scrub started, or `nullptr` if there has been none.
+	 */
+	std::shared_ptr<Scrubber const> scrubber() const;
+
+	/**
+	 * Starts rewriting the fragmented ranges of every merged file in this
+	 * mount into their delta logs, and reclaiming the space of the logs that
+	 * no file refers to any longer, in the background. Any compaction
+	 * already in progress is stopped.
+	 * @param bytesPerSecond The maximum rate to rewrite at, or zero for no limit.
+	 * @param policy Which ranges to rewrite, and how often to repeat the pass.
+	 *               Files added to this mount later are compacted by later
+	 *               passes.
+	 * @throws fusepp::fuse_error with EROFS if there is no directory for delta logs.
+	 */
+	void compactSegments(std::uint64_t bytesPerSecond, CompactionPolicy policy = CompactionPolicy());
+
+	/**
+	 * @return The latest compaction started, or `nullptr` if there has been none.
+	 */
+	std::shared_ptr<SegmentCompactor const> segmentCompactor() const;
+
+	/**
+	 * Sets how long the kernel may cache the filesystem's metadata, and
+	 * whether it keeps its cache of a merged file's data when the file is
+	 * opened. This must be set before the filesystem is mounted.
+	 *
+	 * The kernel is told of every change to merged files, but not of changes
+	 * to the backing hierarchies of split views, which it may not see until
+	 * the timeout has passed.
+	 * @param timeout The number of seconds the kernel may cache metadata for,
+	 *                or zero to leave the timeouts and caching to the command
+	 *                line.
+	 */
+	void setKernelCaching(double timeout);
+
+	/**
+	 * @return The number of seconds the kernel may cache metadata for, or
+	 *         zero if this is left to the command line.
+	 */
+	double kernelCaching() const;
+
+	/**
+	 * @return The kernel cache timeouts set by @ref setKernelCaching, if any.
+	 */
+	std::string options() const override;
+
+	/**
+	 * @return The invalidator through which the kernel is told of changes.
+	 */
+	Invalidator const & invalidator() const {
+		return invalidations;
+	}
+
+	/**
+	 * Sets the merged files to stream into the kernel's page cache as soon
+	 * as the filesystem is mounted.
+	 * @param paths The paths of the files, relative to the mount point, in
+	 *              the order to warm them.
+	 * @param bytesPerSecond The maximum rate to stream at, or zero for no limit.
+	 */
+	void setHotFiles(std::vector<fusepp::path_t> paths, std::uint64_t bytesPerSecond);
+
+	/**
+	 * Starts streaming the hot files into the kernel's page cache, as
+	 * @ref prewarm does.
+	 * @throws fusepp::fuse_error with ENOTCONN if the filesystem is not mounted.
+	 */
+	void prewarmHotFiles();
+
+	/**
+	 * Starts streaming merged files into the kernel's page cache, in the
+	 * background. Each file is first looked up through the mount point, so
+	 * that the kernel has a cache for it. Paths at which there is no merged
+	 * file are ignored. Any prewarm already in progress is stopped.
+	 *
+	 * The kernel drops a file's cache when the file is opened, unless kernel
+	 * caching is on (see @ref setKernelCaching).
+	 * @param paths The paths of the files, relative to the mount point, in
+	 *              the order to warm them.
+	 * @param bytesPerSecond The maximum rate to stream at, or zero for no limit.
+	 * @throws fusepp::fuse_error with ENOTCONN if the filesystem is not mounted.
+	 */
+	void prewarm(std::vector<fusepp::path_t> const & paths, std::uint64_t bytesPerSecond);
+
+	/**
+	 * @return The latest prewarm started, or `nullptr` if there has been none.
+	 */
+	std::shared_ptr<Prewarmer const> prewarmer() const;
+
+	/**
+	 * Gets the merged file at the given path.
+	 * @param path The path of the file, relative to the mount point.
+	 * @return The file, or `nullptr` if there is no merged file at the path.
+	 */
+	std::shared_ptr<MergedFile> mergedFile(fusepp::path_t const & path) const;
+
+	/**
+	 * Lists a directory implied by the paths of the merged files and split
+	 * views beneath it.
+	 * @param path The path of the directory, relative to the mount point.
+	 * @return The name of each merged file, split view root or implied
+	 *         directory directly within the directory, mapped to its file
+	 *         type (`S_IFREG` or `S_IFDIR`).
+	 */
+	std::map<std::string, mode_t> impliedEntries(fusepp::path_t const & path) const;
+
+	/**
+	 * Gets the node at the given path. Concurrent calls for the same path
+	 * share one node, so that their queries of it are combined.
+	 */
+	std::shared_ptr<fusepp::Node1> get_node(fusepp::path_t rel_path) override;
+
+	/**
+	 * Asks for reads to be sent concurrently, writes of more than a page at
+	 * once, and written data spliced out of the kernel.
+	 */
+	void init(fusepp::Connection & connection) override;
+
+	/**
+	 * Starts warming the hot files, if there are any.
+	 */
+	void mounted() override;
+
+private:
+	bool isDirectory(fusepp::path_t const & path) const;
+	std::shared_ptr<fusepp::Node1> makeNode(fusepp::path_t const & rel_path);
+
+	/**
+	 * Has the kernel told of edits made to a merged file.
+	 */
+	void track(fusepp::path_t const & path, MergedFile & file);
+
+	/**
+	 * @return The path of the entry the kernel may hold as missing, which
+	 *         must be dropped once a file at the given path is added.
+	 */
+	fusepp::path_t firstNewEntry(fusepp::path_t const & path) const;
+
+	/**
+	 * Passes a change on to the kernel.
+	 */
+	void invalidate(Invalidator::Change const & change);
+
+	/**
+	 * Passes a range of a merged file to the kernel's page cache.
+	 */
+	void storeInKernel(Prewarmer::Target const & target, off_t offset, std::size_t length);
+	std::shared_ptr<SplitView const> splitView(fusepp::path_t const & path, std::string &inView) const;
+};
+
+} // namespace smfs
+
+#endif /* SMFS_MOUNT_H_ */
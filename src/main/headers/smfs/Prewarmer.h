@@ -0,0 +1,128 @@
+/*
+ * Prewarmer.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_PREWARMER_H_
+#define SMFS_PREWARMER_H_
+
+#include "smfs/MergedFile.h"
+#include "smfs/ThrottledTask.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace smfs {
+
+/**
+ * Streams the contents of a set of merged files into a cache, such as the
+ * kernel's page cache, on a background thread, so that the first reads of
+ * them are served from memory. Each file is passed to the cache in chunks,
+ * from start to end, no faster than a given rate so as not to starve
+ * foreground I/O.
+ *
+ * A file the cache refuses with ENOENT, as the kernel does a file removed
+ * since the prewarm started, is skipped. A file the cache refuses any other way is counted
+ * as an error and given up on, and the next file started.
+ */
+class Prewarmer {
+public:
+
+	/**
+	 * The default number of bytes passed to the cache at once.
+	 */
+	static constexpr std::size_t defaultChunkSize = 128 * 1024;
+
+	/**
+	 * A file to warm, and the name the cache knows it by.
+	 */
+	using Target = std::pair<std::string, std::shared_ptr<MergedFile>>;
+
+	/**
+	 * The function that passes a range of a file to the cache, taking the
+	 * file, the offset of the range and its length.
+	 */
+	using Store = std::function<void(Target const & target, off_t offset, std::size_t length)>;
+
+	/**
+	 * Counters describing the progress of a prewarm.
+	 */
+	struct Stats : TaskState {
+		/**
+		 * The number of files passed to the cache in full.
+		 */
+		std::uint64_t files = 0;
+		std::uint64_t bytes = 0;
+
+		/**
+		 * The number of files the cache had no place for.
+		 */
+		std::uint64_t skipped = 0;
+
+		/**
+		 * The number of files that could not be read or stored.
+		 */
+		std::uint64_t errors = 0;
+
+		/**
+		 * @return A human-readable, single-line summary of these statistics.
+		 */
+		std::string toString() const;
+	};
+
+private:
+	using Task = ThrottledTask<Stats>;
+
+	std::vector<Target> const targets;
+	Store const store;
+	std::size_t const chunkSize;
+	// Declared last, so that it starts after, and stops before, the rest
+	Task task;
+
+public:
+
+	/**
+	 * Starts warming some files.
+	 * @param targets The files to warm, in the order to warm them.
+	 * @param store The function to pass each chunk of a file to.
+	 * @param bytesPerSecond The maximum rate at which to pass data on, or
+	 *                       zero to pass it on as fast as possible.
+	 * @param chunkSize The number of bytes to pass on at once.
+	 */
+	Prewarmer(std::vector<Target> targets, Store store, std::uint64_t bytesPerSecond,
+			std::size_t chunkSize = defaultChunkSize);
+
+	Prewarmer(Prewarmer const &other) = delete;
+	Prewarmer& operator=(Prewarmer const &other) = delete;
+
+	/**
+	 * Asks the prewarm to stop, if it has not finished. A chunk being passed
+	 * on is finished first. It is stopped anyway when destroyed.
+	 */
+	void stop();
+
+	/**
+	 * Waits for every file to have been warmed, or the prewarm to be stopped.
+	 * @return The final statistics.
+	 */
+	Stats wait() const;
+
+	/**
+	 * @return A snapshot of the progress of the prewarm.
+	 */
+	Stats stats() const;
+
+private:
+	void run();
+};
+
+} // namespace smfs
+
+#endif /* SMFS_PREWARMER_H_ */
@@ -0,0 +1,166 @@
+/*
+ * ReplicatedFile.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_REPLICATEDFILE_H_
+#define SMFS_REPLICATEDFILE_H_
+
+#include "smfs/BackingFile.h"
+#include "smfs/DeviceLoad.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace smfs {
+
+/**
+ * When to issue a hedged read to a second replica.
+ */
+struct HedgePolicy {
+	/**
+	 * The percentile of the first replica's recent latency after which to
+	 * hedge.
+	 */
+	double percentile = 0.95;
+
+	/**
+	 * The least time to wait before hedging, however fast the replica has
+	 * been, so that noise does not cause needless hedges.
+	 */
+	std::chrono::nanoseconds minimumDelay = std::chrono::microseconds(500);
+
+	/**
+	 * The time to wait before hedging while there are too few samples to
+	 * estimate a percentile.
+	 */
+	std::chrono::nanoseconds initialDelay = std::chrono::milliseconds(20);
+
+	/**
+	 * The number of samples needed to estimate a percentile.
+	 */
+	std::uint64_t warmupSamples = 20;
+};
+
+/**
+ * A backing file with identical copies on several devices, which reads from
+ * whichever copy is likely to answer soonest.
+ *
+ * Each read is sent to the replica whose device is least loaded, judged by
+ * the reads in flight to it and its recent latency (see @ref DeviceLoad). If
+ * the read has not completed by a deadline based on a high percentile of
+ * that device's recent latency, a duplicate read is sent to the next best
+ * replica, and whichever answers first is used. A read that fails is
+ * retried on another replica, and only fails once every replica has failed.
+ *
+ * Reads are made on a pool of threads, so that the caller can stop waiting
+ * for a slow one, and into buffers of their own, so that one answering late
+ * does not touch the caller's memory.
+ *
+ * The replicas must hold the same data. Since no one descriptor can be
+ * relied on to answer quickly, the data cannot be read from this file's own
+ * descriptor directly (see @ref hasRawDescriptor).
+ *
+ * The file takes the path of its first replica, and that is all a
+ * @ref Manifest records of it: the set of replicas is not persisted, and a
+ * merged file loaded from a manifest reads the first replica alone. Whoever
+ * replicates backing files must keep the other paths, and swap in a
+ * replicated file for the first replica's segments when reloading.
+ */
+class ReplicatedFile : public BackingFile {
+public:
+
+	/**
+	 * A copy of the file, and the load on the device it is on.
+	 */
+	struct Replica {
+		std::shared_ptr<BackingFile> file;
+		std::shared_ptr<DeviceLoad> device;
+	};
+
+	/**
+	 * Counters describing how reads have been served.
+	 */
+	struct Stats {
+		std::uint64_t reads = 0;
+		std::uint64_t hedged = 0;
+		std::uint64_t hedgeWins = 0;
+		std::uint64_t failovers = 0;
+
+		/**
+		 * @return The stats, as `key=value` pairs on one line.
+		 */
+		std::string toString() const;
+	};
+
+	/**
+	 * Opens a copy of the file at each of the given paths, each sharing the
+	 * load of the device it is on.
+	 * @param paths The path of each copy.
+	 * @param policy When to hedge reads.
+	 * @return A shared pointer to the newly-opened file.
+	 * @throws fusepp::fuse_error if a copy could not be opened, or with
+	 *         EINVAL if there are none.
+	 */
+	static std::shared_ptr<ReplicatedFile> open(std::vector<std::string> const & paths,
+			HedgePolicy policy = HedgePolicy());
+
+	/**
+	 * Constructor for ReplicatedFile.
+	 * @param replicas The copies of the file, of which the first is used for
+	 *                 this file's path and descriptor.
+	 * @param policy When to hedge reads.
+	 * @throws fusepp::fuse_error with EINVAL if there are no replicas.
+	 */
+	explicit ReplicatedFile(std::vector<Replica> replicas, HedgePolicy policy = HedgePolicy());
+
+	std::vector<Replica> const & replicas() const {
+		return copies;
+	}
+
+	bool hasRawDescriptor() const override {
+		return false;
+	}
+
+	/**
+	 * @return The size of the first replica, which may store its data
+	 *         differently from how it is read.
+	 */
+	off_t size() const override;
+
+	/**
+	 * @return How reads have been served so far.
+	 */
+	Stats stats() const;
+
+protected:
+	std::size_t readUnchecked(void * buf, std::size_t nbytes, off_t offset) const override;
+
+private:
+	std::vector<Replica> const copies;
+	HedgePolicy const policy;
+	mutable std::atomic<std::uint64_t> reads{0};
+	mutable std::atomic<std::uint64_t> hedged{0};
+	mutable std::atomic<std::uint64_t> hedgeWins{0};
+	mutable std::atomic<std::uint64_t> failovers{0};
+
+	struct Request;
+
+	/**
+	 * @return The deadline after which to hedge a read sent to a replica.
+	 */
+	std::chrono::nanoseconds hedgeDelay(Replica const & replica) const;
+
+	void launch(std::shared_ptr<Request> const & request, std::size_t replica) const;
+};
+
+} // namespace smfs
+
+#endif /* SMFS_REPLICATEDFILE_H_ */
@@ -0,0 +1,100 @@
+/*
+ * Scrubber.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_SCRUBBER_H_
+#define SMFS_SCRUBBER_H_
+
+#include "smfs/BackingFile.h"
+#include "smfs/ThrottledTask.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace smfs {
+
+/**
+ * Verifies every block of a set of backing files against their checksums
+ * on a background thread, reading no faster than a given rate so as not to
+ * starve foreground reads.
+ *
+ * Unlike verification on read, a scrub checks blocks that have already been
+ * verified, so that damage to data that is not being read is found. A block
+ * found damaged is marked unverified, so later reads of it fail with EIO.
+ */
+class Scrubber {
+public:
+
+	/**
+	 * Counters describing the progress of a scrub.
+	 */
+	struct Stats : TaskState {
+		std::uint64_t files = 0;
+		std::uint64_t blocks = 0;
+		std::uint64_t bytes = 0;
+
+		/**
+		 * The number of blocks that did not match their checksums.
+		 */
+		std::uint64_t damaged = 0;
+
+		/**
+		 * The number of blocks that could not be read.
+		 */
+		std::uint64_t errors = 0;
+
+		/**
+		 * @return A human-readable, single-line summary of these statistics.
+		 */
+		std::string toString() const;
+	};
+
+private:
+	using Task = ThrottledTask<Stats>;
+
+	std::vector<std::shared_ptr<BackingFile>> const files;
+	// Declared last, so that it starts after, and stops before, the rest
+	Task task;
+
+public:
+
+	/**
+	 * Starts scrubbing some files. Files without checksums are skipped.
+	 * @param files The files to scrub.
+	 * @param bytesPerSecond The maximum rate at which to read, or zero to read
+	 *                       as fast as possible.
+	 */
+	Scrubber(std::vector<std::shared_ptr<BackingFile>> files, std::uint64_t bytesPerSecond);
+
+	Scrubber(Scrubber const &other) = delete;
+	Scrubber& operator=(Scrubber const &other) = delete;
+
+	/**
+	 * Asks the scrub to stop, if it has not finished. It is stopped anyway
+	 * when destroyed.
+	 */
+	void stop();
+
+	/**
+	 * Waits for the scrub to finish or be stopped.
+	 * @return The final statistics.
+	 */
+	Stats wait() const;
+
+	/**
+	 * @return A snapshot of the progress of the scrub.
+	 */
+	Stats stats() const;
+
+private:
+	void run();
+};
+
+} // namespace smfs
+
+#endif /* SMFS_SCRUBBER_H_ */
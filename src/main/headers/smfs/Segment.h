@@ -0,0 +1,44 @@
+/*
+ * Segment.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_SEGMENT_H_
+#define SMFS_SEGMENT_H_
+
+#include "smfs/BackingFile.h"
+
+#include <cstddef>
+#include <memory>
+
+namespace smfs {
+
+/**
+ * A contiguous range of bytes within a @ref BackingFile.
+ *
+ * Merged files are described as an ordered list of segments, whose contents
+ * are concatenated to form the contents of the merged file.
+ */
+struct Segment {
+
+	/**
+	 * The file containing the segment's data.
+	 */
+	std::shared_ptr<BackingFile> file;
+
+	/**
+	 * The offset within the backing file at which the segment begins.
+	 */
+	off_t offset;
+
+	/**
+	 * The number of bytes in the segment.
+	 */
+	std::size_t length;
+};
+
+} // namespace smfs
+
+#endif /* SMFS_SEGMENT_H_ */
@@ -0,0 +1,249 @@
+/*
+ * SegmentCompactor.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_SEGMENTCOMPACTOR_H_
+#define SMFS_SEGMENTCOMPACTOR_H_
+
+#include "smfs/DeltaLog.h"
+#include "smfs/MergedFile.h"
+#include "smfs/ThrottledTask.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace smfs {
+
+/**
+ * What counts as a fragmented range of a merged file.
+ *
+ * Files are divided into aligned windows, and a window made up of more than
+ * a given number of segments is fragmented, since reading it costs a read of
+ * each.
+ */
+struct CompactionPolicy {
+	/**
+	 * The number of bytes in each window.
+	 */
+	std::size_t windowSize = 1024 * 1024;
+
+	/**
+	 * The most segments a window may overlap without being fragmented.
+	 */
+	std::size_t maxSegments = 16;
+
+	/**
+	 * The number of seconds between passes, or zero for a single pass.
+	 */
+	double interval = 0;
+
+	/**
+	 * The number of seconds a range of a delta log must go unreferenced
+	 * before its space is reclaimed. This must exceed the time a write takes
+	 * to be placed in its file once appended to the log, and the time a
+	 * reader takes to read from the segments it looked up.
+	 */
+	double reclaimDelay = 1;
+};
+
+/**
+ * How fragmented a merged file's segments are.
+ */
+struct Fragmentation {
+	std::uint64_t size = 0;
+	std::uint64_t segments = 0;
+	std::uint64_t windows = 0;
+	std::uint64_t fragmentedWindows = 0;
+	std::uint64_t fragmentedBytes = 0;
+
+	/**
+	 * The number of segments in the most fragmented window.
+	 */
+	std::uint64_t worstWindow = 0;
+
+	/**
+	 * @return The mean number of bytes in a segment.
+	 */
+	std::uint64_t meanSegmentSize() const {
+		return segments ? size / segments : 0;
+	}
+
+	/**
+	 * @return A human-readable, single-line summary of these statistics.
+	 */
+	std::string toString() const;
+};
+
+/**
+ * Rewrites the fragmented ranges of a set of merged files into contiguous
+ * backing extents, on a background thread, writing no faster than a given
+ * rate so as not to starve foreground I/O.
+ *
+ * The data of each fragmented window is read from its segments and appended
+ * to the file's @ref DeltaLog, and the window's segments are then swapped for
+ * the single new one, provided the window has not been edited in the
+ * meantime. Readers see either the old segments or the new, which hold the
+ * same data, and windows compacted one after another join into one segment.
+ * A window edited while it is being compacted is left for a later pass.
+ *
+ * Each pass then reclaims the space of the ranges of the targets' delta logs
+ * that no target refers to any longer, such as data since overwritten or
+ * compacted, by punching holes in the logs. A range is only reclaimed if it
+ * is still unreferenced after @ref CompactionPolicy::reclaimDelay. The
+ * targets must include every file that may refer to the logs.
+ *
+ * Passes may be repeated at an interval, the targets being listed afresh for
+ * each, until the compactor is stopped.
+ */
+class SegmentCompactor {
+public:
+
+	/**
+	 * A file to compact, and the log to write its compacted data to.
+	 */
+	using Target = std::pair<std::shared_ptr<MergedFile>, std::shared_ptr<DeltaLog>>;
+
+	/**
+	 * A function listing the files to compact, called at the start of each pass.
+	 */
+	using Targets = std::function<std::vector<Target>()>;
+
+	/**
+	 * Counters describing the progress of a compaction pass.
+	 */
+	struct Stats : TaskState {
+		std::uint64_t passes = 0;
+		std::uint64_t files = 0;
+		std::uint64_t windows = 0;
+		std::uint64_t bytes = 0;
+
+		/**
+		 * The number of segments replaced, less the number that replaced them.
+		 */
+		std::uint64_t segmentsRemoved = 0;
+
+		/**
+		 * The number of windows edited while being compacted, and so left alone.
+		 */
+		std::uint64_t conflicts = 0;
+
+		/**
+		 * The number of bytes of delta logs whose space has been reclaimed.
+		 */
+		std::uint64_t reclaimedBytes = 0;
+
+		/**
+		 * The number of windows that could not be read or written, and of logs
+		 * whose space could not be reclaimed.
+		 */
+		std::uint64_t errors = 0;
+
+		/**
+		 * @return A human-readable, single-line summary of these statistics.
+		 */
+		std::string toString() const;
+	};
+
+private:
+	using Task = ThrottledTask<Stats>;
+
+	/**
+	 * Ranges of a delta log, as pairs of start and end offsets.
+	 */
+	using Ranges = std::vector<std::pair<off_t, off_t>>;
+
+	Targets const targets;
+	CompactionPolicy const policy;
+	// Declared last, so that it starts after, and stops before, the rest
+	Task task;
+
+public:
+
+	/**
+	 * Starts compacting some files.
+	 * @param targets The files to compact, with their logs.
+	 * @param policy Which ranges to compact.
+	 * @param bytesPerSecond The maximum rate at which to rewrite data, or zero
+	 *                       to rewrite as fast as possible.
+	 */
+	SegmentCompactor(std::vector<Target> targets, CompactionPolicy policy, std::uint64_t bytesPerSecond);
+
+	/**
+	 * Starts compacting files, listed afresh for each pass.
+	 * @param targets The function listing the files to compact, with their logs.
+	 * @param policy Which ranges to compact, and how often.
+	 * @param bytesPerSecond The maximum rate at which to rewrite data, or zero
+	 *                       to rewrite as fast as possible.
+	 */
+	SegmentCompactor(Targets targets, CompactionPolicy policy, std::uint64_t bytesPerSecond);
+
+	SegmentCompactor(SegmentCompactor const &other) = delete;
+	SegmentCompactor& operator=(SegmentCompactor const &other) = delete;
+
+	/**
+	 * Measures how fragmented a file is.
+	 * @param file The file to measure.
+	 * @param policy What counts as fragmented.
+	 */
+	static Fragmentation measure(MergedFile const & file, CompactionPolicy const & policy = CompactionPolicy());
+
+	/**
+	 * Asks the compactor to stop. A window being compacted is finished first.
+	 * It is stopped anyway when destroyed.
+	 */
+	void stop();
+
+	/**
+	 * Waits for the compactor to finish, which one repeating passes only
+	 * does once stopped.
+	 * @return The final statistics.
+	 */
+	Stats wait() const;
+
+	/**
+	 * @return A snapshot of the progress of the compactor.
+	 */
+	Stats stats() const;
+
+private:
+	void run();
+
+	/**
+	 * Compacts the fragmented windows of some files.
+	 * @return Whether to carry on, which is not once stopped.
+	 */
+	bool compactAll(std::vector<Target> const & current);
+
+	/**
+	 * Reclaims the space of the ranges of some files' logs that stay
+	 * unreferenced for the reclaim delay.
+	 * @return Whether to carry on, which is not once stopped.
+	 */
+	bool reclaim(std::vector<Target> const & current);
+
+	/**
+	 * Finds the ranges of some files' logs that none of the files refer to,
+	 * keyed by the logs' paths.
+	 */
+	static std::map<std::string, std::pair<std::shared_ptr<BackingFile>, Ranges>> unreferenced(
+			std::vector<Target> const & current);
+
+	/**
+	 * Compacts one window of a file.
+	 * @return The number of bytes rewritten.
+	 */
+	std::size_t compact(Target const & target, SegmentTree const & tree, off_t offset, std::size_t length);
+};
+
+} // namespace smfs
+
+#endif /* SMFS_SEGMENTCOMPACTOR_H_ */
@@ -0,0 +1,99 @@
+/*
+ * SegmentList.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_SEGMENTLIST_H_
+#define SMFS_SEGMENTLIST_H_
+
+#include "smfs/Segment.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace smfs {
+
+/**
+ * An immutable, ordered list of @ref Segment "segments", indexed by the
+ * offset at which each begins within their concatenation.
+ */
+class SegmentList {
+	std::vector<Segment> segments;
+
+	/**
+	 * The offset at which each segment begins, followed by the total size.
+	 */
+	std::vector<off_t> starts;
+
+public:
+
+	/**
+	 * Constructor for SegmentList. Empty segments are discarded.
+	 * @param segments The segments, in order.
+	 */
+	explicit SegmentList(std::vector<Segment> segments);
+
+	/**
+	 * @return The total number of bytes in the segments.
+	 */
+	off_t size() const {
+		return starts.back();
+	}
+
+	/**
+	 * @return The number of segments in this list.
+	 */
+	std::size_t count() const {
+		return segments.size();
+	}
+
+	/**
+	 * Invokes the given function for each segment overlapping a range of
+	 * bytes, in order. Ranges extending beyond the end are truncated.
+	 *
+	 * @param offset The offset at which the range begins.
+	 * @param nbytes The number of bytes in the range.
+	 * @param fn A function taking the arguments
+	 *           `(Segment const & segment, off_t offsetInSegment, std::size_t length)`.
+	 */
+	template<typename F>
+	void forEachExtent(off_t offset, std::size_t nbytes, F&& fn) const {
+		if(offset >= size()) {
+			return;
+		}
+		off_t end = std::min<off_t>(size(), offset + nbytes);
+		std::size_t i = std::upper_bound(starts.begin(), starts.end(), offset) - starts.begin() - 1;
+		for(; offset < end; ++i) {
+			off_t inSegment = offset - starts[i];
+			std::size_t length = std::min<off_t>(end, starts[i+1]) - offset;
+			fn(segments[i], inSegment, length);
+			offset += length;
+		}
+	}
+
+	/**
+	 * Gets the segments describing a range of bytes, trimmed to the range.
+	 * @param offset The offset at which the range begins.
+	 * @param nbytes The number of bytes in the range.
+	 * @return The segments covering the range, truncated at the end of the list.
+	 */
+	std::vector<Segment> slice(off_t offset, std::size_t nbytes) const;
+
+	/**
+	 * Creates a new list in which a range of bytes has been replaced.
+	 * @param offset The offset at which the range to replace begins. Must
+	 *               not be beyond the end of this list.
+	 * @param nbytes The number of bytes to replace. Any part of the range
+	 *               beyond the end of this list is ignored.
+	 * @param replacement The segments to put in place of the range.
+	 * @return The new list.
+	 */
+	SegmentList splice(off_t offset, std::size_t nbytes, std::vector<Segment> const & replacement) const;
+};
+
+} // namespace smfs
+
+#endif /* SMFS_SEGMENTLIST_H_ */
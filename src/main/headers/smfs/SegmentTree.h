@@ -0,0 +1,146 @@
+/*
+ * SegmentTree.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_SEGMENTTREE_H_
+#define SMFS_SEGMENTTREE_H_
+
+#include "smfs/Segment.h"
+#include "smfs/details/SegmentTree.h"
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace smfs {
+
+/**
+ * An ordered sequence of @ref Segment "segments", indexed by the offset at
+ * which each begins within their concatenation.
+ *
+ * The segments are held in a persistent B+-tree whose inner nodes record the
+ * cumulative length of their children. Trees are immutable: operations that
+ * edit a tree return a new one, sharing all but O(log N) of its nodes with
+ * the original. Offset lookup, splitting, concatenation, and hence insertion
+ * and removal of arbitrary ranges, are all O(log N) in the number of segments.
+ *
+ * Adjacent segments that refer to contiguous ranges of the same backing file
+ * are merged where trees are joined.
+ */
+class SegmentTree {
+	details::TreeNodePtr root;
+
+	explicit SegmentTree(details::TreeNodePtr root);
+
+public:
+
+	/**
+	 * Constructs an empty tree.
+	 */
+	SegmentTree() {}
+
+	/**
+	 * Builds a tree from a list of segments. Empty segments are discarded.
+	 * This takes O(N) time.
+	 * @param segments The segments, in order.
+	 */
+	explicit SegmentTree(std::vector<Segment> const & segments);
+
+	/**
+	 * @return The total number of bytes in the segments.
+	 */
+	off_t size() const {
+		return root ? root->size() : 0;
+	}
+
+	/**
+	 * @return The number of segments in this tree.
+	 */
+	std::size_t count() const {
+		return root ? root->segments : 0;
+	}
+
+	/**
+	 * @return The number of levels in this tree.
+	 */
+	unsigned height() const {
+		return root ? root->height + 1 : 0;
+	}
+
+	/**
+	 * Invokes the given function for each segment overlapping a range of
+	 * bytes, in order. Ranges extending beyond the end are truncated.
+	 * This takes O(log N + K) time, where K is the number of segments visited.
+	 *
+	 * @param offset The offset at which the range begins.
+	 * @param nbytes The number of bytes in the range.
+	 * @param fn A function taking the arguments
+	 *           `(Segment const & segment, off_t offsetInSegment, std::size_t length)`.
+	 */
+	template<typename F>
+	void forEachExtent(off_t offset, std::size_t nbytes, F&& fn) const {
+		if(root && offset < size()) {
+			details::visitExtents(*root, offset, std::min<off_t>(size(), offset + nbytes), fn);
+		}
+	}
+
+	/**
+	 * Gets the segments describing a range of bytes, trimmed to the range.
+	 * @param offset The offset at which the range begins.
+	 * @param nbytes The number of bytes in the range.
+	 * @return The segments covering the range, truncated at the end of the tree.
+	 */
+	std::vector<Segment> slice(off_t offset, std::size_t nbytes) const;
+
+	/**
+	 * Splits this tree in two at the given offset. A segment spanning the
+	 * offset is divided between the two halves.
+	 * @param offset The offset at which to split.
+	 * @return The trees containing the bytes before and after the offset.
+	 */
+	std::pair<SegmentTree, SegmentTree> split(off_t offset) const;
+
+	/**
+	 * Gets the sub-tree describing a range of bytes.
+	 * @param offset The offset at which the range begins.
+	 * @param nbytes The number of bytes in the range.
+	 * @return A tree containing the range, truncated at the end of this tree.
+	 */
+	SegmentTree range(off_t offset, std::size_t nbytes) const;
+
+	/**
+	 * Joins two trees.
+	 * @param left The tree whose segments should come first.
+	 * @param right The tree whose segments should follow.
+	 * @return A tree containing the segments of both trees.
+	 */
+	static SegmentTree concat(SegmentTree const & left, SegmentTree const & right);
+
+	/**
+	 * Creates a new tree in which a range of bytes has been replaced.
+	 * @param offset The offset at which the range to replace begins.
+	 * @param nbytes The number of bytes to replace. Any part of the range
+	 *               beyond the end of this tree is ignored.
+	 * @param replacement The segments to put in place of the range.
+	 * @return The new tree.
+	 */
+	SegmentTree splice(off_t offset, std::size_t nbytes, SegmentTree const & replacement) const;
+
+	/**
+	 * Creates a new tree with a segment inserted at the given offset.
+	 * A segment spanning the offset is divided around the new one.
+	 */
+	SegmentTree insert(off_t offset, Segment const & segment) const;
+
+	/**
+	 * Creates a new tree with a range of bytes removed.
+	 */
+	SegmentTree erase(off_t offset, std::size_t nbytes) const;
+};
+
+} // namespace smfs
+
+#endif /* SMFS_SEGMENTTREE_H_ */
@@ -0,0 +1,61 @@
+/*
+ * Sha256.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_SHA256_H_
+#define SMFS_SHA256_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace smfs {
+
+/**
+ * A SHA-256 digest.
+ */
+using Digest = std::array<std::uint8_t, 32>;
+
+/**
+ * Computes SHA-256 digests (FIPS 180-4) incrementally.
+ */
+class Sha256 {
+	std::uint32_t state[8];
+	std::uint8_t block[64];
+	std::size_t buffered = 0;
+	std::uint64_t total = 0;
+
+public:
+	Sha256();
+
+	/**
+	 * Adds data to the digest.
+	 */
+	void update(void const * data, std::size_t length);
+
+	/**
+	 * Completes the digest. No more data may be added afterwards.
+	 */
+	Digest finish();
+
+	/**
+	 * Computes the digest of some data in one step.
+	 */
+	static Digest of(void const * data, std::size_t length);
+
+	/**
+	 * @return The digest in lower-case hexadecimal.
+	 */
+	static std::string hex(Digest const & digest);
+
+private:
+	void compress(std::uint8_t const * chunk);
+};
+
+} // namespace smfs
+
+#endif /* SMFS_SHA256_H_ */
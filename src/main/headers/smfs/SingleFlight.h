@@ -0,0 +1,82 @@
+/*
+ * SingleFlight.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_SINGLEFLIGHT_H_
+#define SMFS_SINGLEFLIGHT_H_
+
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+
+namespace smfs {
+
+/**
+ * Deduplicates concurrent calls that would produce the same result.
+ *
+ * The first caller to @ref run a function for a given key executes it; any
+ * other callers arriving with the same key before it completes wait for, and
+ * share, its result (or exception) rather than executing their own function.
+ * Once a call completes, the next caller with that key starts a new one.
+ *
+ * @tparam K The type of key identifying equivalent calls.
+ * @tparam V The (copyable) result type of the calls.
+ * @tparam Hash The hash function to use for keys.
+ */
+template<typename K, typename V, typename Hash = std::hash<K>>
+class SingleFlight {
+	std::mutex mutex;
+	std::unordered_map<K, std::shared_future<V>, Hash> flights;
+
+public:
+
+	/**
+	 * Invokes the given function, unless a call with the same key is already
+	 * in flight, in which case its result is awaited instead.
+	 *
+	 * @param key The key identifying the call.
+	 * @param fn The function to invoke, taking no arguments and returning a `V`.
+	 * @return The result of the call.
+	 * @throws Whatever the function invoked for the key threw.
+	 */
+	template<typename F>
+	V run(K const & key, F&& fn) {
+		std::unique_lock<std::mutex> lock(mutex);
+		auto it = flights.find(key);
+		if(it != flights.end()) {
+			std::shared_future<V> flight = it->second;
+			lock.unlock();
+			return flight.get();
+		}
+
+		std::promise<V> promise;
+		flights.emplace(key, promise.get_future().share());
+		lock.unlock();
+
+		try {
+			V value = fn();
+			land(key);
+			promise.set_value(value);
+			return value;
+		} catch(...) {
+			land(key);
+			promise.set_exception(std::current_exception());
+			throw;
+		}
+	}
+
+private:
+	void land(K const & key) {
+		std::lock_guard<std::mutex> lock(mutex);
+		flights.erase(key);
+	}
+};
+
+} // namespace smfs
+
+#endif /* SMFS_SINGLEFLIGHT_H_ */
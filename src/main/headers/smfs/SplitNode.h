@@ -0,0 +1,97 @@
+/*
+ * SplitNode.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_SPLITNODE_H_
+#define SMFS_SPLITNODE_H_
+
+#include "fuse.hpp"
+#include "smfs/BlockCache.h"
+#include "smfs/SplitView.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace smfs {
+
+class Mount;
+
+/**
+ * An open handle to a directory, or split file, within a @ref SplitView.
+ *
+ * The entries are listed once, when the directory is opened. Positions are
+ * indices into that listing, with "." and ".." at positions zero and one.
+ */
+class SplitDirHandle : public fusepp::DirHandle1 {
+	fusepp::path_t const rel_path;
+	SplitView::Resolved const resolved;
+	std::vector<DirectoryEntry> const entries;
+	Mount & mount;
+	std::size_t position = 0;
+
+public:
+
+	/**
+	 * Constructor for SplitDirHandle.
+	 * @param rel_path The path of the directory, relative to the mount point.
+	 * @param view The view containing the directory.
+	 * @param resolved The resolved directory.
+	 * @param mount The mount containing the view.
+	 */
+	SplitDirHandle(fusepp::path_t rel_path, SplitView const & view, SplitView::Resolved resolved, Mount & mount);
+
+	void getattr(struct stat& statbuf) override;
+
+	std::optional<fusepp::AnyDirEntry> readdir() override;
+
+	void seekdir(std::size_t offset) override;
+
+	std::size_t telldir() override;
+};
+
+/**
+ * A node within a @ref SplitView: a directory, a split file presented as a
+ * directory, or a chunk of a split file.
+ *
+ * Chunks are opened as single-segment merged files over their range of the
+ * backing file, so are read in the same way as merged files.
+ */
+class SplitNode : public fusepp::Node1 {
+	std::shared_ptr<SplitView const> const view;
+	SplitView::Resolved const resolved;
+	std::shared_ptr<BlockCache> const cache;
+	Mount & mount;
+
+public:
+
+	/**
+	 * Constructor for SplitNode.
+	 * @param rel_path The path of the node, relative to the mount point.
+	 * @param view The view containing the node.
+	 * @param resolved The node's path, resolved within the view.
+	 * @param cache The block cache to read chunks through, or `nullptr`.
+	 * @param mount The mount containing the view.
+	 */
+	SplitNode(fusepp::path_t rel_path, std::shared_ptr<SplitView const> view, SplitView::Resolved resolved,
+			std::shared_ptr<BlockCache> cache, Mount & mount);
+
+	/**
+	 * Resolves the child directly from this node, so only this node's
+	 * backing directory needs to be loaded.
+	 */
+	std::tuple<std::shared_ptr<fusepp::Node1>, double> lookup(std::string name) override;
+
+	double getattr(struct stat& statbuf) override;
+
+	std::unique_ptr<fusepp::FileHandle1> open(int flags) override;
+
+	std::unique_ptr<fusepp::DirHandle1> opendir(int flags) override;
+};
+
+} // namespace smfs
+
+#endif /* SMFS_SPLITNODE_H_ */
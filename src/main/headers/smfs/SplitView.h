@@ -0,0 +1,245 @@
+/*
+ * SplitView.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_SPLITVIEW_H_
+#define SMFS_SPLITVIEW_H_
+
+#include "smfs/Chunker.h"
+#include "smfs/DirectoryCache.h"
+#include "smfs/Manifest.h"
+#include "smfs/SingleFlight.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+extern "C" {
+	#include <sys/stat.h>
+	#include <sys/types.h>
+}
+
+namespace smfs {
+
+/**
+ * A read-only view of a backing directory hierarchy in which every regular
+ * file is presented as a directory of chunks.
+ *
+ * A file `a/b.dat` of 10 MiB, split into 4 MiB chunks, appears as a
+ * directory `a/b.dat` containing the files `00000000`, `00000001` and
+ * `00000002`, the last holding the final 2 MiB. Subdirectories appear as
+ * directories; entries of any other type are hidden.
+ *
+ * Files are split either into fixed-size chunks, or into content-defined
+ * chunks by a @ref Chunker, so that an insertion into a file only changes
+ * the chunks around it. Content-defined boundaries are computed the first
+ * time a file's chunks are used, and kept for the life of the view for as
+ * long as the file is unchanged. They can be saved to, and loaded from, a
+ * manifest in which each file is recorded with one segment per chunk.
+ *
+ * The backing hierarchy is never walked up front. Each directory's metadata
+ * is read from a @ref DirectoryCache the first time a path within it is
+ * resolved or listed, so a path can be reached in time proportional to its
+ * depth however large the hierarchy is.
+ */
+class SplitView {
+public:
+
+	/**
+	 * A path within a split view, resolved against the backing hierarchy.
+	 */
+	struct Resolved {
+		enum Kind {
+			missing,
+			directory,
+
+			/**
+			 * A backing regular file, presented as a directory of chunks.
+			 */
+			splitFile,
+
+			chunk
+		};
+
+		Kind kind = missing;
+
+		/**
+		 * The path of the backing directory or file.
+		 */
+		std::string backingPath;
+
+		/**
+		 * The attributes of the backing directory or file.
+		 */
+		struct stat backingAttributes{};
+
+		/**
+		 * The attributes presented for the path.
+		 */
+		struct stat attributes{};
+
+		/**
+		 * For chunks, the index of the chunk and the range of the backing
+		 * file it covers.
+		 */
+		std::size_t index = 0;
+		off_t offset = 0;
+		std::size_t length = 0;
+	};
+
+private:
+	using Boundaries = std::shared_ptr<std::vector<off_t> const>;
+
+	/**
+	 * The boundaries of a file, with the version of the file they were
+	 * found in (see @ref version).
+	 */
+	struct Known {
+		std::uint64_t version;
+		Boundaries ends;
+	};
+
+	/**
+	 * The division of a file into chunks.
+	 */
+	struct Layout {
+		off_t fileSize;
+		std::size_t chunkSize;
+
+		/**
+		 * The end of each chunk, if content-defined.
+		 */
+		Boundaries ends;
+
+		std::size_t count() const;
+		off_t start(std::size_t index) const;
+		off_t end(std::size_t index) const;
+	};
+
+	std::string const root;
+	std::size_t const chunkLength;
+	std::optional<Chunker> const chunker;
+	std::shared_ptr<DirectoryCache> const cache;
+	struct stat rootAttributes;
+
+	std::shared_ptr<Manifest const> const savedBoundaries;
+	mutable std::once_flag indexed;
+	mutable std::unordered_map<std::string, std::size_t> savedIndex;
+
+	mutable std::mutex boundariesLock;
+	mutable std::unordered_map<std::string, Known> knownBoundaries;
+	mutable SingleFlight<std::string, Boundaries> chunking;
+
+public:
+
+	/**
+	 * Constructor for SplitView.
+	 * @param root The path of the backing directory to present.
+	 * @param chunkSize The size of each chunk.
+	 * @param cache The cache to load backing directories through, which
+	 *              may be shared with other views.
+	 * @throws fusepp::fuse_error with ENOTDIR if the root is not a directory,
+	 *         or EINVAL if the chunk size is zero.
+	 */
+	SplitView(std::string root, std::size_t chunkSize, std::shared_ptr<DirectoryCache> cache);
+
+	/**
+	 * Constructs a view splitting files into content-defined chunks.
+	 * @param root The path of the backing directory to present.
+	 * @param chunker The chunker to divide files with.
+	 * @param cache The cache to load backing directories through, which
+	 *              may be shared with other views.
+	 * @param boundaries A manifest saved by @ref saveBoundaries from a view
+	 *                   with the same chunker, or `nullptr`. Its boundaries
+	 *                   are used for files that are unchanged since it was
+	 *                   saved, rather than reading them again.
+	 * @throws fusepp::fuse_error with ENOTDIR if the root is not a directory.
+	 */
+	SplitView(std::string root, Chunker chunker, std::shared_ptr<DirectoryCache> cache,
+			std::shared_ptr<Manifest const> boundaries = nullptr);
+
+	/**
+	 * @return The size of each chunk, other than the last of each file, or
+	 *         the average chunk size if chunks are content-defined.
+	 */
+	std::size_t chunkSize() const {
+		return chunkLength;
+	}
+
+	/**
+	 * Writes a manifest recording the content-defined chunk boundaries of
+	 * every file this view has divided, or loaded boundaries for.
+	 * @param path The path to write the manifest to.
+	 * @throws fusepp::fuse_error if the manifest cannot be written.
+	 */
+	void saveBoundaries(std::string const & path) const;
+
+	/**
+	 * Resolves a path within this view, loading the backing directories
+	 * along it as necessary.
+	 * @param path The path, relative to the root of the view and beginning
+	 *             with '/'.
+	 * @return The resolved path, whose kind is @ref Resolved::missing if
+	 *         nothing is presented there.
+	 * @throws fusepp::fuse_error if a backing directory cannot be read.
+	 */
+	Resolved resolve(std::string const & path) const;
+
+	/**
+	 * Resolves an entry of a directory or split file in this view, loading
+	 * the parent's backing directory if necessary.
+	 * @param parent The resolved parent.
+	 * @param name The name of the entry.
+	 * @return The resolved entry, whose kind is @ref Resolved::missing if
+	 *         there is no such entry.
+	 * @throws fusepp::fuse_error if the backing directory cannot be read.
+	 */
+	Resolved lookup(Resolved const & parent, std::string const & name) const;
+
+	/**
+	 * Lists the entries of a directory or split file in this view.
+	 * @param parent A resolved directory or split file.
+	 * @return The entries, sorted by name, with their presented attributes.
+	 * @throws fusepp::fuse_error with ENOTDIR if the parent is neither a
+	 *         directory nor a split file.
+	 */
+	std::vector<DirectoryEntry> list(Resolved const & parent) const;
+
+	/**
+	 * @param index The index of a chunk.
+	 * @return The name of the chunk in its split file.
+	 */
+	static std::string chunkName(std::size_t index);
+
+private:
+	SplitView(std::string root, std::size_t chunkSize, std::optional<Chunker> chunker,
+			std::shared_ptr<DirectoryCache> cache, std::shared_ptr<Manifest const> boundaries);
+
+	Layout layout(Resolved const & file) const;
+	Boundaries boundaries(Resolved const & file) const;
+	Boundaries saved(Resolved const & file) const;
+
+	/**
+	 * Identifies the version of a backing file, from its inode, size,
+	 * modification and change times, so that boundaries found in one
+	 * version are not used for another, even of the same size. The change
+	 * time moves whenever the file is written, even if the modification
+	 * time is then set back.
+	 * @param attributes The attributes of the backing file.
+	 * @return The version, which is never zero.
+	 */
+	static std::uint64_t version(struct stat const & attributes);
+	Resolved chunk(Resolved const & file, Layout const & layout, std::size_t index) const;
+};
+
+} // namespace smfs
+
+#endif /* SMFS_SPLITVIEW_H_ */
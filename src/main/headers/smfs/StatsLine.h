@@ -0,0 +1,66 @@
+/*
+ * StatsLine.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_STATSLINE_H_
+#define SMFS_STATSLINE_H_
+
+#include <cstdint>
+#include <string>
+
+namespace smfs {
+
+/**
+ * Builds the single-line summary of a set of counters that smfs reports
+ * through its extended attributes: space-separated `name=value` pairs,
+ * ending in a newline.
+ *
+ *     return StatsLine().count("hits", hits).ratio("hit_ratio", hitRatio(), 4).str();
+ */
+class StatsLine {
+	std::string line;
+
+public:
+
+	/**
+	 * Adds a counter.
+	 * @param name The name of the counter.
+	 * @param value Its value.
+	 * @return This line.
+	 */
+	StatsLine & count(char const * name, std::uint64_t value);
+
+	/**
+	 * Adds a fractional value.
+	 * @param name The name of the value.
+	 * @param value The value.
+	 * @param precision The number of digits to give after the point.
+	 * @return This line.
+	 */
+	StatsLine & ratio(char const * name, double value, int precision);
+
+	/**
+	 * Adds a flag, as 0 or 1.
+	 * @param name The name of the flag.
+	 * @param value Whether it is set.
+	 * @return This line.
+	 */
+	StatsLine & flag(char const * name, bool value);
+
+	/**
+	 * @return The line, ending in a newline.
+	 */
+	std::string str() const {
+		return line + "\n";
+	}
+
+private:
+	void name(char const * name);
+};
+
+} // namespace smfs
+
+#endif /* SMFS_STATSLINE_H_ */
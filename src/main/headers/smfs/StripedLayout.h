@@ -0,0 +1,104 @@
+/*
+ * StripedLayout.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_STRIPEDLAYOUT_H_
+#define SMFS_STRIPEDLAYOUT_H_
+
+#include "smfs/Segment.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace smfs {
+
+/**
+ * A layout that spreads the data of files across several backing
+ * directories, one for each device, in the manner of RAID-0.
+ *
+ * A striped file is divided into stripes of a fixed size, which are dealt out
+ * round-robin to a member file of the same name in each directory: stripe
+ * `i` is held by the member in directory `i % K`, at offset
+ * `(i / K) * stripeSize`. A striped file is merged back together as one
+ * segment per stripe, so a large read of it is spread across every device,
+ * and read from them in parallel (see @ref MergedFile::read).
+ *
+ * The size of a striped file is the total size of its members, so nothing
+ * need be recorded besides the directories and stripe size.
+ */
+class StripedLayout {
+	std::vector<std::string> const dirs;
+	std::size_t const stripeLength;
+
+public:
+
+	/**
+	 * The default number of bytes in each stripe.
+	 */
+	static constexpr std::size_t defaultStripeSize = 64 * 1024;
+
+	/**
+	 * Constructor for StripedLayout.
+	 * @param directories The directory for each member, in order.
+	 * @param stripeSize The number of bytes in each stripe.
+	 * @throws fusepp::fuse_error with EINVAL if there are no directories or
+	 *         the stripe size is zero.
+	 */
+	explicit StripedLayout(std::vector<std::string> directories, std::size_t stripeSize = defaultStripeSize);
+
+	std::vector<std::string> const & directories() const {
+		return dirs;
+	}
+
+	std::size_t stripeSize() const {
+		return stripeLength;
+	}
+
+	/**
+	 * Stripes the contents of a file across the directories.
+	 * @param source The file to stripe, which is read as it is now.
+	 * @param name The name of the member file to write in each directory.
+	 * @return The number of bytes striped.
+	 * @throws fusepp::fuse_error if the source cannot be read or a member
+	 *         cannot be written.
+	 */
+	off_t write(BackingFile const & source, std::string const & name) const;
+
+	/**
+	 * Opens the members of a striped file.
+	 * @param name The name of the member file in each directory.
+	 * @return The segments making up the striped file, in order.
+	 * @throws fusepp::fuse_error if a member cannot be opened, or with EINVAL
+	 *         if the sizes of the members are not those of a striped file.
+	 */
+	std::vector<Segment> open(std::string const & name) const;
+
+	/**
+	 * Gets the segments making up a striped file.
+	 * @param members The member files, one for each directory, in order.
+	 * @param stripeSize The number of bytes in each stripe.
+	 * @return The segments, one for each stripe.
+	 * @throws fusepp::fuse_error with EINVAL if the sizes of the members are
+	 *         not those of a striped file.
+	 */
+	static std::vector<Segment> segments(std::vector<std::shared_ptr<BackingFile>> const & members,
+			std::size_t stripeSize);
+
+	/**
+	 * @return The size of a member of a striped file.
+	 * @param size The size of the striped file.
+	 * @param stripeSize The number of bytes in each stripe.
+	 * @param count The number of members.
+	 * @param member The index of the member.
+	 */
+	static off_t memberSize(off_t size, std::size_t stripeSize, std::size_t count, std::size_t member);
+};
+
+} // namespace smfs
+
+#endif /* SMFS_STRIPEDLAYOUT_H_ */
@@ -0,0 +1,149 @@
+/*
+ * ThreadPool.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_THREADPOOL_H_
+#define SMFS_THREADPOOL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace smfs {
+
+/**
+ * A fixed set of worker threads for fanning work out from the calling
+ * thread.
+ *
+ * The caller of @ref parallelFor always takes part in the work itself, so it
+ * completes even if every worker is busy, and may safely be called from a
+ * worker. Helpers that only get to run after the work is finished find
+ * nothing left to do and return at once.
+ */
+class ThreadPool {
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::deque<std::function<void()>> queue;
+	bool stopping = false;
+	std::vector<std::thread> workers;
+
+public:
+
+	/**
+	 * The number of worker threads in the @ref io pool.
+	 */
+	static constexpr unsigned ioThreads = 16;
+
+	/**
+	 * Starts the worker threads.
+	 * @param threads The number of worker threads, or zero to use one fewer
+	 *                than the number of hardware threads, as the caller makes
+	 *                up the last.
+	 */
+	explicit ThreadPool(unsigned threads = 0);
+
+	/**
+	 * Stops the worker threads, once they have finished what is queued.
+	 */
+	~ThreadPool();
+
+	ThreadPool(ThreadPool const &other) = delete;
+	ThreadPool& operator=(ThreadPool const &other) = delete;
+
+	/**
+	 * @return A pool shared by everything in the process, with the default
+	 *         number of threads.
+	 */
+	static ThreadPool & shared();
+
+	/**
+	 * @return A pool shared by everything in the process for work that
+	 *         mostly waits on storage, such as reads spread across several
+	 *         devices, which has more threads than there are processors.
+	 */
+	static ThreadPool & io();
+
+	/**
+	 * @return The number of worker threads.
+	 */
+	std::size_t size() const {
+		return workers.size();
+	}
+
+	/**
+	 * Runs a task on a worker thread, without waiting for it. The task must
+	 * not throw.
+	 * @param task The task to run.
+	 */
+	void submit(std::function<void()> task);
+
+	/**
+	 * Invokes a function for each index in a range, on the calling thread
+	 * and as many workers as are free, and waits for all of them to finish.
+	 * @param count The number of indices, from zero.
+	 * @param fn A function taking a `std::size_t` index.
+	 * @throws The first exception thrown by `fn`, once all indices that were
+	 *         started have finished. Indices not yet started are skipped.
+	 */
+	template<typename F>
+	void parallelFor(std::size_t count, F&& fn) {
+		if(count <= 1 || workers.empty()) {
+			for(std::size_t i = 0; i < count; ++i) {
+				fn(i);
+			}
+			return;
+		}
+		std::shared_ptr<Batch> batch = std::make_shared<Batch>(count);
+		std::function<void(std::size_t)> body(std::ref(fn));
+		batch->body = &body;
+		std::size_t helpers = std::min(count - 1, workers.size());
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			for(std::size_t i = 0; i < helpers; ++i) {
+				queue.emplace_back([batch]() { batch->run(); });
+			}
+		}
+		wake.notify_all();
+		batch->run();
+		batch->wait();
+	}
+
+private:
+	/**
+	 * The shared state of a call to @ref parallelFor. The body is only
+	 * touched by a thread that claimed an index, and the caller claims any
+	 * that are left, then waits for every index to finish before returning.
+	 */
+	struct Batch {
+		std::size_t const count;
+		std::atomic<std::size_t> next{0};
+		std::atomic<bool> failed{false};
+		std::function<void(std::size_t)> * body = nullptr;
+		std::mutex mutex;
+		std::condition_variable done;
+		std::size_t finished = 0;
+		std::exception_ptr error;
+
+		explicit Batch(std::size_t count) : count(count) {}
+
+		void run();
+		void wait();
+	};
+
+	void work();
+};
+
+} // namespace smfs
+
+#endif /* SMFS_THREADPOOL_H_ */
@@ -0,0 +1,180 @@
+/*
+ * ThrottledTask.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_THROTTLEDTASK_H_
+#define SMFS_THROTTLEDTASK_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace smfs {
+
+/**
+ * Whether a @ref ThrottledTask has ended, and how. The statistics of such
+ * tasks derive from this.
+ */
+struct TaskState {
+	/**
+	 * Whether the task has ended, having either done everything it had to or
+	 * been stopped.
+	 */
+	bool finished = false;
+
+	/**
+	 * Whether the task was stopped before it had done everything it had to.
+	 */
+	bool stopped = false;
+};
+
+/**
+ * A task run on a background thread, such as a scrub, that works through
+ * data no faster than a given rate so as not to starve foreground I/O, and
+ * keeps statistics of its progress.
+ *
+ * The task's body reports the bytes it has worked through to @ref pace,
+ * which waits until the rate allows more, and tells the body to return once
+ * the task has been stopped. The statistics are marked finished when the
+ * body returns, however it came to, so that @ref wait always returns.
+ *
+ * The owner of a task should declare it after anything its body uses, so
+ * that the body starts only once they are constructed, and is stopped before
+ * they are destroyed.
+ *
+ * @tparam Stats The type of the task's statistics, derived from @ref TaskState.
+ */
+template<typename Stats>
+class ThrottledTask {
+public:
+
+	/**
+	 * The work of a task, given the task to report its progress to.
+	 */
+	using Body = std::function<void(ThrottledTask & task)>;
+
+private:
+	using clock = std::chrono::steady_clock;
+
+	std::uint64_t const bytesPerSecond;
+	mutable std::mutex mutex;
+	mutable std::condition_variable wake;
+	bool stopping = false;
+	Stats counters;
+	clock::time_point start = clock::now();
+	std::uint64_t paced = 0;
+	std::thread worker;
+
+public:
+
+	/**
+	 * Starts a task.
+	 * @param bytesPerSecond The maximum rate at which to work through data, or
+	 *                       zero for no limit.
+	 * @param body The work of the task.
+	 */
+	ThrottledTask(std::uint64_t bytesPerSecond, Body body)
+			: bytesPerSecond(bytesPerSecond), worker([this, body = std::move(body)]() {
+		body(*this);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			counters.finished = true;
+			counters.stopped = stopping;
+		}
+		wake.notify_all();
+	}) {}
+
+	/**
+	 * Stops the task, and waits for its body to return.
+	 */
+	~ThrottledTask() {
+		stop();
+		worker.join();
+	}
+
+	ThrottledTask(ThrottledTask const &other) = delete;
+	ThrottledTask& operator=(ThrottledTask const &other) = delete;
+
+	/**
+	 * Asks the task to stop, without waiting for it to. Work already under
+	 * way, such as a block being verified, is finished first.
+	 */
+	void stop() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		wake.notify_all();
+	}
+
+	/**
+	 * Waits for the task to finish or be stopped.
+	 * @return The final statistics.
+	 */
+	Stats wait() const {
+		std::unique_lock<std::mutex> lock(mutex);
+		wake.wait(lock, [this]() { return counters.finished; });
+		return counters;
+	}
+
+	/**
+	 * @return A snapshot of the statistics.
+	 */
+	Stats stats() const {
+		std::lock_guard<std::mutex> lock(mutex);
+		return counters;
+	}
+
+	/**
+	 * Updates the statistics.
+	 * @param fn A function taking the `Stats &` to update, called with the
+	 *           statistics locked.
+	 */
+	template<typename F>
+	void update(F&& fn) {
+		std::lock_guard<std::mutex> lock(mutex);
+		fn(counters);
+	}
+
+	/**
+	 * Counts some bytes as worked through, and waits until the rate allows
+	 * more to be.
+	 * @param bytes The number of bytes worked through since last called.
+	 * @return Whether to carry on, which the body must not once stopped.
+	 */
+	bool pace(std::uint64_t bytes) {
+		std::unique_lock<std::mutex> lock(mutex);
+		paced += bytes;
+		clock::time_point due = bytesPerSecond
+				? start + std::chrono::duration_cast<clock::duration>(
+						std::chrono::duration<double>(double(paced) / bytesPerSecond))
+				: clock::now();
+		return !wake.wait_until(lock, due, [this]() { return stopping; });
+	}
+
+	/**
+	 * Waits for some time, as between passes of a periodic task. The rate is
+	 * measured afresh afterwards, so the pause is not made up for.
+	 * @param seconds The number of seconds to wait.
+	 * @return Whether to carry on, which the body must not once stopped.
+	 */
+	bool pause(double seconds) {
+		std::unique_lock<std::mutex> lock(mutex);
+		if(wake.wait_for(lock, std::chrono::duration<double>(seconds), [this]() { return stopping; })) {
+			return false;
+		}
+		start = clock::now();
+		paced = 0;
+		return true;
+	}
+};
+
+} // namespace smfs
+
+#endif /* SMFS_THROTTLEDTASK_H_ */
@@ -0,0 +1,108 @@
+/*
+ * TreeScanner.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_TREESCANNER_H_
+#define SMFS_TREESCANNER_H_
+
+#include "smfs/Segment.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace smfs {
+
+/**
+ * A regular file found by a @ref TreeScanner.
+ */
+struct ScannedFile {
+
+	/**
+	 * The path of the file, relative to the root of the scan.
+	 */
+	std::string path;
+
+	std::uint64_t size;
+};
+
+/**
+ * Scans backing directory hierarchies for regular files, in parallel.
+ *
+ * Each directory is a task, run by one of a fixed set of worker threads.
+ * Subdirectories found by a worker are pushed onto its own queue, and taken
+ * from it newest first, so each worker descends depth-first through its part
+ * of the tree; idle workers steal the oldest tasks from the others, which
+ * tend to be the roots of the largest unscanned subtrees. Workers that find
+ * nothing to steal sleep until a directory is queued.
+ *
+ * Directories are read in large batches with `getdents64`, and only the
+ * sizes of regular files are asked of `statx`. Entry types come from the
+ * directory entries themselves where the backing filesystem provides them.
+ */
+class TreeScanner {
+public:
+
+	/**
+	 * Counters describing a scan.
+	 */
+	struct Stats {
+		std::uint64_t directories = 0;
+		std::uint64_t files = 0;
+		std::uint64_t bytes = 0;
+
+		/**
+		 * The number of directories scanned by a worker other than the one
+		 * that found them.
+		 */
+		std::uint64_t steals = 0;
+	};
+
+private:
+	unsigned const threadCount;
+	Stats counters;
+
+public:
+
+	/**
+	 * Constructor for TreeScanner.
+	 * @param threads The number of worker threads to scan with, or zero to
+	 *                use one per hardware thread.
+	 */
+	explicit TreeScanner(unsigned threads = 0);
+
+	/**
+	 * Finds all of the regular files beneath a directory. Symbolic links are
+	 * not followed, and entries other than directories and regular files are
+	 * ignored, as are entries removed while the scan is in progress.
+	 * @param root The directory to scan.
+	 * @return The files found, sorted by path.
+	 * @throws fusepp::fuse_error if a directory cannot be read.
+	 */
+	std::vector<ScannedFile> scan(std::string const & root);
+
+	/**
+	 * Scans a directory, and refers to the files found as the segments of a
+	 * merged file concatenating them in path order. The files are opened
+	 * lazily (see @ref BackingFile::openLazily), so a tree may hold more files
+	 * than the process may have descriptors.
+	 * @param root The directory to scan.
+	 * @return The segments, one per non-empty file.
+	 * @throws fusepp::fuse_error if a directory cannot be read.
+	 */
+	std::vector<Segment> segments(std::string const & root);
+
+	/**
+	 * @return The counters for the last scan.
+	 */
+	Stats stats() const {
+		return counters;
+	}
+};
+
+} // namespace smfs
+
+#endif /* SMFS_TREESCANNER_H_ */
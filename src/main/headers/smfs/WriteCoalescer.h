@@ -0,0 +1,209 @@
+/*
+ * WriteCoalescer.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_WRITECOALESCER_H_
+#define SMFS_WRITECOALESCER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+extern "C" {
+	#include <sys/types.h> // for off_t
+}
+
+namespace smfs {
+
+/**
+ * Buffers small writes to a file that follow on from one another, or land
+ * within the data already buffered, and passes them on as a single large
+ * write, so that an application writing in 4 KiB chunks costs one backing
+ * write per buffer rather than one per chunk.
+ *
+ * The buffer is passed on when a write does not join it, when it reaches
+ * its threshold size, or when @ref flush is called. On reaching the
+ * threshold, only the data up to the last multiple of @ref alignment in the
+ * file is passed on, and the rest is kept buffered, so that a long run of
+ * sequential writes is passed on in pieces that begin and end on page
+ * boundaries, whatever size the writes themselves are. Until then the data is
+ * only held in memory, so its owner must flush before anything reads the
+ * file, and any error writing the buffered data is reported by whichever
+ * call flushes it. A coalescer with a threshold of zero buffers nothing, and
+ * passes every write straight on.
+ *
+ * Writes are serialised, so that the buffered data is passed on in the order
+ * it was written.
+ */
+class WriteCoalescer {
+public:
+
+	/**
+	 * The default number of bytes buffered before they are passed on.
+	 */
+	static constexpr std::size_t defaultThreshold = 1024 * 1024;
+
+	/**
+	 * The offsets in the file at which data passed on on reaching the
+	 * threshold ends are a multiple of this.
+	 */
+	static constexpr std::size_t alignment = 4096;
+
+	/**
+	 * The function buffered data is passed on to, taking the data, the number
+	 * of bytes and the offset to write them at.
+	 */
+	using Sink = std::function<void(void const * data, std::size_t nbytes, off_t offset)>;
+
+	/**
+	 * Counters describing how well writes have been coalesced.
+	 */
+	struct Stats {
+		/**
+		 * The number of writes made to coalescers.
+		 */
+		std::uint64_t writes = 0;
+		std::uint64_t bytes = 0;
+
+		/**
+		 * The number of writes passed on to the sinks.
+		 */
+		std::uint64_t backingWrites = 0;
+
+		/**
+		 * The number of writes passed straight on, by coalescers buffering
+		 * nothing or through @ref writeThrough.
+		 */
+		std::uint64_t writeThrough = 0;
+
+		/**
+		 * @return The mean number of writes made per write passed on.
+		 */
+		double ratio() const {
+			return backingWrites ? static_cast<double>(writes) / backingWrites : 0;
+		}
+
+		/**
+		 * @return A human-readable, single-line summary of these statistics.
+		 */
+		std::string toString() const;
+	};
+
+	/**
+	 * Counters that may be shared between coalescers, such as those of every
+	 * handle open on a mount.
+	 */
+	class Counters {
+		friend class WriteCoalescer;
+
+		std::atomic<std::uint64_t> writes{0};
+		std::atomic<std::uint64_t> bytes{0};
+		std::atomic<std::uint64_t> backingWrites{0};
+		std::atomic<std::uint64_t> writeThrough{0};
+
+	public:
+
+		/**
+		 * @return A snapshot of the counters.
+		 */
+		Stats stats() const;
+	};
+
+private:
+	Sink const sink;
+	std::size_t const limit;
+	std::shared_ptr<Counters> const counters;
+	mutable std::mutex mutex;
+	std::vector<char> buffer;
+	off_t start = 0;
+
+public:
+
+	/**
+	 * Constructor for WriteCoalescer.
+	 * @param sink The function to pass buffered data on to.
+	 * @param threshold The number of bytes to buffer before passing them on,
+	 *                  or zero to pass every write straight on.
+	 * @param counters The counters to record writes in.
+	 */
+	WriteCoalescer(Sink sink, std::size_t threshold = defaultThreshold,
+			std::shared_ptr<Counters> counters = std::make_shared<Counters>());
+
+	WriteCoalescer(WriteCoalescer const &other) = delete;
+	WriteCoalescer& operator=(WriteCoalescer const &other) = delete;
+
+	/**
+	 * @return The number of bytes buffered before they are passed on.
+	 */
+	std::size_t threshold() const {
+		return limit;
+	}
+
+	/**
+	 * @return The range of the file buffered, as its offset and length, or
+	 *         an empty range at offset zero if nothing is buffered.
+	 */
+	std::pair<off_t, std::size_t> pending() const;
+
+	/**
+	 * @param size The size of the file, not counting anything buffered.
+	 * @return The size the file will have once the buffered data is passed
+	 *         on, which is `size` if nothing is buffered.
+	 */
+	off_t size(off_t size) const;
+
+	/**
+	 * Writes data, buffering it if it joins the data already buffered.
+	 * Otherwise, the buffered data is passed on first.
+	 * @param data The data to write.
+	 * @param nbytes The number of bytes to write.
+	 * @param offset The offset to write the data at.
+	 * @throws Anything the sink throws, in which case any data buffered
+	 *         before this write is discarded.
+	 */
+	void write(void const * data, std::size_t nbytes, off_t offset);
+
+	/**
+	 * Makes a write that the caller passes on itself, such as one whose data
+	 * is not in memory, after passing on any buffered data.
+	 * @param nbytes The number of bytes written.
+	 * @param write A function making the write.
+	 * @throws Anything the sink or `write` throws.
+	 */
+	void writeThrough(std::size_t nbytes, std::function<void()> const & write);
+
+	/**
+	 * Passes on any buffered data.
+	 * @throws Anything the sink throws, in which case the data is discarded.
+	 */
+	void flush();
+
+	/**
+	 * @return A snapshot of the counters this coalescer records writes in.
+	 */
+	Stats stats() const {
+		return counters->stats();
+	}
+
+private:
+	void flushLocked();
+
+	/**
+	 * Passes on the buffered data up to the last multiple of
+	 * @ref alignment, or all of it if it does not reach one.
+	 */
+	void flushAligned();
+};
+
+} // namespace smfs
+
+#endif /* SMFS_WRITECOALESCER_H_ */
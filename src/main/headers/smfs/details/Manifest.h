@@ -0,0 +1,243 @@
+/*
+ * Manifest.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_DETAILS_MANIFEST_H_
+#define SMFS_DETAILS_MANIFEST_H_
+
+#include <fusepp/common.hpp>
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+extern "C" {
+	#include <sys/types.h> // for off_t
+}
+
+namespace smfs {
+namespace details {
+
+/*
+ * A manifest file is laid out as:
+ *
+ *   ManifestHeader
+ *   string table        (bytes, referenced by ManifestString)
+ *   backing file table  (ManifestBacking[backingCount])
+ *   merged file table   (ManifestFile[fileCount])
+ *   checkpoint table    (ManifestCheckpoint[checkpointCount])
+ *   segment records     (bytes)
+ *   checksum table      (uint32_t[checksumCount])
+ *   digest table        (uint8_t[digestCount][32])
+ *
+ * Every table is 8-byte aligned, and every fixed-size field is stored in host
+ * byte order, which is recorded in the header. Segment records are varint
+ * encoded, each relative to the one before it. Every `manifestCheckpointStride`
+ * records, the encoding restarts from scratch and a checkpoint records the
+ * position of the record and the offset at which its segment begins, so that a
+ * lookup need only decode records from the nearest checkpoint.
+ *
+ * A backing file may have the CRC-32C of each of its blocks recorded, as a
+ * run of consecutive entries in the checksum table. Likewise, a merged file
+ * may have the nodes of its Merkle tree recorded in the digest table, in the
+ * order given by MerkleTree::all.
+ */
+
+constexpr char manifestMagic[8] = {'S', 'M', 'F', 'S', 'M', 'A', 'N', '\n'};
+
+constexpr std::uint32_t manifestVersion = 4;
+
+constexpr std::uint32_t manifestByteOrder = 0x01020304;
+
+constexpr unsigned manifestCheckpointStride = 64;
+
+struct ManifestHeader {
+	char magic[8];
+	std::uint32_t version;
+	std::uint32_t byteOrder;
+	std::uint64_t length;
+	std::uint64_t stringsOffset;
+	std::uint64_t stringsSize;
+	std::uint64_t backingOffset;
+	std::uint64_t backingCount;
+	std::uint64_t filesOffset;
+	std::uint64_t fileCount;
+	std::uint64_t checkpointsOffset;
+	std::uint64_t checkpointCount;
+	std::uint64_t recordsOffset;
+	std::uint64_t recordsSize;
+	std::uint64_t checksumsOffset;
+	std::uint64_t checksumCount;
+	std::uint64_t digestsOffset;
+	std::uint64_t digestCount;
+};
+
+struct ManifestString {
+	std::uint64_t offset;
+	std::uint64_t length;
+};
+
+struct ManifestBacking {
+	ManifestString path;
+
+	/**
+	 * The size of each checksummed block, or zero if the file has no checksums.
+	 */
+	std::uint64_t checksumBlockSize;
+
+	/**
+	 * The number of bytes of the file covered by its checksums.
+	 */
+	std::uint64_t checksummedSize;
+
+	/**
+	 * The index in the checksum table of the checksum of the first block.
+	 */
+	std::uint64_t firstChecksum;
+};
+
+struct ManifestFile {
+	ManifestString path;
+	std::uint64_t size;
+	std::uint64_t segmentCount;
+	std::uint64_t firstCheckpoint;
+	std::uint64_t checkpointCount;
+
+	/**
+	 * The journal sequence number of the last edit reflected in the file.
+	 */
+	std::uint64_t sequence;
+
+	/**
+	 * The leaf size of the file's Merkle tree, or zero if it has none recorded.
+	 */
+	std::uint64_t merkleLeafSize;
+
+	/**
+	 * The index in the digest table of the first node of the Merkle tree.
+	 */
+	std::uint64_t firstDigest;
+};
+
+struct ManifestCheckpoint {
+	/**
+	 * The offset within the merged file at which the checkpointed segment begins.
+	 */
+	std::uint64_t start;
+
+	/**
+	 * The offset within the segment records at which its record begins.
+	 */
+	std::uint64_t record;
+};
+
+static_assert(std::is_trivially_copyable<ManifestHeader>::value && sizeof(ManifestHeader) == 136, "Unexpected layout");
+static_assert(sizeof(ManifestBacking) == 40 && sizeof(ManifestFile) == 72 && sizeof(ManifestCheckpoint) == 16, "Unexpected layout");
+
+/**
+ * A segment as it is stored in a manifest.
+ */
+struct SegmentRecord {
+	std::uint64_t backing;
+	off_t offset;
+	std::uint64_t length;
+};
+
+inline std::uint64_t zigzag(std::int64_t v) {
+	return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+}
+
+inline std::int64_t unzigzag(std::uint64_t v) {
+	return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+}
+
+inline void putVarint(std::string &out, std::uint64_t v) {
+	while(v >= 0x80) {
+		out.push_back(static_cast<char>(v | 0x80));
+		v >>= 7;
+	}
+	out.push_back(static_cast<char>(v));
+}
+
+/**
+ * Decodes a varint.
+ * @throws fusepp::fuse_error with EIO if the varint runs past `end`.
+ */
+inline std::uint64_t getVarint(unsigned char const * &p, unsigned char const * end) {
+	std::uint64_t v = 0;
+	for(unsigned shift = 0; p != end && shift < 64; shift += 7) {
+		unsigned char byte = *p++;
+		v |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+		if(!(byte & 0x80)) {
+			return v;
+		}
+	}
+	throw fusepp::fuse_error(EIO);
+}
+
+/**
+ * Encodes each record as the change in backing file index from the previous
+ * record, the distance of its offset from where the previous record left off
+ * (or from zero, if in a different backing file), and its length. Sequential
+ * chunks of a backing file hence take a byte for each of the first two fields.
+ */
+class RecordEncoder {
+	std::uint64_t backing = 0;
+	off_t end = 0;
+
+public:
+	void reset() {
+		backing = 0;
+		end = 0;
+	}
+
+	void put(std::string &out, SegmentRecord const & record) {
+		off_t expected = record.backing == backing ? end : 0;
+		putVarint(out, zigzag(static_cast<std::int64_t>(record.backing - backing)));
+		putVarint(out, zigzag(record.offset - expected));
+		putVarint(out, record.length);
+		backing = record.backing;
+		end = record.offset + record.length;
+	}
+};
+
+/**
+ * Decodes the records written by a @ref RecordEncoder, starting at a checkpoint.
+ */
+class RecordDecoder {
+	unsigned char const * p;
+	unsigned char const * end;
+	std::uint64_t backing = 0;
+	off_t last = 0;
+
+public:
+	RecordDecoder(unsigned char const * p, unsigned char const * end) : p(p), end(end) {}
+
+	/**
+	 * Restarts decoding at a checkpoint following the current record.
+	 */
+	void reset() {
+		backing = 0;
+		last = 0;
+	}
+
+	/**
+	 * @throws fusepp::fuse_error with EIO if the records are malformed.
+	 */
+	SegmentRecord next() {
+		std::uint64_t b = backing + unzigzag(getVarint(p, end));
+		off_t expected = b == backing ? last : 0;
+		SegmentRecord record{b, expected + unzigzag(getVarint(p, end)), getVarint(p, end)};
+		backing = record.backing;
+		last = record.offset + record.length;
+		return record;
+	}
+};
+
+} // namespace details
+} // namespace smfs
+
+#endif /* SMFS_DETAILS_MANIFEST_H_ */
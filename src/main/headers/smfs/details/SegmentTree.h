@@ -0,0 +1,129 @@
+/*
+ * SegmentTree.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_DETAILS_SEGMENTTREE_H_
+#define SMFS_DETAILS_SEGMENTTREE_H_
+
+#include "smfs/Segment.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+
+namespace smfs {
+namespace details {
+
+/**
+ * The maximum number of entries in a segment tree node. Chosen so that the
+ * offsets scanned when descending a node span four cache lines.
+ */
+constexpr unsigned treeFanout = 32;
+
+/**
+ * The minimum number of entries in a segment tree node, other than the root
+ * or one that has been left on the edge of a split.
+ */
+constexpr unsigned treeMinFill = treeFanout / 2;
+
+struct TreeNode;
+
+using TreeNodePtr = std::shared_ptr<TreeNode const>;
+
+/**
+ * A node of a @ref SegmentTree. Nodes are immutable once built, so they can be
+ * shared between trees.
+ */
+struct alignas(64) TreeNode {
+
+	/**
+	 * The cumulative number of bytes in entries 0 to i of this node.
+	 */
+	off_t ends[treeFanout];
+
+	/**
+	 * The number of levels below this node, so zero for leaves.
+	 */
+	unsigned height;
+
+	/**
+	 * The number of entries in this node.
+	 */
+	unsigned count;
+
+	/**
+	 * The total number of segments in the subtree rooted at this node.
+	 */
+	std::size_t segments;
+
+	/**
+	 * @return The total number of bytes in the subtree rooted at this node.
+	 */
+	off_t size() const {
+		return count ? ends[count-1] : 0;
+	}
+
+	/**
+	 * @return The offset within this node at which entry `i` begins.
+	 */
+	off_t start(unsigned i) const {
+		return i ? ends[i-1] : 0;
+	}
+
+	/**
+	 * @return The index of the entry containing the given offset within this
+	 *         node, or `count` if the offset is beyond its end.
+	 */
+	unsigned find(off_t offset) const {
+		return std::upper_bound(ends, ends + count, offset) - ends;
+	}
+
+protected:
+	explicit TreeNode(unsigned height) : height(height), count(0), segments(0) {}
+};
+
+struct TreeLeaf : TreeNode {
+	Segment entries[treeFanout];
+
+	TreeLeaf() : TreeNode(0) {}
+};
+
+struct TreeInner : TreeNode {
+	TreeNodePtr children[treeFanout];
+
+	explicit TreeInner(unsigned height) : TreeNode(height) {}
+};
+
+inline TreeLeaf const & leaf(TreeNode const & node) {
+	return static_cast<TreeLeaf const &>(node);
+}
+
+inline TreeInner const & inner(TreeNode const & node) {
+	return static_cast<TreeInner const &>(node);
+}
+
+/**
+ * Visits the segments overlapping the range [offset, end) of a subtree.
+ * Offsets are relative to the start of the subtree.
+ */
+template<typename F>
+void visitExtents(TreeNode const & node, off_t offset, off_t end, F& fn) {
+	for(unsigned i = node.find(offset); i < node.count && node.start(i) < end; ++i) {
+		off_t start = node.start(i);
+		off_t from = std::max(offset, start) - start;
+		off_t to = std::min(end, node.ends[i]) - start;
+		if(node.height == 0) {
+			fn(leaf(node).entries[i], from, static_cast<std::size_t>(to - from));
+		} else {
+			visitExtents(*inner(node).children[i], from, to, fn);
+		}
+	}
+}
+
+} // namespace details
+} // namespace smfs
+
+#endif /* SMFS_DETAILS_SEGMENTTREE_H_ */
@@ -0,0 +1,157 @@
+/*
+ * ioctl.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFS_IOCTL_H_
+#define SMFS_IOCTL_H_
+
+/*
+ * ioctl commands understood by smfs merged files. This header is plain C so
+ * that client tools can use it without depending on the rest of smfs.
+ *
+ * Commands other than @ref SMFS_IOC_SCRUB, @ref SMFS_IOC_COMPACT and
+ * @ref SMFS_IOC_PREWARM edit the file's segment list without rewriting any
+ * data, and take effect atomically: concurrent readers see the file either
+ * wholly before or wholly after the edit.
+ *
+ * Every command fails with EBADF unless the file is open for writing.
+ */
+
+#include <stdint.h>
+#include <sys/ioctl.h>
+
+#define SMFS_IOC_MAGIC 0xF5
+
+/**
+ * The maximum length (including the terminating null) of a path given to
+ * @ref SMFS_IOC_APPEND.
+ */
+#define SMFS_IOC_PATH_MAX 4096
+
+/**
+ * Argument for @ref SMFS_IOC_APPEND.
+ */
+struct smfs_ioc_append {
+	/**
+	 * The path, relative to the mount point and beginning with '/', of the
+	 * merged file whose contents should be appended.
+	 */
+	char source[SMFS_IOC_PATH_MAX];
+};
+
+/**
+ * Argument for @ref SMFS_IOC_CUT.
+ */
+struct smfs_ioc_cut {
+	/** The offset at which the range to remove begins. */
+	uint64_t offset;
+	/** The number of bytes to remove. */
+	uint64_t length;
+};
+
+/**
+ * Argument for @ref SMFS_IOC_COPY_RANGE.
+ */
+struct smfs_ioc_copy_range {
+	/**
+	 * The path, relative to the mount point and beginning with '/', of the
+	 * merged file to copy from, which may be this file.
+	 */
+	char source[SMFS_IOC_PATH_MAX];
+	/** The offset within the source to copy from. */
+	uint64_t source_offset;
+	/** The offset within this file to copy to, which must not be beyond its end. */
+	uint64_t offset;
+	/** The number of bytes to copy. */
+	uint64_t length;
+	/** Set to the number of bytes copied, which is less than `length` at the end of the source. */
+	uint64_t copied;
+};
+
+/**
+ * Argument for @ref SMFS_IOC_SCRUB.
+ */
+struct smfs_ioc_scrub {
+	/** The maximum rate to read at, in bytes per second, or zero for no limit. */
+	uint64_t bytes_per_second;
+};
+
+/**
+ * Argument for @ref SMFS_IOC_COMPACT.
+ */
+struct smfs_ioc_compact {
+	/** The maximum rate to rewrite at, in bytes per second, or zero for no limit. */
+	uint64_t bytes_per_second;
+	/** The number of seconds between passes, or zero for a single pass. */
+	uint64_t interval_seconds;
+};
+
+/**
+ * Argument for @ref SMFS_IOC_PREWARM.
+ */
+struct smfs_ioc_prewarm {
+	/** The maximum rate to stream at, in bytes per second, or zero for no limit. */
+	uint64_t bytes_per_second;
+	/**
+	 * The path, relative to the mount point and beginning with '/', of the
+	 * merged file to warm, or an empty string to warm the mount's hot files.
+	 */
+	char path[SMFS_IOC_PATH_MAX];
+};
+
+/**
+ * Appends the contents of another merged file on the same mount to the end
+ * of this one.
+ */
+#define SMFS_IOC_APPEND _IOW(SMFS_IOC_MAGIC, 1, struct smfs_ioc_append)
+
+/**
+ * Removes a range of bytes from the file, closing up the gap. Unlike
+ * `fallocate(FALLOC_FL_COLLAPSE_RANGE)`, which smfs also supports, the range
+ * need not be block aligned, nor end before the end of the file.
+ */
+#define SMFS_IOC_CUT _IOW(SMFS_IOC_MAGIC, 2, struct smfs_ioc_cut)
+
+/**
+ * Copies a range of another merged file on the same mount, or of this one,
+ * over this file, extending it if need be, as `copy_file_range` does. Only
+ * the segment list is edited, so no data is moved. This reaches smfs on any
+ * libfuse, whereas `copy_file_range` itself is only passed on by libfuse 3.4
+ * and later, and is otherwise carried out by the kernel as reads and writes.
+ */
+#define SMFS_IOC_COPY_RANGE _IOWR(SMFS_IOC_MAGIC, 3, struct smfs_ioc_copy_range)
+
+/**
+ * Starts verifying every checksummed backing file of every merged file on
+ * the mount, in the background, replacing any scrub already in progress.
+ * Progress is reported through the `user.smfs.scrub_stats` extended
+ * attribute. It acts on the whole mount, whichever merged file it is issued
+ * on.
+ */
+#define SMFS_IOC_SCRUB _IOW(SMFS_IOC_MAGIC, 4, struct smfs_ioc_scrub)
+
+/**
+ * Starts rewriting the fragmented ranges of every merged file on the mount
+ * into contiguous extents of their delta logs, and reclaiming the space of
+ * the ranges of the logs that no file refers to any longer, in the
+ * background, once or at an interval, replacing any compaction already in
+ * progress. Progress is reported through the
+ * `user.smfs.compaction_stats` extended attribute. It acts on the whole
+ * mount, whichever merged file it is issued on, and fails with EROFS if the
+ * mount has no directory for delta logs.
+ */
+#define SMFS_IOC_COMPACT _IOW(SMFS_IOC_MAGIC, 5, struct smfs_ioc_compact)
+
+/**
+ * Starts streaming a merged file, or the mount's hot files, into the kernel's
+ * page cache, in the background, replacing any prewarm already in progress,
+ * so that the first reads of them are served from memory. Progress is
+ * reported through the `user.smfs.prewarm_stats` extended attribute. It may
+ * be issued on any merged file, whichever files it warms.
+ */
+#define SMFS_IOC_PREWARM _IOW(SMFS_IOC_MAGIC, 6, struct smfs_ioc_prewarm)
+
+#endif /* SMFS_IOCTL_H_ */
@@ -0,0 +1,107 @@
+/*
+ * BlockCacheTest.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#include "gtest/gtest.h"
+
+#include "smfs/BlockCache.h"
+#include "TempDir.h"
+
+#include <string>
+
+using namespace smfs;
+using namespace std;
+
+static string pattern(size_t length) {
+	string s(length, '\0');
+	for(size_t i = 0; i < length; ++i) {
+		s[i] = 'a' + i % 26;
+	}
+	return s;
+}
+
+static string read_all(BlockCache &cache, BackingFile const & file, off_t offset, size_t nbytes) {
+	string out;
+	cache.read(file, offset, nbytes, [&](shared_ptr<Block> block, size_t inBlock, size_t length) {
+		out.append(block->data() + inBlock, length);
+	});
+	return out;
+}
+
+TEST(BlockCache, serves_repeated_reads_from_cache) {
+	TempDir dir;
+	string contents = pattern(10000);
+	auto file = BackingFile::open(dir.write("a", contents));
+	BlockCache cache(1 << 20, 4096);
+
+	EXPECT_EQ(contents.substr(100, 5000), read_all(cache, *file, 100, 5000));
+	EXPECT_EQ(0, cache.stats().hits);
+	EXPECT_EQ(2, cache.stats().misses);
+
+	EXPECT_EQ(contents.substr(4000, 6000), read_all(cache, *file, 4000, 6000));
+	BlockCache::Stats stats = cache.stats();
+	EXPECT_EQ(2, stats.hits);
+	EXPECT_EQ(3, stats.misses);
+	EXPECT_EQ(8192, stats.bytesSaved);
+	EXPECT_EQ(10000, stats.bytesFetched);
+	EXPECT_DOUBLE_EQ(0.4, stats.hitRatio());
+}
+
+TEST(BlockCache, stops_at_end_of_backing_file) {
+	TempDir dir;
+	auto file = BackingFile::open(dir.write("a", pattern(5000)));
+	BlockCache cache(1 << 20, 4096);
+
+	EXPECT_EQ(1000, read_all(cache, *file, 4000, 100000).size());
+	EXPECT_EQ(0, read_all(cache, *file, 8192, 10).size());
+}
+
+TEST(BlockCache, keeps_within_budget) {
+	TempDir dir;
+	auto file = BackingFile::open(dir.write("a", pattern(64 * 1024)));
+	BlockCache cache(4 * 4096, 4096);
+
+	read_all(cache, *file, 0, 64 * 1024);
+	EXPECT_EQ(12, cache.stats().evictions);
+
+	// Early blocks have been evicted...
+	read_all(cache, *file, 0, 10);
+	EXPECT_EQ(0, cache.stats().hits);
+	// ...but the latest are still there
+	read_all(cache, *file, 60 * 1024, 10);
+	EXPECT_EQ(1, cache.stats().hits);
+}
+
+TEST(BlockCache, working_set_survives_a_sequential_scan) {
+	TempDir dir;
+	auto file = BackingFile::open(dir.write("a", pattern(256 * 1024)));
+	BlockCache cache(16 * 1024, 1024);
+
+	// Touch a small working set, push it out of the FIFO, then touch it
+	// again so that it gets promoted to the main queue
+	read_all(cache, *file, 0, 4096);
+	read_all(cache, *file, 64 * 1024, 16 * 1024);
+	read_all(cache, *file, 0, 4096);
+	EXPECT_EQ(0, cache.stats().hits);
+
+	read_all(cache, *file, 128 * 1024, 128 * 1024);
+
+	uint64_t hits = cache.stats().hits;
+	read_all(cache, *file, 0, 4096);
+	EXPECT_EQ(hits + 4, cache.stats().hits);
+}
+
+TEST(BlockCache, blocks_outlive_eviction_while_referenced) {
+	TempDir dir;
+	string contents = pattern(8192);
+	auto file = BackingFile::open(dir.write("a", contents));
+	BlockCache cache(4096, 4096);
+
+	shared_ptr<Block> first = cache.get(*file, 0);
+	cache.get(*file, 4096);
+	EXPECT_EQ(1, cache.stats().evictions);
+	EXPECT_EQ(contents.substr(0, 4096), string(first->data(), first->size()));
+}
@@ -0,0 +1,133 @@
+/*
+ * ChecksumTest.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "gtest/gtest.h"
+
+#include "smfs/BlockChecksums.h"
+#include "smfs/Crc32c.h"
+#include "smfs/Scrubber.h"
+#include "TempDir.h"
+
+#include <fusepp/common.hpp>
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace smfs;
+using namespace std;
+
+static string randomData(size_t length, unsigned seed) {
+	mt19937_64 random(seed);
+	string rc(length, '\0');
+	for(char &c : rc) {
+		c = static_cast<char>(random());
+	}
+	return rc;
+}
+
+/**
+ * Computes CRC-32C a bit at a time, as a reference.
+ */
+static uint32_t bitwiseCrc(string const & data) {
+	uint32_t crc = ~0u;
+	for(unsigned char byte : data) {
+		crc ^= byte;
+		for(int k = 0; k < 8; ++k) {
+			crc = crc & 1 ? (crc >> 1) ^ 0x82f63b78 : crc >> 1;
+		}
+	}
+	return ~crc;
+}
+
+TEST(ChecksumTest, crc32c_matches_reference) {
+	EXPECT_EQ(0xe3069283, crc32c("123456789", 9));
+	EXPECT_EQ(0x8a9136aa, crc32c(string(32, '\0').data(), 32));
+	EXPECT_EQ(0, crc32c(nullptr, 0));
+
+	// Cover every combination of alignment, interleaving and tail
+	string data = randomData(100000, 1);
+	for(size_t start : {0, 1, 7}) {
+		for(size_t length : {5, 300, 800, 24576, 24576 + 777, 99000}) {
+			string part = data.substr(start, length);
+			EXPECT_EQ(bitwiseCrc(part), crc32c(data.data() + start, length)) << start << " " << length;
+		}
+	}
+	EXPECT_EQ(crc32c(data.data(), data.size()), crc32c(data.data() + 5000, data.size() - 5000, crc32c(data.data(), 5000)));
+}
+
+TEST(ChecksumTest, verifies_blocks_on_first_read) {
+	TempDir dir;
+	string data = randomData(10000, 2);
+	string path = dir.write("f", data);
+	shared_ptr<BackingFile> file = BackingFile::open(path);
+	shared_ptr<BlockChecksums const> sums = BlockChecksums::compute(*file, 1024);
+	EXPECT_EQ(10, sums->count());
+	EXPECT_EQ(784, sums->blockLengthAt(9));
+	file->attachChecksums(sums);
+
+	// Reading part of a block verifies the whole block
+	char buf[2048];
+	EXPECT_EQ(100, file->read(buf, 100, 1500));
+	EXPECT_TRUE(sums->verified(1));
+	EXPECT_EQ(1, sums->verifiedCount());
+	EXPECT_EQ(2048, file->read(buf, 2048, 2048));
+	EXPECT_EQ(3, sums->verifiedCount());
+
+	data[5000] ^= 1;
+	dir.write("f", data);
+	EXPECT_THROW(file->read(buf, 10, 5100), fusepp::fuse_error);
+	EXPECT_FALSE(sums->verified(4));
+	EXPECT_THROW(file->verify(4000, 2000), fusepp::fuse_error);
+	EXPECT_NO_THROW(file->verify(6144, 3856));
+	EXPECT_EQ(7, sums->verifiedCount());
+
+	// Data appended after checksumming is not checked
+	dir.write("f", data + "more");
+	EXPECT_EQ(4, file->read(buf, 100, 10000));
+}
+
+TEST(ChecksumTest, scrub_finds_damaged_blocks) {
+	TempDir dir;
+	vector<shared_ptr<BackingFile>> files;
+	vector<string> data;
+	for(int i = 0; i < 3; ++i) {
+		data.push_back(randomData(64 << 10, 10 + i));
+		files.push_back(BackingFile::open(dir.write(to_string(i), data[i])));
+		files[i]->attachChecksums(BlockChecksums::compute(*files[i], 4096));
+	}
+	files.push_back(BackingFile::open(dir.write("unchecked", "data")));
+	data[1][40000] ^= 0x80;
+	dir.write("1", data[1]);
+
+	Scrubber::Stats stats = Scrubber(files, 0).wait();
+	EXPECT_TRUE(stats.finished);
+	EXPECT_EQ(3, stats.files);
+	EXPECT_EQ(48, stats.blocks);
+	EXPECT_EQ(3 * (64 << 10), stats.bytes);
+	EXPECT_EQ(1, stats.damaged);
+	EXPECT_EQ(0, stats.errors);
+	EXPECT_EQ(15, files[1]->checksums()->verifiedCount());
+}
+
+TEST(ChecksumTest, scrub_is_throttled) {
+	TempDir dir;
+	shared_ptr<BackingFile> file = BackingFile::open(dir.write("f", randomData(64 << 10, 3)));
+	file->attachChecksums(BlockChecksums::compute(*file, 4096));
+
+	// At 256 KiB/s, 64 KiB takes a quarter of a second
+	auto start = chrono::steady_clock::now();
+	Scrubber(vector<shared_ptr<BackingFile>>{file}, 256 << 10).wait();
+	EXPECT_GE(chrono::steady_clock::now() - start, chrono::milliseconds(200));
+
+	// Destroying a scrub stops it
+	start = chrono::steady_clock::now();
+	{
+		Scrubber scrubber({file}, 1024);
+	}
+	EXPECT_LT(chrono::steady_clock::now() - start, chrono::seconds(1));
+}
@@ -0,0 +1,97 @@
+/*
+ * ChunkerTest.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "gtest/gtest.h"
+
+#include "smfs/Chunker.h"
+#include "TempDir.h"
+
+#include <fusepp/common.hpp>
+
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace smfs;
+using namespace std;
+
+static string randomData(size_t length, unsigned seed) {
+	mt19937_64 random(seed);
+	string rc(length, '\0');
+	for(char &c : rc) {
+		c = static_cast<char>(random());
+	}
+	return rc;
+}
+
+/**
+ * Divides data held in memory into chunks.
+ */
+static vector<off_t> chunk(Chunker const & chunker, string const & data) {
+	vector<off_t> rc;
+	unsigned char const * bytes = reinterpret_cast<unsigned char const *>(data.data());
+	for(size_t start = 0; start < data.size();) {
+		start += chunker.cut(bytes + start, data.size() - start);
+		rc.push_back(start);
+	}
+	return rc;
+}
+
+TEST(ChunkerTest, chunk_sizes_are_bounded) {
+	Chunker chunker(4096);
+	EXPECT_EQ(1024, chunker.min());
+	EXPECT_EQ(32768, chunker.max());
+
+	string data = randomData(1 << 20, 1);
+	vector<off_t> ends = chunk(chunker, data);
+	off_t start = 0;
+	for(size_t i = 0; i < ends.size(); ++i) {
+		off_t length = ends[i] - start;
+		EXPECT_LE(length, 32768);
+		if(i + 1 < ends.size()) {
+			EXPECT_GE(length, 1024);
+		}
+		start = ends[i];
+	}
+	double average = double(data.size()) / ends.size();
+	EXPECT_GT(average, 2048);
+	EXPECT_LT(average, 8192);
+}
+
+TEST(ChunkerTest, boundaries_follow_content) {
+	Chunker chunker(4096);
+	string data = randomData(1 << 20, 2);
+	string edited = data.substr(0, 100) + "inserted" + data.substr(100);
+
+	vector<off_t> before = chunk(chunker, data);
+	set<off_t> after;
+	for(off_t end : chunk(chunker, edited)) {
+		after.insert(end - 8);
+	}
+	size_t kept = 0;
+	for(off_t end : before) {
+		kept += after.count(end);
+	}
+	EXPECT_GE(kept, before.size() - 2);
+}
+
+TEST(ChunkerTest, divides_files_as_in_memory) {
+	TempDir dir;
+	Chunker chunker(1024);
+	string data = randomData(5 << 20, 3);
+	shared_ptr<BackingFile> file = BackingFile::open(dir.write("f", data));
+	EXPECT_EQ(chunk(chunker, data), chunker.boundaries(*file));
+
+	shared_ptr<BackingFile> empty = BackingFile::open(dir.write("empty", ""));
+	EXPECT_TRUE(chunker.boundaries(*empty).empty());
+}
+
+TEST(ChunkerTest, rejects_unsupported_sizes) {
+	EXPECT_THROW(Chunker(100), fusepp::fuse_error);
+	EXPECT_EQ(8192, Chunker(10000).average());
+}
@@ -0,0 +1,230 @@
+/*
+ * CompressedFileTest.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "gtest/gtest.h"
+
+#include "smfs/BlockCache.h"
+#include "smfs/CompressedFile.h"
+#include "smfs/Lz4.h"
+#include "smfs/ThreadPool.h"
+#include "TempDir.h"
+
+#include <fusepp/common.hpp>
+
+#include <atomic>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace smfs;
+using namespace std;
+
+static string randomData(size_t length, unsigned seed) {
+	mt19937_64 random(seed);
+	string rc(length, '\0');
+	for(char &c : rc) {
+		c = static_cast<char>(random());
+	}
+	return rc;
+}
+
+/**
+ * Generates something like a log file, which compresses well but not
+ * trivially.
+ */
+static string logData(size_t length, unsigned seed) {
+	static char const * const levels[] = {"INFO", "WARN", "DEBUG", "ERROR"};
+	mt19937_64 random(seed);
+	string rc;
+	while(rc.size() < length) {
+		rc += "2026-10-19T12:" + to_string(random() % 60) + ":" + to_string(random() % 60) + " "
+				+ levels[random() % 4] + " request id=" + to_string(random() % 100000)
+				+ " served in " + to_string(random() % 1000) + "ms\n";
+	}
+	rc.resize(length);
+	return rc;
+}
+
+static string roundTrip(string const & data) {
+	string packed(lz4::bound(data.size()), '\0');
+	size_t n = lz4::compress(data.data(), data.size(), &packed[0], packed.size());
+	EXPECT_NE(0u, n);
+	string rc(data.size(), '\0');
+	EXPECT_EQ(data.size(), lz4::decompress(packed.data(), n, &rc[0], rc.size()));
+	return rc;
+}
+
+TEST(CompressedFileTest, lz4_round_trips) {
+	EXPECT_EQ("", roundTrip(""));
+	EXPECT_EQ("a", roundTrip("a"));
+	EXPECT_EQ("hello, world", roundTrip("hello, world"));
+	string random = randomData(100000, 1);
+	EXPECT_EQ(random, roundTrip(random));
+	string zeros(1 << 20, '\0');
+	EXPECT_EQ(zeros, roundTrip(zeros));
+	string log = logData(200000, 2);
+	EXPECT_EQ(log, roundTrip(log));
+
+	// Repetitive data compresses, and does not fit in less than it needs
+	string packed(lz4::bound(log.size()), '\0');
+	size_t n = lz4::compress(log.data(), log.size(), &packed[0], packed.size());
+	EXPECT_LT(n, log.size() / 2);
+	EXPECT_EQ(0u, lz4::compress(log.data(), log.size(), &packed[0], n - 1));
+	EXPECT_EQ(0u, lz4::compress(random.data(), random.size(), &packed[0], random.size() - 1));
+}
+
+TEST(CompressedFileTest, lz4_rejects_malformed_input) {
+	string log = logData(10000, 3);
+	string packed(lz4::bound(log.size()), '\0');
+	packed.resize(lz4::compress(log.data(), log.size(), &packed[0], packed.size()));
+	string out(log.size(), '\0');
+
+	// Too little room for the output
+	EXPECT_THROW(lz4::decompress(packed.data(), packed.size(), &out[0], out.size() - 1), fusepp::fuse_error);
+	// Cut short in the middle of a sequence
+	EXPECT_THROW(lz4::decompress(packed.data(), 2, &out[0], out.size()), fusepp::fuse_error);
+	// A match reaching back before the start
+	string bad{'\x10', 'a', '\x10', '\x00'};
+	EXPECT_THROW(lz4::decompress(bad.data(), bad.size(), &out[0], out.size()), fusepp::fuse_error);
+	// Garbage either throws or decompresses to something bounded
+	for(unsigned seed = 0; seed < 100; ++seed) {
+		string garbage = randomData(200, seed);
+		try {
+			EXPECT_LE(lz4::decompress(garbage.data(), garbage.size(), &out[0], out.size()), out.size());
+		} catch(fusepp::fuse_error const & e) {
+			EXPECT_EQ(EIO, e.error);
+		}
+	}
+}
+
+TEST(CompressedFileTest, reads_any_range) {
+	TempDir dir;
+	// Mix compressible and incompressible blocks, with a short last block
+	string data = logData(100000, 4) + randomData(20000, 5) + logData(50000, 6);
+	shared_ptr<BackingFile> source = BackingFile::open(dir.write("plain", data));
+	CompressedFile::compress(*source, dir.path + "/packed", 4096);
+
+	shared_ptr<CompressedFile> file = CompressedFile::open(dir.path + "/packed");
+	EXPECT_EQ(static_cast<off_t>(data.size()), file->size());
+	EXPECT_EQ(4096u, file->blockSize());
+	EXPECT_EQ((data.size() + 4095) / 4096, file->blockCount());
+	EXPECT_LT(file->compressedSize(), static_cast<off_t>(data.size()) / 2);
+	EXPECT_FALSE(file->hasRawDescriptor());
+
+	mt19937_64 random(7);
+	for(int i = 0; i < 500; ++i) {
+		off_t offset = random() % data.size();
+		size_t length = random() % 20000;
+		string got(length, '\0');
+		size_t n = file->read(&got[0], length, offset);
+		got.resize(n);
+		EXPECT_EQ(data.substr(offset, length), got) << offset << " " << length;
+	}
+	string all(data.size() + 100, '\0');
+	EXPECT_EQ(data.size(), file->read(&all[0], all.size(), 0));
+	all.resize(data.size());
+	EXPECT_EQ(data, all);
+	EXPECT_EQ(0u, file->read(&all[0], 10, data.size()));
+}
+
+TEST(CompressedFileTest, opens_plain_and_compressed_files) {
+	TempDir dir;
+	string data = logData(30000, 8);
+	shared_ptr<BackingFile> source = BackingFile::open(dir.write("plain", data));
+	CompressedFile::compress(*source, dir.path + "/packed");
+	CompressedFile::compress(*BackingFile::open(dir.write("empty", "")), dir.path + "/empty.lz4");
+
+	shared_ptr<BackingFile> plain = CompressedFile::openAny(dir.path + "/plain");
+	EXPECT_TRUE(plain->hasRawDescriptor());
+	shared_ptr<BackingFile> packed = CompressedFile::openAny(dir.path + "/packed");
+	EXPECT_FALSE(packed->hasRawDescriptor());
+	EXPECT_EQ(static_cast<off_t>(data.size()), packed->size());
+	shared_ptr<BackingFile> empty = CompressedFile::openAny(dir.path + "/empty.lz4");
+	EXPECT_EQ(0, empty->size());
+
+	try {
+		CompressedFile::open(dir.path + "/plain");
+		FAIL();
+	} catch(fusepp::fuse_error const & e) {
+		EXPECT_EQ(EINVAL, e.error);
+	}
+}
+
+TEST(CompressedFileTest, damaged_blocks_fail_with_eio) {
+	TempDir dir;
+	string data = logData(50000, 9);
+	shared_ptr<BackingFile> source = BackingFile::open(dir.write("plain", data));
+	CompressedFile::compress(*source, dir.path + "/packed", 4096);
+
+	// Overwrite the middle of the compressed blocks
+	int fd = ::open((dir.path + "/packed").c_str(), O_WRONLY);
+	string junk(64, '\xff');
+	ASSERT_EQ(64, ::pwrite(fd, junk.data(), junk.size(), 2000));
+	::close(fd);
+
+	shared_ptr<CompressedFile> file = CompressedFile::open(dir.path + "/packed");
+	string all(data.size(), '\0');
+	try {
+		file->read(&all[0], all.size(), 0);
+		FAIL();
+	} catch(fusepp::fuse_error const & e) {
+		EXPECT_EQ(EIO, e.error);
+	}
+	// Blocks beyond the damage still read
+	string tail(1000, '\0');
+	EXPECT_EQ(1000u, file->read(&tail[0], 1000, 40000));
+	EXPECT_EQ(data.substr(40000, 1000), tail);
+}
+
+TEST(CompressedFileTest, caches_decompressed_blocks) {
+	TempDir dir;
+	string data = logData(300000, 10);
+	shared_ptr<BackingFile> source = BackingFile::open(dir.write("plain", data));
+	CompressedFile::compress(*source, dir.path + "/packed", 4096);
+	shared_ptr<CompressedFile> file = CompressedFile::open(dir.path + "/packed");
+
+	BlockCache cache(1 << 20, 16384);
+	for(int pass = 0; pass < 2; ++pass) {
+		string got;
+		cache.read(*file, 1000, 200000, [&](shared_ptr<Block> block, size_t inBlock, size_t n) {
+			got.append(block->data() + inBlock, n);
+		});
+		EXPECT_EQ(data.substr(1000, 200000), got);
+	}
+	BlockCache::Stats stats = cache.stats();
+	EXPECT_EQ(stats.misses, stats.hits);
+}
+
+TEST(CompressedFileTest, thread_pool_runs_every_index_once) {
+	ThreadPool pool(3);
+	vector<atomic<int>> counts(1000);
+	pool.parallelFor(counts.size(), [&](size_t i) {
+		++counts[i];
+	});
+	for(atomic<int> const & count : counts) {
+		EXPECT_EQ(1, count.load());
+	}
+
+	atomic<int> ran{0};
+	EXPECT_THROW(pool.parallelFor(1000, [&](size_t i) {
+		++ran;
+		if(i == 10) {
+			throw runtime_error("failed");
+		}
+	}), runtime_error);
+	EXPECT_LE(ran.load(), 1000);
+
+	// Nested calls complete even when every worker is busy
+	atomic<int> inner{0};
+	pool.parallelFor(8, [&](size_t) {
+		pool.parallelFor(8, [&](size_t) {
+			++inner;
+		});
+	});
+	EXPECT_EQ(64, inner.load());
+}
@@ -0,0 +1,193 @@
+/*
+ * DedupStoreTest.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "gtest/gtest.h"
+
+#include "smfs/BlockCache.h"
+#include "smfs/DedupStore.h"
+#include "smfs/MergedFile.h"
+#include "TempDir.h"
+
+#include <fusepp/common.hpp>
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace smfs;
+using namespace std;
+
+static string randomData(size_t length, unsigned seed) {
+	mt19937_64 random(seed);
+	string rc(length, '\0');
+	for(char &c : rc) {
+		c = static_cast<char>(random());
+	}
+	return rc;
+}
+
+/**
+ * Reads a whole merged file through its block cache.
+ */
+static string readAll(MergedFile const & file) {
+	string rc;
+	file.forEachExtent(0, file.size(), [&](Segment const & segment, off_t inSegment, size_t length) {
+		file.cache()->read(*segment.file, segment.offset + inSegment, length,
+				[&](shared_ptr<Block> block, size_t inBlock, size_t n) {
+			rc.append(block->data() + inBlock, n);
+		});
+	});
+	return rc;
+}
+
+static string sha256(string const & data) {
+	return Sha256::hex(Sha256::of(data.data(), data.size()));
+}
+
+TEST(DedupStoreTest, sha256_matches_known_digests) {
+	EXPECT_EQ("e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855", sha256(""));
+	EXPECT_EQ("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad", sha256("abc"));
+	EXPECT_EQ("248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1",
+			sha256("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"));
+	EXPECT_EQ("cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0", sha256(string(1000000, 'a')));
+
+	// Feeding data in pieces gives the same digest
+	string data = randomData(1000, 1);
+	Sha256 sha;
+	for(size_t i = 0; i < data.size(); i += 7) {
+		sha.update(data.data() + i, min<size_t>(7, data.size() - i));
+	}
+	EXPECT_EQ(sha256(data), Sha256::hex(sha.finish()));
+}
+
+TEST(DedupStoreTest, shares_identical_segments) {
+	TempDir dir;
+	string data = randomData(100000, 2);
+	shared_ptr<BackingFile> a = BackingFile::open(dir.write("a", data));
+	shared_ptr<BackingFile> b = BackingFile::open(dir.write("b", data + "tail"));
+	DedupStore store;
+
+	vector<Segment> first = store.intern({Segment{a, 0, data.size()}});
+	vector<Digest> digests;
+	vector<Segment> second = store.intern({Segment{b, 0, data.size()}, Segment{b, off_t(data.size()), 4}}, &digests);
+	ASSERT_EQ(2, second.size());
+	EXPECT_EQ(a, second[0].file);
+	EXPECT_EQ(0, second[0].offset);
+	EXPECT_EQ(b, second[1].file);
+
+	DedupStore::Stats stats = store.stats();
+	EXPECT_EQ(2, stats.unique);
+	EXPECT_EQ(3, stats.references);
+	EXPECT_EQ(data.size(), stats.savedBytes());
+
+	// Reads of either file now share cached blocks
+	shared_ptr<BlockCache> cache = make_shared<BlockCache>(1 << 20, 4096);
+	MergedFile one(first, cache);
+	MergedFile two(second, cache);
+	EXPECT_EQ(data, readAll(one));
+	EXPECT_EQ(data + "tail", readAll(two));
+	size_t blocks = (data.size() + 4095) / 4096;
+	EXPECT_EQ(blocks, cache->stats().hits);
+	EXPECT_EQ(blocks + 1, cache->stats().misses);
+}
+
+TEST(DedupStoreTest, finds_shared_chunks_within_segments) {
+	TempDir dir;
+	string common = randomData(200000, 3);
+	string one = "header" + common;
+	string two = "a different header" + common;
+	shared_ptr<BackingFile> a = BackingFile::open(dir.write("a", one));
+	shared_ptr<BackingFile> b = BackingFile::open(dir.write("b", two));
+	DedupStore store(Chunker(4096));
+
+	store.intern({Segment{a, 0, one.size()}});
+	vector<Segment> second = store.intern({Segment{b, 0, two.size()}});
+
+	size_t length = 0;
+	size_t shared = 0;
+	for(Segment const & segment : second) {
+		length += segment.length;
+		if(segment.file == a) {
+			shared += segment.length;
+		}
+	}
+	EXPECT_EQ(two.size(), length);
+	EXPECT_GT(shared, common.size() - 2 * 32768);
+	EXPECT_EQ(shared, store.stats().savedBytes());
+}
+
+TEST(DedupStoreTest, releases_contents_with_the_last_reference) {
+	TempDir dir;
+	shared_ptr<BackingFile> a = BackingFile::open(dir.write("a", "contents"));
+	DedupStore store;
+	vector<Digest> digests;
+	store.intern({Segment{a, 0, 8}}, &digests);
+	store.intern({Segment{a, 0, 8}}, &digests);
+	ASSERT_EQ(2, digests.size());
+	EXPECT_EQ(digests[0], digests[1]);
+
+	store.release(digests[0]);
+	EXPECT_TRUE(store.find(digests[0]).has_value());
+	store.release(digests[1]);
+	EXPECT_FALSE(store.find(digests[0]).has_value());
+
+	DedupStore::Stats stats = store.stats();
+	EXPECT_EQ(0, stats.unique);
+	EXPECT_EQ(0, stats.references);
+	EXPECT_EQ(0, stats.logicalBytes);
+}
+
+TEST(DedupStoreTest, moves_contents_no_longer_at_their_canonical_location) {
+	TempDir dir;
+	string data = randomData(10000, 4);
+	shared_ptr<BackingFile> a = BackingFile::open(dir.write("a", data));
+	shared_ptr<BackingFile> b = BackingFile::open(dir.write("b", data));
+	DedupStore store;
+	store.intern({Segment{a, 0, data.size()}});
+
+	// Rewritten in place, behind the store's back
+	dir.write("a", randomData(10000, 5));
+	vector<Segment> second = store.intern({Segment{b, 0, data.size()}});
+	ASSERT_EQ(1, second.size());
+	EXPECT_EQ(b, second[0].file);
+	EXPECT_EQ(1, store.stats().relocated);
+	EXPECT_EQ(2, store.stats().references);
+
+	EXPECT_EQ(b, store.intern({Segment{b, 0, data.size()}})[0].file);
+	EXPECT_EQ(1, store.stats().relocated);
+}
+
+TEST(DedupStoreTest, takes_no_references_when_interning_fails) {
+	TempDir dir;
+	shared_ptr<BackingFile> a = BackingFile::open(dir.write("a", "contents"));
+	DedupStore store;
+	vector<Digest> digests;
+	EXPECT_THROW(store.intern({Segment{a, 0, 8}, Segment{a, 4, 8}}, &digests), fusepp::fuse_error);
+	EXPECT_TRUE(digests.empty());
+	EXPECT_EQ(0, store.stats().references);
+	EXPECT_EQ(0, store.stats().unique);
+}
+
+TEST(DedupStoreTest, files_hold_references_until_edited) {
+	TempDir dir;
+	shared_ptr<BackingFile> a = BackingFile::open(dir.write("a", "contents"));
+	shared_ptr<DedupStore> store = make_shared<DedupStore>();
+	vector<Digest> digests;
+	MergedFile one(store->intern({Segment{a, 0, 8}}, &digests));
+	one.hold(DedupStore::References(store, digests));
+	digests.clear();
+	{
+		MergedFile two(store->intern({Segment{a, 0, 8}}, &digests));
+		two.hold(DedupStore::References(store, digests));
+		EXPECT_EQ(2, store->stats().references);
+	}
+	EXPECT_EQ(1, store->stats().references);
+
+	one.truncate(4);
+	EXPECT_EQ(0, store->stats().references);
+	EXPECT_EQ(0, store->stats().unique);
+}
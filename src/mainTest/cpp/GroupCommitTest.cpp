@@ -0,0 +1,142 @@
+/*
+ * GroupCommitTest.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "gtest/gtest.h"
+
+#include "smfs/DeltaLog.h"
+#include "smfs/GroupCommit.h"
+#include "smfs/MergedFile.h"
+#include "smfs/ThreadPool.h"
+#include "TempDir.h"
+
+#include <fusepp/common.hpp>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C" {
+	#include <sys/stat.h>
+	#include <unistd.h>
+}
+
+using namespace smfs;
+using namespace std;
+
+class GroupCommitTest : public ::testing::Test {
+public:
+	TempDir dir;
+	ThreadPool pool{4};
+
+	vector<shared_ptr<BackingFile>> files(size_t count) {
+		vector<shared_ptr<BackingFile>> rc;
+		for(size_t i = 0; i < count; ++i) {
+			rc.push_back(BackingFile::open(dir.write("f" + to_string(i), "data"), O_RDWR));
+		}
+		return rc;
+	}
+};
+
+TEST_F(GroupCommitTest, syncs_each_file_once) {
+	GroupCommit commits(GroupCommit::defaultSyncfsThreshold, &pool);
+	vector<shared_ptr<BackingFile>> some = files(3);
+	some.push_back(some[0]);
+	commits.sync(some);
+	commits.sync({});
+
+	GroupCommit::Stats stats = commits.stats();
+	EXPECT_EQ(1, stats.requests);
+	EXPECT_EQ(1, stats.rounds);
+	EXPECT_EQ(3, stats.fileSyncs);
+	EXPECT_EQ(0, stats.filesystemSyncs);
+}
+
+TEST_F(GroupCommitTest, syncs_the_filesystem_of_many_files) {
+	GroupCommit commits(3, &pool);
+	commits.sync(files(2));
+	EXPECT_EQ(2, commits.stats().fileSyncs);
+
+	commits.sync(files(3));
+	EXPECT_EQ(2, commits.stats().fileSyncs);
+	EXPECT_EQ(1, commits.stats().filesystemSyncs);
+}
+
+TEST_F(GroupCommitTest, merges_concurrent_requests_into_rounds) {
+	GroupCommit commits(GroupCommit::defaultSyncfsThreshold, &pool);
+	vector<shared_ptr<BackingFile>> all = files(8);
+	vector<thread> threads;
+	for(size_t t = 0; t < all.size(); ++t) {
+		threads.emplace_back([&, t]() {
+			for(int i = 0; i < 20; ++i) {
+				commits.sync({all[t]});
+			}
+		});
+	}
+	for(thread & t : threads) {
+		t.join();
+	}
+
+	GroupCommit::Stats stats = commits.stats();
+	EXPECT_EQ(160, stats.requests);
+	EXPECT_LE(stats.rounds, stats.requests);
+	EXPECT_GE(stats.fileSyncs, stats.rounds);
+	EXPECT_LE(stats.fileSyncs, stats.requests);
+}
+
+TEST_F(GroupCommitTest, fails_everyone_in_a_round_that_fails) {
+	GroupCommit commits(GroupCommit::defaultSyncfsThreshold, &pool);
+	string fifo = dir.path + "/fifo";
+	ASSERT_EQ(0, ::mkfifo(fifo.c_str(), 0644));
+	// A pipe cannot be synced
+	vector<shared_ptr<BackingFile>> some = files(2);
+	some.push_back(BackingFile::open(fifo, O_RDWR));
+	EXPECT_THROW(commits.sync(some), fusepp::fuse_error);
+
+	// The next round is unaffected
+	commits.sync(files(1));
+	EXPECT_EQ(2, commits.stats().rounds);
+}
+
+TEST_F(GroupCommitTest, syncs_the_journals_of_merged_files) {
+	GroupCommit commits(GroupCommit::defaultSyncfsThreshold, &pool);
+	shared_ptr<BackingFile> data = BackingFile::open(dir.write("data", "0123456789"));
+	string journalPath = dir.path + "/journal";
+	shared_ptr<Journal> journal = make_shared<Journal>(journalPath, 0);
+	DeltaLog log(dir.path);
+	vector<shared_ptr<MergedFile const>> merged;
+	for(int i = 0; i < 2; ++i) {
+		shared_ptr<MergedFile> file = make_shared<MergedFile>(vector<Segment>{{data, 0, 10}});
+		file->attach(journal, "/f" + to_string(i), 0);
+		file->write(log, "x", 1, 0);
+		merged.push_back(file);
+	}
+	merged.push_back(merged[0]);
+	EXPECT_EQ(0, BackingFile::open(journalPath)->size());
+
+	commits.sync({log.backing()}, merged);
+	EXPECT_GT(BackingFile::open(journalPath)->size(), 0);
+	EXPECT_EQ(1, commits.stats().rounds);
+	EXPECT_EQ(2, commits.stats().journalSyncs);
+}
+
+TEST_F(GroupCommitTest, fails_everyone_in_a_round_whose_journal_fails) {
+	if(::access("/dev/full", W_OK) != 0) {
+		// Nothing here fails writes for the journal
+		return;
+	}
+	GroupCommit commits(GroupCommit::defaultSyncfsThreshold, &pool);
+	shared_ptr<BackingFile> data = BackingFile::open(dir.write("data", "0123456789"));
+	shared_ptr<MergedFile> file = make_shared<MergedFile>(vector<Segment>{{data, 0, 10}});
+	file->attach(make_shared<Journal>("/dev/full", 0), "/f", 0);
+	DeltaLog log(dir.path);
+	file->write(log, "x", 1, 0);
+	EXPECT_THROW(commits.sync({log.backing()}, {file}), fusepp::fuse_error);
+
+	// The next round is still committed
+	commits.sync(files(1));
+	EXPECT_EQ(2, commits.stats().rounds);
+}
@@ -0,0 +1,101 @@
+/*
+ * InvalidatorTest.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "gtest/gtest.h"
+
+#include "smfs/Invalidator.h"
+
+#include <fusepp/common.hpp>
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace smfs;
+using namespace std;
+
+class InvalidatorTest : public ::testing::Test {
+public:
+	mutex lock;
+	condition_variable released;
+	bool blocked = false;
+	bool entered = false;
+	vector<tuple<string, bool, off_t, off_t>> passed;
+
+	Invalidator::Sink recorder() {
+		return [this](Invalidator::Change const & change) {
+			unique_lock<mutex> guard(lock);
+			entered = true;
+			released.notify_all();
+			released.wait(guard, [this]() { return !blocked; });
+			if(change.path == "/uncached") {
+				throw fusepp::fuse_error(ENOENT);
+			}
+			if(change.path == "/broken") {
+				throw fusepp::fuse_error(EIO);
+			}
+			passed.emplace_back(change.path, change.entry, change.offset, change.length);
+		};
+	}
+
+	void block() {
+		lock_guard<mutex> guard(lock);
+		blocked = true;
+	}
+
+	void waitForSink() {
+		unique_lock<mutex> guard(lock);
+		released.wait(guard, [this]() { return entered; });
+	}
+
+	void release() {
+		{
+			lock_guard<mutex> guard(lock);
+			blocked = false;
+		}
+		released.notify_all();
+	}
+};
+
+TEST_F(InvalidatorTest, passes_on_changes_in_order) {
+	Invalidator invalidator(recorder());
+	invalidator.changed("/a", 10, 5);
+	invalidator.added("/b");
+	invalidator.changed("/uncached", 0, 0);
+	invalidator.changed("/broken", 0, 0);
+	Invalidator::Stats stats = invalidator.wait();
+
+	vector<tuple<string, bool, off_t, off_t>> expected{{"/a", false, 10, 5}, {"/b", true, 0, 0}};
+	EXPECT_EQ(expected, passed);
+	EXPECT_EQ(4, stats.changes);
+	EXPECT_EQ(2, stats.notifications);
+	EXPECT_EQ(1, stats.uncached);
+	EXPECT_EQ(1, stats.errors);
+}
+
+TEST_F(InvalidatorTest, merges_changes_to_the_same_file_while_pending) {
+	Invalidator invalidator(recorder());
+	block();
+	// The first change is passed on, and holds up the rest while they are reported
+	invalidator.changed("/first", 0, 1);
+	waitForSink();
+	invalidator.changed("/a", 10, 5);
+	invalidator.changed("/b", 0, 1);
+	invalidator.changed("/a", 30, 2);
+	invalidator.added("/a");
+	invalidator.changed("/b", 5, 0);
+	release();
+	Invalidator::Stats stats = invalidator.wait();
+
+	vector<tuple<string, bool, off_t, off_t>> expected{{"/first", false, 0, 1},
+		{"/a", false, 10, 22}, {"/b", false, 0, 0}, {"/a", true, 0, 0}};
+	EXPECT_EQ(expected, passed);
+	EXPECT_EQ(6, stats.changes);
+	EXPECT_EQ(2, stats.merged);
+}
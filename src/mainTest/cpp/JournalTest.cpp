@@ -0,0 +1,190 @@
+/*
+ * JournalTest.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "gtest/gtest.h"
+
+#include "smfs/Journal.h"
+#include "smfs/ManifestStore.h"
+#include "TempDir.h"
+
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C" {
+	#include <sys/stat.h>
+	#include <unistd.h>
+}
+
+using namespace smfs;
+using namespace std;
+
+static string contents(MergedFile const & file) {
+	string out;
+	file.forEachExtent(0, file.size(), [&](Segment const & segment, off_t inSegment, size_t length) {
+		string buf(length, '\0');
+		segment.file->read(&buf[0], length, segment.offset + inSegment);
+		out += buf;
+	});
+	return out;
+}
+
+static off_t fileSize(string const & path) {
+	struct stat statbuf;
+	return ::stat(path.c_str(), &statbuf) == 0 ? statbuf.st_size : -1;
+}
+
+static void copyFile(string const & from, string const & to) {
+	ASSERT_EQ(0, ::system(("cp " + from + " " + to).c_str()));
+}
+
+class JournalTest : public ::testing::Test {
+public:
+	TempDir dir;
+	shared_ptr<BackingFile> a = BackingFile::open(dir.write("a", "0123456789"));
+	shared_ptr<BackingFile> b = BackingFile::open(dir.write("b", "abcdefghij"));
+	string journalPath = dir.path + "/journal";
+
+	vector<JournalRecord> replay(string const & path) {
+		vector<JournalRecord> records;
+		Journal::replay(path, [](string const & p) { return BackingFile::open(p); },
+				[&](JournalRecord const & record) { records.push_back(record); });
+		return records;
+	}
+
+	map<string, string> recover(string const & path) {
+		ManifestStore store(path);
+		map<string, string> rc;
+		for(auto const & entry : store.recover()) {
+			rc[entry.first] = contents(*entry.second);
+		}
+		return rc;
+	}
+};
+
+TEST_F(JournalTest, replays_synced_records) {
+	{
+		Journal journal(journalPath, 10);
+		EXPECT_EQ(11, journal.append(JournalRecord::create, "/f", 0, 0, SegmentTree({{a, 0, 4}, {b, 2, 2}})));
+		EXPECT_EQ(12, journal.append(JournalRecord::splice, "/f", 1, 2, SegmentTree({{b, 5, 1}})));
+		journal.sync(12);
+		EXPECT_EQ(12, journal.sequence());
+	}
+
+	vector<JournalRecord> records = replay(journalPath);
+	ASSERT_EQ(2, records.size());
+	EXPECT_EQ(JournalRecord::create, records[0].kind);
+	EXPECT_EQ(11, records[0].sequence);
+	EXPECT_EQ("/f", records[0].path);
+	ASSERT_EQ(2, records[0].segments.size());
+	EXPECT_EQ(a->path, records[0].segments[0].file->path);
+	EXPECT_EQ(b->path, records[0].segments[1].file->path);
+	EXPECT_EQ(2, records[0].segments[1].offset);
+
+	EXPECT_EQ(JournalRecord::splice, records[1].kind);
+	EXPECT_EQ(1, records[1].offset);
+	EXPECT_EQ(2, records[1].length);
+	ASSERT_EQ(1, records[1].segments.size());
+	EXPECT_EQ(5, records[1].segments[0].offset);
+}
+
+TEST_F(JournalTest, discards_torn_records) {
+	{
+		Journal journal(journalPath, 0);
+		journal.append(JournalRecord::create, "/f", 0, 0, SegmentTree({{a, 0, 4}}));
+		journal.sync(journal.append(JournalRecord::splice, "/f", 0, 1, SegmentTree()));
+	}
+	off_t size = fileSize(journalPath);
+	ASSERT_EQ(0, ::truncate(journalPath.c_str(), size - 1));
+
+	EXPECT_EQ(1, replay(journalPath).size());
+	EXPECT_LT(fileSize(journalPath), size - 1);
+	EXPECT_EQ(1, replay(journalPath).size());
+}
+
+TEST_F(JournalTest, commits_concurrent_syncs_together) {
+	Journal journal(journalPath, 0);
+	vector<thread> threads;
+	for(int t = 0; t < 8; ++t) {
+		threads.emplace_back([&]() {
+			for(int i = 0; i < 100; ++i) {
+				journal.sync(journal.append(JournalRecord::splice, "/f", i, 1, SegmentTree()));
+			}
+		});
+	}
+	for(thread &t : threads) {
+		t.join();
+	}
+	EXPECT_EQ(800, journal.sequence());
+	EXPECT_EQ(800, replay(journalPath).size());
+}
+
+TEST_F(JournalTest, store_recovers_files_and_edits) {
+	string store = dir.path + "/store";
+	ASSERT_EQ(0, ::mkdir(store.c_str(), 0755));
+	{
+		ManifestStore s(store);
+		EXPECT_TRUE(s.recover().empty());
+		shared_ptr<MergedFile> f = s.create("/f", {{a, 0, 10}});
+		shared_ptr<MergedFile> g = s.create("/g", {{b, 0, 10}});
+		f->sync();
+		f->cut(2, 3);
+		f->append(*g);
+		g->truncate(4);
+	}
+	map<string, string> expected{{"/f", "0156789abcdefghij"}, {"/g", "abcd"}};
+	EXPECT_EQ(expected, recover(store));
+
+	// Recovering again starts another journal, but replays the same edits
+	EXPECT_EQ(expected, recover(store));
+}
+
+TEST_F(JournalTest, store_compacts_into_manifest) {
+	string store = dir.path + "/store";
+	ASSERT_EQ(0, ::mkdir(store.c_str(), 0755));
+	{
+		ManifestStore s(store);
+		ManifestStore::Files files = s.recover();
+		files.emplace_back("/f", s.create("/f", {{a, 0, 10}}));
+		files.back().second->cut(0, 2);
+		EXPECT_GT(s.journalSize(), 0);
+
+		// Keep the journal as it was before compaction, as if a crash had
+		// happened before it was deleted
+		copyFile(store + "/journal.1", dir.path + "/old");
+		s.compact(files);
+		EXPECT_EQ(-1, fileSize(store + "/journal.1"));
+		EXPECT_EQ(0, s.journalSize());
+		copyFile(dir.path + "/old", store + "/journal.1");
+
+		files.back().second->cut(0, 2);
+		files.emplace_back("/g", s.create("/g", {{b, 0, 3}}));
+		files.back().second->sync();
+	}
+	map<string, string> expected{{"/f", "456789"}, {"/g", "abc"}};
+	EXPECT_EQ(expected, recover(store));
+}
+
+TEST_F(JournalTest, store_compacts_in_background) {
+	string store = dir.path + "/store";
+	ASSERT_EQ(0, ::mkdir(store.c_str(), 0755));
+	{
+		ManifestStore s(store, 1024);
+		ManifestStore::Files files = s.recover();
+		files.emplace_back("/f", s.create("/f", {{a, 0, 10}}));
+		s.startCompactor([&]() { return files; });
+		for(int i = 0; i < 200; ++i) {
+			files.back().second->copyFrom(*files.back().second, i % 10, 0, 1);
+		}
+		for(int i = 0; i < 100 && s.journalSize() >= 1024; ++i) {
+			this_thread::sleep_for(chrono::milliseconds(20));
+		}
+		EXPECT_LT(s.journalSize(), 1024);
+	}
+	EXPECT_EQ(10, recover(store)["/f"].size());
+}
@@ -0,0 +1,190 @@
+/*
+ * ManifestTest.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "gtest/gtest.h"
+
+#include "smfs/Manifest.h"
+#include "smfs/MergedFile.h"
+#include "TempDir.h"
+
+#include <fusepp/common.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace smfs;
+using namespace std;
+
+static string contents(MergedFile const & file, off_t offset, size_t nbytes) {
+	string out;
+	file.forEachExtent(offset, nbytes, [&](Segment const & segment, off_t inSegment, size_t length) {
+		string buf(length, '\0');
+		segment.file->read(&buf[0], length, segment.offset + inSegment);
+		out += buf;
+	});
+	return out;
+}
+
+class ManifestTest : public ::testing::Test {
+public:
+	TempDir dir;
+	string data;
+	shared_ptr<BackingFile> a;
+	shared_ptr<BackingFile> b;
+	string manifestPath = dir.path + "/manifest";
+
+	ManifestTest() {
+		for(int i = 0; i < 1000; ++i) {
+			data += to_string(i % 10);
+		}
+		a = BackingFile::open(dir.write("a", data));
+		b = BackingFile::open(dir.write("b", "abcdefghij"));
+	}
+
+	/**
+	 * Creates a file of many short segments, alternating between backing
+	 * files, with the expected contents.
+	 */
+	MergedFile fragmented(string &expected) {
+		vector<Segment> segments;
+		for(int i = 0; i < 500; ++i) {
+			off_t offset = (i * 7) % 990;
+			segments.push_back({a, offset, 3});
+			segments.push_back({b, i % 10, 1});
+			expected += data.substr(offset, 3) + string(1, 'a' + i % 10);
+		}
+		return MergedFile(segments);
+	}
+};
+
+TEST_F(ManifestTest, round_trips_merged_files) {
+	string expected;
+	MergedFile first = fragmented(expected);
+	MergedFile second({{b, 2, 3}, {a, 0, 10}});
+	MergedFile empty({});
+
+	ManifestWriter writer;
+	writer.add("/dir/first", first);
+	writer.add("/second", second);
+	writer.add("/empty", empty);
+	writer.write(manifestPath);
+
+	shared_ptr<Manifest const> manifest = Manifest::open(manifestPath);
+	ASSERT_EQ(3, manifest->fileCount());
+	EXPECT_EQ("/dir/first", manifest->path(0));
+	EXPECT_EQ(1000, manifest->segmentCount(0));
+	EXPECT_EQ(2000, manifest->size(0));
+	EXPECT_EQ("/empty", manifest->path(2));
+	EXPECT_EQ(0, manifest->size(2));
+
+	MergedFile mapped(manifest, 0);
+	EXPECT_EQ(expected, contents(mapped, 0, 2000));
+	EXPECT_EQ("cde0123456789", contents(MergedFile(manifest, 1), 0, 100));
+	EXPECT_EQ("", contents(MergedFile(manifest, 2), 0, 100));
+}
+
+TEST_F(ManifestTest, looks_up_ranges_from_checkpoints) {
+	string expected;
+	MergedFile file = fragmented(expected);
+	ManifestWriter writer;
+	writer.add("/file", file);
+	writer.write(manifestPath);
+
+	MergedFile mapped(Manifest::open(manifestPath), 0);
+	for(off_t offset : {0, 1, 255, 256, 257, 511, 1000, 1997, 1999}) {
+		for(size_t length : {1, 2, 5, 300}) {
+			EXPECT_EQ(expected.substr(offset, length), contents(mapped, offset, length))
+					<< "at " << offset << " for " << length;
+		}
+	}
+	EXPECT_EQ("", contents(mapped, 2000, 10));
+}
+
+TEST_F(ManifestTest, builds_tree_when_first_edited) {
+	string expected;
+	MergedFile file = fragmented(expected);
+	ManifestWriter writer;
+	writer.add("/file", file);
+	writer.write(manifestPath);
+
+	shared_ptr<Manifest const> manifest = Manifest::open(manifestPath);
+	MergedFile mapped(manifest, 0);
+	MergedFile other(manifest, 0);
+
+	EXPECT_EQ(8, mapped.copyFrom(other, 4, 0, 8));
+	EXPECT_EQ(expected.substr(4, 8) + expected.substr(8), contents(mapped, 0, 4000));
+	mapped.cut(0, 8);
+	EXPECT_EQ(expected.substr(8), contents(mapped, 0, 4000));
+	EXPECT_EQ(1992, mapped.size());
+	// The other file is unaffected
+	EXPECT_EQ(expected, contents(other, 0, 4000));
+}
+
+TEST_F(ManifestTest, rejects_invalid_manifests) {
+	ManifestWriter writer;
+	writer.add("/file", MergedFile({{a, 0, 10}}));
+	writer.write(manifestPath);
+
+	EXPECT_THROW(Manifest::open(dir.path + "/missing"), fusepp::fuse_error);
+	EXPECT_THROW(Manifest::open(dir.write("short", "SMFSMAN")), fusepp::fuse_error);
+
+	string bytes(4096, '\0');
+	int fd = ::open(manifestPath.c_str(), O_RDONLY);
+	ssize_t n = ::read(fd, &bytes[0], bytes.size());
+	::close(fd);
+	ASSERT_GT(n, sizeof(details::ManifestHeader));
+	bytes.resize(n);
+
+	string badMagic = bytes;
+	badMagic[0] = 'X';
+	EXPECT_THROW(Manifest::open(dir.write("magic", badMagic)), fusepp::fuse_error);
+
+	string badVersion = bytes;
+	badVersion[8] = 99;
+	EXPECT_THROW(Manifest::open(dir.write("version", badVersion)), fusepp::fuse_error);
+
+	EXPECT_THROW(Manifest::open(dir.write("truncated", bytes.substr(0, n - 1))), fusepp::fuse_error);
+	EXPECT_NO_THROW(Manifest::open(dir.write("copy", bytes)));
+}
+
+TEST_F(ManifestTest, opens_backing_files_on_first_use) {
+	string path = dir.write("c", "xyz");
+	shared_ptr<BackingFile> c = BackingFile::open(path);
+	ManifestWriter writer;
+	writer.add("/file", MergedFile({{c, 0, 3}}));
+	writer.write(manifestPath);
+	c.reset();
+	::unlink(path.c_str());
+
+	// The missing backing file only matters once it is read
+	shared_ptr<Manifest const> manifest = Manifest::open(manifestPath);
+	MergedFile file(manifest, 0);
+	EXPECT_EQ(3, file.size());
+	EXPECT_THROW(contents(file, 0, 3), fusepp::fuse_error);
+}
+
+TEST_F(ManifestTest, records_backing_file_checksums) {
+	a->attachChecksums(BlockChecksums::compute(*a, 256));
+	ManifestWriter writer;
+	writer.add("/file", MergedFile({{a, 0, 10}, {b, 0, 10}}));
+	writer.computeChecksums(4);
+	writer.write(manifestPath);
+
+	shared_ptr<Manifest const> manifest = Manifest::open(manifestPath);
+	shared_ptr<BlockChecksums const> sums = manifest->backing(0)->checksums();
+	ASSERT_TRUE(sums);
+	EXPECT_EQ(256, sums->blockSize());
+	EXPECT_EQ(a->checksums()->checksums(), sums->checksums());
+	ASSERT_TRUE(manifest->backing(1)->checksums());
+	EXPECT_EQ(3, manifest->backing(1)->checksums()->count());
+
+	MergedFile file(manifest, 0);
+	EXPECT_EQ(data.substr(0, 10) + "ab", contents(file, 0, 12));
+	dir.write("b", "abcdeXghij");
+	EXPECT_EQ(data.substr(0, 10) + "abcd", contents(file, 0, 14));
+	EXPECT_THROW(contents(file, 14, 2), fusepp::fuse_error);
+}
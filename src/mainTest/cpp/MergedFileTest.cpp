@@ -0,0 +1,265 @@
+/*
+ * MergedFileTest.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#include "gtest/gtest.h"
+
+#include "smfs/MergedFile.h"
+#include "TempDir.h"
+
+#include <fusepp/common.hpp>
+
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+extern "C" {
+	#include <fcntl.h>
+	#include <unistd.h>
+}
+
+using namespace smfs;
+using namespace std;
+
+static string contents(MergedFile const & file) {
+	string out;
+	file.forEachExtent(0, file.size(), [&](Segment const & segment, off_t inSegment, size_t length) {
+		string buf(length, '\0');
+		segment.file->read(&buf[0], length, segment.offset + inSegment);
+		out += buf;
+	});
+	return out;
+}
+
+class MergedFileTest : public ::testing::Test {
+public:
+	TempDir dir;
+	shared_ptr<BackingFile> a = BackingFile::open(dir.write("a", "0123456789"));
+	shared_ptr<BackingFile> b = BackingFile::open(dir.write("b", "abcdefghij"));
+};
+
+TEST_F(MergedFileTest, splits_reads_across_segments) {
+	MergedFile merged({{a, 2, 5}, {b, 0, 0}, {b, 4, 6}});
+
+	EXPECT_EQ(11, merged.size());
+	EXPECT_EQ(2, merged.segments()->count());
+
+	string out;
+	merged.forEachExtent(3, 100, [&](Segment const & segment, off_t inSegment, size_t length) {
+		string buf(length, '\0');
+		segment.file->read(&buf[0], length, segment.offset + inSegment);
+		out += buf;
+	});
+	EXPECT_EQ("56efghij", out);
+}
+
+TEST_F(MergedFileTest, copies_ranges_between_files_by_reference) {
+	MergedFile source({{a, 0, 10}, {b, 0, 10}});
+	MergedFile dest({{b, 0, 5}});
+
+	EXPECT_EQ(6, dest.copyFrom(source, 7, 2, 6));
+	EXPECT_EQ("ab789abc", contents(dest));
+	EXPECT_EQ(3, dest.segments()->count());
+
+	// Copying past the end of the source is truncated
+	EXPECT_EQ(3, dest.copyFrom(source, 17, 8, 100));
+	EXPECT_EQ("ab789abchij", contents(dest));
+
+	// Files cannot have holes
+	EXPECT_THROW(dest.copyFrom(source, 0, 20, 1), fusepp::fuse_error);
+}
+
+TEST_F(MergedFileTest, copies_within_a_file) {
+	MergedFile file({{a, 0, 10}});
+	EXPECT_EQ(4, file.copyFrom(file, 0, 8, 4));
+	EXPECT_EQ("012345670123", contents(file));
+}
+
+TEST_F(MergedFileTest, readers_keep_their_snapshot_while_file_is_edited) {
+	MergedFile file({{a, 0, 10}, {b, 0, 10}});
+	shared_ptr<SegmentTree const> before = file.segments();
+
+	file.truncate(4);
+	EXPECT_EQ("0123", contents(file));
+	EXPECT_EQ(20, before->size());
+	EXPECT_THROW(file.truncate(5), fusepp::fuse_error);
+}
+
+TEST_F(MergedFileTest, appends_and_cuts_without_moving_data) {
+	MergedFile file({{a, 0, 10}});
+	MergedFile other({{b, 2, 3}});
+
+	EXPECT_EQ(3, file.append(other));
+	EXPECT_EQ("0123456789cde", contents(file));
+
+	file.cut(2, 9);
+	EXPECT_EQ("01de", contents(file));
+
+	file.cut(3, 100);
+	EXPECT_EQ("01d", contents(file));
+
+	EXPECT_THROW(file.cut(4, 1), fusepp::fuse_error);
+}
+
+TEST_F(MergedFileTest, tells_its_listener_of_edits_other_than_writes) {
+	MergedFile file({{a, 0, 10}});
+	vector<pair<off_t, off_t>> changes;
+	file.listen([&](off_t offset, off_t length) {
+		changes.emplace_back(offset, length);
+	});
+
+	MergedFile other({{b, 0, 10}});
+	file.copyFrom(other, 0, 2, 3);
+	file.append(other);
+	file.cut(4, 2);
+	DeltaLog log(dir.path);
+	file.write(log, "x", 1, 0);
+	file.replaceIfUnchanged(0, file.segments()->range(0, 4), file.segments()->range(0, 4));
+	file.truncate(6);
+
+	// Edits that move the rest of the file change everything after them
+	vector<pair<off_t, off_t>> expected{{2, 3}, {10, 0}, {4, 0}, {6, 0}};
+	EXPECT_EQ(expected, changes);
+}
+
+TEST_F(MergedFileTest, rolls_back_edits_the_journal_cannot_make_durable) {
+	if(::access("/dev/full", W_OK) != 0) {
+		// Nothing here fails writes for the journal
+		return;
+	}
+	MergedFile file({{a, 0, 10}});
+	file.attach(make_shared<Journal>("/dev/full", 0), "/f", 0);
+	vector<pair<off_t, off_t>> changes;
+	file.listen([&](off_t offset, off_t length) {
+		changes.emplace_back(offset, length);
+	});
+
+	EXPECT_THROW(file.cut(2, 3), fusepp::fuse_error);
+	EXPECT_EQ("0123456789", contents(file));
+	// Once for the edit, and once for its rollback
+	vector<pair<off_t, off_t>> expected{{2, 0}, {2, 0}};
+	EXPECT_EQ(expected, changes);
+
+	try {
+		file.truncate(4);
+		FAIL() << "edited a file whose journal has failed";
+	} catch(fusepp::fuse_error const & e) {
+		EXPECT_EQ(EIO, e.error);
+	}
+	EXPECT_EQ(10, file.size());
+}
+
+TEST_F(MergedFileTest, writes_are_durable_once_synced) {
+	MergedFile file({{a, 0, 10}});
+	string journalPath = dir.path + "/journal";
+	file.attach(make_shared<Journal>(journalPath, 0), "/f", 0);
+	DeltaLog log(dir.path);
+	EXPECT_EQ(3, file.write(log, "XYZ", 3, 2));
+	EXPECT_EQ("01XYZ56789", contents(file));
+	EXPECT_EQ(0, BackingFile::open(journalPath)->size());
+
+	file.sync();
+	EXPECT_GT(BackingFile::open(journalPath)->size(), 0);
+}
+
+TEST_F(MergedFileTest, keeps_writes_the_journal_cannot_make_durable) {
+	if(::access("/dev/full", W_OK) != 0) {
+		return;
+	}
+	MergedFile file({{a, 0, 10}});
+	file.attach(make_shared<Journal>("/dev/full", 0), "/f", 0);
+	DeltaLog log(dir.path);
+	EXPECT_EQ(1, file.write(log, "X", 1, 0));
+	EXPECT_THROW(file.sync(), fusepp::fuse_error);
+	EXPECT_EQ("X123456789", contents(file));
+	EXPECT_THROW(file.write(log, "Y", 1, 0), fusepp::fuse_error);
+	EXPECT_EQ("X123456789", contents(file));
+}
+
+TEST_F(MergedFileTest, writes_append_to_a_delta_log) {
+	MergedFile file({{a, 0, 10}, {b, 0, 10}});
+	DeltaLog log(dir.path);
+	EXPECT_EQ(nullptr, log.backing());
+
+	EXPECT_EQ(3, file.write(log, "XYZ", 3, 8));
+	EXPECT_EQ("01234567XYZbcdefghij", contents(file));
+	EXPECT_EQ(3, log.size());
+
+	// Writes past the end extend the file, and sequential writes join up
+	EXPECT_EQ(2, file.write(log, "!!", 2, 20 - 2));
+	EXPECT_EQ(2, file.write(log, "??", 2, 20));
+	EXPECT_EQ("01234567XYZbcdefgh!!??", contents(file));
+	size_t segments = file.segments()->count();
+	EXPECT_EQ(2, file.write(log, "..", 2, 22));
+	EXPECT_EQ(segments, file.segments()->count());
+
+	EXPECT_THROW(file.write(log, "x", 1, 100), fusepp::fuse_error);
+	EXPECT_EQ(0, file.write(log, "", 0, 3));
+
+	// The backing files are untouched
+	string buf(10, '\0');
+	a->read(&buf[0], 10, 0);
+	EXPECT_EQ("0123456789", buf);
+	b->read(&buf[0], 10, 0);
+	EXPECT_EQ("abcdefghij", buf);
+}
+
+TEST_F(MergedFileTest, writes_data_spliced_into_a_delta_log) {
+	MergedFile file({{a, 0, 10}});
+	DeltaLog log(dir.path);
+	int pipefd[2];
+	ASSERT_EQ(0, ::pipe(pipefd));
+	ASSERT_EQ(4, ::write(pipefd[1], "WXYZ", 4));
+
+	EXPECT_EQ(4, file.write(log, 4, 3, [&](BackingFile const & backing, off_t at) {
+		loff_t out = at;
+		ASSERT_EQ(4, ::splice(pipefd[0], nullptr, backing.fd(), &out, 4, SPLICE_F_MOVE));
+	}));
+	EXPECT_EQ("012WXYZ789", contents(file));
+	EXPECT_EQ(4, log.size());
+
+	// Nothing is appended if the offset is past the end
+	EXPECT_THROW(file.write(log, 1, 11, [](BackingFile const &, off_t) { FAIL(); }), fusepp::fuse_error);
+	EXPECT_EQ(4, log.size());
+	::close(pipefd[0]);
+	::close(pipefd[1]);
+}
+
+TEST_F(MergedFileTest, cached_reads_see_later_writes) {
+	MergedFile file({{a, 0, 10}}, make_shared<BlockCache>(1024 * 1024, 4096));
+	DeltaLog log(dir.path);
+	string first(100, 'x'), second(100, 'y');
+	string buf(210, '\0');
+
+	// The delta log's only block is short after the first write, and grows
+	EXPECT_EQ(100, file.write(log, first.data(), 100, 10));
+	EXPECT_EQ(110, file.read(&buf[0], 110, 0));
+	EXPECT_EQ(100, file.write(log, second.data(), 100, 110));
+	EXPECT_EQ(210, file.read(&buf[0], 210, 0));
+	EXPECT_EQ("0123456789" + first + second, buf);
+
+	// Overwritten data is not served from a block read before
+	EXPECT_EQ(100, file.write(log, first.data(), 100, 110));
+	EXPECT_EQ(210, file.read(&buf[0], 210, 0));
+	EXPECT_EQ("0123456789" + first + first, buf);
+}
+
+TEST_F(MergedFileTest, random_writes_match_a_model) {
+	MergedFile file({{a, 0, 10}, {b, 0, 10}});
+	DeltaLog log(dir.path);
+	string model = "0123456789abcdefghij";
+	mt19937_64 random(1);
+	for(int i = 0; i < 500; ++i) {
+		off_t offset = random() % (model.size() + 1);
+		string data(random() % 8 + 1, static_cast<char>('A' + i % 26));
+		file.write(log, data.data(), data.size(), offset);
+		model.resize(max(model.size(), offset + data.size()));
+		model.replace(offset, data.size(), data);
+	}
+	EXPECT_EQ(model, contents(file));
+	log.sync();
+}
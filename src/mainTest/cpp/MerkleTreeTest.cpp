@@ -0,0 +1,140 @@
+/*
+ * MerkleTreeTest.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "gtest/gtest.h"
+
+#include "smfs/Manifest.h"
+#include "smfs/MergedFile.h"
+#include "smfs/MerkleTree.h"
+#include "TempDir.h"
+
+#include <fusepp/common.hpp>
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace smfs;
+using namespace std;
+
+static string randomData(size_t length, unsigned seed) {
+	mt19937_64 random(seed);
+	string rc(length, '\0');
+	for(char &c : rc) {
+		c = static_cast<char>(random());
+	}
+	return rc;
+}
+
+class MerkleTreeTest : public ::testing::Test {
+public:
+	TempDir dir;
+	string data = randomData(13 * 1000 - 10, 1);
+	shared_ptr<BackingFile> backing = BackingFile::open(dir.write("data", data));
+
+	/**
+	 * Makes a merged file of the data, split between several segments.
+	 */
+	MergedFile merged() {
+		return MergedFile({{backing, 0, 2500}, {backing, 2500, 7000}, {backing, 9500, data.size() - 9500}});
+	}
+};
+
+TEST_F(MerkleTreeTest, proves_every_leaf) {
+	MergedFile file = merged();
+	MerkleTree tree = MerkleTree::build(file.snapshot(), 1000, 4);
+	ASSERT_EQ(13, tree.leafCount());
+	EXPECT_EQ(MerkleTree::nodeCount(13), tree.all().size());
+	EXPECT_EQ(tree.all(), MerkleTree::build(file.snapshot(), 1000, 1).all());
+
+	for(size_t i = 0; i < 13; ++i) {
+		string leaf = data.substr(i * 1000, 1000);
+		Digest digest = MerkleTree::hashLeaf(leaf.data(), leaf.size());
+		EXPECT_EQ(digest, tree.leaf(i));
+		vector<Digest> proof = tree.proof(i);
+		EXPECT_LE(proof.size(), 4);
+		EXPECT_TRUE(MerkleTree::verify(tree.root(), 13, i, digest, proof)) << i;
+
+		leaf[0] ^= 1;
+		EXPECT_FALSE(MerkleTree::verify(tree.root(), 13, i, MerkleTree::hashLeaf(leaf.data(), leaf.size()), proof));
+		EXPECT_FALSE(MerkleTree::verify(tree.root(), 13, (i + 1) % 13, digest, proof));
+	}
+
+	MerkleTree empty = MerkleTree::build(MergedFile({}).snapshot(), 1000);
+	EXPECT_EQ(1, empty.leafCount());
+	EXPECT_EQ(MerkleTree::hashLeaf(nullptr, 0), empty.root());
+}
+
+TEST_F(MerkleTreeTest, diffs_only_changed_ranges) {
+	MergedFile file = merged();
+	MerkleTree before = MerkleTree::build(file.snapshot(), 1000);
+	EXPECT_TRUE(before.diff(before).empty());
+
+	// Overwrite bytes 4500..5600 with other data of the same length
+	shared_ptr<BackingFile> other = BackingFile::open(dir.write("other", string(1100, 'x')));
+	file.splice(4500, 1100, SegmentTree({{other, 0, 1100}}));
+	MerkleTree after = MerkleTree::build(file.snapshot(), 1000);
+	EXPECT_EQ((vector<pair<off_t, off_t>>{{4000, 2000}}), before.diff(after));
+
+	// Growing the file differs from the old last leaf onwards
+	MergedFile longer({{backing, 0, data.size()}, {other, 0, 1100}});
+	vector<pair<off_t, off_t>> grown = before.diff(MerkleTree::build(longer.snapshot(), 1000));
+	EXPECT_EQ((vector<pair<off_t, off_t>>{{12000, off_t(data.size()) + 1100 - 12000}}), grown);
+
+	EXPECT_THROW(before.diff(MerkleTree::build(file.snapshot(), 500)), fusepp::fuse_error);
+}
+
+TEST_F(MerkleTreeTest, is_rebuilt_after_edits) {
+	MergedFile file = merged();
+	shared_ptr<MerkleTree const> tree = file.merkleTree();
+	EXPECT_EQ(tree, file.merkleTree());
+	EXPECT_EQ(tree, file.snapshot().merkle);
+
+	file.cut(0, 10);
+	EXPECT_FALSE(file.snapshot().merkle);
+	shared_ptr<MerkleTree const> edited = file.merkleTree();
+	EXPECT_NE(tree->root(), edited->root());
+	EXPECT_EQ(data.size() - 10, edited->size());
+}
+
+TEST_F(MerkleTreeTest, is_built_in_the_background) {
+	shared_ptr<MergedFile> file = make_shared<MergedFile>(vector<Segment>{{backing, 0, data.size()}});
+	EXPECT_FALSE(MergedFile::merkleTreeInBackground(file));
+	shared_ptr<MerkleTree const> tree;
+	for(int i = 0; i < 1000 && !tree; ++i) {
+		this_thread::sleep_for(chrono::milliseconds(5));
+		tree = MergedFile::merkleTreeInBackground(file);
+	}
+	ASSERT_TRUE(tree);
+	EXPECT_EQ(tree, file->merkleTree());
+
+	file->cut(0, 10);
+	EXPECT_FALSE(MergedFile::merkleTreeInBackground(file));
+}
+
+TEST_F(MerkleTreeTest, is_stored_in_manifests) {
+	string big = randomData(300000, 2);
+	shared_ptr<BackingFile> file = BackingFile::open(dir.write("big", big));
+	MergedFile withTree({{file, 0, big.size()}});
+	MergedFile withoutTree({{file, 0, 10}});
+	Digest root = withTree.merkleTree()->root();
+
+	ManifestWriter writer;
+	writer.add("/with", withTree);
+	writer.add("/without", withoutTree);
+	writer.write(dir.path + "/manifest");
+
+	shared_ptr<Manifest const> manifest = Manifest::open(dir.path + "/manifest");
+	EXPECT_FALSE(manifest->merkleTree(1));
+	MergedFile loaded(manifest, 0);
+	ASSERT_TRUE(loaded.snapshot().merkle);
+	EXPECT_EQ(root, loaded.snapshot().merkle->root());
+	EXPECT_EQ(withTree.merkleTree()->all(), loaded.merkleTree()->all());
+}
@@ -0,0 +1,127 @@
+/*
+ * MountTest.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#include "gtest/gtest.h"
+
+#include "smfs/Coalesced.h"
+#include "smfs/DirectoryCache.h"
+#include "smfs/MergedNode.h"
+#include "smfs/Mount.h"
+#include "smfs/ioctl.h"
+#include "TempDir.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+extern "C" {
+	#include <dirent.h>
+	#include <fcntl.h>
+	#include <sys/stat.h>
+}
+
+using namespace smfs;
+using namespace std;
+
+class MountTest : public ::testing::Test {
+public:
+	TempDir dir;
+	shared_ptr<BackingFile> a = BackingFile::open(dir.write("a", "0123456789"));
+	Mount mount;
+};
+
+TEST_F(MountTest, presents_merged_files_and_the_directories_they_imply) {
+	mount.addMergedFile("/d/e/f", {{a, 2, 5}});
+	struct stat statbuf;
+
+	mount.get_node("/d/e/f")->getattr(statbuf);
+	EXPECT_TRUE(S_ISREG(statbuf.st_mode));
+	EXPECT_EQ(5, statbuf.st_size);
+
+	mount.get_node("/d/e")->getattr(statbuf);
+	EXPECT_TRUE(S_ISDIR(statbuf.st_mode));
+
+	try {
+		mount.get_node("/d/x")->getattr(statbuf);
+		FAIL();
+	} catch(fusepp::fuse_error const & e) {
+		EXPECT_EQ(ENOENT, e.error);
+	}
+}
+
+TEST_F(MountTest, combines_queries_of_merged_file_nodes) {
+	mount.addMergedFile("/f", {{a, 0, 10}});
+	EXPECT_NE(nullptr, dynamic_pointer_cast<Coalesced<MergedNode>>(mount.get_node("/f")));
+}
+
+TEST_F(MountTest, lists_implied_directories) {
+	mount.addMergedFile("/d/e/f", {{a, 0, 10}});
+	mount.addMergedFile("/d/g", {{a, 0, 10}});
+	mount.addMergedFile("/h", {{a, 0, 10}});
+	mount.addSplitView("/d/s", make_shared<SplitView>(dir.path, 4, make_shared<DirectoryCache>(1 << 20)));
+
+	unique_ptr<fusepp::DirHandle1> handle = mount.get_node("/d")->opendir(O_RDONLY);
+	vector<pair<string, unsigned char>> listed;
+	while(optional<fusepp::AnyDirEntry> entry = handle->readdir()) {
+		listed.emplace_back((*entry)->getName(), (*entry)->getType());
+	}
+	vector<pair<string, unsigned char>> expected{
+		{".", DT_DIR}, {"..", DT_DIR}, {"e", DT_DIR}, {"g", DT_REG}, {"s", DT_DIR}};
+	EXPECT_EQ(expected, listed);
+
+	// Resumes from an entry's offset, and looks its node up through the mount
+	handle->seekdir(3);
+	optional<fusepp::AnyDirEntry> g = handle->readdir();
+	ASSERT_TRUE(g);
+	EXPECT_EQ("g", (*g)->getName());
+	EXPECT_EQ(4u, handle->telldir());
+	struct stat statbuf;
+	(*g)->lookupNode()->getattr(statbuf);
+	EXPECT_EQ(10, statbuf.st_size);
+
+	handle = mount.get_node("/")->opendir(O_RDONLY);
+	listed.clear();
+	while(optional<fusepp::AnyDirEntry> entry = handle->readdir()) {
+		listed.emplace_back((*entry)->getName(), (*entry)->getType());
+	}
+	expected = {{".", DT_DIR}, {"..", DT_DIR}, {"d", DT_DIR}, {"h", DT_REG}};
+	EXPECT_EQ(expected, listed);
+}
+
+TEST_F(MountTest, starts_background_tasks_only_through_writable_handles) {
+	mount.addMergedFile("/f", {{a, 0, 10}});
+	unique_ptr<fusepp::FileHandle1> handle = mount.get_node("/f")->open(O_RDONLY);
+
+	smfs_ioc_scrub scrub = {};
+	try {
+		handle->ioctl(SMFS_IOC_SCRUB, nullptr, 0, &scrub);
+		FAIL();
+	} catch(fusepp::fuse_error const & e) {
+		EXPECT_EQ(EBADF, e.error);
+	}
+	EXPECT_EQ(nullptr, mount.scrubber());
+
+	mount.setDeltaDirectory(dir.path);
+	smfs_ioc_compact compact = {};
+	try {
+		handle->ioctl(SMFS_IOC_COMPACT, nullptr, 0, &compact);
+		FAIL();
+	} catch(fusepp::fuse_error const & e) {
+		EXPECT_EQ(EBADF, e.error);
+	}
+	EXPECT_EQ(nullptr, mount.segmentCompactor());
+
+	smfs_ioc_prewarm prewarm = {};
+	try {
+		handle->ioctl(SMFS_IOC_PREWARM, nullptr, 0, &prewarm);
+		FAIL();
+	} catch(fusepp::fuse_error const & e) {
+		EXPECT_EQ(EBADF, e.error);
+	}
+	EXPECT_EQ(nullptr, mount.prewarmer());
+}
@@ -0,0 +1,84 @@
+/*
+ * PrewarmerTest.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "gtest/gtest.h"
+
+#include "smfs/Prewarmer.h"
+#include "TempDir.h"
+
+#include <fusepp/common.hpp>
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace smfs;
+using namespace std;
+
+class PrewarmerTest : public ::testing::Test {
+public:
+	TempDir dir;
+	mutex lock;
+	vector<tuple<string, off_t, size_t>> stored;
+
+	shared_ptr<MergedFile> file(string const & name, size_t size) {
+		return make_shared<MergedFile>(vector<Segment>{{BackingFile::open(dir.write(name, string(size, 'x'))),
+				0, size}});
+	}
+
+	Prewarmer::Store recorder() {
+		return [this](Prewarmer::Target const & target, off_t offset, size_t length) {
+			lock_guard<mutex> guard(lock);
+			stored.emplace_back(target.first, offset, length);
+		};
+	}
+};
+
+TEST_F(PrewarmerTest, stores_each_file_in_order_in_chunks) {
+	Prewarmer::Stats stats = Prewarmer({{"/a", file("a", 250)}, {"/b", file("b", 100)}}, recorder(), 0, 100).wait();
+	EXPECT_TRUE(stats.finished);
+	EXPECT_EQ(2, stats.files);
+	EXPECT_EQ(350, stats.bytes);
+	EXPECT_EQ(0, stats.skipped);
+	EXPECT_EQ(0, stats.errors);
+
+	vector<tuple<string, off_t, size_t>> expected{
+		{"/a", 0, 100}, {"/a", 100, 100}, {"/a", 200, 50}, {"/b", 0, 100}};
+	EXPECT_EQ(expected, stored);
+}
+
+TEST_F(PrewarmerTest, skips_files_the_cache_has_no_place_for) {
+	Prewarmer::Store store = [this](Prewarmer::Target const & target, off_t offset, size_t length) {
+		if(target.first == "/missing") {
+			throw fusepp::fuse_error(ENOENT);
+		}
+		if(target.first == "/broken" && offset) {
+			throw fusepp::fuse_error(EIO);
+		}
+		stored.emplace_back(target.first, offset, length);
+	};
+	Prewarmer::Stats stats = Prewarmer({{"/missing", file("m", 10)}, {"/broken", file("b", 300)},
+			{"/ok", file("o", 10)}}, store, 0, 100).wait();
+	EXPECT_EQ(1, stats.files);
+	EXPECT_EQ(1, stats.skipped);
+	EXPECT_EQ(1, stats.errors);
+	EXPECT_EQ(110, stats.bytes);
+	ASSERT_EQ(2, stored.size());
+	EXPECT_EQ("/ok", get<0>(stored.back()));
+}
+
+TEST_F(PrewarmerTest, stops_when_destroyed) {
+	auto start = chrono::steady_clock::now();
+	{
+		// Too slow to get past the first chunk for a long time
+		Prewarmer prewarmer({{"/a", file("a", 1000)}}, recorder(), 1, 100);
+	}
+	EXPECT_LT(chrono::steady_clock::now() - start, chrono::seconds(5));
+	EXPECT_GE(1, stored.size());
+}
@@ -0,0 +1,220 @@
+/*
+ * ReplicatedFileTest.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "gtest/gtest.h"
+
+#include "smfs/DeviceLoad.h"
+#include "smfs/ReplicatedFile.h"
+#include "TempDir.h"
+
+#include <fusepp/common.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace smfs;
+using namespace std;
+using namespace std::chrono;
+
+static string randomData(size_t length, unsigned seed) {
+	mt19937_64 random(seed);
+	string rc(length, '\0');
+	for(char &c : rc) {
+		c = static_cast<char>(random());
+	}
+	return rc;
+}
+
+/**
+ * A replica that can be made slow or broken, and counts its reads.
+ */
+class TestReplica : public BackingFile {
+public:
+	milliseconds delay{0};
+	bool failing = false;
+	mutable atomic<int> reads{0};
+
+	static shared_ptr<TestReplica> open(string const & path) {
+		return shared_ptr<TestReplica>(new TestReplica(path, ::open(path.c_str(), O_RDONLY)));
+	}
+
+protected:
+	size_t readUnchecked(void * buf, size_t nbytes, off_t offset) const override {
+		++reads;
+		if(failing) {
+			throw fusepp::fuse_error(EIO);
+		}
+		this_thread::sleep_for(delay);
+		return BackingFile::readUnchecked(buf, nbytes, offset);
+	}
+
+private:
+	TestReplica(string const & path, int fd) : BackingFile(path, fd) {}
+};
+
+static void prime(DeviceLoad &device, nanoseconds latency, int samples = 50) {
+	for(int i = 0; i < samples; ++i) {
+		device.started();
+		device.finished(latency);
+	}
+}
+
+struct Mirrors {
+	TempDir dir;
+	string data = randomData(100000, 1);
+	shared_ptr<TestReplica> a = TestReplica::open(dir.write("a", data));
+	shared_ptr<TestReplica> b = TestReplica::open(dir.write("b", data));
+	shared_ptr<DeviceLoad> aLoad = make_shared<DeviceLoad>();
+	shared_ptr<DeviceLoad> bLoad = make_shared<DeviceLoad>();
+	ReplicatedFile file{{{a, aLoad}, {b, bLoad}}};
+
+	string read(off_t offset, size_t length) {
+		string rc(length, '\0');
+		rc.resize(file.read(&rc[0], length, offset));
+		return rc;
+	}
+};
+
+TEST(ReplicatedFileTest, histogram_estimates_percentiles) {
+	LatencyHistogram histogram;
+	EXPECT_EQ(nanoseconds(0), histogram.percentile(0.95));
+	for(int i = 0; i < 95; ++i) {
+		histogram.record(microseconds(100));
+	}
+	for(int i = 0; i < 5; ++i) {
+		histogram.record(milliseconds(10));
+	}
+	EXPECT_EQ(100u, histogram.samples());
+	EXPECT_GT(histogram.percentile(0.5), microseconds(100));
+	EXPECT_LE(histogram.percentile(0.5), microseconds(125));
+	EXPECT_LE(histogram.percentile(0.95), microseconds(125));
+	EXPECT_GT(histogram.percentile(0.99), milliseconds(10));
+	EXPECT_LE(histogram.percentile(0.99), microseconds(12500));
+
+	// Old samples decay away
+	for(uint64_t i = 0; i < 4 * LatencyHistogram::decayInterval; ++i) {
+		histogram.record(milliseconds(1));
+	}
+	EXPECT_GT(histogram.percentile(0.5), milliseconds(1));
+	EXPECT_LT(histogram.samples(), 2 * LatencyHistogram::decayInterval);
+}
+
+TEST(ReplicatedFileTest, reads_from_any_replica) {
+	Mirrors mirrors;
+	EXPECT_FALSE(mirrors.file.hasRawDescriptor());
+	EXPECT_EQ(static_cast<off_t>(mirrors.data.size()), mirrors.file.size());
+	mt19937_64 random(2);
+	for(int i = 0; i < 50; ++i) {
+		off_t offset = random() % mirrors.data.size();
+		size_t length = random() % 10000;
+		EXPECT_EQ(mirrors.data.substr(offset, length), mirrors.read(offset, length));
+	}
+	EXPECT_EQ(50u, mirrors.file.stats().reads);
+	EXPECT_EQ(0u, mirrors.aLoad->queueDepth());
+	EXPECT_EQ(0u, mirrors.bLoad->queueDepth());
+}
+
+TEST(ReplicatedFileTest, reads_lazily_opened_replicas) {
+	TempDir dir;
+	string data = randomData(10000, 3);
+	vector<ReplicatedFile::Replica> replicas;
+	for(char const * name : {"a", "b"}) {
+		replicas.push_back(ReplicatedFile::Replica{BackingFile::openLazily(dir.write(name, data)),
+				make_shared<DeviceLoad>()});
+	}
+	ReplicatedFile file(std::move(replicas));
+
+	EXPECT_EQ(10000, file.size());
+	string out(1000, '\0');
+	EXPECT_EQ(1000u, file.read(&out[0], 1000, 4000));
+	EXPECT_EQ(data.substr(4000, 1000), out);
+}
+
+TEST(ReplicatedFileTest, prefers_least_loaded_replica) {
+	Mirrors mirrors;
+	prime(*mirrors.aLoad, milliseconds(10));
+	prime(*mirrors.bLoad, microseconds(100));
+	for(int i = 0; i < 10; ++i) {
+		EXPECT_EQ(mirrors.data.substr(i * 1000, 1000), mirrors.read(i * 1000, 1000));
+	}
+	EXPECT_EQ(0, mirrors.a->reads.load());
+	EXPECT_EQ(10, mirrors.b->reads.load());
+
+	// Reads queued on the faster device eventually make the other the better bet
+	for(int i = 0; i < 1000; ++i) {
+		mirrors.bLoad->started();
+	}
+	EXPECT_EQ(mirrors.data.substr(0, 1000), mirrors.read(0, 1000));
+	EXPECT_EQ(1, mirrors.a->reads.load());
+}
+
+TEST(ReplicatedFileTest, hedges_slow_reads) {
+	Mirrors mirrors;
+	prime(*mirrors.aLoad, milliseconds(1));
+	prime(*mirrors.bLoad, milliseconds(1));
+	mirrors.a->delay = milliseconds(500);
+
+	steady_clock::time_point start = steady_clock::now();
+	EXPECT_EQ(mirrors.data.substr(500, 5000), mirrors.read(500, 5000));
+	EXPECT_LT(steady_clock::now() - start, milliseconds(400));
+	ReplicatedFile::Stats stats = mirrors.file.stats();
+	EXPECT_EQ(1u, stats.hedged);
+	EXPECT_EQ(1u, stats.hedgeWins);
+	EXPECT_EQ(1, mirrors.a->reads.load());
+	EXPECT_EQ(1, mirrors.b->reads.load());
+}
+
+TEST(ReplicatedFileTest, fails_over_to_another_replica) {
+	Mirrors mirrors;
+	prime(*mirrors.bLoad, milliseconds(10));
+	mirrors.a->failing = true;
+	EXPECT_EQ(mirrors.data.substr(0, 100), mirrors.read(0, 100));
+	EXPECT_EQ(1u, mirrors.file.stats().failovers);
+
+	mirrors.b->failing = true;
+	try {
+		mirrors.read(0, 100);
+		FAIL();
+	} catch(fusepp::fuse_error const & e) {
+		EXPECT_EQ(EIO, e.error);
+	}
+}
+
+TEST(ReplicatedFileTest, counts_hedge_wins_after_failing_over) {
+	Mirrors mirrors;
+	shared_ptr<TestReplica> c = TestReplica::open(mirrors.dir.write("c", mirrors.data));
+	shared_ptr<DeviceLoad> cLoad = make_shared<DeviceLoad>();
+	ReplicatedFile file{{{mirrors.a, mirrors.aLoad}, {mirrors.b, mirrors.bLoad}, {c, cLoad}}};
+	prime(*mirrors.aLoad, milliseconds(1));
+	prime(*mirrors.bLoad, milliseconds(2));
+	prime(*cLoad, milliseconds(5));
+	mirrors.a->failing = true;
+	mirrors.b->delay = milliseconds(100);
+	c->delay = milliseconds(500);
+
+	// a fails, b is hedged to c, and b, to which the read failed over, answers first
+	string buf(100, '\0');
+	EXPECT_EQ(100u, file.read(&buf[0], 100, 0));
+	ReplicatedFile::Stats stats = file.stats();
+	EXPECT_EQ(1u, stats.failovers);
+	EXPECT_EQ(1u, stats.hedged);
+	EXPECT_EQ(0u, stats.hedgeWins);
+}
+
+TEST(ReplicatedFileTest, shares_load_by_device) {
+	TempDir dir;
+	string a = dir.write("a", "abc");
+	string b = dir.write("b", "abc");
+	shared_ptr<ReplicatedFile> file = ReplicatedFile::open({a, b});
+	EXPECT_EQ(file->replicas()[0].device, file->replicas()[1].device);
+	EXPECT_EQ(a, file->path);
+	EXPECT_THROW(ReplicatedFile::open({}), fusepp::fuse_error);
+}
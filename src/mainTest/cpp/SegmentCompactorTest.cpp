@@ -0,0 +1,174 @@
+/*
+ * SegmentCompactorTest.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "gtest/gtest.h"
+
+#include "smfs/SegmentCompactor.h"
+#include "TempDir.h"
+
+#include <fusepp/common.hpp>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+extern "C" {
+	#include <sys/stat.h>
+}
+
+using namespace smfs;
+using namespace std;
+
+static string contents(MergedFile const & file) {
+	string out;
+	file.forEachExtent(0, file.size(), [&](Segment const & segment, off_t inSegment, size_t length) {
+		string buf(length, '\0');
+		segment.file->read(&buf[0], length, segment.offset + inSegment);
+		out += buf;
+	});
+	return out;
+}
+
+class SegmentCompactorTest : public ::testing::Test {
+public:
+	TempDir dir;
+	CompactionPolicy policy;
+	shared_ptr<MergedFile> file;
+	shared_ptr<DeltaLog> log = make_shared<DeltaLog>(dir.path);
+
+	SegmentCompactorTest() {
+		policy.windowSize = 64;
+		policy.maxSegments = 4;
+		policy.reclaimDelay = 0.01;
+		string base(256, '.');
+		for(size_t i = 0; i < base.size(); ++i) {
+			base[i] = static_cast<char>('a' + i % 26);
+		}
+		file = make_shared<MergedFile>(vector<Segment>{{BackingFile::open(dir.write("base", base)), 0,
+				base.size()}});
+		// Scatter single-byte writes over the first half, leaving the second intact
+		for(off_t offset = 0; offset < 128; offset += 4) {
+			char c = static_cast<char>('A' + offset % 26);
+			file->write(*log, &c, 1, offset);
+		}
+	}
+};
+
+TEST_F(SegmentCompactorTest, measures_fragmented_windows) {
+	Fragmentation before = SegmentCompactor::measure(*file, policy);
+	EXPECT_EQ(256, before.size);
+	EXPECT_EQ(4, before.windows);
+	EXPECT_EQ(2, before.fragmentedWindows);
+	EXPECT_EQ(128, before.fragmentedBytes);
+	EXPECT_GT(before.worstWindow, policy.maxSegments);
+	EXPECT_EQ(file->segments()->count(), before.segments);
+}
+
+TEST_F(SegmentCompactorTest, rewrites_fragmented_windows_without_changing_contents) {
+	string expected = contents(*file);
+	size_t segmentsBefore = file->segments()->count();
+
+	SegmentCompactor::Stats stats = SegmentCompactor({{file, log}}, policy, 0).wait();
+	EXPECT_TRUE(stats.finished);
+	EXPECT_EQ(1, stats.files);
+	EXPECT_EQ(2, stats.windows);
+	EXPECT_EQ(128, stats.bytes);
+	EXPECT_EQ(0, stats.conflicts);
+	EXPECT_EQ(0, stats.errors);
+
+	EXPECT_EQ(expected, contents(*file));
+	// The two compacted windows were appended one after the other, so join up
+	EXPECT_EQ(2, file->segments()->count());
+	EXPECT_GT(segmentsBefore, 32);
+	EXPECT_GE(stats.segmentsRemoved, segmentsBefore - 4);
+	EXPECT_EQ(0, SegmentCompactor::measure(*file, policy).fragmentedWindows);
+
+	// A second pass has nothing to do
+	stats = SegmentCompactor({{file, log}}, policy, 0).wait();
+	EXPECT_EQ(0, stats.windows);
+}
+
+TEST_F(SegmentCompactorTest, leaves_ranges_edited_since_they_were_read) {
+	shared_ptr<SegmentTree const> before = file->segments();
+	SegmentTree expected = before->range(0, 64);
+	char c = '!';
+	file->write(*log, &c, 1, 10);
+
+	Segment replacement = log->append("x", 1);
+	EXPECT_FALSE(file->replaceIfUnchanged(0, expected, SegmentTree(vector<Segment>{{replacement.file, 0, 64}})));
+	EXPECT_EQ('!', contents(*file)[10]);
+
+	// Edits elsewhere in the file do not count
+	file->write(*log, &c, 1, 200);
+	EXPECT_TRUE(file->replaceIfUnchanged(64, before->range(64, 64), before->range(64, 64)));
+	EXPECT_THROW(file->replaceIfUnchanged(0, expected, before->range(0, 32)), fusepp::fuse_error);
+}
+
+TEST_F(SegmentCompactorTest, stops_when_destroyed) {
+	auto start = chrono::steady_clock::now();
+	{
+		// Too slow to finish the first window for a long time
+		SegmentCompactor compactor({{file, log}}, policy, 1);
+	}
+	EXPECT_LT(chrono::steady_clock::now() - start, chrono::seconds(5));
+	EXPECT_EQ(SegmentCompactor::measure(*file, policy).size, 256);
+
+	// Stopping it lets those waiting for it go
+	SegmentCompactor compactor({{file, log}}, policy, 1);
+	compactor.stop();
+	SegmentCompactor::Stats stats = compactor.wait();
+	EXPECT_TRUE(stats.finished);
+	EXPECT_TRUE(stats.stopped);
+}
+
+TEST_F(SegmentCompactorTest, reclaims_log_space_nothing_refers_to) {
+	string data(64 * 1024, 'd');
+	file->write(*log, data.data(), data.size(), 256);
+	// Overwritten, leaving the first copy in the log unreferenced
+	string again(64 * 1024, 'e');
+	file->write(*log, again.data(), again.size(), 256);
+	string expected = contents(*file);
+
+	struct stat before;
+	ASSERT_EQ(0, ::fstat(log->backing()->fd(), &before));
+	SegmentCompactor::Stats stats = SegmentCompactor({{file, log}}, policy, 0).wait();
+	EXPECT_EQ(0, stats.errors);
+	EXPECT_GE(stats.reclaimedBytes, 60 * 1024);
+	struct stat after;
+	ASSERT_EQ(0, ::fstat(log->backing()->fd(), &after));
+	// Holes are punched, rather than the log shortened, so offsets stay valid
+	EXPECT_LE(before.st_size, after.st_size);
+	EXPECT_LT(after.st_blocks, before.st_blocks);
+	EXPECT_EQ(expected, contents(*file));
+}
+
+TEST_F(SegmentCompactorTest, repeats_passes_until_stopped) {
+	policy.interval = 0.01;
+	vector<SegmentCompactor::Target> targets{{file, log}};
+	SegmentCompactor compactor([&]() { return targets; }, policy, 0);
+	auto deadline = chrono::steady_clock::now() + chrono::seconds(10);
+	while(compactor.stats().passes < 2 && chrono::steady_clock::now() < deadline) {
+		this_thread::sleep_for(chrono::milliseconds(1));
+	}
+	EXPECT_EQ(0, SegmentCompactor::measure(*file, policy).fragmentedWindows);
+
+	// Fragmented again, and compacted again by a later pass
+	for(off_t offset = 128; offset < 192; offset += 4) {
+		char c = '#';
+		file->write(*log, &c, 1, offset);
+	}
+	std::uint64_t passes = compactor.stats().passes;
+	while(compactor.stats().passes < passes + 2 && chrono::steady_clock::now() < deadline) {
+		this_thread::sleep_for(chrono::milliseconds(1));
+	}
+	EXPECT_EQ(0, SegmentCompactor::measure(*file, policy).fragmentedWindows);
+
+	compactor.stop();
+	SegmentCompactor::Stats stats = compactor.wait();
+	EXPECT_TRUE(stats.finished);
+	EXPECT_TRUE(stats.stopped);
+}
@@ -0,0 +1,186 @@
+/*
+ * SegmentTreeTest.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "gtest/gtest.h"
+
+#include "smfs/SegmentTree.h"
+#include "TempDir.h"
+
+#include <cmath>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace smfs;
+using namespace std;
+
+/**
+ * The backing file and offset of each byte described by a list of segments.
+ */
+using Bytes = vector<pair<BackingFile const *, off_t>>;
+
+static Bytes expand(SegmentTree const & tree) {
+	Bytes out;
+	tree.forEachExtent(0, tree.size(), [&](Segment const & segment, off_t inSegment, size_t length) {
+		for(size_t i = 0; i < length; ++i) {
+			out.emplace_back(segment.file.get(), segment.offset + inSegment + i);
+		}
+	});
+	return out;
+}
+
+static Bytes expand(Segment const & segment) {
+	Bytes out;
+	for(size_t i = 0; i < segment.length; ++i) {
+		out.emplace_back(segment.file.get(), segment.offset + i);
+	}
+	return out;
+}
+
+static size_t visited(SegmentTree const & tree) {
+	size_t n = 0;
+	tree.forEachExtent(0, tree.size(), [&](Segment const &, off_t, size_t) { ++n; });
+	return n;
+}
+
+/**
+ * The most levels a tree of the given number of segments should need, were
+ * every node at least half full.
+ */
+static unsigned maxHeight(size_t segments) {
+	return 2 + static_cast<unsigned>(log(segments + 1) / log(details::treeMinFill));
+}
+
+class SegmentTreeTest : public ::testing::Test {
+public:
+	TempDir dir;
+	shared_ptr<BackingFile> a = BackingFile::open(dir.write("a", ""));
+	shared_ptr<BackingFile> b = BackingFile::open(dir.write("b", ""));
+
+	/**
+	 * Creates a run of non-contiguous segments, so none are merged.
+	 */
+	vector<Segment> run(size_t n, size_t length) {
+		vector<Segment> segments;
+		for(size_t i = 0; i < n; ++i) {
+			segments.push_back({i % 2 ? b : a, static_cast<off_t>(i * 2 * length), length});
+		}
+		return segments;
+	}
+};
+
+TEST_F(SegmentTreeTest, builds_balanced_trees) {
+	EXPECT_EQ(0, SegmentTree().size());
+	EXPECT_EQ(0, SegmentTree().height());
+
+	for(size_t n : {1, 31, 32, 33, 1000, 100000}) {
+		SegmentTree tree(run(n, 3));
+		EXPECT_EQ(n * 3, tree.size());
+		EXPECT_EQ(n, tree.count());
+		EXPECT_EQ(n, visited(tree));
+		EXPECT_LE(tree.height(), maxHeight(n));
+	}
+}
+
+TEST_F(SegmentTreeTest, looks_up_extents_by_offset) {
+	SegmentTree tree(run(1000, 4));
+
+	vector<Segment> slice = tree.slice(4 * 500 + 1, 6);
+	ASSERT_EQ(2, slice.size());
+	EXPECT_EQ(a, slice[0].file);
+	EXPECT_EQ(8 * 500 + 1, slice[0].offset);
+	EXPECT_EQ(3, slice[0].length);
+	EXPECT_EQ(b, slice[1].file);
+	EXPECT_EQ(8 * 501, slice[1].offset);
+	EXPECT_EQ(3, slice[1].length);
+
+	EXPECT_TRUE(tree.slice(4000, 10).empty());
+	EXPECT_EQ(1, tree.slice(3999, 10).size());
+}
+
+TEST_F(SegmentTreeTest, splits_and_joins) {
+	SegmentTree tree(run(5000, 2));
+	Bytes expected = expand(tree);
+
+	for(off_t at : {0, 1, 2, 5001, 9999, 10000}) {
+		pair<SegmentTree, SegmentTree> parts = tree.split(at);
+		EXPECT_EQ(at, parts.first.size());
+		EXPECT_EQ(10000 - at, parts.second.size());
+		EXPECT_LE(parts.first.height(), tree.height());
+
+		SegmentTree joined = SegmentTree::concat(parts.first, parts.second);
+		EXPECT_EQ(expected, expand(joined));
+		// Rejoining a divided segment merges it back together
+		EXPECT_EQ(5000, joined.count());
+	}
+}
+
+TEST_F(SegmentTreeTest, joins_trees_of_different_heights) {
+	SegmentTree tall(run(20000, 1));
+	SegmentTree shortTree(vector<Segment>{{a, 1000000, 7}});
+
+	SegmentTree right = SegmentTree::concat(tall, shortTree);
+	SegmentTree left = SegmentTree::concat(shortTree, tall);
+
+	Bytes expected = expand(tall);
+	Bytes extra = expand(vector<Segment>{{a, 1000000, 7}}.front());
+	Bytes expectedRight = expected;
+	expectedRight.insert(expectedRight.end(), extra.begin(), extra.end());
+	Bytes expectedLeft = extra;
+	expectedLeft.insert(expectedLeft.end(), expected.begin(), expected.end());
+
+	EXPECT_EQ(expectedRight, expand(right));
+	EXPECT_EQ(expectedLeft, expand(left));
+	EXPECT_EQ(20001, right.count());
+	EXPECT_LE(right.height(), maxHeight(20001));
+	EXPECT_LE(left.height(), maxHeight(20001));
+}
+
+TEST_F(SegmentTreeTest, edits_match_a_flat_model) {
+	mt19937 rng(42);
+	SegmentTree tree(run(200, 5));
+	Bytes model = expand(tree);
+	off_t next = 1 << 20;
+
+	for(int i = 0; i < 2000; ++i) {
+		off_t offset = uniform_int_distribution<off_t>(0, model.size())(rng);
+		size_t length = uniform_int_distribution<size_t>(0, 20)(rng);
+
+		switch(rng() % 3) {
+		case 0: {
+			Segment segment{rng() % 2 ? a : b, next, length + 1};
+			next += 2 * (length + 1);
+			tree = tree.insert(offset, segment);
+			Bytes bytes = expand(segment);
+			model.insert(model.begin() + offset, bytes.begin(), bytes.end());
+			break;
+		}
+		case 1: {
+			tree = tree.erase(offset, length);
+			size_t end = min(model.size(), offset + length);
+			model.erase(model.begin() + offset, model.begin() + end);
+			break;
+		}
+		default: {
+			size_t from = uniform_int_distribution<size_t>(0, model.size())(rng);
+			SegmentTree copied = tree.range(from, length);
+			size_t end = min(model.size(), from + length);
+			Bytes bytes(model.begin() + from, model.begin() + end);
+			tree = tree.splice(offset, bytes.size(), copied);
+			size_t replaced = min(model.size(), offset + bytes.size());
+			model.erase(model.begin() + offset, model.begin() + replaced);
+			model.insert(model.begin() + offset, bytes.begin(), bytes.end());
+			break;
+		}
+		}
+
+		ASSERT_EQ(model.size(), tree.size());
+		ASSERT_EQ(tree.count(), visited(tree));
+		ASSERT_LE(tree.height(), maxHeight(tree.count()));
+		ASSERT_EQ(model, expand(tree));
+	}
+}
@@ -0,0 +1,140 @@
+/*
+ * SingleFlightTest.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#include "gtest/gtest.h"
+
+#include "smfs/BlockCache.h"
+#include "smfs/Coalesced.h"
+#include "smfs/SingleFlight.h"
+#include "TempDir.h"
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace smfs;
+using namespace std;
+
+TEST(SingleFlight, concurrent_calls_share_one_execution) {
+	SingleFlight<int, int> flights;
+	atomic<int> calls{0};
+	atomic<bool> release{false};
+
+	vector<thread> threads;
+	vector<int> results(8);
+	for(int i = 0; i < 8; ++i) {
+		threads.emplace_back([&, i]() {
+			results[i] = flights.run(1, [&]() {
+				++calls;
+				while(!release) this_thread::yield();
+				return 42;
+			});
+		});
+	}
+	this_thread::sleep_for(chrono::milliseconds(50));
+	release = true;
+	for(thread &t : threads) t.join();
+
+	EXPECT_EQ(1, calls);
+	for(int result : results) {
+		EXPECT_EQ(42, result);
+	}
+}
+
+TEST(SingleFlight, sequential_calls_execute_separately) {
+	SingleFlight<int, int> flights;
+	int calls = 0;
+	EXPECT_EQ(1, flights.run(1, [&]() { return ++calls; }));
+	EXPECT_EQ(2, flights.run(1, [&]() { return ++calls; }));
+	EXPECT_EQ(3, flights.run(2, [&]() { return ++calls; }));
+}
+
+TEST(SingleFlight, exceptions_are_shared_and_do_not_stick) {
+	SingleFlight<int, int> flights;
+	EXPECT_THROW(flights.run(1, []() -> int { throw runtime_error("boom"); }), runtime_error);
+	EXPECT_EQ(7, flights.run(1, []() { return 7; }));
+}
+
+/**
+ * A node whose attributes are slow to determine, and counted.
+ */
+struct SlowNode : fusepp::Node1 {
+	atomic<int> calls{0};
+	atomic<bool> release{false};
+
+	SlowNode(fusepp::path_t rel_path) : Node1(rel_path) {}
+
+	double getattr(struct stat& statbuf) override {
+		++calls;
+		while(!release) this_thread::yield();
+		statbuf = {};
+		statbuf.st_size = 42;
+		return 1.0;
+	}
+};
+
+TEST(Coalesced, concurrent_getattrs_share_one_call) {
+	Coalesced<SlowNode> node(fusepp::path_t("/a"));
+
+	vector<thread> threads;
+	vector<off_t> sizes(8);
+	for(int i = 0; i < 8; ++i) {
+		threads.emplace_back([&, i]() {
+			struct stat statbuf;
+			EXPECT_EQ(1.0, node.getattr(statbuf));
+			sizes[i] = statbuf.st_size;
+		});
+	}
+	this_thread::sleep_for(chrono::milliseconds(50));
+	node.release = true;
+	for(thread &t : threads) t.join();
+
+	EXPECT_EQ(1, node.calls);
+	for(off_t size : sizes) {
+		EXPECT_EQ(42, size);
+	}
+}
+
+/**
+ * A backing file whose reads are slow, and counted.
+ */
+struct SlowFile : BackingFile {
+	mutable atomic<int> reads{0};
+
+	SlowFile(string const & path) : BackingFile(path, ::open(path.c_str(), O_RDONLY)) {}
+
+	size_t read(void * buf, size_t nbytes, off_t offset) const override {
+		++reads;
+		this_thread::sleep_for(chrono::milliseconds(50));
+		return BackingFile::read(buf, nbytes, offset);
+	}
+};
+
+TEST(BlockCache, coalesces_concurrent_misses_on_a_block) {
+	TempDir dir;
+	SlowFile file(dir.write("a", string(8192, 'x')));
+	BlockCache cache(1 << 20, 4096);
+
+	vector<thread> threads;
+	for(int i = 0; i < 16; ++i) {
+		threads.emplace_back([&]() {
+			EXPECT_EQ(4096, cache.get(file, 4096)->size());
+		});
+	}
+	for(thread &t : threads) t.join();
+
+	EXPECT_EQ(1, file.reads);
+	BlockCache::Stats stats = cache.stats();
+	EXPECT_EQ(16, stats.hits + stats.misses);
+	// How many misses join the flight, rather than finding the block once it
+	// has landed, depends on timing; only the one read is certain
+	EXPECT_GE(16, stats.misses);
+	EXPECT_GT(stats.misses, stats.coalesced);
+	EXPECT_EQ(4096, stats.bytesFetched);
+}
@@ -0,0 +1,239 @@
+/*
+ * SplitViewTest.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "gtest/gtest.h"
+
+#include "smfs/DirectoryCache.h"
+#include "smfs/SplitView.h"
+#include "TempDir.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C" {
+	#include <fcntl.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+}
+
+using namespace smfs;
+using namespace std;
+
+class SplitViewTest : public ::testing::Test {
+public:
+	TempDir dir;
+	shared_ptr<DirectoryCache> cache = make_shared<DirectoryCache>(1 << 20);
+
+	void mkdir(string const & name) {
+		ASSERT_EQ(0, ::mkdir((dir.path + "/" + name).c_str(), 0755));
+	}
+
+	vector<string> names(vector<DirectoryEntry> const & entries) {
+		vector<string> rc;
+		for(DirectoryEntry const & entry : entries) {
+			rc.push_back(entry.name);
+		}
+		return rc;
+	}
+};
+
+TEST_F(SplitViewTest, loads_only_the_directories_resolved_through) {
+	mkdir("a");
+	mkdir("a/b");
+	mkdir("c");
+	mkdir("c/d");
+	dir.write("a/b/f", "0123456789");
+
+	SplitView view(dir.path, 4, cache);
+	EXPECT_EQ(0, cache->stats().loads);
+
+	SplitView::Resolved f = view.resolve("/a/b/f");
+	EXPECT_EQ(SplitView::Resolved::splitFile, f.kind);
+	EXPECT_TRUE(S_ISDIR(f.attributes.st_mode));
+	EXPECT_EQ(3, cache->stats().loads);
+
+	EXPECT_EQ(SplitView::Resolved::directory, view.resolve("/a/b").kind);
+	EXPECT_EQ(3, cache->stats().loads);
+	EXPECT_EQ(2, cache->stats().hits);
+}
+
+TEST_F(SplitViewTest, presents_files_as_chunks) {
+	dir.write("f", "0123456789");
+	::symlink("f", (dir.path + "/link").c_str());
+	SplitView view(dir.path, 4, cache);
+
+	EXPECT_EQ(vector<string>{"f"}, names(view.list(view.resolve("/"))));
+	EXPECT_EQ((vector<string>{"00000000", "00000001", "00000002"}), names(view.list(view.resolve("/f"))));
+	EXPECT_EQ(SplitView::Resolved::missing, view.resolve("/link").kind);
+
+	SplitView::Resolved last = view.resolve("/f/00000002");
+	ASSERT_EQ(SplitView::Resolved::chunk, last.kind);
+	EXPECT_EQ(2, last.index);
+	EXPECT_EQ(8, last.offset);
+	EXPECT_EQ(2, last.length);
+	EXPECT_EQ(2, last.attributes.st_size);
+	EXPECT_TRUE(S_ISREG(last.attributes.st_mode));
+	EXPECT_EQ(0, last.attributes.st_mode & 0222);
+
+	EXPECT_EQ(SplitView::Resolved::missing, view.resolve("/f/00000003").kind);
+	EXPECT_EQ(SplitView::Resolved::missing, view.resolve("/f/2").kind);
+	EXPECT_EQ(SplitView::Resolved::missing, view.resolve("/f/00000002/x").kind);
+	EXPECT_EQ(SplitView::Resolved::missing, view.resolve("/g").kind);
+}
+
+TEST_F(SplitViewTest, evicts_least_recently_used_directories) {
+	for(string name : {"a", "b", "c"}) {
+		mkdir(name);
+		for(int i = 0; i < 20; ++i) {
+			dir.write(name + "/" + to_string(i), "");
+		}
+	}
+	size_t one = Directory::load(dir.path + "/a")->footprint();
+	DirectoryCache small(2 * one + one / 2);
+
+	small.get(dir.path + "/a");
+	small.get(dir.path + "/b");
+	small.get(dir.path + "/a");
+	small.get(dir.path + "/c");
+	EXPECT_EQ(1, small.stats().evictions);
+	EXPECT_LE(small.size(), 2 * one + one / 2);
+
+	// b was the least recently used, so a is still cached
+	small.get(dir.path + "/a");
+	EXPECT_EQ(2, small.stats().hits);
+	small.get(dir.path + "/b");
+	EXPECT_EQ(4, small.stats().loads);
+}
+
+TEST_F(SplitViewTest, invalidated_directories_are_reloaded) {
+	mkdir("a");
+	SplitView view(dir.path, 4, cache);
+	EXPECT_EQ(SplitView::Resolved::missing, view.resolve("/a/f").kind);
+
+	dir.write("a/f", "x");
+	EXPECT_EQ(SplitView::Resolved::missing, view.resolve("/a/f").kind);
+	cache->invalidate(dir.path + "/a");
+	EXPECT_EQ(SplitView::Resolved::splitFile, view.resolve("/a/f").kind);
+}
+
+TEST_F(SplitViewTest, coalesces_concurrent_loads) {
+	for(int i = 0; i < 2000; ++i) {
+		dir.write(to_string(i), "");
+	}
+	vector<thread> threads;
+	for(int t = 0; t < 8; ++t) {
+		threads.emplace_back([&]() {
+			EXPECT_EQ(2000, cache->get(dir.path)->entries().size());
+		});
+	}
+	for(thread &t : threads) {
+		t.join();
+	}
+	DirectoryCache::Stats stats = cache->stats();
+	EXPECT_EQ(8, stats.hits + stats.loads + stats.coalesced);
+	EXPECT_EQ(1, stats.loads);
+}
+
+TEST_F(SplitViewTest, splits_files_by_content) {
+	string data;
+	for(int i = 0; i < 100000; ++i) {
+		data += to_string(i * 7919);
+	}
+	dir.write("f", data);
+	SplitView view(dir.path, Chunker(1024), cache);
+
+	vector<DirectoryEntry> chunks = view.list(view.resolve("/f"));
+	ASSERT_GT(chunks.size(), 100);
+	off_t offset = 0;
+	for(DirectoryEntry const & entry : chunks) {
+		SplitView::Resolved chunk = view.resolve("/f/" + entry.name);
+		ASSERT_EQ(SplitView::Resolved::chunk, chunk.kind);
+		EXPECT_EQ(offset, chunk.offset);
+		EXPECT_LE(chunk.length, 8192);
+		offset += chunk.length;
+	}
+	EXPECT_EQ(data.size(), offset);
+}
+
+TEST_F(SplitViewTest, saves_and_loads_chunk_boundaries) {
+	mkdir("store");
+	string data(200000, 'x');
+	for(size_t i = 0; i < data.size(); i += 13) {
+		data[i] = static_cast<char>(i * 31);
+	}
+	mkdir("view");
+	dir.write("view/f", data);
+	dir.write("view/g", "small");
+	string manifestPath = dir.path + "/store/chunks";
+
+	vector<DirectoryEntry> chunks;
+	{
+		SplitView view(dir.path + "/view", Chunker(1024), cache);
+		chunks = view.list(view.resolve("/f"));
+		view.saveBoundaries(manifestPath);
+	}
+
+	shared_ptr<Manifest const> manifest = Manifest::open(manifestPath);
+	ASSERT_EQ(1, manifest->fileCount());
+	EXPECT_EQ(chunks.size(), manifest->segmentCount(0));
+
+	// Make the saved boundaries distinguishable from recomputed ones
+	ManifestWriter writer;
+	writer.addRanges(dir.path + "/view/f", dir.path + "/view/f", {100000, 200000}, manifest->sequence(0));
+	writer.write(manifestPath);
+
+	SplitView view(dir.path + "/view", Chunker(1024), cache, Manifest::open(manifestPath));
+	EXPECT_EQ((vector<string>{"00000000", "00000001"}), names(view.list(view.resolve("/f"))));
+	EXPECT_EQ(100000, view.resolve("/f/00000001").offset);
+	EXPECT_EQ(1, names(view.list(view.resolve("/g"))).size());
+
+	view.saveBoundaries(manifestPath);
+	EXPECT_EQ(2, Manifest::open(manifestPath)->fileCount());
+}
+
+TEST_F(SplitViewTest, divides_files_rewritten_at_the_same_size_again) {
+	mkdir("store");
+	mkdir("view");
+	dir.write("view/f", string(200000, 'x'));
+	string manifestPath = dir.path + "/store/chunks";
+	{
+		SplitView view(dir.path + "/view", Chunker(1024), cache);
+		view.list(view.resolve("/f"));
+		view.saveBoundaries(manifestPath);
+	}
+	shared_ptr<Manifest const> manifest = Manifest::open(manifestPath);
+	ManifestWriter writer;
+	writer.addRanges(dir.path + "/view/f", dir.path + "/view/f", {100000, 200000}, manifest->sequence(0));
+	writer.write(manifestPath);
+
+	SplitView view(dir.path + "/view", Chunker(1024), cache, Manifest::open(manifestPath));
+	SplitView::Resolved f = view.resolve("/f");
+	EXPECT_EQ(2, view.list(f).size());
+
+	// Same size, different contents, and the modification time put back
+	string data(200000, 'x');
+	for(size_t i = 0; i < data.size(); i += 13) {
+		data[i] = static_cast<char>(i * 31);
+	}
+	struct stat before;
+	ASSERT_EQ(0, ::stat((dir.path + "/view/f").c_str(), &before));
+	// Past the granularity of file timestamps, so the change time moves
+	this_thread::sleep_for(chrono::milliseconds(20));
+	dir.write("view/f", data);
+	struct timespec times[] = {before.st_atim, before.st_mtim};
+	ASSERT_EQ(0, ::utimensat(AT_FDCWD, (dir.path + "/view/f").c_str(), times, 0));
+	cache->invalidate(dir.path + "/view");
+
+	f = view.resolve("/f");
+	EXPECT_EQ(200000, f.backingAttributes.st_size);
+	EXPECT_GT(view.list(f).size(), 2);
+
+	SplitView reloaded(dir.path + "/view", Chunker(1024), cache, Manifest::open(manifestPath));
+	EXPECT_GT(reloaded.list(reloaded.resolve("/f")).size(), 2);
+}
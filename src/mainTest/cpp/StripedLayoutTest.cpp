@@ -0,0 +1,149 @@
+/*
+ * StripedLayoutTest.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "gtest/gtest.h"
+
+#include "smfs/MergedFile.h"
+#include "smfs/StripedLayout.h"
+#include "TempDir.h"
+
+#include <fusepp/common.hpp>
+
+#include <random>
+#include <string>
+#include <vector>
+
+extern "C" {
+	#include <dirent.h>
+	#include <sys/stat.h>
+}
+
+using namespace smfs;
+using namespace std;
+
+static string randomData(size_t length, unsigned seed) {
+	mt19937_64 random(seed);
+	string rc(length, '\0');
+	for(char &c : rc) {
+		c = static_cast<char>(random());
+	}
+	return rc;
+}
+
+static vector<string> makeDirectories(TempDir const & dir, size_t count) {
+	vector<string> rc;
+	for(size_t i = 0; i < count; ++i) {
+		rc.push_back(dir.path + "/disk" + to_string(i));
+		::mkdir(rc.back().c_str(), 0755);
+	}
+	return rc;
+}
+
+static string readRange(MergedFile const & file, off_t offset, size_t nbytes) {
+	string rc(nbytes, '\0');
+	rc.resize(file.read(&rc[0], nbytes, offset));
+	return rc;
+}
+
+static size_t openDescriptors() {
+	size_t rc = 0;
+	DIR * fds = ::opendir("/proc/self/fd");
+	while(::readdir(fds)) {
+		++rc;
+	}
+	::closedir(fds);
+	return rc;
+}
+
+TEST(StripedLayoutTest, deals_stripes_round_robin) {
+	TempDir dir;
+	StripedLayout layout(makeDirectories(dir, 3), 4096);
+	string data = randomData(4096 * 7 + 100, 1);
+	EXPECT_EQ(static_cast<off_t>(data.size()), layout.write(*BackingFile::open(dir.write("source", data)), "file"));
+
+	// Stripes 0, 3 and 6 are in the first member, then the partial stripe 7 in the second
+	EXPECT_EQ(4096 * 3, BackingFile::open(dir.path + "/disk0/file")->size());
+	EXPECT_EQ(4096 * 2 + 100, BackingFile::open(dir.path + "/disk1/file")->size());
+	EXPECT_EQ(4096 * 2, BackingFile::open(dir.path + "/disk2/file")->size());
+	for(size_t i = 0; i < 3; ++i) {
+		EXPECT_EQ(StripedLayout::memberSize(data.size(), 4096, 3, i),
+				BackingFile::open(dir.path + "/disk" + to_string(i) + "/file")->size());
+	}
+
+	vector<Segment> segments = layout.open("file");
+	ASSERT_EQ(8u, segments.size());
+	EXPECT_EQ(4096, segments[3].offset);
+	EXPECT_EQ(dir.path + "/disk0/file", segments[3].file->path);
+	EXPECT_EQ(100u, segments[7].length);
+	EXPECT_EQ(dir.path + "/disk1/file", segments[7].file->path);
+}
+
+TEST(StripedLayoutTest, reads_back_in_parallel) {
+	TempDir dir;
+	StripedLayout layout(makeDirectories(dir, 4), 4096);
+	string data = randomData(1 << 20, 2);
+	layout.write(*BackingFile::open(dir.write("source", data)), "file");
+
+	for(shared_ptr<BlockCache> cache : {shared_ptr<BlockCache>(), make_shared<BlockCache>(1 << 20, 16384)}) {
+		MergedFile file(layout.open("file"), cache);
+		EXPECT_EQ(static_cast<off_t>(data.size()), file.size());
+		EXPECT_TRUE(file.readsInParallel(0, MergedFile::parallelReadSize));
+		EXPECT_FALSE(file.readsInParallel(0, 4096));
+		EXPECT_EQ(data, readRange(file, 0, data.size() + 1));
+
+		mt19937_64 random(3);
+		for(int i = 0; i < 50; ++i) {
+			off_t offset = random() % data.size();
+			size_t length = random() % (300 * 1024);
+			EXPECT_EQ(data.substr(offset, length), readRange(file, offset, length)) << offset << " " << length;
+		}
+		EXPECT_EQ("", readRange(file, data.size(), 10));
+	}
+}
+
+TEST(StripedLayoutTest, rejects_mismatched_members) {
+	TempDir dir;
+	vector<string> dirs = makeDirectories(dir, 2);
+	StripedLayout layout(dirs, 4096);
+	layout.write(*BackingFile::open(dir.write("source", randomData(4096 * 3, 4))), "file");
+	dir.write("disk1/file", randomData(100, 5));
+	try {
+		layout.open("file");
+		FAIL();
+	} catch(fusepp::fuse_error const & e) {
+		EXPECT_EQ(EINVAL, e.error);
+	}
+	EXPECT_THROW(StripedLayout({}, 4096), fusepp::fuse_error);
+	EXPECT_THROW(StripedLayout(dirs, 0), fusepp::fuse_error);
+}
+
+TEST(StripedLayoutTest, closes_members_once_written_or_failed) {
+	TempDir dir;
+	vector<string> dirs = makeDirectories(dir, 2);
+	shared_ptr<BackingFile> source = BackingFile::open(dir.write("source", randomData(4096 * 3, 8)));
+	size_t before = openDescriptors();
+	StripedLayout(dirs, 4096).write(*source, "file");
+	EXPECT_EQ(before, openDescriptors());
+
+	dirs.push_back(dir.path + "/missing");
+	EXPECT_THROW(StripedLayout(dirs, 4096).write(*source, "other"), fusepp::fuse_error);
+	EXPECT_EQ(before, openDescriptors());
+}
+
+TEST(StripedLayoutTest, short_backing_files_fail_with_eio) {
+	TempDir dir;
+	shared_ptr<BackingFile> a = BackingFile::open(dir.write("a", randomData(100000, 6)));
+	shared_ptr<BackingFile> b = BackingFile::open(dir.write("b", randomData(1000, 7)));
+	MergedFile file({{a, 0, 100000}, {b, 0, 100000}});
+	string buf(200000, '\0');
+	try {
+		file.read(&buf[0], buf.size(), 0);
+		FAIL();
+	} catch(fusepp::fuse_error const & e) {
+		EXPECT_EQ(EIO, e.error);
+	}
+}
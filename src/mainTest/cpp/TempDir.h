@@ -0,0 +1,61 @@
+/*
+ * TempDir.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef TEMPDIR_H_
+#define TEMPDIR_H_
+
+#include <string>
+#include <cstdlib>
+
+extern "C" {
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <ftw.h>
+}
+
+/**
+ * A temporary directory, deleted along with its contents on destruction.
+ */
+class TempDir {
+public:
+	std::string const path;
+
+	TempDir() : path(create()) {}
+
+	~TempDir() {
+		::nftw(path.c_str(), [](char const * p, struct stat const *, int, struct FTW *) {
+			return ::remove(p);
+		}, 16, FTW_DEPTH | FTW_PHYS);
+	}
+
+	/**
+	 * Creates a file within this directory.
+	 * @param name The name of the file to create.
+	 * @param contents The contents to write to the file.
+	 * @return The full path of the file.
+	 */
+	std::string write(std::string const & name, std::string const & contents) const {
+		std::string file = path + "/" + name;
+		int fd = ::open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if(fd < 0 || ::write(fd, contents.data(), contents.size()) != (ssize_t) contents.size()) {
+			std::abort();
+		}
+		::close(fd);
+		return file;
+	}
+
+private:
+	static std::string create() {
+		char tmpl[] = "/tmp/smfsTest.XXXXXX";
+		if(!::mkdtemp(tmpl)) {
+			std::abort();
+		}
+		return tmpl;
+	}
+};
+
+#endif /* TEMPDIR_H_ */
@@ -0,0 +1,62 @@
+/*
+ * ThrottledTaskTest.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "gtest/gtest.h"
+
+#include "smfs/StatsLine.h"
+#include "smfs/ThrottledTask.h"
+
+#include <chrono>
+#include <string>
+
+using namespace smfs;
+using namespace std;
+
+namespace {
+
+struct Counted : TaskState {
+	uint64_t chunks = 0;
+};
+
+using Task = ThrottledTask<Counted>;
+
+} // namespace
+
+TEST(ThrottledTaskTest, paces_to_the_rate) {
+	// At 1 MiB/s, 256 KiB takes a quarter of a second
+	auto start = chrono::steady_clock::now();
+	Counted stats = Task(1 << 20, [](Task & task) {
+		for(int i = 0; i < 4 && task.pace(64 << 10); ++i) {
+			task.update([](Counted & counted) {
+				++counted.chunks;
+			});
+		}
+	}).wait();
+	EXPECT_GE(chrono::steady_clock::now() - start, chrono::milliseconds(150));
+	EXPECT_EQ(4, stats.chunks);
+	EXPECT_TRUE(stats.finished);
+	EXPECT_FALSE(stats.stopped);
+}
+
+TEST(ThrottledTaskTest, finishes_when_stopped) {
+	auto start = chrono::steady_clock::now();
+	Task task(1, [](Task & task) {
+		// A day's work at one byte per second
+		while(task.pace(1) && task.pause(86400)) {}
+	});
+	task.stop();
+	Counted stats = task.wait();
+	EXPECT_LT(chrono::steady_clock::now() - start, chrono::seconds(5));
+	EXPECT_TRUE(stats.finished);
+	EXPECT_TRUE(stats.stopped);
+}
+
+TEST(ThrottledTaskTest, formats_stats_on_one_line) {
+	EXPECT_EQ("hits=3 ratio=0.25 finished=1\n",
+			StatsLine().count("hits", 3).ratio("ratio", 0.25, 2).flag("finished", true).str());
+	EXPECT_EQ("\n", StatsLine().str());
+}
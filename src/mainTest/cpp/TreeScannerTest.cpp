@@ -0,0 +1,123 @@
+/*
+ * TreeScannerTest.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "gtest/gtest.h"
+
+#include "smfs/TreeScanner.h"
+#include "TempDir.h"
+
+#include <fusepp/common.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+extern "C" {
+	#include <sys/resource.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+}
+
+using namespace smfs;
+using namespace std;
+
+class TreeScannerTest : public ::testing::Test {
+public:
+	TempDir dir;
+
+	void mkdir(string const & name) {
+		ASSERT_EQ(0, ::mkdir((dir.path + "/" + name).c_str(), 0755));
+	}
+};
+
+TEST_F(TreeScannerTest, finds_regular_files_in_path_order) {
+	mkdir("b");
+	mkdir("b/c");
+	mkdir("empty");
+	dir.write("b/c/z", "12345");
+	dir.write("b/y", "");
+	dir.write("a", "123");
+	::symlink("a", (dir.path + "/link").c_str());
+	::mkfifo((dir.path + "/fifo").c_str(), 0644);
+
+	TreeScanner scanner(4);
+	vector<ScannedFile> files = scanner.scan(dir.path);
+	ASSERT_EQ(3, files.size());
+	EXPECT_EQ("a", files[0].path);
+	EXPECT_EQ(3, files[0].size);
+	EXPECT_EQ("b/c/z", files[1].path);
+	EXPECT_EQ(5, files[1].size);
+	EXPECT_EQ("b/y", files[2].path);
+
+	TreeScanner::Stats stats = scanner.stats();
+	EXPECT_EQ(4, stats.directories);
+	EXPECT_EQ(3, stats.files);
+	EXPECT_EQ(8, stats.bytes);
+}
+
+TEST_F(TreeScannerTest, scans_wide_trees_on_all_workers) {
+	for(int i = 0; i < 50; ++i) {
+		string d = to_string(i);
+		mkdir(d);
+		for(int j = 0; j < 20; ++j) {
+			dir.write(d + "/" + to_string(j), string(j, 'x'));
+		}
+	}
+	TreeScanner scanner(8);
+	vector<ScannedFile> files = scanner.scan(dir.path);
+	EXPECT_EQ(1000, files.size());
+	EXPECT_EQ(51, scanner.stats().directories);
+	EXPECT_EQ(50 * 190, scanner.stats().bytes);
+	EXPECT_TRUE(is_sorted(files.begin(), files.end(), [](ScannedFile const & a, ScannedFile const & b) {
+		return a.path < b.path;
+	}));
+}
+
+TEST_F(TreeScannerTest, produces_segments) {
+	mkdir("d");
+	dir.write("d/2", "cd");
+	dir.write("d/1", "ab");
+	dir.write("d/3", "");
+
+	vector<Segment> segments = TreeScanner(2).segments(dir.path);
+	ASSERT_EQ(2, segments.size());
+	EXPECT_EQ(dir.path + "/d/1", segments[0].file->path);
+	EXPECT_EQ(2, segments[1].length);
+}
+
+TEST_F(TreeScannerTest, produces_segments_for_more_files_than_descriptors) {
+	for(int i = 0; i < 300; ++i) {
+		dir.write(to_string(i), to_string(i));
+	}
+
+	struct rlimit saved;
+	ASSERT_EQ(0, ::getrlimit(RLIMIT_NOFILE, &saved));
+	struct rlimit lowered = saved;
+	lowered.rlim_cur = 128;
+	ASSERT_EQ(0, ::setrlimit(RLIMIT_NOFILE, &lowered));
+	vector<Segment> segments;
+	try {
+		segments = TreeScanner(2).segments(dir.path);
+	} catch(...) {
+		::setrlimit(RLIMIT_NOFILE, &saved);
+		throw;
+	}
+	ASSERT_EQ(0, ::setrlimit(RLIMIT_NOFILE, &saved));
+
+	ASSERT_EQ(300, segments.size());
+	for(Segment const & segment : segments) {
+		EXPECT_EQ(-1, segment.file->fd());
+		string name = segment.file->path.substr(dir.path.size() + 1);
+		string contents(segment.length, '\0');
+		EXPECT_EQ(segment.length, segment.file->read(&contents[0], segment.length, 0));
+		EXPECT_EQ(name, contents);
+	}
+}
+
+TEST_F(TreeScannerTest, fails_on_missing_root) {
+	EXPECT_THROW(TreeScanner(2).scan(dir.path + "/missing"), fusepp::fuse_error);
+}
@@ -0,0 +1,185 @@
+/*
+ * WriteCoalescerTest.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "gtest/gtest.h"
+
+#include "smfs/WriteCoalescer.h"
+
+#include <fusepp/common.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace smfs;
+using namespace std;
+
+class WriteCoalescerTest : public ::testing::Test {
+public:
+	vector<pair<off_t, string>> written;
+
+	WriteCoalescer::Sink sink() {
+		return [this](void const * data, size_t nbytes, off_t offset) {
+			written.emplace_back(offset, string(static_cast<char const *>(data), nbytes));
+		};
+	}
+};
+
+TEST_F(WriteCoalescerTest, joins_sequential_writes) {
+	WriteCoalescer coalescer(sink(), 1024);
+	coalescer.write("abc", 3, 10);
+	coalescer.write("def", 3, 13);
+	coalescer.write("ghi", 3, 16);
+	EXPECT_TRUE(written.empty());
+	EXPECT_EQ(make_pair(off_t(10), size_t(9)), coalescer.pending());
+	EXPECT_EQ(19, coalescer.size(15));
+	EXPECT_EQ(30, coalescer.size(30));
+
+	coalescer.flush();
+	ASSERT_EQ(1, written.size());
+	EXPECT_EQ(make_pair(off_t(10), string("abcdefghi")), written[0]);
+	EXPECT_EQ(make_pair(off_t(0), size_t(0)), coalescer.pending());
+	// As if the file had been truncated since
+	EXPECT_EQ(5, coalescer.size(5));
+
+	// Nothing left to pass on
+	coalescer.flush();
+	EXPECT_EQ(1, written.size());
+
+	WriteCoalescer::Stats stats = coalescer.stats();
+	EXPECT_EQ(3, stats.writes);
+	EXPECT_EQ(9, stats.bytes);
+	EXPECT_EQ(1, stats.backingWrites);
+	EXPECT_DOUBLE_EQ(3.0, stats.ratio());
+}
+
+TEST_F(WriteCoalescerTest, overwrites_buffered_data_in_place) {
+	WriteCoalescer coalescer(sink(), 1024);
+	coalescer.write("abcdef", 6, 0);
+	coalescer.write("XY", 2, 2);
+	coalescer.write("Z", 1, 0);
+	coalescer.write("0123", 4, 4);
+	coalescer.flush();
+	ASSERT_EQ(1, written.size());
+	EXPECT_EQ(make_pair(off_t(0), string("ZbXY0123")), written[0]);
+}
+
+TEST_F(WriteCoalescerTest, passes_on_the_buffer_before_a_write_elsewhere) {
+	WriteCoalescer coalescer(sink(), 1024);
+	coalescer.write("abc", 3, 10);
+	coalescer.write("def", 3, 20);
+	ASSERT_EQ(1, written.size());
+	EXPECT_EQ(make_pair(off_t(10), string("abc")), written[0]);
+
+	// A write before the buffered data does not join it either
+	coalescer.write("ghi", 3, 17);
+	ASSERT_EQ(2, written.size());
+	EXPECT_EQ(make_pair(off_t(20), string("def")), written[1]);
+	EXPECT_EQ(make_pair(off_t(17), size_t(3)), coalescer.pending());
+}
+
+TEST_F(WriteCoalescerTest, passes_on_the_buffer_when_it_reaches_the_threshold) {
+	WriteCoalescer coalescer(sink(), 8);
+	coalescer.write("abcd", 4, 0);
+	coalescer.write("efgh", 4, 4);
+	ASSERT_EQ(1, written.size());
+	EXPECT_EQ(make_pair(off_t(0), string("abcdefgh")), written[0]);
+
+	coalescer.write("ijklmnopqr", 10, 8);
+	ASSERT_EQ(2, written.size());
+	EXPECT_EQ(make_pair(off_t(8), string("ijklmnopqr")), written[1]);
+	EXPECT_EQ(0, coalescer.pending().second);
+}
+
+TEST_F(WriteCoalescerTest, passes_on_aligned_data_at_the_threshold) {
+	WriteCoalescer coalescer(sink(), 8192);
+	string data(3000, 'x');
+	coalescer.write(data.data(), 3000, 100);
+	coalescer.write(data.data(), 3000, 3100);
+	coalescer.write(data.data(), 3000, 6100);
+	ASSERT_EQ(1, written.size());
+	EXPECT_EQ(100, written[0].first);
+	EXPECT_EQ(8092, written[0].second.size());
+	EXPECT_EQ(make_pair(off_t(8192), size_t(908)), coalescer.pending());
+
+	// Later pieces of the run begin and end on aligned offsets
+	for(off_t offset = 9100; offset < 20000; offset += 3000) {
+		coalescer.write(data.data(), 3000, offset);
+	}
+	ASSERT_EQ(2, written.size());
+	EXPECT_EQ(8192, written[1].first);
+	EXPECT_EQ(8192, written[1].second.size());
+
+	coalescer.flush();
+	ASSERT_EQ(3, written.size());
+	EXPECT_EQ(16384, written[2].first);
+	EXPECT_EQ(21100 - 16384, written[2].second.size());
+}
+
+TEST_F(WriteCoalescerTest, writes_straight_through_with_no_threshold) {
+	auto counters = make_shared<WriteCoalescer::Counters>();
+	WriteCoalescer coalescer(sink(), 0, counters);
+	coalescer.write("abc", 3, 0);
+	coalescer.write("def", 3, 3);
+	EXPECT_EQ(2, written.size());
+
+	WriteCoalescer::Stats stats = counters->stats();
+	EXPECT_EQ(2, stats.writes);
+	EXPECT_EQ(2, stats.backingWrites);
+	EXPECT_EQ(2, stats.writeThrough);
+	EXPECT_DOUBLE_EQ(1.0, stats.ratio());
+}
+
+TEST_F(WriteCoalescerTest, shares_counters_between_coalescers) {
+	auto counters = make_shared<WriteCoalescer::Counters>();
+	WriteCoalescer a(sink(), 1024, counters);
+	WriteCoalescer b(sink(), 1024, counters);
+	a.write("abc", 3, 0);
+	a.write("def", 3, 3);
+	b.write("ghi", 3, 0);
+	a.flush();
+	b.flush();
+	EXPECT_EQ(3, counters->stats().writes);
+	EXPECT_EQ(2, counters->stats().backingWrites);
+	EXPECT_EQ(counters->stats().toString(), a.stats().toString());
+}
+
+TEST_F(WriteCoalescerTest, passes_on_the_buffer_before_writing_through) {
+	WriteCoalescer coalescer(sink(), 1024);
+	coalescer.write("abc", 3, 0);
+	coalescer.writeThrough(5, [&]() {
+		written.emplace_back(3, "defgh");
+	});
+	ASSERT_EQ(2, written.size());
+	EXPECT_EQ(make_pair(off_t(0), string("abc")), written[0]);
+	EXPECT_EQ(make_pair(off_t(3), string("defgh")), written[1]);
+
+	WriteCoalescer::Stats stats = coalescer.stats();
+	EXPECT_EQ(2, stats.writes);
+	EXPECT_EQ(8, stats.bytes);
+	EXPECT_EQ(2, stats.backingWrites);
+	EXPECT_EQ(1, stats.writeThrough);
+}
+
+TEST_F(WriteCoalescerTest, discards_the_buffer_if_it_cannot_be_passed_on) {
+	bool fail = true;
+	WriteCoalescer coalescer([&](void const * data, size_t nbytes, off_t offset) {
+		if(fail) {
+			throw fusepp::fuse_error(EIO);
+		}
+		written.emplace_back(offset, string(static_cast<char const *>(data), nbytes));
+	}, 1024);
+	coalescer.write("abc", 3, 0);
+	EXPECT_THROW(coalescer.flush(), fusepp::fuse_error);
+	EXPECT_EQ(0, coalescer.pending().second);
+
+	fail = false;
+	coalescer.write("def", 3, 3);
+	coalescer.flush();
+	ASSERT_EQ(1, written.size());
+	EXPECT_EQ(make_pair(off_t(3), string("def")), written[0]);
+}
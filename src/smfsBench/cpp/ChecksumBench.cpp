@@ -0,0 +1,46 @@
+/*
+ * ChecksumBench.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "Bench.h"
+
+#include "smfs/Crc32c.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace smfs;
+
+namespace {
+
+constexpr std::size_t dataSize = 256 << 20;
+
+/**
+ * Measures the rate at which CRC-32C is computed over in-memory data, in
+ * blocks of a range of sizes.
+ */
+void checksums() {
+	std::vector<unsigned char> data(dataSize);
+	for(std::size_t i = 0; i < dataSize; ++i) {
+		data[i] = static_cast<unsigned char>(i * 2654435761u >> 24);
+	}
+
+	for(std::size_t block : {512, 4096, 131072}) {
+		std::uint32_t total = 0;
+		auto start = std::chrono::steady_clock::now();
+		for(std::size_t offset = 0; offset < dataSize; offset += block) {
+			total ^= crc32c(data.data() + offset, block);
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::string label = "block " + std::to_string(block) + " (" + std::to_string(total & 1) + ")";
+		bench::report(label.c_str(), dataSize, seconds);
+	}
+}
+
+bench::Register registration("checksums", checksums);
+
+} // namespace
@@ -0,0 +1,52 @@
+/*
+ * ChunkerBench.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "Bench.h"
+
+#include "smfs/Chunker.h"
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace smfs;
+
+namespace {
+
+constexpr std::size_t dataSize = 256 << 20;
+
+/**
+ * Measures the rate at which in-memory data is divided into content-defined
+ * chunks, for a range of average chunk sizes.
+ */
+void chunking() {
+	std::vector<unsigned char> data(dataSize);
+	std::mt19937_64 random(42);
+	for(std::size_t i = 0; i < dataSize; i += 8) {
+		std::uint64_t r = random();
+		for(std::size_t j = 0; j < 8; ++j) {
+			data[i + j] = static_cast<unsigned char>(r >> (j * 8));
+		}
+	}
+
+	for(std::size_t average : {4096, 8192, 65536, 1 << 20}) {
+		Chunker chunker(average);
+		std::size_t chunks = 0;
+		auto start = std::chrono::steady_clock::now();
+		for(std::size_t offset = 0; offset < dataSize; ++chunks) {
+			offset += chunker.cut(data.data() + offset, dataSize - offset);
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::string label = "average " + std::to_string(average) + " (" + std::to_string(chunks) + " chunks)";
+		bench::report(label.c_str(), dataSize, seconds);
+	}
+}
+
+bench::Register registration("chunking", chunking);
+
+} // namespace
@@ -0,0 +1,119 @@
+/*
+ * CompressedBench.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "Bench.h"
+
+#include "smfs/BlockCache.h"
+#include "smfs/CompressedFile.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+extern "C" {
+	#include <fcntl.h>
+	#include <unistd.h>
+}
+
+using namespace smfs;
+
+namespace {
+
+constexpr std::size_t dataSize = 64 << 20;
+constexpr std::size_t randomReads = 20000;
+
+/**
+ * Writes a file of log-like lines, which compress well but not trivially.
+ */
+void generate(std::string const & path) {
+	static char const * const levels[] = {"INFO", "WARN", "DEBUG", "ERROR"};
+	std::mt19937_64 random(1);
+	std::string data;
+	while(data.size() < dataSize) {
+		data += "2026-10-19T12:" + std::to_string(random() % 60) + ":" + std::to_string(random() % 60)
+				+ " " + levels[random() % 4] + " request id=" + std::to_string(random() % 100000)
+				+ " served in " + std::to_string(random() % 1000) + "ms\n";
+	}
+	int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if(fd >= 0) {
+		ssize_t rc = ::write(fd, data.data(), dataSize);
+		(void) rc;
+		::close(fd);
+	}
+}
+
+double since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Measures sequential, random and large reads of one file.
+ */
+void readFile(char const * name, BackingFile const & file) {
+	std::vector<char> buffer(16 << 20);
+	auto start = std::chrono::steady_clock::now();
+	for(off_t offset = 0; offset < static_cast<off_t>(dataSize); offset += 1 << 20) {
+		file.read(buffer.data(), 1 << 20, offset);
+	}
+	bench::report((std::string(name) + " sequential 1 MiB").c_str(), dataSize, since(start));
+
+	start = std::chrono::steady_clock::now();
+	for(off_t offset = 0; offset < static_cast<off_t>(dataSize); offset += buffer.size()) {
+		file.read(buffer.data(), buffer.size(), offset);
+	}
+	bench::report((std::string(name) + " sequential 16 MiB").c_str(), dataSize, since(start));
+
+	std::mt19937_64 random(2);
+	start = std::chrono::steady_clock::now();
+	for(std::size_t i = 0; i < randomReads; ++i) {
+		file.read(buffer.data(), 4096, random() % (dataSize - 4096));
+	}
+	bench::report((std::string(name) + " random 4 KiB").c_str(), randomReads * 4096, since(start));
+
+	BlockCache cache(dataSize * 2);
+	for(int pass = 0; pass < 2; ++pass) {
+		start = std::chrono::steady_clock::now();
+		for(std::size_t i = 0; i < randomReads; ++i) {
+			cache.read(file, random() % (dataSize - 4096), 4096, [](std::shared_ptr<Block>, std::size_t, std::size_t) {});
+		}
+		bench::report((std::string(name) + (pass ? " random 4 KiB, warm cache" : " random 4 KiB, cold cache")).c_str(),
+				randomReads * 4096, since(start));
+	}
+}
+
+/**
+ * Compares reads of a compressed container of log-like data against reads
+ * of the same data uncompressed.
+ */
+void compressedReads() {
+	char dir[] = "/tmp/smfs-bench-XXXXXX";
+	if(!::mkdtemp(dir)) {
+		return;
+	}
+	std::string plainPath = std::string(dir) + "/plain";
+	std::string packedPath = std::string(dir) + "/packed";
+	generate(plainPath);
+	std::shared_ptr<BackingFile> plain = BackingFile::open(plainPath);
+
+	auto start = std::chrono::steady_clock::now();
+	CompressedFile::compress(*plain, packedPath);
+	bench::report("compress", dataSize, since(start));
+	std::shared_ptr<CompressedFile> packed = CompressedFile::open(packedPath);
+	std::printf("  %-40s %12.2f\n", "compression ratio", static_cast<double>(dataSize) / packed->compressedSize());
+
+	readFile("plain", *plain);
+	readFile("compressed", *packed);
+
+	::system((std::string("rm -rf ") + dir).c_str());
+}
+
+bench::Register registration("compressed_reads", compressedReads);
+
+} // namespace
@@ -0,0 +1,112 @@
+/*
+ * DeltaLogBench.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "Bench.h"
+
+#include "smfs/DeltaLog.h"
+#include "smfs/MergedFile.h"
+#include "smfs/WriteCoalescer.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+extern "C" {
+	#include <fcntl.h>
+	#include <unistd.h>
+}
+
+using namespace smfs;
+
+namespace {
+
+constexpr std::size_t fileSize = 256 << 20;
+constexpr std::size_t writeSize = 4096;
+constexpr std::size_t writeCount = 32768;
+
+double since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Compares small writes at random offsets made by appending to a delta log
+ * against the same writes made in place with `pwrite`, each followed by a
+ * sync of everything written, and sequential writes made through a delta
+ * log with and without coalescing.
+ */
+void deltaWrites() {
+	char dir[] = "/tmp/smfs-bench-XXXXXX";
+	if(!::mkdtemp(dir)) {
+		return;
+	}
+	std::string basePath = std::string(dir) + "/base";
+	int fd = ::open(basePath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	std::vector<char> chunk(1 << 20, 'x');
+	for(std::size_t written = 0; written < fileSize; written += chunk.size()) {
+		ssize_t rc = ::write(fd, chunk.data(), chunk.size());
+		(void) rc;
+	}
+	::fsync(fd);
+
+	std::vector<off_t> offsets;
+	std::mt19937_64 random(1);
+	for(std::size_t i = 0; i < writeCount; ++i) {
+		offsets.push_back(random() % (fileSize / writeSize) * writeSize);
+	}
+	std::vector<char> data(writeSize, 'y');
+
+	auto start = std::chrono::steady_clock::now();
+	for(off_t offset : offsets) {
+		ssize_t rc = ::pwrite(fd, data.data(), writeSize, offset);
+		(void) rc;
+	}
+	::fdatasync(fd);
+	bench::report("pwrite in place, random 4 KiB", writeCount * writeSize, since(start));
+	::close(fd);
+
+	MergedFile file({{BackingFile::open(basePath), 0, fileSize}});
+	DeltaLog log(dir);
+	start = std::chrono::steady_clock::now();
+	for(off_t offset : offsets) {
+		file.write(log, data.data(), writeSize, offset);
+	}
+	log.sync();
+	bench::report("delta log, random 4 KiB", writeCount * writeSize, since(start));
+	std::printf("  %-40s %12zu\n", "segments after writes", file.segments()->count());
+
+	MergedFile sequential({{BackingFile::open(basePath), 0, fileSize}});
+	DeltaLog sequentialLog(dir);
+	start = std::chrono::steady_clock::now();
+	for(std::size_t i = 0; i < writeCount; ++i) {
+		sequential.write(sequentialLog, data.data(), writeSize, i * writeSize);
+	}
+	sequentialLog.sync();
+	bench::report("delta log, sequential 4 KiB", writeCount * writeSize, since(start));
+	std::printf("  %-40s %12zu\n", "segments after writes", sequential.segments()->count());
+
+	MergedFile coalesced({{BackingFile::open(basePath), 0, fileSize}});
+	DeltaLog coalescedLog(dir);
+	WriteCoalescer coalescer([&](void const * data, std::size_t nbytes, off_t offset) {
+		coalesced.write(coalescedLog, data, nbytes, offset);
+	});
+	start = std::chrono::steady_clock::now();
+	for(std::size_t i = 0; i < writeCount; ++i) {
+		coalescer.write(data.data(), writeSize, i * writeSize);
+	}
+	coalescer.flush();
+	coalescedLog.sync();
+	bench::report("coalesced delta log, sequential 4 KiB", writeCount * writeSize, since(start));
+	std::printf("  %-40s %12.1f\n", "writes per log append", coalescer.stats().ratio());
+
+	::system((std::string("rm -rf ") + dir).c_str());
+}
+
+bench::Register registration("delta_writes", deltaWrites);
+
+} // namespace
@@ -0,0 +1,70 @@
+/*
+ * JournalBench.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "Bench.h"
+
+#include "smfs/ManifestStore.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+extern "C" {
+	#include <unistd.h>
+}
+
+using namespace smfs;
+
+namespace {
+
+constexpr int editsPerThread = 5000;
+
+/**
+ * Measures the throughput of journalled edits to merged files, with
+ * increasing numbers of concurrent editors.
+ */
+void journalledEdits() {
+	char dir[] = "/tmp/smfs-bench-XXXXXX";
+	if(!::mkdtemp(dir)) {
+		return;
+	}
+	std::shared_ptr<BackingFile> backing = BackingFile::open("/dev/null");
+
+	for(int threads : {1, 4, 16, 64}) {
+		ManifestStore store(dir);
+		ManifestStore::Files files = store.recover();
+		std::vector<std::shared_ptr<MergedFile>> edited;
+		for(int t = 0; t < threads; ++t) {
+			std::string path = "/t" + std::to_string(threads) + "/" + std::to_string(t);
+			edited.push_back(store.create(path, {{backing, 0, 1 << 20}}));
+			edited.back()->sync();
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		std::vector<std::thread> workers;
+		for(int t = 0; t < threads; ++t) {
+			workers.emplace_back([&, t]() {
+				MergedFile &file = *edited[t];
+				for(int i = 0; i < editsPerThread; ++i) {
+					file.copyFrom(file, (i * 4096) % (1 << 19), 0, 4096);
+				}
+			});
+		}
+		for(std::thread &w : workers) {
+			w.join();
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::printf("  %2d threads: %10.0f edits/s\n", threads, threads * editsPerThread / seconds);
+	}
+
+	::system((std::string("rm -rf ") + dir).c_str());
+}
+
+bench::Register registration("journalled_edits", journalledEdits);
+
+} // namespace
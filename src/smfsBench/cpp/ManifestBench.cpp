@@ -0,0 +1,90 @@
+/*
+ * ManifestBench.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "Bench.h"
+
+#include "smfs/Manifest.h"
+#include "smfs/MergedFile.h"
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+extern "C" {
+	#include <unistd.h>
+}
+
+using namespace smfs;
+
+namespace {
+
+constexpr std::size_t fileCount = 1000;
+constexpr std::size_t segmentsPerFile = 10000;
+constexpr std::size_t segmentLength = 65536;
+
+double since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Times loading a manifest of ten million segments, and looking up segments
+ * in the files it describes.
+ */
+void manifestLoad() {
+	std::string path = "/tmp/smfs-bench-manifest";
+	std::shared_ptr<BackingFile> backing = BackingFile::open("/dev/null");
+
+	auto start = std::chrono::steady_clock::now();
+	{
+		ManifestWriter writer;
+		for(std::size_t f = 0; f < fileCount; ++f) {
+			std::vector<Segment> segments;
+			for(std::size_t i = 0; i < segmentsPerFile; ++i) {
+				// Interleave chunks so no segments are contiguous
+				off_t chunk = (i * fileCount + f) * segmentLength;
+				segments.push_back({backing, chunk, segmentLength - f % 7});
+			}
+			writer.add("/file" + std::to_string(f), MergedFile(segments));
+		}
+		writer.write(path);
+	}
+	std::printf("  wrote %zu segments in %.2f s\n", fileCount * segmentsPerFile, since(start));
+
+	start = std::chrono::steady_clock::now();
+	std::shared_ptr<Manifest const> manifest = Manifest::open(path);
+	std::vector<std::shared_ptr<MergedFile>> files;
+	for(std::size_t f = 0; f < manifest->fileCount(); ++f) {
+		files.push_back(std::make_shared<MergedFile>(manifest, f));
+	}
+	std::printf("  ready to serve in %.3f ms\n", since(start) * 1000);
+
+	std::mt19937_64 rng(1);
+	std::size_t found = 0;
+	bench::time("manifest: lookup in place", 1000000, [&](std::size_t) {
+		MergedFile const & file = *files[rng() % files.size()];
+		off_t offset = std::uniform_int_distribution<off_t>(0, file.size() - 1)(rng);
+		file.forEachExtent(offset, 4096, [&](Segment const &, off_t, std::size_t) { ++found; });
+	});
+
+	start = std::chrono::steady_clock::now();
+	for(std::shared_ptr<MergedFile> const & file : files) {
+		file->segments();
+	}
+	std::printf("  built all segment trees in %.2f s\n", since(start));
+	bench::time("tree: lookup", 1000000, [&](std::size_t) {
+		MergedFile const & file = *files[rng() % files.size()];
+		off_t offset = std::uniform_int_distribution<off_t>(0, file.size() - 1)(rng);
+		file.forEachExtent(offset, 4096, [&](Segment const &, off_t, std::size_t) { ++found; });
+	});
+
+	std::printf("  (%zu extents visited)\n", found);
+	::unlink(path.c_str());
+}
+
+bench::Register registration("manifest_load", manifestLoad);
+
+} // namespace
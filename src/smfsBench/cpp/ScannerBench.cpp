@@ -0,0 +1,118 @@
+/*
+ * ScannerBench.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "Bench.h"
+
+#include "smfs/TreeScanner.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+extern "C" {
+	#include <dirent.h>
+	#include <fcntl.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+}
+
+using namespace smfs;
+
+namespace {
+
+constexpr int topDirectories = 32;
+constexpr int subDirectories = 32;
+constexpr int filesPerDirectory = 64;
+
+/**
+ * Generates a tree of topDirectories * subDirectories directories, each
+ * holding filesPerDirectory small files.
+ */
+void generate(std::string const & root) {
+	for(int i = 0; i < topDirectories; ++i) {
+		std::string top = root + "/" + std::to_string(i);
+		::mkdir(top.c_str(), 0755);
+		for(int j = 0; j < subDirectories; ++j) {
+			std::string sub = top + "/" + std::to_string(j);
+			::mkdir(sub.c_str(), 0755);
+			for(int k = 0; k < filesPerDirectory; ++k) {
+				int fd = ::open((sub + "/" + std::to_string(k)).c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+				if(fd >= 0) {
+					::ftruncate(fd, k * 512);
+					::close(fd);
+				}
+			}
+		}
+	}
+}
+
+/**
+ * A serial readdir and stat walk, as the baseline.
+ */
+std::size_t serialWalk(std::string const & path) {
+	DIR * dir = ::opendir(path.c_str());
+	if(!dir) {
+		return 0;
+	}
+	std::size_t files = 0;
+	while(struct dirent * entry = ::readdir(dir)) {
+		if(std::strcmp(entry->d_name, ".") == 0 || std::strcmp(entry->d_name, "..") == 0) {
+			continue;
+		}
+		std::string child = path + "/" + entry->d_name;
+		struct stat statbuf;
+		if(::lstat(child.c_str(), &statbuf) != 0) {
+			continue;
+		}
+		if(S_ISDIR(statbuf.st_mode)) {
+			files += serialWalk(child);
+		} else if(S_ISREG(statbuf.st_mode)) {
+			++files;
+		}
+	}
+	::closedir(dir);
+	return files;
+}
+
+template<typename F>
+void timeScan(char const * label, F&& fn) {
+	auto start = std::chrono::steady_clock::now();
+	std::size_t files = fn();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::printf("  %-40s %12.0f files/s  (%zu files)\n", label, files / seconds, files);
+}
+
+/**
+ * Measures the rate at which a generated tree is scanned, serially and by
+ * the parallel scanner with increasing numbers of workers. The tree is
+ * scanned once beforehand, so that all runs see a warm dentry cache.
+ */
+void treeScan() {
+	char dir[] = "/tmp/smfs-bench-XXXXXX";
+	if(!::mkdtemp(dir)) {
+		return;
+	}
+	generate(dir);
+	serialWalk(dir);
+
+	timeScan("serial readdir+lstat", [&]() {
+		return serialWalk(dir);
+	});
+	for(unsigned threads : {1u, 4u, 16u}) {
+		std::string label = "scanner, " + std::to_string(threads) + " threads";
+		timeScan(label.c_str(), [&]() {
+			return TreeScanner(threads).scan(dir).size();
+		});
+	}
+
+	::system((std::string("rm -rf ") + dir).c_str());
+}
+
+bench::Register registration("tree_scan", treeScan);
+
+} // namespace
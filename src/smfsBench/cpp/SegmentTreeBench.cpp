@@ -0,0 +1,85 @@
+/*
+ * SegmentTreeBench.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "Bench.h"
+
+#include "smfs/SegmentList.h"
+#include "smfs/SegmentTree.h"
+
+#include <random>
+#include <vector>
+
+using namespace smfs;
+
+namespace {
+
+constexpr std::size_t segmentCount = 1000000;
+constexpr std::size_t segmentLength = 4096;
+
+/**
+ * Compares edits to a segment tree with rebuilding a flat segment list,
+ * for a file of a million segments.
+ */
+void segmentMaps() {
+	std::shared_ptr<BackingFile> file = BackingFile::open("/dev/null");
+	std::vector<Segment> segments;
+	for(std::size_t i = 0; i < segmentCount; ++i) {
+		// Leave gaps so no segments are contiguous
+		segments.push_back({file, static_cast<off_t>(i * 2 * segmentLength), segmentLength});
+	}
+	off_t size = segmentCount * segmentLength;
+	Segment extra{file, -1, 100};
+
+	std::mt19937_64 rng(1);
+	std::uniform_int_distribution<off_t> anywhere(0, size - 1);
+	std::size_t found = 0;
+	auto count = [&](Segment const &, off_t, std::size_t) { ++found; };
+
+	SegmentTree tree(segments);
+	SegmentList list(segments);
+	std::printf("  tree height %u for %zu segments\n", tree.height(), tree.count());
+
+	bench::time("tree: lookup", 1000000, [&](std::size_t) {
+		tree.forEachExtent(anywhere(rng), 1, count);
+	});
+	bench::time("list: lookup", 1000000, [&](std::size_t) {
+		list.forEachExtent(anywhere(rng), 1, count);
+	});
+
+	bench::time("tree: insert in middle", 100000, [&](std::size_t) {
+		tree.insert(anywhere(rng), extra);
+	});
+	bench::time("list: insert in middle (rebuild)", 100, [&](std::size_t) {
+		list.splice(anywhere(rng), 0, {extra});
+	});
+
+	bench::time("tree: erase from middle", 100000, [&](std::size_t) {
+		tree.erase(anywhere(rng), segmentLength);
+	});
+	bench::time("list: erase from middle (rebuild)", 100, [&](std::size_t) {
+		list.splice(anywhere(rng), segmentLength, {});
+	});
+
+	bench::time("tree: split range", 100000, [&](std::size_t) {
+		tree.range(anywhere(rng), size / 4);
+	});
+	bench::time("list: split range (rebuild)", 100, [&](std::size_t) {
+		SegmentList(list.slice(anywhere(rng), size / 4));
+	});
+
+	SegmentTree edited = tree;
+	bench::time("tree: cumulative edits", 100000, [&](std::size_t i) {
+		off_t at = std::uniform_int_distribution<off_t>(0, edited.size() - 1)(rng);
+		edited = i % 2 ? edited.erase(at, 100) : edited.insert(at, extra);
+	});
+
+	std::printf("  (%zu extents visited)\n", found);
+}
+
+bench::Register registration("segment_maps", segmentMaps);
+
+} // namespace
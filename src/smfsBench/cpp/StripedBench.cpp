@@ -0,0 +1,117 @@
+/*
+ * StripedBench.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "Bench.h"
+
+#include "smfs/MergedFile.h"
+#include "smfs/StripedLayout.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C" {
+	#include <fcntl.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+}
+
+using namespace smfs;
+
+namespace {
+
+constexpr std::size_t dataSize = 32 << 20;
+
+/**
+ * The rate at which each simulated device delivers data.
+ */
+constexpr double deviceBytesPerSecond = 200.0 * (1 << 20);
+
+/**
+ * A backing file that reads no faster than a single device would, by
+ * sleeping for as long as the device would take. Reads of one file are
+ * serialised, as they would be by the device.
+ */
+class ThrottledFile : public BackingFile {
+	mutable std::mutex device;
+
+public:
+	static std::shared_ptr<BackingFile> open(std::string const & path) {
+		int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		return std::shared_ptr<BackingFile>(new ThrottledFile(path, fd));
+	}
+
+protected:
+	std::size_t readUnchecked(void * buf, std::size_t nbytes, off_t offset) const override {
+		std::lock_guard<std::mutex> lock(device);
+		std::size_t rc = BackingFile::readUnchecked(buf, nbytes, offset);
+		std::this_thread::sleep_for(std::chrono::duration<double>(rc / deviceBytesPerSecond));
+		return rc;
+	}
+
+private:
+	ThrottledFile(std::string const & path, int fd) : BackingFile(path, fd) {}
+};
+
+/**
+ * Measures reads of a file striped across one, two and four throttled
+ * directories.
+ */
+void stripedReads() {
+	char root[] = "/tmp/smfs-bench-XXXXXX";
+	if(!::mkdtemp(root)) {
+		return;
+	}
+	std::string sourcePath = std::string(root) + "/source";
+	{
+		std::string data(dataSize, '\0');
+		for(std::size_t i = 0; i < dataSize; ++i) {
+			data[i] = static_cast<char>(i * 2654435761u >> 24);
+		}
+		int fd = ::open(sourcePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		ssize_t rc = ::write(fd, data.data(), data.size());
+		(void) rc;
+		::close(fd);
+	}
+	std::shared_ptr<BackingFile> source = BackingFile::open(sourcePath);
+
+	for(std::size_t devices : {1, 2, 4}) {
+		std::vector<std::string> dirs;
+		for(std::size_t i = 0; i < devices; ++i) {
+			dirs.push_back(std::string(root) + "/" + std::to_string(devices) + "-" + std::to_string(i));
+			::mkdir(dirs.back().c_str(), 0755);
+		}
+		StripedLayout layout(dirs);
+		layout.write(*source, "file");
+		std::vector<std::shared_ptr<BackingFile>> members;
+		for(std::string const & dir : dirs) {
+			members.push_back(ThrottledFile::open(dir + "/file"));
+		}
+		MergedFile file(StripedLayout::segments(members, layout.stripeSize()));
+
+		for(std::size_t readSize : {std::size_t(128 << 10), std::size_t(4 << 20)}) {
+			std::vector<char> buffer(readSize);
+			auto start = std::chrono::steady_clock::now();
+			for(off_t offset = 0; offset < static_cast<off_t>(dataSize); offset += readSize) {
+				file.read(buffer.data(), readSize, offset);
+			}
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			std::string label = std::to_string(devices) + " devices, " + std::to_string(readSize >> 10) + " KiB reads";
+			bench::report(label.c_str(), dataSize, seconds);
+		}
+	}
+
+	::system((std::string("rm -rf ") + root).c_str());
+}
+
+bench::Register registration("striped_reads", stripedReads);
+
+} // namespace
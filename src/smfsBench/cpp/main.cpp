@@ -0,0 +1,34 @@
+/*
+ * main.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#include "Bench.h"
+
+#include <cstdio>
+
+/**
+ * Runs the benchmarks named on the command line, or all of them if none are.
+ */
+int main(int argc, char** argv) {
+	if(argc == 1) {
+		for(auto const & entry : bench::registry()) {
+			std::printf("%s\n", entry.first.c_str());
+			entry.second();
+		}
+		return 0;
+	}
+
+	for(int i = 1; i < argc; ++i) {
+		auto it = bench::registry().find(argv[i]);
+		if(it == bench::registry().end()) {
+			std::fprintf(stderr, "Unknown benchmark: %s\n", argv[i]);
+			return 1;
+		}
+		std::printf("%s\n", it->first.c_str());
+		it->second();
+	}
+	return 0;
+}
@@ -0,0 +1,65 @@
+/*
+ * Bench.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SMFSBENCH_BENCH_H_
+#define SMFSBENCH_BENCH_H_
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <string>
+
+namespace bench {
+
+/**
+ * The registered benchmarks, by name.
+ */
+inline std::map<std::string, std::function<void()>> & registry() {
+	static std::map<std::string, std::function<void()>> benchmarks;
+	return benchmarks;
+}
+
+/**
+ * Registers a benchmark on construction. Declare one at namespace scope.
+ */
+struct Register {
+	Register(std::string const & name, std::function<void()> fn) {
+		registry().emplace(name, std::move(fn));
+	}
+};
+
+/**
+ * Times a number of iterations of a function and reports the mean time
+ * per iteration.
+ * @param label The name to report the timing under.
+ * @param iterations The number of times to call `fn`.
+ * @param fn A function taking the iteration number.
+ * @return The mean time per iteration, in nanoseconds.
+ */
+template<typename F>
+double time(char const * label, std::size_t iterations, F&& fn) {
+	auto start = std::chrono::steady_clock::now();
+	for(std::size_t i = 0; i < iterations; ++i) {
+		fn(i);
+	}
+	std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+	double mean = elapsed.count() / iterations;
+	std::printf("  %-40s %12.0f ns/op  (%zu ops)\n", label, mean, iterations);
+	return mean;
+}
+
+/**
+ * Reports a throughput figure.
+ */
+inline void report(char const * label, double bytes, double seconds) {
+	std::printf("  %-40s %12.1f MiB/s\n", label, bytes / seconds / (1 << 20));
+}
+
+} // namespace bench
+
+#endif /* SMFSBENCH_BENCH_H_ */
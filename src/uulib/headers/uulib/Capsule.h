@@ -66,11 +66,11 @@ public:
 		return *get();
 	}
 
-	I const * const operator->() const {
+	I const * operator->() const {
 		return get();
 	}
 
-	I* const operator->() {
+	I* operator->() {
 		return get();
 	}
 
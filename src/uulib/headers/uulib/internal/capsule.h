@@ -113,21 +113,21 @@ public:
 		return &val;
 	}
 
-	void copy(Storage const &from, Storage &to) const override {}
+	void copy(Storage const &, Storage &) const override {}
 
-	void move(Storage &from, Storage &to) const override {}
+	void move(Storage &, Storage &) const override {}
 
 
 
-	bool assign(Storage const &from, Storage &to) const override {
+	bool assign(Storage const &, Storage &) const override {
 		return false;
 	}
 
-	bool assign(Storage &&from, Storage &to) const override {
+	bool assign(Storage &&, Storage &) const override {
 		return false;
 	}
 
-	void destroy(Storage& location) const noexcept override {}
+	void destroy(Storage&) const noexcept override {}
 };
 
 class DynamicStorage : public virtual Storage {
@@ -417,7 +417,7 @@ public:
 	void destroy(Storage& location) const override {
 		T* impl = getImpl(location);
 		impl->~T();
-		std::memset(impl, 0, sizeof(T));
+		std::memset(static_cast<void *>(impl), 0, sizeof(T));
 	}
 
 };